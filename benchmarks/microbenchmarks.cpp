@@ -0,0 +1,646 @@
+// Microbenchmarks for the mesh hot paths of MainWindow, Polygon and the
+// geometry helpers at increasing entity counts. Runs headless (offscreen QPA)
+// and reports wall time and operator new allocations per call.
+//
+//   microbenchmarks [--sizes 1000,10000,100000,1000000] [--budget-ms 5000] [--json report.json]
+
+#include "faceextractor.h"
+#include "line.h"
+#include "mainwindow.h"
+#include "meshgeometry.h"
+#include "planarmesh.h"
+#include "polygon.h"
+#include "stressbenchmark.h"
+#include "vertex.h"
+#include "voronoitissue.h"
+
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QGraphicsScene>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QtMath>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <random>
+
+namespace {
+std::atomic<quint64> g_allocationCount{0};
+std::atomic<quint64> g_allocatedBytes{0};
+
+void countAllocation(std::size_t size)
+{
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+}
+} // namespace
+
+// Allocations are counted through the replaceable operator new, which works
+// with any standard library. Every form is replaced, so none of them mixes
+// with the library's own allocator. Qt containers that call malloc directly
+// are not counted.
+void *operator new(std::size_t size)
+{
+    countAllocation(size);
+    if (void *pointer = std::malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    countAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept
+{
+    return ::operator new(size, tag);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept
+{
+    std::free(pointer);
+}
+
+namespace {
+// Over-aligned types get a malloc block with room to align into; the block
+// itself is kept just before the aligned pointer.
+void *allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+{
+    countAllocation(size);
+    const auto align = static_cast<std::size_t>(alignment);
+    void *block = std::malloc(size + align + sizeof(void *));
+    if (!block)
+        return nullptr;
+    const std::uintptr_t address = (reinterpret_cast<std::uintptr_t>(block) + sizeof(void *) + align - 1)
+                                   & ~static_cast<std::uintptr_t>(align - 1);
+    reinterpret_cast<void **>(address)[-1] = block;
+    return reinterpret_cast<void *>(address);
+}
+
+void freeAligned(void *pointer) noexcept
+{
+    if (pointer)
+        std::free(static_cast<void **>(pointer)[-1]);
+}
+} // namespace
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (void *pointer = allocateAligned(size, alignment))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return ::operator new(size, alignment);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t, const std::nothrow_t &) noexcept
+{
+    freeAligned(pointer);
+}
+
+// Builds fixtures through MainWindow's bulk loader, the path the label-mask
+// import and the Voronoi generator take, so that every entity is registered
+// with the indexes, the validator and the crossing guard exactly as in the
+// app, without the per-entity interactive paths.
+class MainWindowBenchmark
+{
+public:
+    // Square grid of about vertexCount vertices, with its lines and cells,
+    // in raster order.
+    static std::vector<Vertex *> buildGrid(MainWindow &window, int vertexCount)
+    {
+        const int verticesPerSide = std::max(2, static_cast<int>(std::lround(std::sqrt(vertexCount))));
+        const int cellsPerSide = verticesPerSide - 1;
+        constexpr qreal spacing = 10.0;
+        const QRectF area(0.0, 0.0, cellsPerSide * spacing, cellsPerSide * spacing);
+        window.m_scene->setSceneRect(area);
+        window.buildBenchmarkGridMesh(cellsPerSide * cellsPerSide, area);
+        return vertices(window);
+    }
+
+    // A single counter-clockwise polygon with vertexCount corners on a circle.
+    static Polygon *buildRing(MainWindow &window, int vertexCount)
+    {
+        const qreal radius = std::max<qreal>(256.0, vertexCount / 4.0);
+        window.m_scene->setSceneRect(-radius, -radius, 2.0 * radius, 2.0 * radius);
+
+        PlanarMesh mesh;
+        mesh.vertices.reserve(static_cast<std::size_t>(vertexCount));
+        mesh.lines.reserve(static_cast<std::size_t>(vertexCount));
+        for (int i = 0; i < vertexCount; ++i) {
+            const qreal angle = qDegreesToRadians(360.0 * i / vertexCount);
+            mesh.vertices.emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+            mesh.lines.emplace_back(i, (i + 1) % vertexCount);
+        }
+        mesh.faceVertices.resize(static_cast<std::size_t>(vertexCount));
+        std::iota(mesh.faceVertices.begin(), mesh.faceVertices.end(), 0);
+        mesh.faceLines = mesh.faceVertices;
+        mesh.faceOffsets.push_back(vertexCount);
+        window.loadPlanarMesh(mesh);
+        return window.m_polygons.empty() ? nullptr : window.m_polygons.front().get();
+    }
+
+    // Destroys the mesh newest entity first, which QGraphicsScene handles in
+    // constant time per item as long as nothing was removed out of order.
+    static void releaseMesh(MainWindow &window)
+    {
+        while (!window.m_polygons.empty())
+            window.m_polygons.pop_back();
+        while (!window.m_lines.empty())
+            window.m_lines.pop_back();
+        while (!window.m_vertices.empty())
+            window.m_vertices.pop_back();
+        window.clearPolygons();
+        window.clearLines();
+    }
+
+    static std::vector<Vertex *> vertices(const MainWindow &window)
+    {
+        std::vector<Vertex *> result;
+        result.reserve(window.m_vertices.size());
+        for (const auto &vertex : window.m_vertices)
+            result.push_back(vertex.get());
+        return result;
+    }
+
+    static std::vector<Line *> lines(const MainWindow &window)
+    {
+        std::vector<Line *> result;
+        result.reserve(window.m_lines.size());
+        for (const auto &line : window.m_lines)
+            result.push_back(line.get());
+        return result;
+    }
+
+    static Vertex *createVertexWithId(MainWindow &window, int id, const QPointF &position)
+    {
+        return window.createVertexWithId(id, position);
+    }
+
+    static Line *findLineByVertices(const MainWindow &window, Vertex *startVertex, Vertex *endVertex)
+    {
+        return window.findLineByVertices(startVertex, endVertex);
+    }
+
+    static bool orderLinesIntoPolygon(const MainWindow &window,
+                                      const std::vector<Line *> &inputLines,
+                                      std::vector<Line *> &orderedLines,
+                                      std::vector<Vertex *> &orderedVertices)
+    {
+        return window.orderLinesIntoPolygon(inputLines, orderedLines, orderedVertices);
+    }
+
+    static void deleteVertex(MainWindow &window, Vertex *vertex)
+    {
+        window.deleteVertex(vertex);
+    }
+
+    static QJsonObject meshToJson(const MainWindow &window)
+    {
+        return window.meshToJson();
+    }
+
+    static bool loadMeshFromJson(MainWindow &window, const QJsonObject &rootObject, QString *errorString)
+    {
+        return window.loadMeshFromJson(rootObject, errorString);
+    }
+
+};
+
+namespace {
+constexpr quint32 kSeed = 1;
+
+double toMicroseconds(qint64 nanoseconds)
+{
+    return static_cast<double>(nanoseconds) / 1000.0;
+}
+
+struct BenchmarkResult
+{
+    QString operation;
+    int size = 0;
+    bool skipped = false;
+    double predictedMs = 0.0;
+    std::vector<qint64> nanoseconds;
+    quint64 allocations = 0;
+    quint64 bytes = 0;
+
+    double meanNanoseconds() const
+    {
+        return static_cast<double>(std::accumulate(nanoseconds.begin(), nanoseconds.end(), qint64(0)))
+               / static_cast<double>(nanoseconds.size());
+    }
+
+    QJsonObject toJson() const
+    {
+        QJsonObject object;
+        object.insert(QStringLiteral("operation"), operation);
+        object.insert(QStringLiteral("size"), size);
+        if (skipped) {
+            object.insert(QStringLiteral("skipped"), true);
+            object.insert(QStringLiteral("predicted_ms_per_call"), predictedMs);
+            return object;
+        }
+
+        std::vector<qint64> sorted = nanoseconds;
+        std::sort(sorted.begin(), sorted.end());
+        const double count = static_cast<double>(sorted.size());
+        object.insert(QStringLiteral("samples"), static_cast<qint64>(sorted.size()));
+        object.insert(QStringLiteral("mean_us"), meanNanoseconds() / 1000.0);
+        object.insert(QStringLiteral("min_us"), toMicroseconds(sorted.front()));
+        object.insert(QStringLiteral("p50_us"), toMicroseconds(sorted[(sorted.size() - 1) / 2]));
+        object.insert(QStringLiteral("max_us"), toMicroseconds(sorted.back()));
+        object.insert(QStringLiteral("allocations_per_call"), static_cast<double>(allocations) / count);
+        object.insert(QStringLiteral("bytes_per_call"), static_cast<double>(bytes) / count);
+        return object;
+    }
+};
+
+// Times operations call by call within a per-operation budget. Larger sizes
+// are skipped when a quadratic extrapolation from the previous size predicts
+// that a single call would already exceed the budget.
+class BenchmarkRunner
+{
+public:
+    explicit BenchmarkRunner(qint64 budgetMs)
+        : m_budgetNs(budgetMs * 1000000)
+    {
+    }
+
+    bool isAffordable(const QString &operation, int size) const
+    {
+        return predictedNanoseconds(operation, size) <= static_cast<double>(m_budgetNs);
+    }
+
+    void measure(const QString &operation,
+                 int size,
+                 int maximumSamples,
+                 const std::function<void(int)> &call,
+                 const std::function<void(int)> &prepare = {})
+    {
+        BenchmarkResult result;
+        result.operation = operation;
+        result.size = size;
+
+        if (!isAffordable(operation, size)) {
+            result.skipped = true;
+            result.predictedMs = predictedNanoseconds(operation, size) / 1.0e6;
+            report(result);
+            return;
+        }
+
+        qint64 spent = 0;
+        for (int sample = 0; sample < maximumSamples && spent < m_budgetNs; ++sample) {
+            if (prepare)
+                prepare(sample);
+
+            const quint64 allocationsBefore = g_allocationCount.load(std::memory_order_relaxed);
+            const quint64 bytesBefore = g_allocatedBytes.load(std::memory_order_relaxed);
+            QElapsedTimer timer;
+            timer.start();
+            call(sample);
+            const qint64 elapsed = timer.nsecsElapsed();
+            result.allocations += g_allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+            result.bytes += g_allocatedBytes.load(std::memory_order_relaxed) - bytesBefore;
+
+            result.nanoseconds.push_back(elapsed);
+            spent += elapsed;
+        }
+
+        m_lastMeasured[operation] = {size, result.meanNanoseconds()};
+        report(result);
+    }
+
+    QJsonArray results() const
+    {
+        return m_results;
+    }
+
+private:
+    struct Measurement
+    {
+        int size = 0;
+        double meanNanoseconds = 0.0;
+    };
+
+    double predictedNanoseconds(const QString &operation, int size) const
+    {
+        const auto it = m_lastMeasured.find(operation);
+        if (it == m_lastMeasured.end() || it->second.size >= size)
+            return 0.0;
+
+        const double growth = static_cast<double>(size) / it->second.size;
+        return it->second.meanNanoseconds * growth * growth;
+    }
+
+    void report(const BenchmarkResult &result)
+    {
+        QTextStream out(stdout);
+        out << qSetFieldWidth(30) << Qt::left << result.operation << qSetFieldWidth(10) << Qt::right << result.size;
+        if (result.skipped) {
+            out << qSetFieldWidth(0) << "  skipped (predicted " << QString::number(result.predictedMs, 'f', 0)
+                << " ms per call)" << Qt::endl;
+        } else {
+            const double count = static_cast<double>(result.nanoseconds.size());
+            out << qSetFieldWidth(8) << result.nanoseconds.size() << qSetFieldWidth(14)
+                << QString::number(result.meanNanoseconds() / 1000.0, 'f', 1) << qSetFieldWidth(14)
+                << QString::number(static_cast<double>(result.allocations) / count, 'f', 1) << qSetFieldWidth(14)
+                << QString::number(static_cast<double>(result.bytes) / count, 'f', 0) << qSetFieldWidth(0)
+                << Qt::endl;
+        }
+        m_results.append(result.toJson());
+    }
+
+    qint64 m_budgetNs;
+    std::map<QString, Measurement> m_lastMeasured;
+    QJsonArray m_results;
+};
+
+void runGridBenchmarks(BenchmarkRunner &runner, int size)
+{
+    const QStringList operations{QStringLiteral("findLineByVertices"),
+                                 QStringLiteral("exportJson"),
+                                 QStringLiteral("importJson"),
+                                 QStringLiteral("createVertexWithId"),
+                                 QStringLiteral("deleteVertex")};
+    const bool anyAffordable = std::any_of(operations.begin(), operations.end(), [&](const QString &operation) {
+        return runner.isAffordable(operation, size);
+    });
+
+    MainWindow window;
+    std::vector<Vertex *> grid;
+    if (anyAffordable)
+        grid = MainWindowBenchmark::buildGrid(window, size);
+    const std::vector<Line *> lines = MainWindowBenchmark::lines(window);
+    std::mt19937 generator(kSeed);
+
+    runner.measure(QStringLiteral("findLineByVertices"), size, 1000, [&](int sample) {
+        const Line *line = lines[std::uniform_int_distribution<std::size_t>(0, lines.size() - 1)(generator)];
+        if (sample % 2 == 0)
+            MainWindowBenchmark::findLineByVertices(window, line->startVertex(), line->endVertex());
+        else
+            MainWindowBenchmark::findLineByVertices(window, line->endVertex(), line->startVertex());
+    });
+
+    QByteArray json;
+    runner.measure(QStringLiteral("exportJson"), size, 5, [&](int) {
+        json = QJsonDocument(MainWindowBenchmark::meshToJson(window)).toJson(QJsonDocument::Compact);
+    });
+
+    // Imports into an empty window, as File > Import does on a fresh canvas.
+    if (json.isEmpty() && runner.isAffordable(QStringLiteral("importJson"), size))
+        json = QJsonDocument(MainWindowBenchmark::meshToJson(window)).toJson(QJsonDocument::Compact);
+
+    std::unique_ptr<MainWindow> target;
+    const auto releaseTarget = [&target] {
+        if (target)
+            MainWindowBenchmark::releaseMesh(*target);
+        target.reset();
+    };
+    runner.measure(
+        QStringLiteral("importJson"),
+        size,
+        3,
+        [&](int) {
+            QString errorString;
+            MainWindowBenchmark::loadMeshFromJson(*target, QJsonDocument::fromJson(json).object(), &errorString);
+        },
+        [&](int) {
+            releaseTarget();
+            target = std::make_unique<MainWindow>();
+        });
+    releaseTarget();
+
+    int nextId = static_cast<int>(grid.size());
+    runner.measure(QStringLiteral("createVertexWithId"), size, 200, [&](int sample) {
+        MainWindowBenchmark::createVertexWithId(window, nextId++, QPointF(-10.0 - sample, -10.0));
+    });
+
+    // Each deletion cascades to the (up to) four cells and lines around the
+    // vertex; grid vertices are picked without repetition.
+    runner.measure(QStringLiteral("deleteVertex"), size, 50, [&](int) {
+        const std::size_t index = std::uniform_int_distribution<std::size_t>(0, grid.size() - 1)(generator);
+        Vertex *vertex = grid[index];
+        grid[index] = grid.back();
+        grid.pop_back();
+        MainWindowBenchmark::deleteVertex(window, vertex);
+    });
+
+    MainWindowBenchmark::releaseMesh(window);
+}
+
+void runRingBenchmarks(BenchmarkRunner &runner, int size)
+{
+    const QStringList operations{QStringLiteral("orderLinesIntoPolygon"),
+                                 QStringLiteral("sortVerticesCounterClockwise"),
+                                 QStringLiteral("Polygon::updateShape")};
+    const bool anyAffordable = std::any_of(operations.begin(), operations.end(), [&](const QString &operation) {
+        return runner.isAffordable(operation, size);
+    });
+
+    MainWindow window;
+    Polygon *polygon = anyAffordable ? MainWindowBenchmark::buildRing(window, size) : nullptr;
+    std::mt19937 generator(kSeed);
+
+    std::vector<Line *> shuffledLines = polygon ? polygon->lines() : std::vector<Line *>();
+    std::shuffle(shuffledLines.begin(), shuffledLines.end(), generator);
+    runner.measure(QStringLiteral("orderLinesIntoPolygon"), size, 10, [&](int) {
+        std::vector<Line *> orderedLines;
+        std::vector<Vertex *> orderedVertices;
+        MainWindowBenchmark::orderLinesIntoPolygon(window, shuffledLines, orderedLines, orderedVertices);
+    });
+
+    std::vector<Vertex *> shuffledVertices = polygon ? polygon->vertices() : std::vector<Vertex *>();
+    std::shuffle(shuffledVertices.begin(), shuffledVertices.end(), generator);
+    runner.measure(QStringLiteral("sortVerticesCounterClockwise"), size, 10, [&](int) {
+        sortVerticesCounterClockwise(shuffledVertices);
+    });
+
+    runner.measure(QStringLiteral("Polygon::updateShape"), size, 20, [&](int) { polygon->updateShape(); });
+
+    MainWindowBenchmark::releaseMesh(window);
+}
+
+// Model-free: size is the number of Voronoi cells whose faces are rebuilt
+// from the vertices and lines alone.
+void runFaceExtractionBenchmarks(BenchmarkRunner &runner, int size)
+{
+    PlanarMesh mesh;
+    if (runner.isAffordable(QStringLiteral("extractFaces"), size)) {
+        VoronoiTissueOptions options;
+        options.cellCount = size;
+        options.area = QRectF(0.0, 0.0, 10000.0, 10000.0);
+        options.seed = kSeed;
+        mesh = generateVoronoiTissue(options);
+    }
+    runner.measure(QStringLiteral("extractFaces"), size, 10, [&](int) { extractFaces(mesh); });
+}
+
+bool parseSizes(const QString &value, std::vector<int> *sizes)
+{
+    sizes->clear();
+    for (const QString &part : value.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int size = part.trimmed().toInt(&ok);
+        if (!ok || size < 3)
+            return false;
+        sizes->push_back(size);
+    }
+    std::sort(sizes->begin(), sizes->end());
+    return !sizes->empty();
+}
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Microbenchmarks for the mesh hot paths."));
+    parser.addHelpOption();
+    const QCommandLineOption sizesOption(QStringLiteral("sizes"),
+                                         QStringLiteral("Comma-separated entity counts."),
+                                         QStringLiteral("list"),
+                                         QStringLiteral("1000,10000,100000,1000000"));
+    const QCommandLineOption budgetOption(QStringLiteral("budget-ms"),
+                                          QStringLiteral("Time budget per operation and size."),
+                                          QStringLiteral("ms"),
+                                          QStringLiteral("5000"));
+    const QCommandLineOption jsonOption(QStringLiteral("json"),
+                                        QStringLiteral("Also write the results as JSON to <path>."),
+                                        QStringLiteral("path"));
+    parser.addOption(sizesOption);
+    parser.addOption(budgetOption);
+    parser.addOption(jsonOption);
+    parser.process(app);
+
+    std::vector<int> sizes;
+    if (!parseSizes(parser.value(sizesOption), &sizes)) {
+        QTextStream(stderr) << "--sizes expects a comma-separated list of integers >= 3" << Qt::endl;
+        return 2;
+    }
+    bool budgetOk = false;
+    const qint64 budgetMs = parser.value(budgetOption).toLongLong(&budgetOk);
+    if (!budgetOk || budgetMs <= 0) {
+        QTextStream(stderr) << "--budget-ms expects a positive integer" << Qt::endl;
+        return 2;
+    }
+
+    QTextStream(stdout) << qSetFieldWidth(30) << Qt::left << "operation" << qSetFieldWidth(10) << Qt::right << "size"
+                        << qSetFieldWidth(8) << "calls" << qSetFieldWidth(14) << "mean us" << qSetFieldWidth(14)
+                        << "allocs/call" << qSetFieldWidth(14) << "bytes/call" << qSetFieldWidth(0) << Qt::endl;
+
+    BenchmarkRunner runner(budgetMs);
+    for (int size : sizes) {
+        runGridBenchmarks(runner, size);
+        runRingBenchmarks(runner, size);
+        runFaceExtractionBenchmarks(runner, size);
+    }
+
+    const QString jsonPath = parser.value(jsonOption);
+    if (jsonPath.isEmpty())
+        return 0;
+
+    QJsonObject report;
+    report.insert(QStringLiteral("benchmark"), QStringLiteral("microbenchmarks"));
+    report.insert(QStringLiteral("qt_version"), QString::fromLatin1(qVersion()));
+    report.insert(QStringLiteral("budget_ms"), budgetMs);
+#if defined(__GLIBC__)
+    report.insert(QStringLiteral("allocations"), QStringLiteral("malloc"));
+#else
+    report.insert(QStringLiteral("allocations"), QStringLiteral("operator new"));
+#endif
+    report.insert(QStringLiteral("results"), runner.results());
+
+    QString errorString;
+    if (!writeStressBenchmarkReport(report, jsonPath, &errorString)) {
+        QTextStream(stderr) << "Cannot write benchmark report: " << errorString << Qt::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,13 @@
+QT       += core gui concurrent widgets
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = microbenchmarks
+
+INCLUDEPATH += $$PWD/..
+
+include(../polygons_on_white_canvas2.pri)
+
+SOURCES += \
+    microbenchmarks.cpp
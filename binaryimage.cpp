@@ -0,0 +1,130 @@
+#include "binaryimage.h"
+
+#include <QImage>
+#include <QtAlgorithms>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+constexpr int kLuminanceThreshold = 128;
+} // namespace
+
+BinaryImage::BinaryImage(int width, int height)
+    : m_width(std::max(0, width))
+    , m_height(std::max(0, height))
+    , m_wordsPerRow((m_width + 63) / 64)
+    , m_words(static_cast<std::size_t>(m_wordsPerRow) * m_height, 0)
+{
+}
+
+BinaryImage BinaryImage::fromContourImage(const QImage &image)
+{
+    if (image.isNull())
+        return BinaryImage();
+
+    // Scan lines of the 32-bit formats are read directly; anything else is
+    // converted to 8-bit grey first.
+    QImage source = image;
+    const bool rgb = source.format() == QImage::Format_RGB32 || source.format() == QImage::Format_ARGB32
+                     || source.format() == QImage::Format_ARGB32_Premultiplied;
+    if (!rgb && source.format() != QImage::Format_Grayscale8)
+        source = source.convertToFormat(QImage::Format_Grayscale8);
+
+    BinaryImage result(source.width(), source.height());
+    std::vector<int> rows(static_cast<std::size_t>(result.m_height));
+    std::iota(rows.begin(), rows.end(), 0);
+    std::vector<qint64> brightCounts(rows.size(), 0);
+
+    QtConcurrent::blockingMap(rows, [&](const int &y) {
+        quint64 *words = result.row(y);
+        qint64 bright = 0;
+        if (rgb) {
+            const auto *pixels = reinterpret_cast<const QRgb *>(source.constScanLine(y));
+            for (int x = 0; x < result.m_width; ++x) {
+                if (qGray(pixels[x]) >= kLuminanceThreshold)
+                    words[x / 64] |= quint64(1) << (x % 64);
+            }
+        } else {
+            const uchar *pixels = source.constScanLine(y);
+            for (int x = 0; x < result.m_width; ++x) {
+                if (pixels[x] >= kLuminanceThreshold)
+                    words[x / 64] |= quint64(1) << (x % 64);
+            }
+        }
+        for (int w = 0; w < result.m_wordsPerRow; ++w)
+            bright += qPopulationCount(words[w]);
+        brightCounts[static_cast<std::size_t>(y)] = bright;
+    });
+
+    const qint64 bright = std::accumulate(brightCounts.begin(), brightCounts.end(), qint64(0));
+    if (2 * bright > static_cast<qint64>(result.m_width) * result.m_height) {
+        const quint64 lastMask = lastWordMask(result.m_width);
+        QtConcurrent::blockingMap(rows, [&](const int &y) {
+            quint64 *words = result.row(y);
+            for (int w = 0; w < result.m_wordsPerRow; ++w)
+                words[w] = ~words[w];
+            words[result.m_wordsPerRow - 1] &= lastMask;
+        });
+    }
+
+    return result;
+}
+
+bool BinaryImage::isNull() const
+{
+    return m_width == 0 || m_height == 0;
+}
+
+int BinaryImage::width() const
+{
+    return m_width;
+}
+
+int BinaryImage::height() const
+{
+    return m_height;
+}
+
+int BinaryImage::wordsPerRow() const
+{
+    return m_wordsPerRow;
+}
+
+bool BinaryImage::pixel(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+        return false;
+    return (row(y)[x / 64] >> (x % 64)) & 1;
+}
+
+void BinaryImage::setPixel(int x, int y, bool on)
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+        return;
+
+    const quint64 bit = quint64(1) << (x % 64);
+    if (on)
+        row(y)[x / 64] |= bit;
+    else
+        row(y)[x / 64] &= ~bit;
+}
+
+quint64 *BinaryImage::row(int y)
+{
+    return m_words.data() + static_cast<std::size_t>(y) * m_wordsPerRow;
+}
+
+const quint64 *BinaryImage::row(int y) const
+{
+    return m_words.data() + static_cast<std::size_t>(y) * m_wordsPerRow;
+}
+
+qint64 BinaryImage::count() const
+{
+    qint64 total = 0;
+    for (quint64 word : m_words)
+        total += qPopulationCount(word);
+    return total;
+}
@@ -0,0 +1,48 @@
+#ifndef BINARYIMAGE_H
+#define BINARYIMAGE_H
+
+#include <QtGlobal>
+
+#include <vector>
+
+class QImage;
+
+// Bit-packed binary image: pixel (x, y) is bit x % 64 of row(y)[x / 64].
+// Bits past the right edge of a row are always clear, so whole words can be
+// combined and tested without masking.
+class BinaryImage
+{
+public:
+    BinaryImage() = default;
+    BinaryImage(int width, int height);
+
+    // Thresholds luminance at 128 and keeps the minority class as foreground,
+    // so both dark-on-light and light-on-dark contour drawings work.
+    static BinaryImage fromContourImage(const QImage &image);
+
+    bool isNull() const;
+    int width() const;
+    int height() const;
+    int wordsPerRow() const;
+
+    bool pixel(int x, int y) const;
+    void setPixel(int x, int y, bool on);
+    quint64 *row(int y);
+    const quint64 *row(int y) const;
+    qint64 count() const;
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    int m_wordsPerRow = 0;
+    std::vector<quint64> m_words;
+};
+
+// The bits of the last word of a row that lie within width pixels.
+inline quint64 lastWordMask(int width)
+{
+    const int usedBits = width % 64;
+    return usedBits == 0 ? ~quint64(0) : (quint64(1) << usedBits) - 1;
+}
+
+#endif // BINARYIMAGE_H
@@ -0,0 +1,440 @@
+#include "contourpreprocessor.h"
+
+#include "stripes.h"
+
+#include <QImage>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+// Grey pixels of type T, either the scan lines of a QImage or a plane
+// filtered from one.
+template<typename T>
+struct GreyView
+{
+    const uchar *bits = nullptr;
+    qsizetype bytesPerLine = 0;
+    int width = 0;
+    int height = 0;
+
+    const T *row(int y) const { return reinterpret_cast<const T *>(bits + y * bytesPerLine); }
+};
+
+template<typename T>
+struct GreyPlane
+{
+    GreyPlane(int width, int height)
+        : width(width)
+        , height(height)
+        , pixels(static_cast<std::size_t>(width) * height)
+    {
+    }
+
+    T *row(int y) { return pixels.data() + static_cast<std::size_t>(y) * width; }
+    GreyView<T> view() const
+    {
+        return GreyView<T>{reinterpret_cast<const uchar *>(pixels.data()),
+                           static_cast<qsizetype>(width * sizeof(T)),
+                           width,
+                           height};
+    }
+
+    int width;
+    int height;
+    std::vector<T> pixels;
+};
+
+// Copies row y (clamped into the image) with radius replicated pixels on
+// either side.
+template<typename T, typename U>
+void loadPaddedRow(const GreyView<T> &source, int y, int radius, U *padded)
+{
+    const T *row = source.row(std::clamp(y, 0, source.height - 1));
+    std::fill(padded, padded + radius, static_cast<U>(row[0]));
+    std::copy(row, row + source.width, padded + radius);
+    std::fill(padded + radius + source.width, padded + 2 * radius + source.width, static_cast<U>(row[source.width - 1]));
+}
+
+// Separable Gaussian in float: each stripe blurs the rows it needs
+// horizontally, then sums them vertically.
+template<typename T>
+GreyPlane<T> gaussianBlur(const GreyView<T> &source, qreal sigma)
+{
+    const int radius = std::max(1, static_cast<int>(std::ceil(3.0 * sigma)));
+    std::vector<float> weights(static_cast<std::size_t>(2 * radius + 1));
+    for (int k = -radius; k <= radius; ++k)
+        weights[static_cast<std::size_t>(k + radius)] = static_cast<float>(std::exp(-0.5 * k * k / (sigma * sigma)));
+    const float total = std::accumulate(weights.begin(), weights.end(), 0.0f);
+    for (float &weight : weights)
+        weight /= total;
+
+    const int width = source.width;
+    GreyPlane<T> result(width, source.height);
+    std::vector<Stripe> stripes = makeStripes(source.height);
+    QtConcurrent::blockingMap(stripes, [&](Stripe &stripe) {
+        const int top = stripe.first - radius;
+        const int rowCount = stripe.end - stripe.first + 2 * radius;
+        std::vector<float> padded(static_cast<std::size_t>(width + 2 * radius));
+        std::vector<float> horizontal(static_cast<std::size_t>(rowCount) * width);
+        for (int i = 0; i < rowCount; ++i) {
+            loadPaddedRow(source, top + i, radius, padded.data());
+            float *output = horizontal.data() + static_cast<std::size_t>(i) * width;
+            for (int k = 0; k <= 2 * radius; ++k) {
+                const float weight = weights[static_cast<std::size_t>(k)];
+                const float *input = padded.data() + k;
+                for (int x = 0; x < width; ++x)
+                    output[x] += weight * input[x];
+            }
+        }
+
+        std::vector<float> sums(static_cast<std::size_t>(width));
+        for (int y = stripe.first; y < stripe.end; ++y) {
+            std::fill(sums.begin(), sums.end(), 0.0f);
+            for (int k = 0; k <= 2 * radius; ++k) {
+                const float weight = weights[static_cast<std::size_t>(k)];
+                const float *input = horizontal.data() + static_cast<std::size_t>(y - stripe.first + k) * width;
+                for (int x = 0; x < width; ++x)
+                    sums[static_cast<std::size_t>(x)] += weight * input[x];
+            }
+            T *output = result.row(y);
+            for (int x = 0; x < width; ++x)
+                output[x] = static_cast<T>(std::min(sums[static_cast<std::size_t>(x)] + 0.5f,
+                                                    static_cast<float>(std::numeric_limits<T>::max())));
+        }
+    });
+    return result;
+}
+
+// 3x3 median with the 19 compare-exchange network of Paeth, applied to a
+// whole row at once so that each step is a vector min/max.
+template<typename T>
+GreyPlane<T> medianBlur3x3(const GreyView<T> &source)
+{
+    const int width = source.width;
+    GreyPlane<T> result(width, source.height);
+    std::vector<Stripe> stripes = makeStripes(source.height);
+    QtConcurrent::blockingMap(stripes, [&](Stripe &stripe) {
+        std::vector<T> padded(static_cast<std::size_t>(3 * (width + 2)));
+        for (int y = stripe.first; y < stripe.end; ++y) {
+            for (int dy = 0; dy < 3; ++dy)
+                loadPaddedRow(source, y + dy - 1, 1, padded.data() + dy * (width + 2));
+
+            // Paeth's 19 compare-exchanges, done branch-free on locals so
+            // that the loop over x vectorizes.
+            const T *above = padded.data();
+            const T *middle = above + (width + 2);
+            const T *below = middle + (width + 2);
+            T *output = result.row(y);
+            for (int x = 0; x < width; ++x) {
+                T p[9] = {above[x], above[x + 1], above[x + 2],
+                          middle[x], middle[x + 1], middle[x + 2],
+                          below[x], below[x + 1], below[x + 2]};
+                const auto sort = [&p](int a, int b) {
+                    const T first = p[a];
+                    const T second = p[b];
+                    p[a] = first < second ? first : second;
+                    p[b] = first < second ? second : first;
+                };
+                sort(1, 2), sort(4, 5), sort(7, 8);
+                sort(0, 1), sort(3, 4), sort(6, 7);
+                sort(1, 2), sort(4, 5), sort(7, 8);
+                sort(0, 3), sort(5, 8), sort(4, 7);
+                sort(3, 6), sort(1, 4), sort(2, 5);
+                sort(4, 7), sort(4, 2), sort(6, 4);
+                sort(4, 2);
+                output[x] = p[4];
+            }
+        }
+    });
+    return result;
+}
+
+struct OtsuResult
+{
+    // Pixels above threshold are on the bright side.
+    int threshold = 0;
+    // Whether the bright side is the majority, i.e. the contours are dark.
+    bool darkContours = true;
+};
+
+template<typename T>
+OtsuResult otsuThreshold(const GreyView<T> &grey)
+{
+    constexpr int kLevels = std::numeric_limits<T>::max() + 1;
+
+    // One histogram per core; 16-bit histograms are too large for more.
+    std::vector<Stripe> stripes = makeStripes(grey.height, 1);
+    std::vector<std::vector<quint32>> histograms(stripes.size());
+    std::vector<int> stripeIndices(stripes.size());
+    std::iota(stripeIndices.begin(), stripeIndices.end(), 0);
+    QtConcurrent::blockingMap(stripeIndices, [&](const int &index) {
+        std::vector<quint32> &histogram = histograms[static_cast<std::size_t>(index)];
+        histogram.assign(kLevels, 0);
+        const Stripe &stripe = stripes[static_cast<std::size_t>(index)];
+        for (int y = stripe.first; y < stripe.end; ++y) {
+            const T *pixels = grey.row(y);
+            for (int x = 0; x < grey.width; ++x)
+                ++histogram[pixels[x]];
+        }
+    });
+
+    std::vector<double> counts(kLevels, 0.0);
+    for (const std::vector<quint32> &histogram : histograms) {
+        for (int level = 0; level < kLevels; ++level)
+            counts[static_cast<std::size_t>(level)] += histogram[static_cast<std::size_t>(level)];
+    }
+
+    double total = 0.0;
+    double weightedTotal = 0.0;
+    for (int level = 0; level < kLevels; ++level) {
+        total += counts[static_cast<std::size_t>(level)];
+        weightedTotal += level * counts[static_cast<std::size_t>(level)];
+    }
+
+    // Maximizes the between-class variance w0 w1 (m0 - m1)^2.
+    OtsuResult result;
+    double below = 0.0;
+    double weightedBelow = 0.0;
+    double bestVariance = -1.0;
+    double belowAtBest = 0.0;
+    for (int level = 0; level + 1 < kLevels; ++level) {
+        below += counts[static_cast<std::size_t>(level)];
+        weightedBelow += level * counts[static_cast<std::size_t>(level)];
+        const double above = total - below;
+        if (below == 0.0 || above == 0.0)
+            continue;
+        const double meanDifference = weightedBelow / below - (weightedTotal - weightedBelow) / above;
+        const double variance = below * above * meanDifference * meanDifference;
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            belowAtBest = below;
+            result.threshold = level;
+        }
+    }
+    result.darkContours = 2.0 * (total - belowAtBest) > total;
+    return result;
+}
+
+// Packs 64 comparisons at a time; the contour side becomes foreground.
+template<typename T>
+BinaryImage thresholdGlobal(const GreyView<T> &grey, const OtsuResult &otsu)
+{
+    BinaryImage result(grey.width, grey.height);
+    const T threshold = static_cast<T>(otsu.threshold);
+    const quint64 lastMask = lastWordMask(grey.width);
+    std::vector<Stripe> stripes = makeStripes(grey.height);
+    QtConcurrent::blockingMap(stripes, [&](Stripe &stripe) {
+        for (int y = stripe.first; y < stripe.end; ++y) {
+            const T *pixels = grey.row(y);
+            quint64 *words = result.row(y);
+            for (int w = 0; w < result.wordsPerRow(); ++w) {
+                const int begin = w * 64;
+                const int count = std::min(64, grey.width - begin);
+                quint64 bright = 0;
+                for (int b = 0; b < count; ++b)
+                    bright |= quint64(pixels[begin + b] > threshold) << b;
+                words[w] = otsu.darkContours ? ~bright : bright;
+            }
+            words[result.wordsPerRow() - 1] &= lastMask;
+        }
+    });
+    return result;
+}
+
+// Compares each pixel with the mean of its window. Each stripe keeps running
+// column sums over the window rows and takes the window sums from their
+// prefix sums, so the cost per pixel does not depend on the radius.
+template<typename T>
+BinaryImage thresholdAdaptive(const GreyView<T> &grey, int radius, qreal offset, bool darkContours)
+{
+    BinaryImage result(grey.width, grey.height);
+    const int width = grey.width;
+    const int height = grey.height;
+    const double scaledOffset = offset * std::numeric_limits<T>::max();
+    std::vector<Stripe> stripes = makeStripes(height);
+    QtConcurrent::blockingMap(stripes, [&](Stripe &stripe) {
+        std::vector<quint32> columnSums(static_cast<std::size_t>(width), 0);
+        std::vector<quint64> prefix(static_cast<std::size_t>(width) + 1, 0);
+        const auto addRow = [&](int y, int sign) {
+            const T *pixels = grey.row(y);
+            for (int x = 0; x < width; ++x)
+                columnSums[static_cast<std::size_t>(x)] += static_cast<quint32>(sign * pixels[x]);
+        };
+
+        for (int y = std::max(0, stripe.first - radius); y <= std::min(height - 1, stripe.first + radius); ++y)
+            addRow(y, 1);
+
+        for (int y = stripe.first; y < stripe.end; ++y) {
+            if (y > stripe.first) {
+                if (y + radius < height)
+                    addRow(y + radius, 1);
+                if (y - radius - 1 >= 0)
+                    addRow(y - radius - 1, -1);
+            }
+            const int windowRows = std::min(height - 1, y + radius) - std::max(0, y - radius) + 1;
+            std::partial_sum(columnSums.begin(), columnSums.end(), prefix.begin() + 1);
+
+            const T *pixels = grey.row(y);
+            quint64 *words = result.row(y);
+            for (int x = 0; x < width; ++x) {
+                const int left = std::max(0, x - radius);
+                const int right = std::min(width, x + radius + 1);
+                const double mean = static_cast<double>(prefix[static_cast<std::size_t>(right)]
+                                                        - prefix[static_cast<std::size_t>(left)])
+                                    / (static_cast<double>(windowRows) * (right - left));
+                const double value = pixels[x];
+                const bool contour = darkContours ? value < mean - scaledOffset : value > mean + scaledOffset;
+                words[x / 64] |= quint64(contour) << (x % 64);
+            }
+        }
+    });
+    return result;
+}
+
+// Half-widths of the element's rows, for dy = -radius .. radius.
+std::vector<int> elementRows(StructuringElement element, int radius)
+{
+    std::vector<int> rows(static_cast<std::size_t>(2 * radius + 1));
+    for (int dy = -radius; dy <= radius; ++dy) {
+        int halfWidth = radius;
+        if (element == StructuringElement::Cross)
+            halfWidth = dy == 0 ? radius : 0;
+        else if (element == StructuringElement::Disk)
+            halfWidth = static_cast<int>(std::floor(std::sqrt(static_cast<double>(radius * radius - dy * dy)) + 1e-9));
+        rows[static_cast<std::size_t>(dy + radius)] = halfWidth;
+    }
+    return rows;
+}
+
+// output pixel x = input pixel x - shift; pixels from outside the row,
+// including the padding bits of the last word, read as fill.
+void shiftRow(const quint64 *input, int wordsPerRow, quint64 lastMask, int shift, bool fill, quint64 *output)
+{
+    const quint64 fillWord = fill ? ~quint64(0) : 0;
+    const auto word = [&](int w) {
+        if (w < 0 || w >= wordsPerRow)
+            return fillWord;
+        return w == wordsPerRow - 1 ? (input[w] & lastMask) | (fillWord & ~lastMask) : input[w];
+    };
+
+    const int wordShift = shift >= 0 ? shift / 64 : -((-shift + 63) / 64);
+    const int bitShift = shift - wordShift * 64;
+    for (int w = 0; w < wordsPerRow; ++w) {
+        const quint64 current = word(w - wordShift);
+        output[w] = bitShift == 0 ? current : (current << bitShift) | (word(w - wordShift - 1) >> (64 - bitShift));
+    }
+}
+
+// Dilates (or erodes) a row horizontally by halfWidth, doubling the covered
+// span with each pass.
+void spreadRow(const quint64 *input,
+               int wordsPerRow,
+               quint64 lastMask,
+               int halfWidth,
+               bool erosion,
+               quint64 *output,
+               quint64 *left,
+               quint64 *right)
+{
+    std::copy(input, input + wordsPerRow, output);
+    for (int span = 0; span < halfWidth;) {
+        const int step = std::min(span + 1, halfWidth - span);
+        shiftRow(output, wordsPerRow, lastMask, step, erosion, left);
+        shiftRow(output, wordsPerRow, lastMask, -step, erosion, right);
+        for (int w = 0; w < wordsPerRow; ++w)
+            output[w] = erosion ? output[w] & left[w] & right[w] : output[w] | left[w] | right[w];
+        span += step;
+    }
+}
+
+BinaryImage morphology(const BinaryImage &image, StructuringElement element, int radius, bool erosion)
+{
+    if (image.isNull() || radius <= 0)
+        return image;
+
+    const int wordsPerRow = image.wordsPerRow();
+    const int height = image.height();
+    const quint64 lastMask = lastWordMask(image.width());
+    const std::vector<int> rows = elementRows(element, radius);
+    BinaryImage result(image.width(), height);
+
+    std::vector<Stripe> stripes = makeStripes(height);
+    QtConcurrent::blockingMap(stripes, [&](Stripe &stripe) {
+        std::vector<quint64> buffers(static_cast<std::size_t>(3 * wordsPerRow));
+        quint64 *spread = buffers.data();
+        quint64 *left = spread + wordsPerRow;
+        quint64 *right = left + wordsPerRow;
+        for (int y = stripe.first; y < stripe.end; ++y) {
+            quint64 *output = result.row(y);
+            std::fill(output, output + wordsPerRow, erosion ? ~quint64(0) : 0);
+            for (int dy = -radius; dy <= radius; ++dy) {
+                // Rows outside the image are all fill, which changes nothing.
+                if (y + dy < 0 || y + dy >= height)
+                    continue;
+                spreadRow(image.row(y + dy), wordsPerRow, lastMask, rows[static_cast<std::size_t>(dy + radius)], erosion,
+                          spread, left, right);
+                for (int w = 0; w < wordsPerRow; ++w)
+                    output[w] = erosion ? output[w] & spread[w] : output[w] | spread[w];
+            }
+            output[wordsPerRow - 1] &= lastMask;
+        }
+    });
+    return result;
+}
+
+template<typename T>
+BinaryImage preprocess(const GreyView<T> &source, const ContourPreprocessOptions &options)
+{
+    GreyPlane<T> filtered(0, 0);
+    GreyView<T> grey = source;
+    if (options.denoising == ContourDenoising::Gaussian && options.gaussianSigma > 0.0) {
+        filtered = gaussianBlur(source, options.gaussianSigma);
+        grey = filtered.view();
+    } else if (options.denoising == ContourDenoising::Median) {
+        filtered = medianBlur3x3(source);
+        grey = filtered.view();
+    }
+
+    const OtsuResult otsu = otsuThreshold(grey);
+    BinaryImage mask = options.thresholding == ContourThresholding::Adaptive
+                           ? thresholdAdaptive(grey, std::max(1, options.adaptiveRadius), options.adaptiveOffset,
+                                               otsu.darkContours)
+                           : thresholdGlobal(grey, otsu);
+
+    if (options.openingRadius > 0)
+        mask = dilate(erode(mask, options.element, options.openingRadius), options.element, options.openingRadius);
+    if (options.closingRadius > 0)
+        mask = erode(dilate(mask, options.element, options.closingRadius), options.element, options.closingRadius);
+    return mask;
+}
+} // namespace
+
+BinaryImage preprocessContourImage(const QImage &image, const ContourPreprocessOptions &options)
+{
+    if (image.isNull())
+        return BinaryImage();
+
+    QImage grey = image;
+    if (grey.format() != QImage::Format_Grayscale8 && grey.format() != QImage::Format_Grayscale16)
+        grey = grey.convertToFormat(grey.depth() > 32 ? QImage::Format_Grayscale16 : QImage::Format_Grayscale8);
+
+    if (grey.format() == QImage::Format_Grayscale16) {
+        return preprocess(GreyView<quint16>{grey.constBits(), grey.bytesPerLine(), grey.width(), grey.height()},
+                          options);
+    }
+    return preprocess(GreyView<quint8>{grey.constBits(), grey.bytesPerLine(), grey.width(), grey.height()}, options);
+}
+
+BinaryImage dilate(const BinaryImage &image, StructuringElement element, int radius)
+{
+    return morphology(image, element, radius, false);
+}
+
+BinaryImage erode(const BinaryImage &image, StructuringElement element, int radius)
+{
+    return morphology(image, element, radius, true);
+}
@@ -0,0 +1,72 @@
+#ifndef CONTOURPREPROCESSOR_H
+#define CONTOURPREPROCESSOR_H
+
+#include "binaryimage.h"
+
+#include <QtGlobal>
+
+class QImage;
+
+enum class ContourDenoising
+{
+    None,
+    Gaussian,
+    Median,
+};
+
+enum class ContourThresholding
+{
+    // One threshold for the whole image, chosen by Otsu's method.
+    Otsu,
+    // Each pixel against the mean of the window around it, which follows
+    // uneven illumination.
+    Adaptive,
+};
+
+enum class StructuringElement
+{
+    Square,
+    Disk,
+    Cross,
+};
+
+struct ContourPreprocessOptions
+{
+    ContourDenoising denoising = ContourDenoising::Gaussian;
+    // Standard deviation of the Gaussian, in pixels. The median is 3x3.
+    qreal gaussianSigma = 1.0;
+
+    ContourThresholding thresholding = ContourThresholding::Otsu;
+    // The adaptive window is 2 * adaptiveRadius + 1 pixels wide.
+    int adaptiveRadius = 15;
+    // How far a pixel has to be from its local mean, towards the contour
+    // side, as a fraction of full scale.
+    qreal adaptiveOffset = 0.02;
+
+    // Opening removes specks narrower than the element, closing then bridges
+    // gaps in the contours; a radius of 0 skips the step.
+    StructuringElement element = StructuringElement::Disk;
+    int openingRadius = 0;
+    int closingRadius = 0;
+};
+
+// Turns a contour image into a contour mask for thinToSkeleton: grey
+// conversion, denoising, thresholding and binary open/close. 8- and 16-bit
+// grey images are read straight from their scan lines and keep their full
+// depth; other formats are converted to whichever of the two holds them. As
+// in BinaryImage::fromContourImage, the contours are the minority side of the
+// Otsu threshold, so both dark and light contours work.
+//
+// The filters run over row stripes on all cores, with inner loops over
+// contiguous rows that the compiler vectorizes; the morphology works on 64
+// packed pixels at a time.
+BinaryImage preprocessContourImage(const QImage &image, const ContourPreprocessOptions &options);
+
+// Binary dilation and erosion by the element of the given radius (a
+// (2 radius + 1) wide square, disk or cross). Pixels outside the image count
+// as background for dilation and as foreground for erosion, so neither grows
+// nor eats into the border.
+BinaryImage dilate(const BinaryImage &image, StructuringElement element, int radius);
+BinaryImage erode(const BinaryImage &image, StructuringElement element, int radius);
+
+#endif // CONTOURPREPROCESSOR_H
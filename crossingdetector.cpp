@@ -0,0 +1,276 @@
+#include "crossingdetector.h"
+
+#include "linespatialindex.h"
+
+#include <QPromise>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+// Keeps the grid (and the per-cell segment lists) bounded for meshes with
+// very long lines or extreme aspect ratios.
+constexpr int kMaximumCellsPerAxis = 4096;
+// Progress reported once the segments have been binned into the grid.
+constexpr int kBinnedProgress = 10;
+
+struct SegmentBounds
+{
+    qreal left = 0.0;
+    qreal top = 0.0;
+    qreal right = 0.0;
+    qreal bottom = 0.0;
+};
+
+class CrossingGrid
+{
+public:
+    explicit CrossingGrid(const std::vector<CrossingSegment> &segments)
+    {
+        m_bounds.reserve(segments.size());
+        qreal left = segments.front().segment.x1();
+        qreal top = segments.front().segment.y1();
+        qreal right = left;
+        qreal bottom = top;
+        qreal totalExtent = 0.0;
+
+        for (const CrossingSegment &segment : segments) {
+            const QLineF &line = segment.segment;
+            SegmentBounds bounds{std::min(line.x1(), line.x2()),
+                                 std::min(line.y1(), line.y2()),
+                                 std::max(line.x1(), line.x2()),
+                                 std::max(line.y1(), line.y2())};
+            left = std::min(left, bounds.left);
+            top = std::min(top, bounds.top);
+            right = std::max(right, bounds.right);
+            bottom = std::max(bottom, bounds.bottom);
+            totalExtent += std::max(bounds.right - bounds.left, bounds.bottom - bounds.top);
+            m_bounds.push_back(bounds);
+        }
+
+        // Aim for about one segment per cell, but never make cells much
+        // smaller than a typical segment, or every segment spans many cells.
+        const qreal width = right - left;
+        const qreal height = bottom - top;
+        const qreal area = std::max<qreal>(width * height, 1.0);
+        const qreal averageExtent = totalExtent / static_cast<qreal>(segments.size());
+        const qreal cellsWanted = static_cast<qreal>(segments.size());
+        m_cellSize = std::max({std::sqrt(area / cellsWanted),
+                               averageExtent,
+                               std::max(width, height) / kMaximumCellsPerAxis,
+                               qreal(1e-9)});
+        m_left = left;
+        m_top = top;
+        m_columns = std::clamp(static_cast<int>(width / m_cellSize) + 1, 1, kMaximumCellsPerAxis);
+        m_rows = std::clamp(static_cast<int>(height / m_cellSize) + 1, 1, kMaximumCellsPerAxis);
+
+        // Two-pass counting sort of segment indices into a compact cell table.
+        m_cellStarts.assign(static_cast<std::size_t>(m_columns) * m_rows + 1, 0);
+        for (const SegmentBounds &bounds : m_bounds) {
+            forEachCell(bounds, [this](std::size_t cell) { ++m_cellStarts[cell + 1]; });
+        }
+        for (std::size_t cell = 1; cell < m_cellStarts.size(); ++cell)
+            m_cellStarts[cell] += m_cellStarts[cell - 1];
+
+        m_entries.resize(m_cellStarts.back());
+        std::vector<std::size_t> fill(m_cellStarts.begin(), m_cellStarts.end() - 1);
+        for (std::size_t index = 0; index < m_bounds.size(); ++index) {
+            forEachCell(m_bounds[index], [&](std::size_t cell) {
+                m_entries[fill[cell]++] = static_cast<int>(index);
+            });
+        }
+    }
+
+    int rows() const { return m_rows; }
+
+    // Appends the crossings owned by the cells of one grid row.
+    void collectRow(int row, const std::vector<CrossingSegment> &segments, std::vector<LineCrossing> &result) const
+    {
+        for (int column = 0; column < m_columns; ++column) {
+            const std::size_t cell = cellIndex(column, row);
+            const std::size_t begin = m_cellStarts[cell];
+            const std::size_t end = m_cellStarts[cell + 1];
+
+            for (std::size_t i = begin; i < end; ++i) {
+                const int firstIndex = m_entries[i];
+                const CrossingSegment &first = segments[static_cast<std::size_t>(firstIndex)];
+                const SegmentBounds &firstBounds = m_bounds[static_cast<std::size_t>(firstIndex)];
+
+                for (std::size_t j = i + 1; j < end; ++j) {
+                    const int secondIndex = m_entries[j];
+                    const CrossingSegment &second = segments[static_cast<std::size_t>(secondIndex)];
+                    const SegmentBounds &secondBounds = m_bounds[static_cast<std::size_t>(secondIndex)];
+
+                    if (secondBounds.left > firstBounds.right || secondBounds.right < firstBounds.left
+                        || secondBounds.top > firstBounds.bottom || secondBounds.bottom < firstBounds.top) {
+                        continue;
+                    }
+
+                    // Lines meeting at a shared vertex are connected, not crossing.
+                    if (first.startVertexId == second.startVertexId || first.startVertexId == second.endVertexId
+                        || first.endVertexId == second.startVertexId || first.endVertexId == second.endVertexId) {
+                        continue;
+                    }
+
+                    const qreal ownerX = std::max(firstBounds.left, secondBounds.left);
+                    const qreal ownerY = std::max(firstBounds.top, secondBounds.top);
+                    if (cellIndex(columnFor(ownerX), rowFor(ownerY)) != cell)
+                        continue;
+
+                    if (LineSpatialIndex::segmentsIntersect(first.segment, second.segment)) {
+                        result.push_back(LineCrossing{std::min(first.lineId, second.lineId),
+                                                      std::max(first.lineId, second.lineId)});
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    int columnFor(qreal x) const
+    {
+        return std::clamp(static_cast<int>((x - m_left) / m_cellSize), 0, m_columns - 1);
+    }
+
+    int rowFor(qreal y) const
+    {
+        return std::clamp(static_cast<int>((y - m_top) / m_cellSize), 0, m_rows - 1);
+    }
+
+    std::size_t cellIndex(int column, int row) const
+    {
+        return static_cast<std::size_t>(row) * static_cast<std::size_t>(m_columns) + static_cast<std::size_t>(column);
+    }
+
+    template<typename Visitor>
+    void forEachCell(const SegmentBounds &bounds, Visitor &&visitor) const
+    {
+        const int lastColumn = columnFor(bounds.right);
+        const int lastRow = rowFor(bounds.bottom);
+        for (int row = rowFor(bounds.top); row <= lastRow; ++row) {
+            for (int column = columnFor(bounds.left); column <= lastColumn; ++column)
+                visitor(cellIndex(column, row));
+        }
+    }
+
+    std::vector<SegmentBounds> m_bounds;
+    std::vector<std::size_t> m_cellStarts;
+    std::vector<int> m_entries;
+    qreal m_left = 0.0;
+    qreal m_top = 0.0;
+    qreal m_cellSize = 1.0;
+    int m_columns = 1;
+    int m_rows = 1;
+};
+
+std::vector<LineCrossing> runDetection(const std::vector<CrossingSegment> &segments,
+                                       QPromise<std::vector<LineCrossing>> *promise)
+{
+    std::vector<LineCrossing> crossings;
+    if (segments.size() < 2)
+        return crossings;
+
+    const CrossingGrid grid(segments);
+    if (promise) {
+        if (promise->isCanceled())
+            return crossings;
+        promise->setProgressValue(kBinnedProgress);
+    }
+
+    // Rows are grouped into a few tasks per worker so each task has enough
+    // work to amortise scheduling while the load still balances.
+    const int taskCount = std::min(grid.rows(), std::max(1, QThread::idealThreadCount() * 8));
+    const int rowsPerTask = (grid.rows() + taskCount - 1) / taskCount;
+
+    std::vector<std::vector<LineCrossing>> taskResults(static_cast<std::size_t>(taskCount));
+    std::vector<int> taskIndices(static_cast<std::size_t>(taskCount));
+    for (int task = 0; task < taskCount; ++task)
+        taskIndices[static_cast<std::size_t>(task)] = task;
+
+    std::atomic<int> finishedTasks{0};
+    QtConcurrent::blockingMap(taskIndices, [&](const int &task) {
+        if (promise && promise->isCanceled())
+            return;
+
+        const int lastRow = std::min(grid.rows(), (task + 1) * rowsPerTask);
+        for (int row = task * rowsPerTask; row < lastRow; ++row)
+            grid.collectRow(row, segments, taskResults[static_cast<std::size_t>(task)]);
+
+        const int finished = ++finishedTasks;
+        if (promise)
+            promise->setProgressValue(kBinnedProgress + (100 - kBinnedProgress) * finished / taskCount);
+    });
+
+    for (std::vector<LineCrossing> &taskResult : taskResults)
+        crossings.insert(crossings.end(), taskResult.begin(), taskResult.end());
+
+    std::sort(crossings.begin(), crossings.end(), [](const LineCrossing &lhs, const LineCrossing &rhs) {
+        return lhs.firstLineId != rhs.firstLineId ? lhs.firstLineId < rhs.firstLineId
+                                                  : lhs.secondLineId < rhs.secondLineId;
+    });
+    return crossings;
+}
+
+void detectCrossings(QPromise<std::vector<LineCrossing>> &promise, const std::vector<CrossingSegment> &segments)
+{
+    promise.setProgressRange(0, 100);
+    promise.setProgressValue(0);
+
+    std::vector<LineCrossing> crossings = runDetection(segments, &promise);
+    if (promise.isCanceled())
+        return;
+
+    promise.addResult(std::move(crossings));
+    promise.setProgressValue(100);
+}
+} // namespace
+
+CrossingDetector::CrossingDetector(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_watcher, &QFutureWatcher<std::vector<LineCrossing>>::finished, this, &CrossingDetector::handleFinished);
+    connect(&m_watcher,
+            &QFutureWatcher<std::vector<LineCrossing>>::progressValueChanged,
+            this,
+            &CrossingDetector::progressChanged);
+}
+
+CrossingDetector::~CrossingDetector()
+{
+    cancel();
+}
+
+std::vector<LineCrossing> CrossingDetector::findCrossings(const std::vector<CrossingSegment> &segments)
+{
+    return runDetection(segments, nullptr);
+}
+
+void CrossingDetector::detect(std::vector<CrossingSegment> segments)
+{
+    cancel();
+    m_watcher.setFuture(QtConcurrent::run(detectCrossings, std::move(segments)));
+}
+
+void CrossingDetector::cancel()
+{
+    if (m_watcher.isRunning())
+        m_watcher.cancel();
+}
+
+bool CrossingDetector::isRunning() const
+{
+    return m_watcher.isRunning() && !m_watcher.isCanceled();
+}
+
+void CrossingDetector::handleFinished()
+{
+    emit finished();
+    if (m_watcher.isCanceled() || m_watcher.future().resultCount() == 0)
+        return;
+
+    emit crossingsFound(m_watcher.result());
+}
@@ -0,0 +1,56 @@
+#ifndef CROSSINGDETECTOR_H
+#define CROSSINGDETECTOR_H
+
+#include <QFutureWatcher>
+#include <QLineF>
+#include <QObject>
+
+#include <vector>
+
+// Snapshot of one line taken on the UI thread; the worker never touches the
+// live model.
+struct CrossingSegment
+{
+    int lineId = -1;
+    int startVertexId = -1;
+    int endVertexId = -1;
+    QLineF segment;
+};
+
+struct LineCrossing
+{
+    int firstLineId = -1;
+    int secondLineId = -1;
+};
+
+// Finds every pair of crossing lines in a mesh on a worker thread. Segments
+// are binned into a uniform grid and the cells are checked in parallel; each
+// pair is only reported by the cell holding the top-left corner of the
+// overlap of their bounding boxes, so no pair is reported twice.
+class CrossingDetector : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CrossingDetector(QObject *parent = nullptr);
+    ~CrossingDetector() override;
+
+    static std::vector<LineCrossing> findCrossings(const std::vector<CrossingSegment> &segments);
+
+    void detect(std::vector<CrossingSegment> segments);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void progressChanged(int percent);
+    void crossingsFound(const std::vector<LineCrossing> &crossings);
+    // After every run, whether it found crossings or was canceled.
+    void finished();
+
+private:
+    void handleFinished();
+
+    QFutureWatcher<std::vector<LineCrossing>> m_watcher;
+};
+
+#endif // CROSSINGDETECTOR_H
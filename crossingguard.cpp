@@ -0,0 +1,168 @@
+#include "crossingguard.h"
+
+#include "line.h"
+#include "linespatialindex.h"
+#include "vertex.h"
+
+#include <QLineF>
+#include <QRectF>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+// How far short of the first contact a clamped move stops, in scene units.
+constexpr qreal kClearance = 1.0e-3;
+// Larger than any sweep parameter: no contact during the move.
+constexpr qreal kNoContact = 2.0;
+
+// An incident line of the moving vertex together with the nearby segments it
+// must stay clear of.
+struct MovingSegment
+{
+    QPointF anchor;
+    std::size_t firstObstacle = 0;
+    std::size_t obstacleCount = 0;
+};
+
+qreal cross(const QPointF &first, const QPointF &second)
+{
+    return first.x() * second.y() - first.y() * second.x();
+}
+
+// The smallest t in [0, 1] at which the segment from anchor to
+// from + t * direction touches obstacle, or kNoContact. The segment and the
+// obstacle are apart at t = 0, so the first contact either puts an obstacle
+// endpoint on the moving segment or puts the moving end on the obstacle.
+qreal firstContact(const QPointF &anchor, const QPointF &from, const QPointF &direction, const QLineF &obstacle)
+{
+    qreal first = kNoContact;
+
+    // The moving segment sweeps over an obstacle endpoint: the endpoint is on
+    // the line through anchor and from + t * direction, between the two.
+    for (const QPointF &point : {obstacle.p1(), obstacle.p2()}) {
+        const QPointF offset = point - anchor;
+        const qreal rate = cross(direction, offset);
+        if (rate == 0.0)
+            continue;
+        const qreal t = -cross(from - anchor, offset) / rate;
+        if (t < 0.0 || t > 1.0 || t >= first)
+            continue;
+        const QPointF reach = from + direction * t - anchor;
+        const qreal along = QPointF::dotProduct(offset, reach);
+        if (along >= 0.0 && along <= QPointF::dotProduct(reach, reach))
+            first = t;
+    }
+
+    // The moving end runs into the obstacle.
+    const QPointF edge = obstacle.p2() - obstacle.p1();
+    const QPointF offset = obstacle.p1() - from;
+    const qreal denominator = cross(direction, edge);
+    if (denominator != 0.0) {
+        const qreal t = cross(offset, edge) / denominator;
+        const qreal s = cross(offset, direction) / denominator;
+        if (t >= 0.0 && t <= 1.0 && s >= 0.0 && s <= 1.0)
+            first = std::min(first, t);
+    } else if (cross(offset, direction) == 0.0) {
+        // Moving along the obstacle's line: it is met at its nearer end.
+        const qreal lengthSquared = QPointF::dotProduct(direction, direction);
+        const qreal t1 = QPointF::dotProduct(obstacle.p1() - from, direction) / lengthSquared;
+        const qreal t2 = QPointF::dotProduct(obstacle.p2() - from, direction) / lengthSquared;
+        const qreal enter = std::max(0.0, std::min(t1, t2));
+        if (enter <= std::min(1.0, std::max(t1, t2)))
+            first = std::min(first, enter);
+    }
+
+    return first;
+}
+
+QRectF sweptBounds(const QPointF &anchor, const QPointF &from, const QPointF &to)
+{
+    const qreal left = std::min({anchor.x(), from.x(), to.x()});
+    const qreal top = std::min({anchor.y(), from.y(), to.y()});
+    const qreal right = std::max({anchor.x(), from.x(), to.x()});
+    const qreal bottom = std::max({anchor.y(), from.y(), to.y()});
+    return QRectF(QPointF(left, top), QPointF(right, bottom));
+}
+} // namespace
+
+CrossingGuard::CrossingGuard(const LineSpatialIndex *lineIndex)
+    : m_lineIndex(lineIndex)
+{
+}
+
+void CrossingGuard::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+bool CrossingGuard::isEnabled() const
+{
+    return m_enabled;
+}
+
+QPointF CrossingGuard::constrainMove(const Vertex *vertex, const QPointF &target) const
+{
+    if (!m_enabled || !m_lineIndex || !vertex || vertex->connectedLines().empty())
+        return target;
+
+    const QPointF from = vertex->position();
+    if (from == target)
+        return target;
+
+    std::vector<MovingSegment> moving;
+    std::vector<QLineF> obstacles;
+    moving.reserve(vertex->connectedLines().size());
+
+    for (const Line *line : vertex->connectedLines()) {
+        if (!line || !line->startVertex() || !line->endVertex())
+            continue;
+
+        const Vertex *anchorVertex = line->startVertex() == vertex ? line->endVertex() : line->startVertex();
+        MovingSegment segment;
+        segment.anchor = anchorVertex->position();
+        segment.firstObstacle = obstacles.size();
+
+        // Lines sharing an endpoint with the moving segment only touch it there.
+        for (const Line *other : m_lineIndex->inRect(sweptBounds(segment.anchor, from, target))) {
+            if (other->involvesVertex(vertex) || other->involvesVertex(anchorVertex))
+                continue;
+            obstacles.emplace_back(other->startVertex()->position(), other->endVertex()->position());
+        }
+
+        segment.obstacleCount = obstacles.size() - segment.firstObstacle;
+        if (segment.obstacleCount > 0)
+            moving.push_back(segment);
+    }
+
+    if (moving.empty())
+        return target;
+
+    // A mesh that is already tangled is not made worse by moving, and refusing
+    // every move would leave no way to untangle it by hand.
+    const auto crosses = [&](const QPointF &position) {
+        for (const MovingSegment &segment : moving) {
+            const QLineF movingLine(segment.anchor, position);
+            for (std::size_t i = 0; i < segment.obstacleCount; ++i) {
+                if (LineSpatialIndex::segmentsIntersect(movingLine, obstacles[segment.firstObstacle + i]))
+                    return true;
+            }
+        }
+        return false;
+    };
+    if (crosses(from))
+        return target;
+
+    const QPointF direction = target - from;
+    qreal contact = kNoContact;
+    for (const MovingSegment &segment : moving) {
+        for (std::size_t i = 0; i < segment.obstacleCount; ++i)
+            contact = std::min(contact, firstContact(segment.anchor, from, direction, obstacles[segment.firstObstacle + i]));
+    }
+    if (contact > 1.0)
+        return target;
+
+    const qreal length = std::sqrt(QPointF::dotProduct(direction, direction));
+    return from + direction * std::max(0.0, contact - kClearance / length);
+}
@@ -0,0 +1,31 @@
+#ifndef CROSSINGGUARD_H
+#define CROSSINGGUARD_H
+
+#include <QPointF>
+
+class LineSpatialIndex;
+class Vertex;
+
+// Keeps interactive vertex drags from making the vertex's incident lines
+// cross other lines. Only segments near the swept area are tested, using the
+// line spatial index, so the cost of a move does not grow with the mesh.
+class CrossingGuard
+{
+public:
+    explicit CrossingGuard(const LineSpatialIndex *lineIndex);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const;
+
+    // Returns target, or the point just before the straight move from the
+    // vertex's current position first makes one of its lines touch another.
+    // The whole area the lines sweep over is checked, so a fast drag cannot
+    // jump a line over an obstacle.
+    QPointF constrainMove(const Vertex *vertex, const QPointF &target) const;
+
+private:
+    const LineSpatialIndex *m_lineIndex = nullptr;
+    bool m_enabled = false;
+};
+
+#endif // CROSSINGGUARD_H
@@ -0,0 +1,201 @@
+#include "distancetransform.h"
+
+#include "stripes.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+// Column pass over the columns of packed words [stripe.first, stripe.end):
+// writes the row of the nearest set pixel in the same column, or -1. The
+// stripe walks down whole row segments rather than down single columns, so
+// memory is read in order.
+void nearestInColumns(const BinaryImage &mask, const Stripe &stripe, int *nearestRows)
+{
+    const int width = mask.width();
+    const int height = mask.height();
+    const int firstColumn = stripe.first * 64;
+    const int endColumn = std::min(width, stripe.end * 64);
+    if (firstColumn >= endColumn)
+        return;
+
+    // Downwards, the nearest set pixel above or on each pixel.
+    for (int y = 0; y < height; ++y) {
+        const quint64 *words = mask.row(y);
+        int *current = nearestRows + static_cast<qsizetype>(y) * width;
+        const int *above = y > 0 ? current - width : nullptr;
+        for (int x = firstColumn; x < endColumn; ++x) {
+            const bool set = (words[x >> 6] >> (x & 63)) & 1;
+            current[x] = set ? y : (above ? above[x] : -1);
+        }
+    }
+
+    // Upwards, replaced by the nearest set pixel below where that is closer.
+    std::vector<int> below(static_cast<std::size_t>(endColumn - firstColumn), -1);
+    for (int y = height - 1; y >= 0; --y) {
+        const quint64 *words = mask.row(y);
+        int *current = nearestRows + static_cast<qsizetype>(y) * width;
+        for (int x = firstColumn; x < endColumn; ++x) {
+            int &nextBelow = below[static_cast<std::size_t>(x - firstColumn)];
+            const bool set = (words[x >> 6] >> (x & 63)) & 1;
+            nextBelow = set ? y : nextBelow;
+            const int above = current[x];
+            const bool belowCloser = nextBelow >= 0 && (above < 0 || nextBelow - y < y - above);
+            current[x] = belowCloser ? nextBelow : above;
+        }
+    }
+}
+
+// Scratch space of the row pass, one per stripe.
+struct Envelope
+{
+    explicit Envelope(int width)
+        : columns(static_cast<std::size_t>(width))
+        , rows(static_cast<std::size_t>(width))
+        , heights(static_cast<std::size_t>(width))
+        , startNumerators(static_cast<std::size_t>(width))
+        , startDenominators(static_cast<std::size_t>(width))
+    {
+    }
+
+    // The parabolas of the lower envelope: apex column, row of the set
+    // pixel, squared column distance, and the column from which each is the
+    // lowest as a fraction with a positive denominator.
+    std::vector<int> columns;
+    std::vector<int> rows;
+    std::vector<qint64> heights;
+    std::vector<qint64> startNumerators;
+    std::vector<qint64> startDenominators;
+};
+
+// Row pass for row y: each column holding a set pixel contributes the
+// parabola (x - column)^2 + (y - row)^2, and every pixel takes the lowest.
+// Reads the column pass from nearest and overwrites it with raster indices.
+// The intersections are kept as exact fractions, which saves a division per
+// parabola.
+void nearestInRow(int y, int width, int *nearest, float *distances, Envelope &envelope)
+{
+    int *rowNearest = nearest + static_cast<qsizetype>(y) * width;
+    float *rowDistances = distances + static_cast<qsizetype>(y) * width;
+
+    int top = -1;
+    for (int column = 0; column < width; ++column) {
+        const int row = rowNearest[column];
+        if (row < 0)
+            continue;
+
+        const qint64 height = static_cast<qint64>(y - row) * (y - row);
+        qint64 numerator = 0;
+        qint64 denominator = 1;
+        while (top >= 0) {
+            const auto t = static_cast<std::size_t>(top);
+            const int previous = envelope.columns[t];
+            // Where the new parabola drops below the one on top.
+            numerator = height + static_cast<qint64>(column) * column - envelope.heights[t]
+                        - static_cast<qint64>(previous) * previous;
+            denominator = 2 * static_cast<qint64>(column - previous);
+            if (top == 0 || numerator * envelope.startDenominators[t] > envelope.startNumerators[t] * denominator)
+                break;
+            --top;
+        }
+
+        const auto t = static_cast<std::size_t>(++top);
+        envelope.columns[t] = column;
+        envelope.rows[t] = row;
+        envelope.heights[t] = height;
+        envelope.startNumerators[t] = numerator;
+        envelope.startDenominators[t] = denominator;
+    }
+
+    if (top < 0) {
+        std::fill(rowNearest, rowNearest + width, DistanceTransform::kNoPixel);
+        std::fill(rowDistances, rowDistances + width, std::numeric_limits<float>::infinity());
+        return;
+    }
+
+    int k = 0;
+    for (int x = 0; x < width; ++x) {
+        while (k < top
+               && envelope.startNumerators[static_cast<std::size_t>(k) + 1]
+                      < x * envelope.startDenominators[static_cast<std::size_t>(k) + 1]) {
+            ++k;
+        }
+        const auto t = static_cast<std::size_t>(k);
+        const int column = envelope.columns[t];
+        // Squared distances past 2^24 do not fit a float exactly, so the root
+        // is taken of the exact integer.
+        const qint64 squaredDistance = static_cast<qint64>(x - column) * (x - column) + envelope.heights[t];
+        rowDistances[x] = static_cast<float>(std::sqrt(static_cast<double>(squaredDistance)));
+        rowNearest[x] = envelope.rows[t] * width + column;
+    }
+}
+} // namespace
+
+DistanceTransform::DistanceTransform(const BinaryImage &mask)
+    : m_width(mask.width())
+    , m_height(mask.height())
+{
+    if (mask.isNull())
+        return;
+
+    const std::size_t pixelCount = static_cast<std::size_t>(m_width) * m_height;
+    m_nearest.resize(pixelCount);
+    m_distances.resize(pixelCount);
+
+    std::vector<Stripe> columnStripes = makeStripes(mask.wordsPerRow());
+    QtConcurrent::blockingMap(columnStripes, [&](Stripe &stripe) {
+        nearestInColumns(mask, stripe, m_nearest.data());
+    });
+
+    // Every row only reads its own column results, so rows run independently.
+    std::vector<Stripe> rowStripes = makeStripes(m_height);
+    QtConcurrent::blockingMap(rowStripes, [&](Stripe &stripe) {
+        Envelope envelope(m_width);
+        for (int y = stripe.first; y < stripe.end; ++y)
+            nearestInRow(y, m_width, m_nearest.data(), m_distances.data(), envelope);
+    });
+}
+
+bool DistanceTransform::isNull() const
+{
+    return m_distances.empty();
+}
+
+int DistanceTransform::width() const
+{
+    return m_width;
+}
+
+int DistanceTransform::height() const
+{
+    return m_height;
+}
+
+float DistanceTransform::distance(int x, int y) const
+{
+    return m_distances[static_cast<std::size_t>(y) * m_width + x];
+}
+
+int DistanceTransform::nearestIndex(int x, int y) const
+{
+    return m_nearest[static_cast<std::size_t>(y) * m_width + x];
+}
+
+QPoint DistanceTransform::nearestPixel(int x, int y) const
+{
+    const int index = nearestIndex(x, y);
+    return index == kNoPixel ? QPoint(-1, -1) : QPoint(index % m_width, index / m_width);
+}
+
+const float *DistanceTransform::distances() const
+{
+    return m_distances.data();
+}
+
+const int *DistanceTransform::nearestIndices() const
+{
+    return m_nearest.data();
+}
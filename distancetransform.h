@@ -0,0 +1,46 @@
+#ifndef DISTANCETRANSFORM_H
+#define DISTANCETRANSFORM_H
+
+#include "binaryimage.h"
+
+#include <QPoint>
+
+#include <vector>
+
+// Exact Euclidean distance transform of a BinaryImage: for every pixel, the
+// distance to the nearest set pixel and which pixel that is. Distances are
+// between pixel centres, so set pixels are at distance 0 from themselves.
+class DistanceTransform
+{
+public:
+    static constexpr int kNoPixel = -1;
+
+    DistanceTransform() = default;
+    // Runs the separable algorithm of Meijster et al. (2000): a pass down
+    // every column, then the lower envelope of parabolas (Felzenszwalb and
+    // Huttenlocher) along every row. Both passes are split into stripes on
+    // all cores, and both are linear in the number of pixels.
+    explicit DistanceTransform(const BinaryImage &mask);
+
+    bool isNull() const;
+    int width() const;
+    int height() const;
+
+    // Infinity when the mask has no set pixel at all.
+    float distance(int x, int y) const;
+    // Raster index (y * width + x) of the nearest set pixel, or kNoPixel.
+    int nearestIndex(int x, int y) const;
+    QPoint nearestPixel(int x, int y) const;
+
+    // Both maps in raster order.
+    const float *distances() const;
+    const int *nearestIndices() const;
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    std::vector<float> m_distances;
+    std::vector<int> m_nearest;
+};
+
+#endif // DISTANCETRANSFORM_H
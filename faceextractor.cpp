@@ -0,0 +1,147 @@
+#include "faceextractor.h"
+
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+constexpr int kChunksPerThread = 4;
+
+// Half-edge 2 * line runs from the line's first vertex to its second;
+// 2 * line + 1 runs back.
+int origin(const PlanarMesh &mesh, int halfEdge)
+{
+    const auto &line = mesh.lines[static_cast<std::size_t>(halfEdge / 2)];
+    return halfEdge % 2 == 0 ? line.first : line.second;
+}
+
+int twin(int halfEdge)
+{
+    return halfEdge ^ 1;
+}
+
+// Runs function(first, end) over [0, count) split into chunks on all cores.
+template<typename Function>
+void forEachChunk(int count, Function function)
+{
+    const int chunkCount = std::clamp(QThread::idealThreadCount() * kChunksPerThread, 1, std::max(1, count));
+    std::vector<int> chunks(static_cast<std::size_t>(chunkCount));
+    std::iota(chunks.begin(), chunks.end(), 0);
+    QtConcurrent::blockingMap(chunks, [&](const int &chunk) {
+        function(static_cast<int>(static_cast<qint64>(count) * chunk / chunkCount),
+                 static_cast<int>(static_cast<qint64>(count) * (chunk + 1) / chunkCount));
+    });
+}
+} // namespace
+
+void extractFaces(PlanarMesh &mesh)
+{
+    mesh.faceOffsets.assign(1, 0);
+    mesh.faceVertices.clear();
+    mesh.faceLines.clear();
+
+    const int vertexCount = static_cast<int>(mesh.vertices.size());
+    const int halfEdgeCount = static_cast<int>(mesh.lines.size()) * 2;
+    if (halfEdgeCount == 0)
+        return;
+
+    // Outgoing half-edges of each vertex, sorted counter-clockwise by angle.
+    std::vector<int> outgoingStarts(static_cast<std::size_t>(vertexCount) + 1, 0);
+    for (int halfEdge = 0; halfEdge < halfEdgeCount; ++halfEdge)
+        ++outgoingStarts[static_cast<std::size_t>(origin(mesh, halfEdge)) + 1];
+    std::partial_sum(outgoingStarts.begin(), outgoingStarts.end(), outgoingStarts.begin());
+
+    std::vector<int> outgoing(static_cast<std::size_t>(halfEdgeCount));
+    std::vector<int> fill(outgoingStarts.begin(), outgoingStarts.end() - 1);
+    for (int halfEdge = 0; halfEdge < halfEdgeCount; ++halfEdge)
+        outgoing[static_cast<std::size_t>(fill[static_cast<std::size_t>(origin(mesh, halfEdge))]++)] = halfEdge;
+
+    std::vector<qreal> angles(static_cast<std::size_t>(halfEdgeCount));
+    std::vector<int> ranks(static_cast<std::size_t>(halfEdgeCount));
+    forEachChunk(vertexCount, [&](int first, int end) {
+        for (int vertex = first; vertex < end; ++vertex) {
+            const auto begin = outgoing.begin() + outgoingStarts[static_cast<std::size_t>(vertex)];
+            const auto finish = outgoing.begin() + outgoingStarts[static_cast<std::size_t>(vertex) + 1];
+            const QPointF &position = mesh.vertices[static_cast<std::size_t>(vertex)];
+            for (auto it = begin; it != finish; ++it) {
+                const QPointF direction = mesh.vertices[static_cast<std::size_t>(origin(mesh, twin(*it)))] - position;
+                angles[static_cast<std::size_t>(*it)] = std::atan2(direction.y(), direction.x());
+            }
+            std::sort(begin, finish, [&angles](int a, int b) {
+                return angles[static_cast<std::size_t>(a)] < angles[static_cast<std::size_t>(b)];
+            });
+            for (auto it = begin; it != finish; ++it)
+                ranks[static_cast<std::size_t>(*it)] = static_cast<int>(it - begin);
+        }
+    });
+
+    // The face left of u -> v continues with the half-edge leaving v just
+    // clockwise of v -> u.
+    std::vector<int> next(static_cast<std::size_t>(halfEdgeCount));
+    forEachChunk(halfEdgeCount, [&](int first, int end) {
+        for (int halfEdge = first; halfEdge < end; ++halfEdge) {
+            const int back = twin(halfEdge);
+            const auto vertex = static_cast<std::size_t>(origin(mesh, back));
+            const int degree = outgoingStarts[vertex + 1] - outgoingStarts[vertex];
+            const int rank = (ranks[static_cast<std::size_t>(back)] + degree - 1) % degree;
+            next[static_cast<std::size_t>(halfEdge)] =
+                outgoing[static_cast<std::size_t>(outgoingStarts[vertex] + rank)];
+        }
+    });
+
+    std::vector<bool> visited(static_cast<std::size_t>(halfEdgeCount), false);
+    std::vector<int> ring;
+    std::vector<int> lastSeen(static_cast<std::size_t>(vertexCount), -1);
+    for (int start = 0; start < halfEdgeCount; ++start) {
+        if (visited[static_cast<std::size_t>(start)])
+            continue;
+
+        // Walking there and straight back along a dangling line cancels out.
+        ring.clear();
+        for (int halfEdge = start; !visited[static_cast<std::size_t>(halfEdge)];
+             halfEdge = next[static_cast<std::size_t>(halfEdge)]) {
+            visited[static_cast<std::size_t>(halfEdge)] = true;
+            if (!ring.empty() && ring.back() == twin(halfEdge))
+                ring.pop_back();
+            else
+                ring.push_back(halfEdge);
+        }
+        std::size_t first = 0;
+        std::size_t last = ring.size();
+        while (last - first >= 2 && ring[first] == twin(ring[last - 1])) {
+            ++first;
+            --last;
+        }
+        if (last - first < 3)
+            continue;
+
+        qreal doubleArea = 0.0;
+        bool simple = true;
+        const int faceIndex = static_cast<int>(mesh.faceCount());
+        for (std::size_t i = first; i < last; ++i) {
+            const int vertex = origin(mesh, ring[i]);
+            int &seen = lastSeen[static_cast<std::size_t>(vertex)];
+            simple = simple && seen != faceIndex;
+            seen = faceIndex;
+
+            const QPointF &current = mesh.vertices[static_cast<std::size_t>(vertex)];
+            const QPointF &following = mesh.vertices[static_cast<std::size_t>(origin(mesh, twin(ring[i])))];
+            doubleArea += current.x() * following.y() - following.x() * current.y();
+        }
+        // The outer face winds the other way.
+        if (!simple || doubleArea <= 0.0) {
+            for (std::size_t i = first; i < last; ++i)
+                lastSeen[static_cast<std::size_t>(origin(mesh, ring[i]))] = -1;
+            continue;
+        }
+
+        for (std::size_t i = first; i < last; ++i) {
+            mesh.faceVertices.push_back(origin(mesh, ring[i]));
+            mesh.faceLines.push_back(ring[i] / 2);
+        }
+        mesh.faceOffsets.push_back(static_cast<int>(mesh.faceVertices.size()));
+    }
+}
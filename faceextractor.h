@@ -0,0 +1,15 @@
+#ifndef FACEEXTRACTOR_H
+#define FACEEXTRACTOR_H
+
+#include "planarmesh.h"
+
+// Replaces the faces of mesh with every bounded face of the planar graph
+// formed by its vertices and lines. Lines around each vertex are sorted by
+// angle and each face is walked once; the outer face of every connected part
+// is discarded. Faces are counter-clockwise in scene coordinates (positive
+// signedArea). Dangling lines inside a face are left out of its ring; faces
+// that still touch one vertex twice are skipped. A part nested inside a face
+// of another part is not cut out of that face.
+void extractFaces(PlanarMesh &mesh);
+
+#endif // FACEEXTRACTOR_H
@@ -0,0 +1,351 @@
+#include "halfedgemesh.h"
+
+#include "line.h"
+#include "polygon.h"
+#include "vertex.h"
+
+#include <QPointF>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+qreal cross(const QPointF &first, const QPointF &second)
+{
+    return first.x() * second.y() - second.x() * first.y();
+}
+} // namespace
+
+void HalfEdgeMesh::clear()
+{
+    m_halfEdges.clear();
+    m_freePairs.clear();
+    m_outgoing.clear();
+    m_lineHalfEdges.clear();
+    m_boundaries.clear();
+}
+
+std::size_t HalfEdgeMesh::halfEdgeCount() const
+{
+    return 2 * m_lineHalfEdges.size();
+}
+
+void HalfEdgeMesh::trackVertex(Vertex *vertex)
+{
+    if (vertex)
+        m_outgoing.emplace(vertex, kNoHalfEdge);
+}
+
+void HalfEdgeMesh::untrackVertex(Vertex *vertex)
+{
+    m_outgoing.erase(vertex);
+}
+
+void HalfEdgeMesh::trackLine(Line *line)
+{
+    if (!line || m_lineHalfEdges.count(line))
+        return;
+
+    Vertex *start = line->startVertex();
+    Vertex *end = line->endVertex();
+    if (!start || !end || start == end)
+        return;
+
+    m_outgoing.emplace(start, kNoHalfEdge);
+    m_outgoing.emplace(end, kNoHalfEdge);
+
+    const int halfEdge = allocatePair();
+    m_halfEdges[static_cast<std::size_t>(halfEdge)] = HalfEdge{start, line, nullptr, kNoHalfEdge, kNoHalfEdge};
+    m_halfEdges[static_cast<std::size_t>(twin(halfEdge))] = HalfEdge{end, line, nullptr, kNoHalfEdge, kNoHalfEdge};
+    link(halfEdge);
+    link(twin(halfEdge));
+    m_lineHalfEdges.emplace(line, halfEdge);
+}
+
+void HalfEdgeMesh::untrackLine(Line *line)
+{
+    const auto it = m_lineHalfEdges.find(line);
+    if (it == m_lineHalfEdges.end())
+        return;
+
+    const int halfEdge = it->second;
+    m_lineHalfEdges.erase(it);
+
+    for (const int side : {halfEdge, twin(halfEdge)}) {
+        if (Polygon *polygon = face(side))
+            reassignBoundary(polygon, halfEdge);
+    }
+
+    unlink(halfEdge);
+    unlink(twin(halfEdge));
+    m_halfEdges[static_cast<std::size_t>(halfEdge)] = HalfEdge{};
+    m_halfEdges[static_cast<std::size_t>(twin(halfEdge))] = HalfEdge{};
+    m_freePairs.push_back(halfEdge);
+}
+
+void HalfEdgeMesh::trackPolygon(Polygon *polygon)
+{
+    if (!polygon || m_boundaries.count(polygon))
+        return;
+
+    const std::vector<Line *> &lines = polygon->lines();
+    const std::size_t count = lines.size();
+
+    // Each line's half-edge is taken towards the vertex it shares with the
+    // following line; the ring is then flipped if it runs the wrong way.
+    const auto ringHalfEdge = [&](std::size_t i) {
+        const int halfEdge = this->halfEdge(lines[i]);
+        if (halfEdge == kNoHalfEdge)
+            return kNoHalfEdge;
+        const Line *following = lines[(i + 1) % count];
+        return following && following->involvesVertex(target(halfEdge)) ? halfEdge : twin(halfEdge);
+    };
+
+    qreal area = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const int halfEdge = ringHalfEdge(i);
+        if (halfEdge != kNoHalfEdge)
+            area += cross(origin(halfEdge)->position(), target(halfEdge)->position());
+    }
+
+    int first = kNoHalfEdge;
+    for (std::size_t i = 0; i < count; ++i) {
+        int halfEdge = ringHalfEdge(i);
+        if (halfEdge == kNoHalfEdge)
+            continue;
+        if (area < 0.0)
+            halfEdge = twin(halfEdge);
+
+        HalfEdge &record = m_halfEdges[static_cast<std::size_t>(halfEdge)];
+        if (record.face)
+            continue;
+        record.face = polygon;
+        if (first == kNoHalfEdge)
+            first = halfEdge;
+    }
+    m_boundaries.emplace(polygon, first);
+}
+
+void HalfEdgeMesh::untrackPolygon(Polygon *polygon)
+{
+    const auto it = m_boundaries.find(polygon);
+    if (it == m_boundaries.end())
+        return;
+
+    for (const Line *line : polygon->lines()) {
+        const int halfEdge = this->halfEdge(line);
+        if (halfEdge == kNoHalfEdge)
+            continue;
+        for (const int side : {halfEdge, twin(halfEdge)}) {
+            HalfEdge &record = m_halfEdges[static_cast<std::size_t>(side)];
+            if (record.face == polygon)
+                record.face = nullptr;
+        }
+    }
+    m_boundaries.erase(it);
+}
+
+void HalfEdgeMesh::vertexMoved(Vertex *vertex)
+{
+    const int first = outgoing(vertex);
+    if (first == kNoHalfEdge)
+        return;
+
+    m_starScratch.clear();
+    forEachOutgoing(vertex, [this](int halfEdge) { m_starScratch.push_back(halfEdge); });
+
+    for (const int halfEdge : m_starScratch) {
+        unlink(halfEdge);
+        unlink(twin(halfEdge));
+    }
+    for (const int halfEdge : m_starScratch) {
+        link(halfEdge);
+        link(twin(halfEdge));
+    }
+}
+
+int HalfEdgeMesh::halfEdge(const Line *line) const
+{
+    const auto it = m_lineHalfEdges.find(line);
+    return it != m_lineHalfEdges.end() ? it->second : kNoHalfEdge;
+}
+
+int HalfEdgeMesh::outgoing(const Vertex *vertex) const
+{
+    const auto it = m_outgoing.find(vertex);
+    return it != m_outgoing.end() ? it->second : kNoHalfEdge;
+}
+
+int HalfEdgeMesh::boundary(const Polygon *polygon) const
+{
+    const auto it = m_boundaries.find(polygon);
+    return it != m_boundaries.end() ? it->second : kNoHalfEdge;
+}
+
+bool HalfEdgeMesh::faceRing(const std::vector<Line *> &lines,
+                            std::vector<Line *> &orderedLines,
+                            std::vector<Vertex *> &orderedVertices) const
+{
+    const std::size_t count = lines.size();
+    if (count < 3)
+        return false;
+
+    m_lineScratch.assign(lines.begin(), lines.end());
+    std::sort(m_lineScratch.begin(), m_lineScratch.end());
+    if (!m_lineScratch.front() || std::adjacent_find(m_lineScratch.begin(), m_lineScratch.end()) != m_lineScratch.end())
+        return false;
+
+    const int first = halfEdge(lines.front());
+    if (first == kNoHalfEdge)
+        return false;
+
+    for (const int start : {first, twin(first)}) {
+        std::size_t steps = 0;
+        int halfEdge = start;
+        do {
+            if (!std::binary_search(m_lineScratch.begin(), m_lineScratch.end(), line(halfEdge)))
+                break;
+            ++steps;
+            halfEdge = next(halfEdge);
+        } while (halfEdge != start && steps <= count);
+
+        if (halfEdge != start || steps != count)
+            continue;
+
+        orderedLines.clear();
+        orderedVertices.clear();
+        do {
+            orderedLines.push_back(line(halfEdge));
+            orderedVertices.push_back(origin(halfEdge));
+            halfEdge = next(halfEdge);
+        } while (halfEdge != start);
+
+        // The walk covers every given line only if none repeats, and a face
+        // pinched at a cut vertex is not a polygon ring.
+        m_lineScratch.assign(orderedLines.begin(), orderedLines.end());
+        std::sort(m_lineScratch.begin(), m_lineScratch.end());
+        if (std::adjacent_find(m_lineScratch.begin(), m_lineScratch.end()) != m_lineScratch.end())
+            return false;
+        m_vertexScratch.assign(orderedVertices.begin(), orderedVertices.end());
+        std::sort(m_vertexScratch.begin(), m_vertexScratch.end());
+        return std::adjacent_find(m_vertexScratch.begin(), m_vertexScratch.end()) == m_vertexScratch.end();
+    }
+    return false;
+}
+
+int HalfEdgeMesh::allocatePair()
+{
+    if (!m_freePairs.empty()) {
+        const int halfEdge = m_freePairs.back();
+        m_freePairs.pop_back();
+        return halfEdge;
+    }
+
+    const int halfEdge = static_cast<int>(m_halfEdges.size());
+    m_halfEdges.resize(m_halfEdges.size() + 2);
+    return halfEdge;
+}
+
+// Inserts the half-edge into the angular order around its origin. With b a
+// half-edge leaving the origin and a the one before it, the new half-edge h
+// goes between them: next(twin(b)) = h and next(twin(h)) = a.
+void HalfEdgeMesh::link(int halfEdge)
+{
+    HalfEdge &record = m_halfEdges[static_cast<std::size_t>(halfEdge)];
+    int &first = m_outgoing[record.origin];
+    const int opposite = twin(halfEdge);
+    if (first == kNoHalfEdge) {
+        first = halfEdge;
+        record.prev = opposite;
+        m_halfEdges[static_cast<std::size_t>(opposite)].next = halfEdge;
+        return;
+    }
+
+    const QPointF position = record.origin->position();
+    const auto angleOf = [&](int candidate) {
+        const QPointF offset = target(candidate)->position() - position;
+        return std::atan2(offset.y(), offset.x());
+    };
+
+    // b is the first half-edge at a larger angle, or the smallest angle when
+    // the new one is the largest.
+    const qreal angle = angleOf(halfEdge);
+    int after = kNoHalfEdge;
+    int smallest = kNoHalfEdge;
+    qreal afterAngle = 0.0;
+    qreal smallestAngle = 0.0;
+    int candidate = first;
+    do {
+        const qreal candidateAngle = angleOf(candidate);
+        if (smallest == kNoHalfEdge || candidateAngle < smallestAngle) {
+            smallest = candidate;
+            smallestAngle = candidateAngle;
+        }
+        if (candidateAngle > angle && (after == kNoHalfEdge || candidateAngle < afterAngle)) {
+            after = candidate;
+            afterAngle = candidateAngle;
+        }
+        candidate = nextAroundOrigin(candidate);
+    } while (candidate != first);
+
+    const int b = after != kNoHalfEdge ? after : smallest;
+    const int a = next(twin(b));
+    m_halfEdges[static_cast<std::size_t>(twin(b))].next = halfEdge;
+    record.prev = twin(b);
+    m_halfEdges[static_cast<std::size_t>(opposite)].next = a;
+    m_halfEdges[static_cast<std::size_t>(a)].prev = opposite;
+}
+
+void HalfEdgeMesh::unlink(int halfEdge)
+{
+    const auto it = m_outgoing.find(origin(halfEdge));
+    if (it == m_outgoing.end())
+        return;
+
+    const int before = next(twin(halfEdge));
+    if (before == halfEdge) {
+        it->second = kNoHalfEdge;
+        return;
+    }
+
+    const int previous = prev(halfEdge);
+    m_halfEdges[static_cast<std::size_t>(previous)].next = before;
+    m_halfEdges[static_cast<std::size_t>(before)].prev = previous;
+    if (it->second == halfEdge)
+        it->second = before;
+}
+
+// The half-edge after halfEdge on the polygon's ring: next(halfEdge) when
+// the ring is a face, otherwise the polygon's half-edge found by turning
+// around the target.
+int HalfEdgeMesh::nextFaceHalfEdge(int halfEdge, const Polygon *polygon) const
+{
+    const int first = next(halfEdge);
+    int candidate = first;
+    while (face(candidate) != polygon) {
+        candidate = next(twin(candidate));
+        if (candidate == first)
+            return kNoHalfEdge;
+    }
+    return candidate;
+}
+
+void HalfEdgeMesh::reassignBoundary(Polygon *polygon, int removedPair)
+{
+    const auto it = m_boundaries.find(polygon);
+    if (it == m_boundaries.end() || (it->second | 1) != (removedPair | 1))
+        return;
+
+    it->second = kNoHalfEdge;
+    for (const Line *line : polygon->lines()) {
+        const int halfEdge = this->halfEdge(line);
+        if (halfEdge == kNoHalfEdge || halfEdge == removedPair)
+            continue;
+        for (const int side : {halfEdge, twin(halfEdge)}) {
+            if (face(side) == polygon) {
+                it->second = side;
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#ifndef HALFEDGEMESH_H
+#define HALFEDGEMESH_H
+
+#include <unordered_map>
+#include <vector>
+
+class Vertex;
+class Line;
+class Polygon;
+
+// Half-edge (doubly connected edge list) view of the vertex/line/polygon
+// model, kept up to date by the entities that register with it
+// (setHalfEdgeMesh).
+//
+// Every line owns a pair of half-edges h and twin(h) = h ^ 1; halfEdge(line)
+// runs from the start vertex to the end vertex. The half-edges leaving a
+// vertex are linked in order of increasing angle, and next(h) is the
+// half-edge that leaves target(h) just before twin(h) in that order, so
+// following next walks around a face of the line graph with the face on the
+// side where signedArea() is positive. Half-edges on the ring of a polygon
+// point at it through face(); a half-edge borders at most one polygon, the
+// first one tracked.
+//
+// Queries and traversals do not allocate.
+class HalfEdgeMesh
+{
+public:
+    static constexpr int kNoHalfEdge = -1;
+
+    void clear();
+    std::size_t halfEdgeCount() const;
+
+    void trackVertex(Vertex *vertex);
+    void untrackVertex(Vertex *vertex);
+    void trackLine(Line *line);
+    void untrackLine(Line *line);
+    void trackPolygon(Polygon *polygon);
+    void untrackPolygon(Polygon *polygon);
+    // Restores the angular order around the vertex and its neighbours.
+    void vertexMoved(Vertex *vertex);
+
+    int halfEdge(const Line *line) const;
+    int outgoing(const Vertex *vertex) const;
+    int boundary(const Polygon *polygon) const;
+
+    static int twin(int halfEdge) { return halfEdge ^ 1; }
+    int next(int halfEdge) const { return m_halfEdges[static_cast<std::size_t>(halfEdge)].next; }
+    int prev(int halfEdge) const { return m_halfEdges[static_cast<std::size_t>(halfEdge)].prev; }
+    Vertex *origin(int halfEdge) const { return m_halfEdges[static_cast<std::size_t>(halfEdge)].origin; }
+    Vertex *target(int halfEdge) const { return origin(twin(halfEdge)); }
+    Line *line(int halfEdge) const { return m_halfEdges[static_cast<std::size_t>(halfEdge)].line; }
+    Polygon *face(int halfEdge) const { return m_halfEdges[static_cast<std::size_t>(halfEdge)].face; }
+    // The half-edge leaving the same origin at the next larger angle.
+    int nextAroundOrigin(int halfEdge) const { return twin(prev(halfEdge)); }
+
+    // Calls visitor(halfEdge) for every half-edge leaving the vertex, in
+    // order of increasing angle.
+    template<typename Visitor>
+    void forEachOutgoing(const Vertex *vertex, Visitor &&visitor) const;
+
+    // Calls visitor(halfEdge) for the half-edges of the polygon's ring, in
+    // ring order. Lines of the graph that end on the ring without being part
+    // of it are stepped over.
+    template<typename Visitor>
+    void forEachBoundaryHalfEdge(const Polygon *polygon, Visitor &&visitor) const;
+
+    // Calls visitor(neighbour) for the polygon across each line of the ring
+    // that has one, so a neighbour sharing several lines is visited for each.
+    template<typename Visitor>
+    void forEachNeighbour(const Polygon *polygon, Visitor &&visitor) const;
+
+    // If lines are exactly the lines around one face of the line graph,
+    // writes them in ring order, with orderedVertices[i] the start of
+    // orderedLines[i], and returns true.
+    bool faceRing(const std::vector<Line *> &lines,
+                  std::vector<Line *> &orderedLines,
+                  std::vector<Vertex *> &orderedVertices) const;
+
+private:
+    struct HalfEdge
+    {
+        Vertex *origin = nullptr;
+        Line *line = nullptr;
+        Polygon *face = nullptr;
+        int next = kNoHalfEdge;
+        int prev = kNoHalfEdge;
+    };
+
+    int allocatePair();
+    void link(int halfEdge);
+    void unlink(int halfEdge);
+    int nextFaceHalfEdge(int halfEdge, const Polygon *polygon) const;
+    void reassignBoundary(Polygon *polygon, int removedPair);
+
+    std::vector<HalfEdge> m_halfEdges;
+    std::vector<int> m_freePairs;
+    std::unordered_map<const Vertex *, int> m_outgoing;
+    std::unordered_map<const Line *, int> m_lineHalfEdges;
+    std::unordered_map<const Polygon *, int> m_boundaries;
+    // Scratch buffers reused by vertexMoved() and faceRing().
+    std::vector<int> m_starScratch;
+    mutable std::vector<const Line *> m_lineScratch;
+    mutable std::vector<const Vertex *> m_vertexScratch;
+};
+
+template<typename Visitor>
+void HalfEdgeMesh::forEachOutgoing(const Vertex *vertex, Visitor &&visitor) const
+{
+    const int first = outgoing(vertex);
+    if (first == kNoHalfEdge)
+        return;
+
+    int halfEdge = first;
+    do {
+        visitor(halfEdge);
+        halfEdge = nextAroundOrigin(halfEdge);
+    } while (halfEdge != first);
+}
+
+template<typename Visitor>
+void HalfEdgeMesh::forEachBoundaryHalfEdge(const Polygon *polygon, Visitor &&visitor) const
+{
+    const int first = boundary(polygon);
+    if (first == kNoHalfEdge)
+        return;
+
+    int halfEdge = first;
+    std::size_t steps = 0;
+    do {
+        visitor(halfEdge);
+        halfEdge = nextFaceHalfEdge(halfEdge, polygon);
+    } while (halfEdge != kNoHalfEdge && halfEdge != first && ++steps < m_halfEdges.size());
+}
+
+template<typename Visitor>
+void HalfEdgeMesh::forEachNeighbour(const Polygon *polygon, Visitor &&visitor) const
+{
+    forEachBoundaryHalfEdge(polygon, [&](int halfEdge) {
+        Polygon *neighbour = face(twin(halfEdge));
+        if (neighbour && neighbour != polygon)
+            visitor(neighbour);
+    });
+}
+
+#endif // HALFEDGEMESH_H
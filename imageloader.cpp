@@ -0,0 +1,111 @@
+#include "imageloader.h"
+
+#include <QImageIOHandler>
+#include <QImageReader>
+#include <QPromise>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+
+namespace {
+constexpr int kPreviewMaximumDimension = 2048;
+
+void decodeImage(QPromise<DecodedImage> &promise, const QString &filePath)
+{
+    promise.setProgressRange(0, 100);
+    promise.setProgressValue(0);
+
+    QImageReader reader(filePath);
+    const QSize fullSize = reader.size();
+    promise.setProgressValue(5);
+
+    // Only formats that can decode straight to a smaller size (e.g. JPEG) get a
+    // preview pass; for everything else a preview would cost a second full decode.
+    const bool wantsPreview = fullSize.isValid()
+                              && std::max(fullSize.width(), fullSize.height()) > kPreviewMaximumDimension
+                              && reader.supportsOption(QImageIOHandler::ScaledSize);
+
+    if (wantsPreview) {
+        if (promise.isCanceled())
+            return;
+
+        QImageReader previewReader(filePath);
+        previewReader.setScaledSize(fullSize.scaled(kPreviewMaximumDimension,
+                                                    kPreviewMaximumDimension,
+                                                    Qt::KeepAspectRatio));
+        const QImage preview = previewReader.read();
+        if (!preview.isNull())
+            promise.addResult(DecodedImage{preview, true, QString()});
+
+        promise.setProgressValue(30);
+    }
+
+    if (promise.isCanceled())
+        return;
+
+    const QImage image = reader.read();
+    if (image.isNull()) {
+        promise.addResult(DecodedImage{QImage(), false, reader.errorString()});
+        return;
+    }
+
+    promise.addResult(DecodedImage{image, false, QString()});
+    promise.setProgressValue(100);
+}
+} // namespace
+
+ImageLoader::ImageLoader(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_watcher, &QFutureWatcher<DecodedImage>::resultReadyAt, this, &ImageLoader::handleResultReady);
+    connect(&m_watcher, &QFutureWatcher<DecodedImage>::progressValueChanged, this, &ImageLoader::progressChanged);
+}
+
+ImageLoader::~ImageLoader()
+{
+    cancel();
+}
+
+QSize ImageLoader::readImageSize(const QString &filePath, QString *errorString)
+{
+    QImageReader reader(filePath);
+    if (!reader.canRead()) {
+        if (errorString)
+            *errorString = reader.errorString();
+        return QSize();
+    }
+
+    return reader.size();
+}
+
+void ImageLoader::load(const QString &filePath)
+{
+    cancel();
+    m_watcher.setFuture(QtConcurrent::run(decodeImage, filePath));
+}
+
+void ImageLoader::cancel()
+{
+    if (m_watcher.isRunning())
+        m_watcher.cancel();
+}
+
+bool ImageLoader::isLoading() const
+{
+    return m_watcher.isRunning() && !m_watcher.isCanceled();
+}
+
+void ImageLoader::handleResultReady(int index)
+{
+    if (m_watcher.isCanceled())
+        return;
+
+    const DecodedImage result = m_watcher.resultAt(index);
+    if (!result.errorString.isEmpty() || result.image.isNull()) {
+        emit loadFailed(result.errorString);
+    } else if (result.preview) {
+        emit previewReady(result.image);
+    } else {
+        emit imageReady(result.image);
+    }
+}
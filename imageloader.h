@@ -0,0 +1,43 @@
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include <QFutureWatcher>
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QString>
+
+struct DecodedImage
+{
+    QImage image;
+    bool preview = false;
+    QString errorString;
+};
+
+class ImageLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImageLoader(QObject *parent = nullptr);
+    ~ImageLoader() override;
+
+    static QSize readImageSize(const QString &filePath, QString *errorString = nullptr);
+
+    void load(const QString &filePath);
+    void cancel();
+    bool isLoading() const;
+
+signals:
+    void progressChanged(int percent);
+    void previewReady(const QImage &preview);
+    void imageReady(const QImage &image);
+    void loadFailed(const QString &errorString);
+
+private:
+    void handleResultReady(int index);
+
+    QFutureWatcher<DecodedImage> m_watcher;
+};
+
+#endif // IMAGELOADER_H
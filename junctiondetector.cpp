@@ -0,0 +1,126 @@
+#include "junctiondetector.h"
+
+#include "pixelcomponents.h"
+#include "stripes.h"
+
+#include <QtAlgorithms>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <array>
+
+namespace {
+constexpr int kJunctionCrossingNumber = 3;
+
+// Indexed by the neighbour bits p0..p7 = E, NE, N, NW, W, SW, S, SE.
+const std::array<quint8, 256> &crossingNumbers()
+{
+    static const std::array<quint8, 256> table = [] {
+        std::array<quint8, 256> result{};
+        for (int mask = 0; mask < 256; ++mask) {
+            int transitions = 0;
+            for (int i = 0; i < 8; ++i) {
+                if (!(mask & (1 << i)) && (mask & (1 << ((i + 1) % 8))))
+                    ++transitions;
+            }
+            result[static_cast<std::size_t>(mask)] = static_cast<quint8>(transitions);
+        }
+        return result;
+    }();
+    return table;
+}
+
+int bitAt(const quint64 *row, int x, int width)
+{
+    if (!row || x < 0 || x >= width)
+        return 0;
+    return static_cast<int>((row[x / 64] >> (x % 64)) & 1);
+}
+
+int neighbourMask(const BinaryImage &image, int x, int y)
+{
+    const int width = image.width();
+    const quint64 *above = y > 0 ? image.row(y - 1) : nullptr;
+    const quint64 *current = image.row(y);
+    const quint64 *below = y + 1 < image.height() ? image.row(y + 1) : nullptr;
+    return bitAt(current, x + 1, width) | bitAt(above, x + 1, width) << 1 | bitAt(above, x, width) << 2
+           | bitAt(above, x - 1, width) << 3 | bitAt(current, x - 1, width) << 4 | bitAt(below, x - 1, width) << 5
+           | bitAt(below, x, width) << 6 | bitAt(below, x + 1, width) << 7;
+}
+} // namespace
+
+BinaryImage junctionPixels(const BinaryImage &skeleton)
+{
+    BinaryImage junctions(skeleton.width(), skeleton.height());
+    if (skeleton.isNull())
+        return junctions;
+
+    std::vector<Stripe> stripes = makeStripes(skeleton.height());
+    const auto &table = crossingNumbers();
+    QtConcurrent::blockingMap(stripes, [&](Stripe &stripe) {
+        for (int y = stripe.first; y < stripe.end; ++y) {
+            const quint64 *row = skeleton.row(y);
+            quint64 *output = junctions.row(y);
+            for (int w = 0; w < skeleton.wordsPerRow(); ++w) {
+                for (quint64 bits = row[w]; bits != 0; bits &= bits - 1) {
+                    const int bit = static_cast<int>(qCountTrailingZeroBits(bits));
+                    const int mask = neighbourMask(skeleton, w * 64 + bit, y);
+                    if (table[static_cast<std::size_t>(mask)] >= kJunctionCrossingNumber)
+                        output[w] |= quint64(1) << bit;
+                }
+            }
+        }
+    });
+    return junctions;
+}
+
+BinaryImage junctionRegions(const BinaryImage &skeleton, const BinaryImage &junctionPixels)
+{
+    BinaryImage regions(skeleton.width(), skeleton.height());
+    const int wordsPerRow = skeleton.wordsPerRow();
+    std::vector<quint64> spread(static_cast<std::size_t>(wordsPerRow));
+    for (int y = 0; y < skeleton.height(); ++y) {
+        // Junction pixels of this row and its neighbours, spread sideways.
+        std::fill(spread.begin(), spread.end(), 0);
+        for (int sourceY = std::max(0, y - 1); sourceY <= std::min(skeleton.height() - 1, y + 1); ++sourceY) {
+            const quint64 *row = junctionPixels.row(sourceY);
+            for (int w = 0; w < wordsPerRow; ++w) {
+                spread[static_cast<std::size_t>(w)] |= row[w] | row[w] << 1 | row[w] >> 1
+                                                       | (w > 0 ? row[w - 1] >> 63 : 0)
+                                                       | (w + 1 < wordsPerRow ? row[w + 1] << 63 : 0);
+            }
+        }
+
+        const quint64 *skeletonRow = skeleton.row(y);
+        quint64 *output = regions.row(y);
+        for (int w = 0; w < wordsPerRow; ++w)
+            output[w] = spread[static_cast<std::size_t>(w)] & skeletonRow[w];
+    }
+    return regions;
+}
+
+std::vector<QPointF> junctionCentres(const PixelComponents &regions, const BinaryImage &junctionPixels)
+{
+    std::vector<QPointF> centres;
+    centres.reserve(static_cast<std::size_t>(regions.componentCount()));
+    for (int component = 0; component < regions.componentCount(); ++component) {
+        QPointF sum;
+        int count = 0;
+        for (const int *it = regions.componentBegin(component); it != regions.componentEnd(component); ++it) {
+            const QPoint pixel = regions.pixel(*it);
+            if (junctionPixels.pixel(pixel.x(), pixel.y())) {
+                sum += pixel;
+                ++count;
+            }
+        }
+        // Pixel (x, y) covers [x, x + 1) x [y, y + 1) in the scene.
+        centres.push_back(sum / count + QPointF(0.5, 0.5));
+    }
+    return centres;
+}
+
+std::vector<QPointF> detectJunctions(const BinaryImage &skeleton)
+{
+    const BinaryImage junctions = junctionPixels(skeleton);
+    return junctionCentres(PixelComponents(junctionRegions(skeleton, junctions)), junctions);
+}
@@ -0,0 +1,29 @@
+#ifndef JUNCTIONDETECTOR_H
+#define JUNCTIONDETECTOR_H
+
+#include "binaryimage.h"
+
+#include <QPointF>
+
+#include <vector>
+
+class PixelComponents;
+
+// Pixels of a one pixel wide skeleton whose crossing number (0 -> 1
+// transitions around the 3x3 neighbourhood) is three or more.
+BinaryImage junctionPixels(const BinaryImage &skeleton);
+
+// Junction pixels together with the skeleton pixels touching them. The
+// branches leaving a junction touch each other next to it, so they only
+// separate outside this region; junction pixels whose regions touch form a
+// single junction.
+BinaryImage junctionRegions(const BinaryImage &skeleton, const BinaryImage &junctionPixels);
+
+// The centre of the junction pixels in each component of the regions, in
+// image coordinates, indexed like the components.
+std::vector<QPointF> junctionCentres(const PixelComponents &regions, const BinaryImage &junctionPixels);
+
+// The junctionCentres of skeleton, in raster order.
+std::vector<QPointF> detectJunctions(const BinaryImage &skeleton);
+
+#endif // JUNCTIONDETECTOR_H
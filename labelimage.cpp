@@ -0,0 +1,126 @@
+#include "labelimage.h"
+
+#include <QImage>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+LabelImage::LabelImage(int width, int height, int labelCount)
+    : m_width(std::max(0, width))
+    , m_height(std::max(0, height))
+    , m_labelCount(std::max(0, labelCount))
+    , m_labels(static_cast<std::size_t>(m_width) * m_height, 0)
+{
+}
+
+LabelImage LabelImage::fromImage(const QImage &image)
+{
+    if (image.isNull())
+        return LabelImage();
+
+    const int width = image.width();
+    const int height = image.height();
+    LabelImage result(width, height, 0);
+
+    if (image.format() == QImage::Format_Grayscale8 || image.format() == QImage::Format_Grayscale16) {
+        const bool wide = image.format() == QImage::Format_Grayscale16;
+        std::vector<int> rows(static_cast<std::size_t>(height));
+        std::iota(rows.begin(), rows.end(), 0);
+        std::vector<int> rowMaxima(rows.size(), 0);
+        QtConcurrent::blockingMap(rows, [&](const int &y) {
+            int *labels = result.row(y);
+            if (wide) {
+                const auto *pixels = reinterpret_cast<const quint16 *>(image.constScanLine(y));
+                std::copy(pixels, pixels + width, labels);
+            } else {
+                const uchar *pixels = image.constScanLine(y);
+                std::copy(pixels, pixels + width, labels);
+            }
+            rowMaxima[static_cast<std::size_t>(y)] = *std::max_element(labels, labels + width);
+        });
+        result.m_labelCount = *std::max_element(rowMaxima.begin(), rowMaxima.end());
+        return result;
+    }
+
+    // Colours are few and repeat in long runs, so one lookup per run is
+    // enough and this stays serial.
+    const QImage rgb = image.convertToFormat(QImage::Format_RGB32);
+    std::unordered_map<QRgb, int> colourLabels;
+    colourLabels.emplace(qRgb(0, 0, 0), 0);
+    for (int y = 0; y < height; ++y) {
+        const auto *pixels = reinterpret_cast<const QRgb *>(rgb.constScanLine(y));
+        int *labels = result.row(y);
+        QRgb runColour = qRgb(0, 0, 0);
+        int runLabel = 0;
+        for (int x = 0; x < width; ++x) {
+            if (pixels[x] != runColour) {
+                runColour = pixels[x];
+                runLabel = colourLabels.emplace(runColour, static_cast<int>(colourLabels.size())).first->second;
+            }
+            labels[x] = runLabel;
+        }
+    }
+    result.m_labelCount = static_cast<int>(colourLabels.size()) - 1;
+    return result;
+}
+
+bool LabelImage::isNull() const
+{
+    return m_labels.empty();
+}
+
+int LabelImage::width() const
+{
+    return m_width;
+}
+
+int LabelImage::height() const
+{
+    return m_height;
+}
+
+int LabelImage::labelCount() const
+{
+    return m_labelCount;
+}
+
+int LabelImage::label(int x, int y) const
+{
+    return m_labels[static_cast<std::size_t>(y) * m_width + x];
+}
+
+void LabelImage::setLabel(int x, int y, int label)
+{
+    m_labels[static_cast<std::size_t>(y) * m_width + x] = label;
+}
+
+int *LabelImage::row(int y)
+{
+    return m_labels.data() + static_cast<std::size_t>(y) * m_width;
+}
+
+const int *LabelImage::row(int y) const
+{
+    return m_labels.data() + static_cast<std::size_t>(y) * m_width;
+}
+
+BinaryImage LabelImage::boundaries() const
+{
+    BinaryImage result(m_width, m_height);
+    std::vector<int> rows(static_cast<std::size_t>(m_height));
+    std::iota(rows.begin(), rows.end(), 0);
+
+    QtConcurrent::blockingMap(rows, [&](const int &y) {
+        const int *labels = row(y);
+        const int *below = y + 1 < m_height ? row(y + 1) : labels;
+        quint64 *words = result.row(y);
+        for (int x = 0; x < m_width; ++x) {
+            const int right = x + 1 < m_width ? labels[x + 1] : labels[x];
+            if (right != labels[x] || below[x] != labels[x])
+                words[x / 64] |= quint64(1) << (x % 64);
+        }
+    });
+    return result;
+}
@@ -0,0 +1,45 @@
+#ifndef LABELIMAGE_H
+#define LABELIMAGE_H
+
+#include "binaryimage.h"
+
+#include <vector>
+
+class QImage;
+
+// One integer label per pixel, as produced by a segmentation: 0 for pixels
+// that belong to no region, 1..labelCount() for the regions.
+class LabelImage
+{
+public:
+    LabelImage() = default;
+    LabelImage(int width, int height, int labelCount);
+
+    // Reads a label mask as written by segmentation tools: 8- and 16-bit
+    // grey pixels are the labels themselves, and in colour masks every
+    // colour but black is a label of its own, numbered in raster order.
+    static LabelImage fromImage(const QImage &image);
+
+    bool isNull() const;
+    int width() const;
+    int height() const;
+    int labelCount() const;
+
+    int label(int x, int y) const;
+    void setLabel(int x, int y, int label);
+    int *row(int y);
+    const int *row(int y) const;
+
+    // Pixels whose right or lower neighbour has another label, i.e. a one
+    // pixel wide trace of the region boundaries that thinToSkeleton turns
+    // into a skeleton.
+    BinaryImage boundaries() const;
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    int m_labelCount = 0;
+    std::vector<int> m_labels;
+};
+
+#endif // LABELIMAGE_H
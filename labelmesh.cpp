@@ -0,0 +1,640 @@
+#include "labelmesh.h"
+
+#include "faceextractor.h"
+#include "meshgeometry.h"
+
+#include <QtAlgorithms>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <tuple>
+
+namespace {
+// Lattice points per tile side; a tile of label rows stays in cache.
+constexpr int kTileSize = 256;
+
+// Directions along the pixel edges, as bits of Cracks::edges().
+enum Direction
+{
+    Right,
+    Down,
+    Left,
+    Up,
+};
+constexpr int kStepX[4] = {1, 0, -1, 0};
+constexpr int kStepY[4] = {0, 1, 0, -1};
+
+int opposite(int direction)
+{
+    return (direction + 2) % 4;
+}
+
+// The pixel edges between different labels. Lattice point (x, y) is the
+// corner shared by pixels (x - 1, y - 1), (x, y - 1), (x - 1, y) and (x, y).
+class Cracks
+{
+public:
+    explicit Cracks(const LabelImage &labels)
+        : m_labels(labels)
+        , m_width(labels.width())
+        , m_height(labels.height())
+    {
+    }
+
+    int label(int x, int y) const
+    {
+        return x >= 0 && x < m_width && y >= 0 && y < m_height ? m_labels.row(y)[x] : 0;
+    }
+
+    // Bit d is set if the edge from (x, y) in direction d separates labels.
+    int edges(int x, int y) const
+    {
+        const int northWest = label(x - 1, y - 1);
+        const int northEast = label(x, y - 1);
+        const int southWest = label(x - 1, y);
+        const int southEast = label(x, y);
+        return (northEast != southEast ? 1 << Right : 0) | (southWest != southEast ? 1 << Down : 0)
+               | (northWest != southWest ? 1 << Left : 0) | (northWest != northEast ? 1 << Up : 0);
+    }
+
+    // The labels on the inside (to the right, looking along the edge with y
+    // down, which is the inside of a face with positive signedArea) and on
+    // the outside of the edge from (x, y) in direction d.
+    std::pair<int, int> sides(int x, int y, int direction) const
+    {
+        switch (direction) {
+        case Right:
+            return {label(x, y), label(x, y - 1)};
+        case Down:
+            return {label(x - 1, y), label(x, y)};
+        case Left:
+            return {label(x - 1, y - 1), label(x - 1, y)};
+        default:
+            return {label(x, y - 1), label(x - 1, y - 1)};
+        }
+    }
+
+private:
+    const LabelImage &m_labels;
+    int m_width = 0;
+    int m_height = 0;
+};
+
+struct Chain
+{
+    // Vertex indices; -1 for both on a closed boundary without junctions,
+    // which gets a vertex of its own at its first point.
+    int start = -1;
+    int end = -1;
+    int inside = 0;
+    int outside = 0;
+    // The corners of the boundary, and what is left after simplification.
+    std::vector<QPointF> corners;
+    std::vector<QPointF> simplified;
+};
+
+struct Tile
+{
+    // Lattice points [firstX, endX) x [firstY, endY).
+    int firstX = 0;
+    int endX = 0;
+    int firstY = 0;
+    int endY = 0;
+    // Keys y * (width + 1) + x of the junctions, in raster order, and the
+    // index of the first one among all junctions.
+    std::vector<qint64> junctions;
+    int firstJunction = 0;
+    std::vector<Chain> chains;
+};
+
+// A chain as it goes into the mesh: its end vertices and the points its
+// lines run through, which are some of its corners.
+struct Path
+{
+    explicit Path(const Chain &chain)
+        : chain(&chain)
+        , points(chain.simplified)
+    {
+        cornerIndices.reserve(points.size());
+        int corner = 0;
+        for (const QPointF &position : points) {
+            while (chain.corners[static_cast<std::size_t>(corner)] != position)
+                ++corner;
+            cornerIndices.push_back(corner++);
+        }
+    }
+
+    // Whether simplification dropped any corner.
+    bool hasShortcuts() const { return points.size() < chain->corners.size(); }
+
+    void revert()
+    {
+        points = chain->corners;
+        cornerIndices.resize(points.size());
+        std::iota(cornerIndices.begin(), cornerIndices.end(), 0);
+    }
+
+    const Chain *chain = nullptr;
+    int start = 0;
+    int end = 0;
+    std::vector<QPointF> points;
+    // Index into chain->corners of each point.
+    std::vector<int> cornerIndices;
+    bool conflicting = false;
+};
+
+// Lattice points per side of a PathGrid cell.
+constexpr int kGridCellSize = 32;
+
+qreal cross(const QPointF &a, const QPointF &b)
+{
+    return a.x() * b.y() - a.y() * b.x();
+}
+
+bool onSegment(const QPointF &position, const QPointF &a, const QPointF &b)
+{
+    return cross(b - a, position - a) == 0.0 && std::min(a.x(), b.x()) <= position.x()
+           && position.x() <= std::max(a.x(), b.x()) && std::min(a.y(), b.y()) <= position.y()
+           && position.y() <= std::max(a.y(), b.y());
+}
+
+// Whether segments ab and cd have a point in common other than an end point
+// they share. Path points lie on the lattice, so the tests are exact.
+bool segmentsConflict(const QPointF &a, const QPointF &b, const QPointF &c, const QPointF &d)
+{
+    const bool sharesA = a == c || a == d;
+    const bool sharesB = b == c || b == d;
+    if (sharesA && sharesB)
+        return true;
+    if (sharesA || sharesB) {
+        // Two segments from one point meet again only if they overlap.
+        const QPointF common = sharesA ? a : b;
+        const QPointF own = (sharesA ? b : a) - common;
+        const QPointF other = (c == common ? d : c) - common;
+        return cross(own, other) == 0.0 && QPointF::dotProduct(own, other) > 0.0;
+    }
+    const qreal sideC = cross(b - a, c - a);
+    const qreal sideD = cross(b - a, d - a);
+    const qreal sideA = cross(d - c, a - c);
+    const qreal sideB = cross(d - c, b - c);
+    if (((sideC > 0.0 && sideD < 0.0) || (sideC < 0.0 && sideD > 0.0))
+        && ((sideA > 0.0 && sideB < 0.0) || (sideA < 0.0 && sideB > 0.0))) {
+        return true;
+    }
+    return onSegment(c, a, b) || onSegment(d, a, b) || onSegment(a, c, d) || onSegment(b, c, d);
+}
+
+// Whether position lies inside or on the ring of corners[first..last]
+// closed by the shortcut from corners[last] back to corners[first].
+bool insideOrOnRing(const QPointF &position, const std::vector<QPointF> &corners, int first, int last)
+{
+    bool inside = false;
+    for (int i = first; i <= last; ++i) {
+        const QPointF &a = corners[static_cast<std::size_t>(i)];
+        const QPointF &b = corners[static_cast<std::size_t>(i < last ? i + 1 : first)];
+        if (onSegment(position, a, b))
+            return true;
+        if ((a.y() > position.y()) != (b.y() > position.y())
+            && position.x() < a.x() + (position.y() - a.y()) * (b.x() - a.x()) / (b.y() - a.y())) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+// The points and lines of all paths by the grid cells they touch, to find
+// what lies near a shortcut.
+class PathGrid
+{
+public:
+    PathGrid(const std::vector<Path> &paths, int latticeWidth, int latticeHeight)
+        : m_columns(latticeWidth / kGridCellSize + 1)
+        , m_rows(latticeHeight / kGridCellSize + 1)
+        , m_points(static_cast<std::size_t>(m_columns) * m_rows)
+        , m_lines(m_points.size())
+    {
+        for (std::size_t path = 0; path < paths.size(); ++path) {
+            const std::vector<QPointF> &points = paths[path].points;
+            for (std::size_t i = 0; i < points.size(); ++i) {
+                const Entry entry{static_cast<int>(path), static_cast<int>(i)};
+                m_points[cell(points[i].x(), points[i].y())].push_back(entry);
+                if (i + 1 == points.size())
+                    continue;
+                const QPointF &next = points[i + 1];
+                visitCells(m_lines,
+                           std::min(points[i].x(), next.x()),
+                           std::min(points[i].y(), next.y()),
+                           std::max(points[i].x(), next.x()),
+                           std::max(points[i].y(), next.y()),
+                           [&](std::vector<Entry> &cell) {
+                               cell.push_back(entry);
+                               return false;
+                           });
+            }
+        }
+    }
+
+    // Whether a shortcut of paths[index] conflicts with any path.
+    bool hasConflict(const std::vector<Path> &paths, std::size_t index) const
+    {
+        const Path &path = paths[index];
+        for (std::size_t i = 0; i + 1 < path.points.size(); ++i) {
+            if (path.cornerIndices[i + 1] - path.cornerIndices[i] > 1
+                && (crossesLine(paths, index, i) || enclosesPoint(paths, index, i))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Entry
+    {
+        int path;
+        int index;
+    };
+
+    const QPointF &pointOf(const std::vector<Path> &paths, const Entry &entry) const
+    {
+        return paths[static_cast<std::size_t>(entry.path)].points[static_cast<std::size_t>(entry.index)];
+    }
+
+    // Whether line i of paths[index] meets another line other than at a
+    // shared end.
+    bool crossesLine(const std::vector<Path> &paths, std::size_t index, std::size_t i) const
+    {
+        const Entry own{static_cast<int>(index), static_cast<int>(i)};
+        const QPointF &a = pointOf(paths, own);
+        const QPointF &b = paths[index].points[i + 1];
+        return visitCells(m_lines,
+                          std::min(a.x(), b.x()),
+                          std::min(a.y(), b.y()),
+                          std::max(a.x(), b.x()),
+                          std::max(a.y(), b.y()),
+                          [&](const std::vector<Entry> &cell) {
+                              for (const Entry &line : cell) {
+                                  if (line.path == own.path && line.index == own.index)
+                                      continue;
+                                  const Entry lineEnd{line.path, line.index + 1};
+                                  if (segmentsConflict(a, b, pointOf(paths, line), pointOf(paths, lineEnd)))
+                                      return true;
+                              }
+                              return false;
+                          });
+    }
+
+    // Whether the corners line i of paths[index] skips, closed by the line,
+    // enclose a point of any path, which would change sides.
+    bool enclosesPoint(const std::vector<Path> &paths, std::size_t index, std::size_t i) const
+    {
+        const Path &path = paths[index];
+        const std::vector<QPointF> &corners = path.chain->corners;
+        const int first = path.cornerIndices[i];
+        const int last = path.cornerIndices[i + 1];
+        const QPointF &a = corners[static_cast<std::size_t>(first)];
+        const QPointF &b = corners[static_cast<std::size_t>(last)];
+        qreal left = a.x();
+        qreal top = a.y();
+        qreal right = a.x();
+        qreal bottom = a.y();
+        for (int corner = first + 1; corner <= last; ++corner) {
+            const QPointF &position = corners[static_cast<std::size_t>(corner)];
+            left = std::min(left, position.x());
+            top = std::min(top, position.y());
+            right = std::max(right, position.x());
+            bottom = std::max(bottom, position.y());
+        }
+        return visitCells(m_points, left, top, right, bottom, [&](const std::vector<Entry> &cell) {
+            for (const Entry &point : cell) {
+                const QPointF &position = pointOf(paths, point);
+                if (position != a && position != b && insideOrOnRing(position, corners, first, last))
+                    return true;
+            }
+            return false;
+        });
+    }
+
+    std::size_t cell(qreal x, qreal y) const
+    {
+        const int column = std::clamp(static_cast<int>(x) / kGridCellSize, 0, m_columns - 1);
+        const int row = std::clamp(static_cast<int>(y) / kGridCellSize, 0, m_rows - 1);
+        return static_cast<std::size_t>(row) * m_columns + column;
+    }
+
+    // Calls visit on the cells overlapping the bounds until it returns true.
+    template<typename Cells, typename Visit>
+    bool visitCells(Cells &cells, qreal left, qreal top, qreal right, qreal bottom, Visit visit) const
+    {
+        const std::size_t topLeft = cell(left, top);
+        const std::size_t bottomRight = cell(right, bottom);
+        const std::size_t columns = bottomRight % m_columns - topLeft % m_columns + 1;
+        for (std::size_t rowStart = topLeft; rowStart <= bottomRight; rowStart += m_columns) {
+            for (std::size_t column = 0; column < columns; ++column) {
+                if (visit(cells[rowStart + column]))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    int m_columns = 0;
+    int m_rows = 0;
+    std::vector<std::vector<Entry>> m_points;
+    std::vector<std::vector<Entry>> m_lines;
+};
+
+class LabelMeshBuilder
+{
+public:
+    LabelMeshBuilder(const LabelImage &labels, qreal tolerance)
+        : m_cracks(labels)
+        , m_latticeWidth(labels.width() + 1)
+        , m_latticeHeight(labels.height() + 1)
+        , m_tilesPerRow((m_latticeWidth + kTileSize - 1) / kTileSize)
+        , m_tolerance(tolerance)
+    {
+        const int tilesPerColumn = (m_latticeHeight + kTileSize - 1) / kTileSize;
+        m_tiles.resize(static_cast<std::size_t>(m_tilesPerRow) * tilesPerColumn);
+        for (int row = 0; row < tilesPerColumn; ++row) {
+            for (int column = 0; column < m_tilesPerRow; ++column) {
+                Tile &tile = m_tiles[static_cast<std::size_t>(row) * m_tilesPerRow + column];
+                tile.firstX = column * kTileSize;
+                tile.endX = std::min(m_latticeWidth, tile.firstX + kTileSize);
+                tile.firstY = row * kTileSize;
+                tile.endY = std::min(m_latticeHeight, tile.firstY + kTileSize);
+            }
+        }
+    }
+
+    PlanarMesh build(std::vector<int> *lostLabels)
+    {
+        QtConcurrent::blockingMap(m_tiles, [this](Tile &tile) { findJunctions(tile); });
+
+        // Numbering the junctions of all tiles lets a chain that leaves its
+        // tile find the junction it ends on.
+        int junctionCount = 0;
+        for (Tile &tile : m_tiles) {
+            tile.firstJunction = junctionCount;
+            junctionCount += static_cast<int>(tile.junctions.size());
+        }
+
+        QtConcurrent::blockingMap(m_tiles, [this](Tile &tile) {
+            traceChains(tile);
+            traceClosedBoundaries(tile);
+            for (Chain &chain : tile.chains)
+                chain.simplified = simplifyPolyline(chain.corners, m_tolerance);
+        });
+
+        return assemble(junctionCount, lostLabels);
+    }
+
+private:
+    qint64 key(int x, int y) const { return static_cast<qint64>(y) * m_latticeWidth + x; }
+
+    QPointF point(qint64 key) const
+    {
+        return QPointF(static_cast<qreal>(key % m_latticeWidth), static_cast<qreal>(key / m_latticeWidth));
+    }
+
+    static bool isJunction(int edges) { return qPopulationCount(static_cast<quint32>(edges)) > 2; }
+
+    int junctionIndex(int x, int y) const
+    {
+        const Tile &tile = m_tiles[static_cast<std::size_t>(y / kTileSize) * m_tilesPerRow + x / kTileSize];
+        const auto it = std::lower_bound(tile.junctions.begin(), tile.junctions.end(), key(x, y));
+        return tile.firstJunction + static_cast<int>(it - tile.junctions.begin());
+    }
+
+    void findJunctions(Tile &tile) const
+    {
+        for (int y = tile.firstY; y < tile.endY; ++y) {
+            for (int x = tile.firstX; x < tile.endX; ++x) {
+                if (isJunction(m_cracks.edges(x, y)))
+                    tile.junctions.push_back(key(x, y));
+            }
+        }
+    }
+
+    // Follows the boundary from (x, y) in direction until it reaches a
+    // junction or returns to (x, y), recording the corners on the way.
+    // Returns the end point and the direction it is entered from there.
+    std::pair<qint64, int> follow(int x, int y, int direction, std::vector<QPointF> &corners) const
+    {
+        const qint64 startKey = key(x, y);
+        corners.assign(1, QPointF(x, y));
+        for (;;) {
+            x += kStepX[direction];
+            y += kStepY[direction];
+            const int edges = m_cracks.edges(x, y);
+            if (isJunction(edges) || key(x, y) == startKey) {
+                corners.emplace_back(x, y);
+                return {key(x, y), opposite(direction)};
+            }
+            const int next = qCountTrailingZeroBits(static_cast<quint32>(edges & ~(1 << opposite(direction))));
+            if (next != direction)
+                corners.emplace_back(x, y);
+            direction = next;
+        }
+    }
+
+    // Every chain is found from both of its ends; the end with the smaller
+    // (key, direction) keeps it.
+    void traceChains(Tile &tile) const
+    {
+        std::vector<QPointF> corners;
+        for (std::size_t i = 0; i < tile.junctions.size(); ++i) {
+            const qint64 startKey = tile.junctions[i];
+            const int x = static_cast<int>(startKey % m_latticeWidth);
+            const int y = static_cast<int>(startKey / m_latticeWidth);
+            const int edges = m_cracks.edges(x, y);
+            for (int direction = Right; direction <= Up; ++direction) {
+                if (!(edges & (1 << direction)))
+                    continue;
+                const auto [endKey, endDirection] = follow(x, y, direction, corners);
+                if (std::make_pair(endKey, endDirection) < std::make_pair(startKey, direction))
+                    continue;
+
+                Chain chain;
+                chain.start = tile.firstJunction + static_cast<int>(i);
+                chain.end = junctionIndex(static_cast<int>(endKey % m_latticeWidth),
+                                          static_cast<int>(endKey / m_latticeWidth));
+                std::tie(chain.inside, chain.outside) = m_cracks.sides(x, y, direction);
+                chain.corners = corners;
+                tile.chains.push_back(std::move(chain));
+            }
+        }
+    }
+
+    // Boundaries without any junction, such as a region surrounded by a
+    // single other one, are closed. Each is traced from its first point in
+    // raster order, which has edges right and down; other candidates give up
+    // on meeting an earlier point or a junction.
+    void traceClosedBoundaries(Tile &tile) const
+    {
+        std::vector<QPointF> corners;
+        for (int y = tile.firstY; y < tile.endY; ++y) {
+            for (int x = tile.firstX; x < tile.endX; ++x) {
+                if (m_cracks.edges(x, y) != ((1 << Right) | (1 << Down)) || !isFirstOfClosedBoundary(x, y))
+                    continue;
+
+                follow(x, y, Right, corners);
+                Chain chain;
+                std::tie(chain.inside, chain.outside) = m_cracks.sides(x, y, Right);
+                chain.corners = corners;
+                tile.chains.push_back(std::move(chain));
+            }
+        }
+    }
+
+    bool isFirstOfClosedBoundary(int startX, int startY) const
+    {
+        int x = startX;
+        int y = startY;
+        int direction = Right;
+        do {
+            x += kStepX[direction];
+            y += kStepY[direction];
+            if (y < startY || (y == startY && x < startX))
+                return false;
+            const int edges = m_cracks.edges(x, y);
+            if (isJunction(edges))
+                return false;
+            direction = qCountTrailingZeroBits(static_cast<quint32>(edges & ~(1 << opposite(direction))));
+        } while (x != startX || y != startY);
+        return true;
+    }
+
+    // Chains whose simplified shortcuts cross another chain, touch one, or
+    // move a point of another chain (or of their own) to the other side go
+    // back to their corners. Reverting adds points, which can put other
+    // shortcuts in conflict, so this repeats until nothing changes.
+    void keepTopology(std::vector<Path> &paths) const
+    {
+        std::vector<std::size_t> pending;
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            if (paths[i].hasShortcuts())
+                pending.push_back(i);
+        }
+        while (!pending.empty()) {
+            const PathGrid grid(paths, m_latticeWidth, m_latticeHeight);
+            QtConcurrent::blockingMap(pending, [&](std::size_t &index) {
+                paths[index].conflicting = grid.hasConflict(paths, index);
+            });
+
+            const auto firstKept = std::partition(pending.begin(), pending.end(), [&](std::size_t index) {
+                return !paths[index].conflicting;
+            });
+            if (firstKept == pending.end())
+                break;
+            for (auto it = firstKept; it != pending.end(); ++it)
+                paths[*it].revert();
+            pending.erase(firstKept, pending.end());
+        }
+    }
+
+    PlanarMesh assemble(int junctionCount, std::vector<int> *lostLabels) const
+    {
+        PlanarMesh mesh;
+        mesh.vertices.reserve(static_cast<std::size_t>(junctionCount));
+        for (const Tile &tile : m_tiles) {
+            for (const qint64 junction : tile.junctions)
+                mesh.vertices.push_back(point(junction));
+        }
+
+        std::vector<Path> paths;
+        std::vector<int> labels;
+        for (const Tile &tile : m_tiles) {
+            for (const Chain &chain : tile.chains) {
+                Path path(chain);
+                path.start = chain.start;
+                if (path.start < 0) {
+                    path.start = static_cast<int>(mesh.vertices.size());
+                    mesh.vertices.push_back(chain.corners.front());
+                }
+                path.end = chain.end < 0 ? path.start : chain.end;
+                paths.push_back(std::move(path));
+                labels.push_back(chain.inside);
+                labels.push_back(chain.outside);
+            }
+        }
+        keepTopology(paths);
+
+        // Labels inside and outside of each line, from its first vertex to
+        // its second.
+        std::vector<std::pair<int, int>> lineSides;
+        for (const Path &path : paths) {
+            int previous = path.start;
+            for (std::size_t i = 1; i < path.points.size(); ++i) {
+                int current = path.end;
+                if (i + 1 < path.points.size()) {
+                    current = static_cast<int>(mesh.vertices.size());
+                    mesh.vertices.push_back(path.points[i]);
+                }
+                mesh.lines.emplace_back(previous, current);
+                lineSides.emplace_back(path.chain->inside, path.chain->outside);
+                previous = current;
+            }
+        }
+
+        extractFaces(mesh);
+
+        // Faces of label 0 are background enclosed by regions.
+        PlanarMesh regions;
+        regions.vertices = std::move(mesh.vertices);
+        regions.lines = std::move(mesh.lines);
+        std::vector<int> faceLabels;
+        for (std::size_t face = 0; face < mesh.faceCount(); ++face) {
+            const int first = mesh.faceOffsets[face];
+            const int last = mesh.faceOffsets[face + 1];
+            const auto line = static_cast<std::size_t>(mesh.faceLines[static_cast<std::size_t>(first)]);
+            const bool forward = regions.lines[line].first == mesh.faceVertices[static_cast<std::size_t>(first)];
+            const int label = forward ? lineSides[line].first : lineSides[line].second;
+            if (label == 0)
+                continue;
+
+            faceLabels.push_back(label);
+            regions.faceVertices.insert(regions.faceVertices.end(),
+                                        mesh.faceVertices.begin() + first,
+                                        mesh.faceVertices.begin() + last);
+            regions.faceLines.insert(regions.faceLines.end(),
+                                     mesh.faceLines.begin() + first,
+                                     mesh.faceLines.begin() + last);
+            regions.faceOffsets.push_back(static_cast<int>(regions.faceVertices.size()));
+        }
+
+        // Every region has a boundary, so the labels beside the chains are
+        // all the labels there are.
+        if (lostLabels) {
+            std::sort(labels.begin(), labels.end());
+            labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+            std::sort(faceLabels.begin(), faceLabels.end());
+            lostLabels->clear();
+            std::set_difference(labels.begin(),
+                                labels.end(),
+                                faceLabels.begin(),
+                                faceLabels.end(),
+                                std::back_inserter(*lostLabels));
+            lostLabels->erase(std::remove(lostLabels->begin(), lostLabels->end(), 0), lostLabels->end());
+        }
+        return regions;
+    }
+
+    Cracks m_cracks;
+    int m_latticeWidth = 0;
+    int m_latticeHeight = 0;
+    int m_tilesPerRow = 0;
+    qreal m_tolerance = 0.0;
+    std::vector<Tile> m_tiles;
+};
+} // namespace
+
+PlanarMesh meshFromLabels(const LabelImage &labels, qreal tolerance, std::vector<int> *lostLabels)
+{
+    if (lostLabels)
+        lostLabels->clear();
+    if (labels.isNull())
+        return PlanarMesh();
+    return LabelMeshBuilder(labels, std::max<qreal>(0.0, tolerance)).build(lostLabels);
+}
@@ -0,0 +1,30 @@
+#ifndef LABELMESH_H
+#define LABELMESH_H
+
+#include "labelimage.h"
+#include "planarmesh.h"
+
+#include <QtGlobal>
+
+#include <vector>
+
+// Turns a label image into a mesh of shared lines, one face per region. The
+// boundaries run along the pixel edges: every point where three or more
+// labels meet (pixels outside the image count as label 0) becomes a shared
+// vertex, and the boundary between two labels from one such vertex to the
+// next becomes a chain of lines, simplified to within tolerance pixels.
+// Neighbouring regions therefore share the vertices and lines between them.
+// A chain whose simplification would cross or touch another chain, or move
+// one to its other side, keeps all of its corners.
+// Faces cover the nonzero labels; the mesh is in pixel coordinates, with
+// pixel (x, y) the unit square at (x, y).
+//
+// The image is cut into tiles, each finding the junctions it owns and
+// tracing the chains that start at them on all cores. Junctions are numbered
+// across tiles afterwards, which joins the chains that cross tile seams.
+//
+// If lostLabels is given, it receives the nonzero labels that got no face,
+// such as a region that touches itself at a corner, in ascending order.
+PlanarMesh meshFromLabels(const LabelImage &labels, qreal tolerance = 1.0, std::vector<int> *lostLabels = nullptr);
+
+#endif // LABELMESH_H
@@ -2,44 +2,15 @@
 
 #include "vertex.h"
 #include "polygon.h"
+#include "halfedgemesh.h"
+#include "linegraphicsitem.h"
+#include "linespatialindex.h"
+#include "meshvalidator.h"
 
-#include <QGraphicsLineItem>
 #include <QGraphicsScene>
 #include <QLineF>
-#include <QPen>
-#include <QVariant>
 #include <algorithm>
 
-namespace
-{
-class LineGraphicsItem : public QGraphicsLineItem
-{
-public:
-    explicit LineGraphicsItem(Line *line)
-        : QGraphicsLineItem()
-        , m_line(line)
-    {
-        QPen pen(QColor(0, 170, 0));
-        pen.setWidthF(2.0);
-        setPen(pen);
-        setZValue(0.5);
-        setFlag(QGraphicsItem::ItemIsSelectable);
-    }
-
-protected:
-    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override
-    {
-        if (change == QGraphicsItem::ItemScenePositionHasChanged && m_line) {
-            m_line->updatePosition();
-        }
-        return QGraphicsLineItem::itemChange(change, value);
-    }
-
-private:
-    Line *m_line = nullptr;
-};
-} // namespace
-
 Line::Line(int id, Vertex *startVertex, Vertex *endVertex, QGraphicsScene *scene)
     : m_id(id)
     , m_startVertex(startVertex)
@@ -47,7 +18,7 @@ Line::Line(int id, Vertex *startVertex, Vertex *endVertex, QGraphicsScene *scene
     , m_scene(scene)
 {
     if (m_scene) {
-        m_item = new LineGraphicsItem(this);
+        m_item = new LineGraphicsItem;
         m_scene->addItem(m_item);
     }
 
@@ -61,6 +32,12 @@ Line::Line(int id, Vertex *startVertex, Vertex *endVertex, QGraphicsScene *scene
 
 Line::~Line()
 {
+    if (m_meshValidator)
+        m_meshValidator->untrackLine(this);
+
+    if (m_halfEdgeMesh)
+        m_halfEdgeMesh->untrackLine(this);
+
     auto polygons = m_polygons;
     for (Polygon *polygon : polygons) {
         if (polygon)
@@ -73,6 +50,9 @@ Line::~Line()
     if (m_endVertex)
         m_endVertex->removeConnectedLine(this);
 
+    if (m_spatialIndex)
+        m_spatialIndex->remove(this);
+
     if (m_scene && m_item)
         m_scene->removeItem(m_item);
 
@@ -100,15 +80,55 @@ QGraphicsItem *Line::graphicsItem() const
     return m_item;
 }
 
-void Line::updatePosition()
+void Line::setSpatialIndex(LineSpatialIndex *index)
+{
+    if (m_spatialIndex == index)
+        return;
+
+    if (m_spatialIndex)
+        m_spatialIndex->remove(this);
+
+    m_spatialIndex = index;
+    updatePosition();
+}
+
+void Line::setMeshValidator(MeshValidator *validator)
 {
-    if (!m_item)
+    if (m_meshValidator == validator)
         return;
 
+    if (m_meshValidator)
+        m_meshValidator->untrackLine(this);
+
+    m_meshValidator = validator;
+    if (m_meshValidator)
+        m_meshValidator->trackLine(this);
+}
+
+void Line::setHalfEdgeMesh(HalfEdgeMesh *mesh)
+{
+    if (m_halfEdgeMesh == mesh)
+        return;
+
+    if (m_halfEdgeMesh)
+        m_halfEdgeMesh->untrackLine(this);
+
+    m_halfEdgeMesh = mesh;
+    if (m_halfEdgeMesh)
+        m_halfEdgeMesh->trackLine(this);
+}
+
+void Line::updatePosition()
+{
     const QPointF startPos = m_startVertex ? m_startVertex->position() : QPointF();
     const QPointF endPos = m_endVertex ? m_endVertex->position() : QPointF();
+    const QLineF segment(startPos, endPos);
+
+    if (m_spatialIndex)
+        m_spatialIndex->update(this, segment);
 
-    static_cast<QGraphicsLineItem *>(m_item)->setLine(QLineF(startPos, endPos));
+    if (m_item)
+        m_item->setLine(segment);
 }
 
 bool Line::involvesVertex(const Vertex *vertex) const
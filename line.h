@@ -7,6 +7,10 @@
 
 class QGraphicsItem;
 class QGraphicsScene;
+class HalfEdgeMesh;
+class LineGraphicsItem;
+class LineSpatialIndex;
+class MeshValidator;
 class Vertex;
 class Polygon;
 
@@ -20,6 +24,9 @@ public:
     Vertex *startVertex() const;
     Vertex *endVertex() const;
     QGraphicsItem *graphicsItem() const;
+    void setSpatialIndex(LineSpatialIndex *index);
+    void setMeshValidator(MeshValidator *validator);
+    void setHalfEdgeMesh(HalfEdgeMesh *mesh);
 
     void updatePosition();
     bool involvesVertex(const Vertex *vertex) const;
@@ -32,7 +39,10 @@ private:
     Vertex *m_startVertex = nullptr;
     Vertex *m_endVertex = nullptr;
     QGraphicsScene *m_scene = nullptr;
-    QGraphicsItem *m_item = nullptr;
+    LineGraphicsItem *m_item = nullptr;
+    LineSpatialIndex *m_spatialIndex = nullptr;
+    MeshValidator *m_meshValidator = nullptr;
+    HalfEdgeMesh *m_halfEdgeMesh = nullptr;
     std::vector<Polygon *> m_polygons;
 };
 
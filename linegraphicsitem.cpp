@@ -0,0 +1,117 @@
+#include "linegraphicsitem.h"
+
+#include "zoomablegraphicsview.h"
+
+#include <QColor>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPolygonF>
+#include <QStyle>
+#include <QStyleOptionGraphicsItem>
+#include <QWidget>
+
+#include <cmath>
+
+LineGraphicsItem::LineGraphicsItem()
+    : m_style(sharedStyle())
+{
+    setZValue(0.5);
+    setFlag(QGraphicsItem::ItemIsSelectable);
+}
+
+const LineItemStyle *LineGraphicsItem::sharedStyle()
+{
+    static const LineItemStyle style = [] {
+        LineItemStyle lineStyle;
+        lineStyle.pen = QPen(QColor(0, 170, 0));
+        lineStyle.pen.setWidthF(2.0);
+        lineStyle.hitHalfWidth = lineStyle.pen.widthF() / 2.0;
+        return lineStyle;
+    }();
+    return &style;
+}
+
+int LineGraphicsItem::type() const
+{
+    return Type;
+}
+
+QLineF LineGraphicsItem::line() const
+{
+    return m_line;
+}
+
+void LineGraphicsItem::setLine(const QLineF &line)
+{
+    if (m_line == line)
+        return;
+
+    prepareGeometryChange();
+    m_line = line;
+    update();
+}
+
+const QPen &LineGraphicsItem::pen() const
+{
+    return m_style->pen;
+}
+
+QRectF LineGraphicsItem::boundingRect() const
+{
+    // The corners of the square caps of a diagonal line reach sqrt(2) half
+    // widths past its ends.
+    const qreal extent = m_style->hitHalfWidth * std::sqrt(2.0);
+    return QRectF(m_line.p1(), m_line.p2()).normalized().adjusted(-extent, -extent, extent, extent);
+}
+
+QPainterPath LineGraphicsItem::shape() const
+{
+    // Same outline the default square-capped pen stroke would produce.
+    QPainterPath path;
+    const qreal halfWidth = m_style->hitHalfWidth;
+    const qreal length = m_line.length();
+    if (qFuzzyIsNull(length)) {
+        path.addRect(QRectF(m_line.p1(), m_line.p1()).adjusted(-halfWidth, -halfWidth, halfWidth, halfWidth));
+        return path;
+    }
+
+    const QPointF tangent = (m_line.p2() - m_line.p1()) * (halfWidth / length);
+    const QPointF normal(-tangent.y(), tangent.x());
+    path.addPolygon(QPolygonF({m_line.p1() - tangent + normal,
+                               m_line.p2() + tangent + normal,
+                               m_line.p2() + tangent - normal,
+                               m_line.p1() - tangent - normal}));
+    path.closeSubpath();
+    return path;
+}
+
+bool LineGraphicsItem::contains(const QPointF &point) const
+{
+    // The rectangle of shape(): within the half width across the line and
+    // up to the half width past either end along it.
+    const qreal halfWidth = m_style->hitHalfWidth;
+    const QPointF offset = point - m_line.p1();
+    const qreal length = m_line.length();
+    if (qFuzzyIsNull(length))
+        return std::abs(offset.x()) <= halfWidth && std::abs(offset.y()) <= halfWidth;
+
+    const QPointF direction = (m_line.p2() - m_line.p1()) / length;
+    const qreal along = QPointF::dotProduct(offset, direction);
+    const qreal across = direction.x() * offset.y() - direction.y() * offset.x();
+    return along >= -halfWidth && along <= length + halfWidth && std::abs(across) <= halfWidth;
+}
+
+void LineGraphicsItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    if (ZoomableGraphicsView::rendersOverlayInTiles(widget))
+        return;
+
+    painter->setPen(m_style->pen);
+    painter->drawLine(m_line);
+
+    if (option->state & QStyle::State_Selected) {
+        painter->setPen(QPen(option->palette.windowText(), 0.0, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(boundingRect());
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef LINEGRAPHICSITEM_H
+#define LINEGRAPHICSITEM_H
+
+#include <QGraphicsItem>
+#include <QLineF>
+#include <QPen>
+
+// Appearance shared by every line item.
+struct LineItemStyle
+{
+    QPen pen;
+    qreal hitHalfWidth = 0.0;
+};
+
+class LineGraphicsItem : public QGraphicsItem
+{
+public:
+    enum { Type = UserType + 2 };
+
+    LineGraphicsItem();
+
+    static const LineItemStyle *sharedStyle();
+
+    int type() const override;
+    QLineF line() const;
+    void setLine(const QLineF &line);
+    const QPen &pen() const;
+
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;
+    bool contains(const QPointF &point) const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    const LineItemStyle *m_style = nullptr;
+    QLineF m_line;
+};
+
+#endif // LINEGRAPHICSITEM_H
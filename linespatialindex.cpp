@@ -0,0 +1,443 @@
+#include "linespatialindex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr qreal kDefaultCellSize = 32.0;
+constexpr qreal kMinimumCellSize = 1.0;
+constexpr qreal kCellsAcrossBounds = 64.0;
+// Upper bound on the average number of segments per cell inside the bounds.
+constexpr qreal kMaximumAverageOccupancy = 8.0;
+// The cells are rebuilt once the preferred size is this far off, either way,
+// so that a rebuild is paid for by the insertions that made it necessary.
+constexpr qreal kResizeFactor = 2.0;
+// Slack, in cells, when registering a diagonal segment column by column.
+constexpr qreal kCellMargin = 1.0e-9;
+
+qreal segmentLength(const QLineF &segment)
+{
+    return std::hypot(segment.dx(), segment.dy());
+}
+
+QRectF segmentBounds(const QLineF &segment)
+{
+    return QRectF(segment.p1(), segment.p2()).normalized();
+}
+
+// Twice the signed area of (origin, first, second); the sign gives the turn.
+qreal orientation(const QPointF &origin, const QPointF &first, const QPointF &second)
+{
+    return (first.x() - origin.x()) * (second.y() - origin.y()) - (first.y() - origin.y()) * (second.x() - origin.x());
+}
+
+// For a point already known to be collinear with the segment.
+bool withinSegmentBounds(const QLineF &segment, const QPointF &position)
+{
+    return position.x() >= std::min(segment.x1(), segment.x2()) && position.x() <= std::max(segment.x1(), segment.x2())
+           && position.y() >= std::min(segment.y1(), segment.y2()) && position.y() <= std::max(segment.y1(), segment.y2());
+}
+} // namespace
+
+LineSpatialIndex::LineSpatialIndex()
+    : m_cellSize(kDefaultCellSize)
+{
+}
+
+void LineSpatialIndex::setBounds(const QRectF &bounds)
+{
+    m_bounds = bounds.normalized();
+    rebuild(preferredCellSize());
+}
+
+void LineSpatialIndex::clear()
+{
+    m_cells.clear();
+    m_records.clear();
+    m_totalLength = 0.0;
+    m_occupied = CellRange();
+}
+
+std::size_t LineSpatialIndex::size() const
+{
+    return m_records.size();
+}
+
+void LineSpatialIndex::insert(Line *line, const QLineF &segment)
+{
+    if (!line)
+        return;
+
+    if (m_records.count(line)) {
+        update(line, segment);
+        return;
+    }
+
+    Record record{segment, cellsFor(segmentBounds(segment))};
+    addToCells(line, segment);
+    m_records.emplace(line, record);
+    m_totalLength += segmentLength(segment);
+    resizeIfNeeded();
+}
+
+void LineSpatialIndex::update(Line *line, const QLineF &segment)
+{
+    const auto it = m_records.find(line);
+    if (it == m_records.end()) {
+        insert(line, segment);
+        return;
+    }
+
+    Record &record = it->second;
+    m_totalLength += segmentLength(segment) - segmentLength(record.segment);
+
+    // A segment within one row or column of cells passes through all of them.
+    const CellRange cells = cellsFor(segmentBounds(segment));
+    if (cells.left == record.cells.left && cells.top == record.cells.top && cells.right == record.cells.right
+        && cells.bottom == record.cells.bottom && (cells.left == cells.right || cells.top == cells.bottom)) {
+        record.segment = segment;
+        return;
+    }
+
+    removeFromCells(line, record.segment);
+    record.segment = segment;
+    record.cells = cells;
+    addToCells(line, segment);
+    resizeIfNeeded();
+}
+
+void LineSpatialIndex::remove(Line *line)
+{
+    const auto it = m_records.find(line);
+    if (it == m_records.end())
+        return;
+
+    removeFromCells(line, it->second.segment);
+    m_totalLength -= segmentLength(it->second.segment);
+    m_records.erase(it);
+    resizeIfNeeded();
+}
+
+Line *LineSpatialIndex::nearest(const QPointF &position, qreal maximumDistance, qreal *distance) const
+{
+    if (m_records.empty() || maximumDistance < 0.0)
+        return nullptr;
+
+    Line *closest = nullptr;
+    qreal closestDistance = maximumDistance;
+
+    const int centerX = cellIndex(position.x());
+    const int centerY = cellIndex(position.y());
+    std::size_t visitedCells = 0;
+
+    const auto visitCell = [&](int x, int y) {
+        const auto it = m_cells.find(cellKey(x, y));
+        if (it == m_cells.end())
+            return;
+
+        ++visitedCells;
+        for (Line *line : it->second) {
+            const qreal lineDistance = distanceToSegment(position, m_records.at(line).segment);
+            if (lineDistance <= closestDistance) {
+                closestDistance = lineDistance;
+                closest = line;
+            }
+        }
+    };
+
+    for (int ring = 0;; ++ring) {
+        if (ring == 0) {
+            visitCell(centerX, centerY);
+        } else {
+            for (int dx = -ring; dx <= ring; ++dx) {
+                visitCell(centerX + dx, centerY - ring);
+                visitCell(centerX + dx, centerY + ring);
+            }
+            for (int dy = -ring + 1; dy <= ring - 1; ++dy) {
+                visitCell(centerX - ring, centerY + dy);
+                visitCell(centerX + ring, centerY + dy);
+            }
+        }
+
+        // A segment closer than ring * cellSize is registered in a cell that
+        // has already been visited.
+        const qreal coveredDistance = ring * m_cellSize;
+        if ((closest && closestDistance <= coveredDistance) || coveredDistance > maximumDistance
+            || visitedCells >= m_cells.size()) {
+            break;
+        }
+    }
+
+    if (closest && distance)
+        *distance = closestDistance;
+    return closest;
+}
+
+std::vector<Line *> LineSpatialIndex::inRect(const QRectF &rect) const
+{
+    const QRectF area = rect.normalized();
+    std::vector<Line *> result = linesInCells(cellsFor(area));
+    result.erase(std::remove_if(result.begin(),
+                                result.end(),
+                                [this, &area](Line *line) {
+                                    return !segmentIntersectsRect(m_records.at(line).segment, area);
+                                }),
+                 result.end());
+    return result;
+}
+
+std::vector<Line *> LineSpatialIndex::crossingCandidates(const QLineF &segment, const Line *ignoredLine) const
+{
+    const QRectF bounds = segmentBounds(segment);
+    std::vector<Line *> result = linesInCells(cellsFor(bounds));
+    result.erase(std::remove_if(result.begin(),
+                                result.end(),
+                                [this, &bounds, ignoredLine](Line *line) {
+                                    if (line == ignoredLine)
+                                        return true;
+                                    const QRectF lineBounds = segmentBounds(m_records.at(line).segment);
+                                    return lineBounds.right() < bounds.left() || lineBounds.left() > bounds.right()
+                                           || lineBounds.bottom() < bounds.top() || lineBounds.top() > bounds.bottom();
+                                }),
+                 result.end());
+    return result;
+}
+
+bool LineSpatialIndex::rayHitsLine(const QPointF &origin, const QPointF &direction) const
+{
+    const qreal length = std::hypot(direction.x(), direction.y());
+    if (m_records.empty() || length <= 0.0)
+        return false;
+
+    // Past the farthest corner of the occupied cells nothing can be hit.
+    const qreal left = m_occupied.left * m_cellSize;
+    const qreal top = m_occupied.top * m_cellSize;
+    const qreal right = (m_occupied.right + 1) * m_cellSize;
+    const qreal bottom = (m_occupied.bottom + 1) * m_cellSize;
+    const qreal reach = std::hypot(std::max(origin.x() - left, right - origin.x()),
+                                   std::max(origin.y() - top, bottom - origin.y()));
+    const QLineF ray(origin, origin + direction * (reach / length));
+
+    bool hit = false;
+    forEachCell(ray, [&](int x, int y) {
+        if (hit)
+            return;
+        const auto it = m_cells.find(cellKey(x, y));
+        if (it == m_cells.end())
+            return;
+        for (Line *line : it->second) {
+            if (segmentsIntersect(ray, m_records.at(line).segment)) {
+                hit = true;
+                return;
+            }
+        }
+    });
+    return hit;
+}
+
+qreal LineSpatialIndex::distanceToSegment(const QPointF &position, const QLineF &segment)
+{
+    const QPointF direction = segment.p2() - segment.p1();
+    const qreal lengthSquared = QPointF::dotProduct(direction, direction);
+    qreal t = 0.0;
+    if (lengthSquared > 0.0)
+        t = std::clamp(QPointF::dotProduct(position - segment.p1(), direction) / lengthSquared, 0.0, 1.0);
+
+    const QPointF offset = position - (segment.p1() + direction * t);
+    return std::sqrt(QPointF::dotProduct(offset, offset));
+}
+
+bool LineSpatialIndex::segmentIntersectsRect(const QLineF &segment, const QRectF &rect)
+{
+    // Liang-Barsky clipping of the segment against the rectangle.
+    const qreal dx = segment.dx();
+    const qreal dy = segment.dy();
+    const qreal p[4] = {-dx, dx, -dy, dy};
+    const qreal q[4] = {segment.x1() - rect.left(),
+                        rect.right() - segment.x1(),
+                        segment.y1() - rect.top(),
+                        rect.bottom() - segment.y1()};
+
+    qreal entry = 0.0;
+    qreal exit = 1.0;
+    for (int i = 0; i < 4; ++i) {
+        if (qFuzzyIsNull(p[i])) {
+            if (q[i] < 0.0)
+                return false;
+            continue;
+        }
+
+        const qreal t = q[i] / p[i];
+        if (p[i] < 0.0)
+            entry = std::max(entry, t);
+        else
+            exit = std::min(exit, t);
+
+        if (entry > exit)
+            return false;
+    }
+    return true;
+}
+
+bool LineSpatialIndex::segmentsIntersect(const QLineF &first, const QLineF &second)
+{
+    const qreal d1 = orientation(second.p1(), second.p2(), first.p1());
+    const qreal d2 = orientation(second.p1(), second.p2(), first.p2());
+    const qreal d3 = orientation(first.p1(), first.p2(), second.p1());
+    const qreal d4 = orientation(first.p1(), first.p2(), second.p2());
+
+    if (((d1 > 0.0 && d2 < 0.0) || (d1 < 0.0 && d2 > 0.0)) && ((d3 > 0.0 && d4 < 0.0) || (d3 < 0.0 && d4 > 0.0)))
+        return true;
+
+    // Touching and collinear overlaps count as intersections.
+    return (d1 == 0.0 && withinSegmentBounds(second, first.p1())) || (d2 == 0.0 && withinSegmentBounds(second, first.p2()))
+           || (d3 == 0.0 && withinSegmentBounds(first, second.p1()))
+           || (d4 == 0.0 && withinSegmentBounds(first, second.p2()));
+}
+
+qreal LineSpatialIndex::preferredCellSize() const
+{
+    const qreal extent = std::max(m_bounds.width(), m_bounds.height());
+    if (m_records.empty())
+        return extent > 0.0 ? std::max(kMinimumCellSize, extent / kCellsAcrossBounds) : kDefaultCellSize;
+
+    // About one segment length per cell keeps both the cells a segment is
+    // registered in and the segments a cell holds few; dense meshes of long
+    // segments are further held to the occupancy bound.
+    const qreal count = static_cast<qreal>(m_records.size());
+    qreal cellSize = m_totalLength / count;
+    const qreal area = m_bounds.width() * m_bounds.height();
+    if (area > 0.0)
+        cellSize = std::min(cellSize, std::sqrt(kMaximumAverageOccupancy * area / count));
+    return std::max(kMinimumCellSize, cellSize);
+}
+
+void LineSpatialIndex::resizeIfNeeded()
+{
+    const qreal cellSize = preferredCellSize();
+    if (cellSize > m_cellSize * kResizeFactor || cellSize * kResizeFactor < m_cellSize)
+        rebuild(cellSize);
+}
+
+void LineSpatialIndex::rebuild(qreal cellSize)
+{
+    m_cellSize = cellSize;
+    m_cells.clear();
+    m_occupied = CellRange();
+    for (auto &[line, record] : m_records) {
+        record.cells = cellsFor(segmentBounds(record.segment));
+        addToCells(line, record.segment);
+    }
+}
+
+LineSpatialIndex::CellRange LineSpatialIndex::cellsFor(const QRectF &rect) const
+{
+    return CellRange{cellIndex(rect.left()), cellIndex(rect.top()), cellIndex(rect.right()), cellIndex(rect.bottom())};
+}
+
+int LineSpatialIndex::cellIndex(qreal coordinate) const
+{
+    return static_cast<int>(std::floor(coordinate / m_cellSize));
+}
+
+std::int64_t LineSpatialIndex::cellKey(int x, int y)
+{
+    // Shifting a negative cell would be undefined, so the halves are packed
+    // as unsigned bits.
+    return static_cast<std::int64_t>((static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32)
+                                     | static_cast<std::uint32_t>(y));
+}
+
+template<typename Visitor>
+void LineSpatialIndex::forEachCell(const QLineF &segment, Visitor &&visitor) const
+{
+    const QRectF bounds = segmentBounds(segment);
+    const CellRange range = cellsFor(bounds);
+    if (range.left == range.right || range.top == range.bottom) {
+        for (int y = range.top; y <= range.bottom; ++y) {
+            for (int x = range.left; x <= range.right; ++x)
+                visitor(x, y);
+        }
+        return;
+    }
+
+    // Column by column, the cells between the segment's lowest and highest
+    // point in the column, widened a little against rounding. A long
+    // diagonal segment is thus in a number of cells linear in its length.
+    const qreal slope = segment.dy() / segment.dx();
+    const qreal margin = m_cellSize * kCellMargin;
+    for (int x = range.left; x <= range.right; ++x) {
+        const qreal first = std::max(bounds.left(), x * m_cellSize);
+        const qreal last = std::min(bounds.right(), (x + 1) * m_cellSize);
+        const qreal firstY = segment.y1() + (first - segment.x1()) * slope;
+        const qreal lastY = segment.y1() + (last - segment.x1()) * slope;
+        const int top = std::max(range.top, cellIndex(std::min(firstY, lastY) - margin));
+        const int bottom = std::min(range.bottom, cellIndex(std::max(firstY, lastY) + margin));
+        for (int y = top; y <= bottom; ++y)
+            visitor(x, y);
+    }
+}
+
+void LineSpatialIndex::addToCells(Line *line, const QLineF &segment)
+{
+    forEachCell(segment, [this, line](int x, int y) { m_cells[cellKey(x, y)].push_back(line); });
+
+    const CellRange cells = cellsFor(segmentBounds(segment));
+    if (m_occupied.left > m_occupied.right) {
+        m_occupied = cells;
+    } else {
+        m_occupied.left = std::min(m_occupied.left, cells.left);
+        m_occupied.top = std::min(m_occupied.top, cells.top);
+        m_occupied.right = std::max(m_occupied.right, cells.right);
+        m_occupied.bottom = std::max(m_occupied.bottom, cells.bottom);
+    }
+}
+
+void LineSpatialIndex::removeFromCells(Line *line, const QLineF &segment)
+{
+    forEachCell(segment, [this, line](int x, int y) {
+        const auto cellIt = m_cells.find(cellKey(x, y));
+        if (cellIt == m_cells.end())
+            return;
+
+        auto &lines = cellIt->second;
+        const auto it = std::find(lines.begin(), lines.end(), line);
+        if (it != lines.end()) {
+            *it = lines.back();
+            lines.pop_back();
+        }
+        if (lines.empty())
+            m_cells.erase(cellIt);
+    });
+}
+
+std::vector<Line *> LineSpatialIndex::linesInCells(const CellRange &range) const
+{
+    std::vector<Line *> result;
+    if (m_records.empty())
+        return result;
+
+    const qint64 cellCount = static_cast<qint64>(range.right - range.left + 1) * (range.bottom - range.top + 1);
+    if (cellCount > static_cast<qint64>(m_cells.size())) {
+        for (const auto &[line, record] : m_records) {
+            const CellRange &cells = record.cells;
+            if (cells.right >= range.left && cells.left <= range.right && cells.bottom >= range.top
+                && cells.top <= range.bottom) {
+                result.push_back(line);
+            }
+        }
+        return result;
+    }
+
+    for (int y = range.top; y <= range.bottom; ++y) {
+        for (int x = range.left; x <= range.right; ++x) {
+            const auto it = m_cells.find(cellKey(x, y));
+            if (it != m_cells.end())
+                result.insert(result.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
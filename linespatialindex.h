@@ -0,0 +1,80 @@
+#ifndef LINESPATIALINDEX_H
+#define LINESPATIALINDEX_H
+
+#include <QLineF>
+#include <QPointF>
+#include <QRectF>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Line;
+
+// Uniform hash grid over line segments. Each segment is registered in every
+// cell it passes through, so queries only look at nearby cells. The
+// cells follow the mean segment length and the line count: they are rebuilt
+// when the mesh gets denser or its lines longer or shorter, so that a cell
+// holds a bounded number of segments however many lines there are.
+class LineSpatialIndex
+{
+public:
+    LineSpatialIndex();
+
+    void setBounds(const QRectF &bounds);
+    void clear();
+    std::size_t size() const;
+
+    void insert(Line *line, const QLineF &segment);
+    void update(Line *line, const QLineF &segment);
+    void remove(Line *line);
+
+    Line *nearest(const QPointF &position, qreal maximumDistance, qreal *distance = nullptr) const;
+    std::vector<Line *> inRect(const QRectF &rect) const;
+    std::vector<Line *> crossingCandidates(const QLineF &segment, const Line *ignoredLine = nullptr) const;
+    // Whether the ray from origin in direction crosses or touches a line.
+    bool rayHitsLine(const QPointF &origin, const QPointF &direction) const;
+
+    static qreal distanceToSegment(const QPointF &position, const QLineF &segment);
+    static bool segmentIntersectsRect(const QLineF &segment, const QRectF &rect);
+    static bool segmentsIntersect(const QLineF &first, const QLineF &second);
+
+private:
+    struct CellRange
+    {
+        int left = 0;
+        int top = 0;
+        int right = -1;
+        int bottom = -1;
+    };
+
+    struct Record
+    {
+        QLineF segment;
+        // The cells of the segment's bounding box.
+        CellRange cells;
+    };
+
+    qreal preferredCellSize() const;
+    void resizeIfNeeded();
+    void rebuild(qreal cellSize);
+    CellRange cellsFor(const QRectF &rect) const;
+    int cellIndex(qreal coordinate) const;
+    static std::int64_t cellKey(int x, int y);
+    template<typename Visitor>
+    void forEachCell(const QLineF &segment, Visitor &&visitor) const;
+    void addToCells(Line *line, const QLineF &segment);
+    void removeFromCells(Line *line, const QLineF &segment);
+    std::vector<Line *> linesInCells(const CellRange &range) const;
+
+    QRectF m_bounds;
+    qreal m_cellSize = 0.0;
+    // Sum of the segment lengths, for their mean.
+    qreal m_totalLength = 0.0;
+    // Covers every cell that has held a segment since the last rebuild.
+    CellRange m_occupied;
+    std::unordered_map<std::int64_t, std::vector<Line *>> m_cells;
+    std::unordered_map<Line *, Record> m_records;
+};
+
+#endif // LINESPATIALINDEX_H
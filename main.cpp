@@ -1,6 +1,8 @@
 #include "mainwindow.h"
+#include "stressbenchmark.h"
 
 #include <QApplication>
+#include <QTextStream>
 #include <QStyleFactory>
 #include <QPalette>
 #include <QColor>
@@ -31,9 +33,47 @@ static void setDarkTheme(QApplication& app) {
         "QToolTip { color: #dddddd; background: #2a2a2a; border: 1px solid #444; }"
         );
 }
+
+static bool hasArgument(int argc, char *argv[], const char *argument) {
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], argument) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Headless stress benchmark: prints (or writes) a JSON report and exits
+// non-zero if the parameters are invalid or a relationship check failed.
+static int runStressBenchmark(QApplication& app) {
+    StressBenchmarkOptions options;
+    QString errorString;
+    if (!parseStressBenchmarkOptions(app.arguments(), &options, &errorString)) {
+        QTextStream(stderr) << errorString << Qt::endl;
+        return 2;
+    }
+
+    MainWindow w;
+    const QJsonObject report = w.runStressBenchmark(options);
+
+    if (!writeStressBenchmarkReport(report, options.reportPath, &errorString)) {
+        QTextStream(stderr) << "Cannot write benchmark report: " << errorString << Qt::endl;
+        return 2;
+    }
+
+    return report.value(QStringLiteral("validation_failures")).toInt() == 0 ? 0 : 1;
+}
+
 int main(int argc, char *argv[])
 {
+    // The benchmark never shows a window, so it must not need a display.
+    const bool benchmark = hasArgument(argc, argv, "--benchmark");
+    if (benchmark && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
     QApplication a(argc, argv);
+    if (benchmark)
+        return runStressBenchmark(a);
+
     setDarkTheme(a);
     MainWindow w;
     w.show();
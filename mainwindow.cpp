@@ -4,7 +4,34 @@
 #include "zoomablegraphicsview.h"
 #include "line.h"
 #include "polygon.h"
-
+#include "meshgeometry.h"
+#include "imageloader.h"
+#include "linegraphicsitem.h"
+#include "vertexgraphicsitem.h"
+#include "vertexspatialindex.h"
+#include "linespatialindex.h"
+#include "polygonspatialindex.h"
+#include "crossingguard.h"
+#include "crossingdetector.h"
+#include "meshvalidator.h"
+#include "halfedgemesh.h"
+#include "stressbenchmark.h"
+#include "planarmesh.h"
+#include "voronoitissue.h"
+#include "binaryimage.h"
+#include "contourpreprocessor.h"
+#include "distancetransform.h"
+#include "watershed.h"
+#include "skeletonizer.h"
+#include "junctiondetector.h"
+#include "skeletontracer.h"
+#include "faceextractor.h"
+#include "labelimage.h"
+#include "labelmesh.h"
+#include "skeletonoverlayitem.h"
+
+#include <QCheckBox>
+#include <QComboBox>
 #include <QDialog>
 #include <QDialogButtonBox>
 #include <QDoubleSpinBox>
@@ -18,6 +45,7 @@
 #include <QRadioButton>
 #include <QPainter>
 #include <QRectF>
+#include <QSignalBlocker>
 #include <QStringList>
 #include <QGraphicsPixmapItem>
 #include <QColor>
@@ -45,6 +73,14 @@
 #include <QRegularExpression>
 #include <QDebug>
 #include <QRandomGenerator>
+#include <QProgressBar>
+#include <QStatusBar>
+#include <QToolButton>
+#include <QTransform>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QGraphicsEllipseItem>
+#include <QGraphicsLineItem>
 
 #include <algorithm>
 #include <set>
@@ -53,109 +89,32 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <cmath>
+#include <limits>
+#include <type_traits>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
 
 namespace {
+constexpr qreal kVertexSnapRadiusPixels = 8.0;
+// How far beside a line, in line lengths, a ray starts to probe its face.
+constexpr qreal kBesideLine = 1.0e-6;
+
+// Debug builds recheck the entities touched by each edit as soon as the scene
+// settles; release builds only validate on demand.
+#ifdef QT_DEBUG
+constexpr bool kValidateMeshContinuously = true;
+#else
+constexpr bool kValidateMeshContinuously = false;
+#endif
+
 struct SnapshotOptions
 {
     QString filePath;
     int quality = 90;
 };
 
-qreal signedArea(const std::vector<Vertex *> &vertices)
-{
-    if (vertices.size() < 3)
-        return 0.0;
-
-    qreal area = 0.0;
-    for (std::size_t i = 0; i < vertices.size(); ++i) {
-        const Vertex *current = vertices[i];
-        const Vertex *next = vertices[(i + 1) % vertices.size()];
-        if (!current || !next)
-            continue;
-
-        const QPointF currentPos = current->position();
-        const QPointF nextPos = next->position();
-        area += (currentPos.x() * nextPos.y()) - (nextPos.x() * currentPos.y());
-    }
-
-    return area * 0.5;
-}
-
-void ensureCounterClockwise(std::vector<Vertex *> &vertices, std::vector<Line *> &lines)
-{
-    if (vertices.size() < 3 || lines.size() != vertices.size())
-        return;
-
-    if (signedArea(vertices) < 0) {
-        std::vector<Vertex *> reversedVertices;
-        reversedVertices.reserve(vertices.size());
-        reversedVertices.push_back(vertices.front());
-        for (std::size_t i = vertices.size(); i-- > 1;)
-            reversedVertices.push_back(vertices[i]);
-
-        std::vector<Line *> reversedLines;
-        reversedLines.reserve(lines.size());
-        for (auto it = lines.rbegin(); it != lines.rend(); ++it)
-            reversedLines.push_back(*it);
-
-        vertices = std::move(reversedVertices);
-        lines = std::move(reversedLines);
-    }
-}
-
-std::vector<Vertex *> sortVerticesCounterClockwise(const std::vector<Vertex *> &vertices)
-{
-    std::vector<Vertex *> sorted;
-    sorted.reserve(vertices.size());
-    for (Vertex *vertex : vertices) {
-        if (vertex)
-            sorted.push_back(vertex);
-    }
-
-    if (sorted.size() < 3)
-        return sorted;
-
-    qreal sumX = 0.0;
-    qreal sumY = 0.0;
-    for (Vertex *vertex : sorted) {
-        const QPointF pos = vertex->position();
-        sumX += pos.x();
-        sumY += pos.y();
-    }
-    const qreal invCount = 1.0 / static_cast<qreal>(sorted.size());
-    const QPointF centroid(sumX * invCount, sumY * invCount);
-
-    std::sort(sorted.begin(), sorted.end(), [&centroid](Vertex *lhs, Vertex *rhs) {
-        const QPointF lhsPos = lhs->position();
-        const QPointF rhsPos = rhs->position();
-        const qreal lhsAngle = std::atan2(lhsPos.y() - centroid.y(), lhsPos.x() - centroid.x());
-        const qreal rhsAngle = std::atan2(rhsPos.y() - centroid.y(), rhsPos.x() - centroid.x());
-        if (lhsAngle < rhsAngle)
-            return true;
-        if (lhsAngle > rhsAngle)
-            return false;
-
-        const qreal lhsDx = lhsPos.x() - centroid.x();
-        const qreal lhsDy = lhsPos.y() - centroid.y();
-        const qreal rhsDx = rhsPos.x() - centroid.x();
-        const qreal rhsDy = rhsPos.y() - centroid.y();
-        const qreal lhsDistSq = lhsDx * lhsDx + lhsDy * lhsDy;
-        const qreal rhsDistSq = rhsDx * rhsDx + rhsDy * rhsDy;
-        return lhsDistSq < rhsDistSq;
-    });
-
-    if (signedArea(sorted) < 0) {
-        std::vector<Vertex *> reversed;
-        reversed.reserve(sorted.size());
-        reversed.push_back(sorted.front());
-        for (std::size_t i = sorted.size(); i-- > 1;)
-            reversed.push_back(sorted[i]);
-        sorted = std::move(reversed);
-    }
-
-    return sorted;
-}
-
 std::optional<SnapshotOptions> requestSnapshotOptions(QWidget *parent,
                                                      const QString &title,
                                                      const QString &defaultFileName)
@@ -205,6 +164,100 @@ std::optional<SnapshotOptions> requestSnapshotOptions(QWidget *parent,
     options.quality = qualitySpinBox->value();
     return options;
 }
+
+// Bytes currently allocated on the heap, or -1 where the C library cannot tell.
+qint64 allocatedHeapBytes()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return static_cast<qint64>(mallinfo2().uordblks);
+#else
+    return -1;
+#endif
+}
+
+struct ItemBenchmarkResult
+{
+    qint64 heapBytesPerItem = -1;
+    qint64 creationMs = 0;
+    qint64 hitTestMs = 0;
+    qint64 hits = 0;
+};
+
+template<typename CreateItem>
+ItemBenchmarkResult benchmarkGraphicsItems(CreateItem createItem,
+                                           int itemCount,
+                                           const std::vector<QPointF> &probes,
+                                           const QRectF &sceneRect)
+{
+    ItemBenchmarkResult result;
+    std::vector<QGraphicsItem *> items;
+    items.reserve(static_cast<std::size_t>(itemCount));
+
+    QElapsedTimer timer;
+    const qint64 heapBefore = allocatedHeapBytes();
+    timer.start();
+    for (int i = 0; i < itemCount; ++i)
+        items.push_back(createItem(i));
+    result.creationMs = timer.elapsed();
+    const qint64 heapAfter = allocatedHeapBytes();
+    if (heapBefore >= 0 && heapAfter >= 0)
+        result.heapBytesPerItem = (heapAfter - heapBefore) / std::max(1, itemCount);
+
+    QGraphicsScene scene(sceneRect);
+    for (QGraphicsItem *item : items)
+        scene.addItem(item);
+    scene.items(sceneRect.center());
+
+    timer.restart();
+    for (const QPointF &probe : probes)
+        result.hits += scene.items(probe).size();
+    result.hitTestMs = timer.elapsed();
+
+    return result;
+}
+
+// One side of a line in the half-edge mesh: the face cycle that starts with
+// the half-edge.
+struct FaceCycle
+{
+    std::vector<Vertex *> vertices;
+    std::vector<Line *> lines;
+};
+
+// Walks the face cycle from start. Returns false, and stops there, if the
+// walk meets the twin, i.e. both sides of the line are on the same face and
+// the line does not close a cycle, or if a half-edge after the first is not
+// on polygon's side, so the cycle is not one cell or one empty face.
+bool walkFaceCycle(const HalfEdgeMesh &mesh, int start, const Polygon *polygon, FaceCycle &cycle)
+{
+    int halfEdge = start;
+    do {
+        if (halfEdge == HalfEdgeMesh::twin(start) || (halfEdge != start && mesh.face(halfEdge) != polygon))
+            return false;
+
+        cycle.vertices.push_back(mesh.origin(halfEdge));
+        cycle.lines.push_back(mesh.line(halfEdge));
+        halfEdge = mesh.next(halfEdge);
+    } while (halfEdge != start);
+    return true;
+}
+
+// Whether the face on the side of halfEdge is the unbounded one, as shown by
+// a ray from just beside the middle of its line that meets no line at all.
+// False means that it may or may not be.
+bool isOutsideFace(const HalfEdgeMesh &mesh, const LineSpatialIndex &index, int halfEdge)
+{
+    const QPointF start = mesh.origin(halfEdge)->position();
+    const QPointF end = mesh.target(halfEdge)->position();
+    // The face is on the (-dy, dx) side of its half-edges.
+    const QPointF normal(start.y() - end.y(), end.x() - start.x());
+    const QPointF origin = (start + end) / 2.0 + normal * kBesideLine;
+    for (const QPointF &direction : {normal, QPointF(1.0, 0.0), QPointF(-1.0, 0.0), QPointF(0.0, 1.0), QPointF(0.0, -1.0)}) {
+        if (!index.rayHitsLine(origin, direction))
+            return true;
+    }
+    return false;
+}
 } // namespace
 
 MainWindow::MainWindow(QWidget *parent)
@@ -216,6 +269,19 @@ MainWindow::MainWindow(QWidget *parent)
     m_scene = new QGraphicsScene(this);
     m_scene->setSceneRect(0, 0, 512, 512);
 
+    m_vertexIndex = std::make_unique<VertexSpatialIndex>();
+    m_vertexIndex->setBounds(m_scene->sceneRect());
+    m_lineIndex = std::make_unique<LineSpatialIndex>();
+    m_lineIndex->setBounds(m_scene->sceneRect());
+    m_polygonIndex = std::make_unique<PolygonSpatialIndex>();
+    m_crossingGuard = std::make_unique<CrossingGuard>(m_lineIndex.get());
+    m_meshValidator = std::make_unique<MeshValidator>();
+    m_halfEdgeMesh = std::make_unique<HalfEdgeMesh>();
+    connect(m_scene, &QGraphicsScene::sceneRectChanged, this, [this](const QRectF &rect) {
+        m_vertexIndex->setBounds(rect);
+        m_lineIndex->setBounds(rect);
+    });
+
     if (auto *splitter = qobject_cast<QSplitter *>(ui->graphicsView->parentWidget())) {
         const int index = splitter->indexOf(ui->graphicsView);
         if (index >= 0) {
@@ -234,6 +300,40 @@ MainWindow::MainWindow(QWidget *parent)
 
     resetSelectionLabels();
 
+    m_imageLoader = new ImageLoader(this);
+    connect(m_imageLoader, &ImageLoader::previewReady, this, &MainWindow::handleBackgroundPreviewReady);
+    connect(m_imageLoader, &ImageLoader::imageReady, this, &MainWindow::handleBackgroundImageReady);
+    connect(m_imageLoader, &ImageLoader::loadFailed, this, &MainWindow::handleBackgroundImageLoadFailed);
+    connect(m_imageLoader, &ImageLoader::progressChanged, this, &MainWindow::handleBackgroundImageLoadProgress);
+
+    m_crossingDetector = new CrossingDetector(this);
+    connect(m_crossingDetector, &CrossingDetector::progressChanged, this, &MainWindow::handleLineCrossingsProgress);
+    connect(m_crossingDetector, &CrossingDetector::crossingsFound, this, &MainWindow::handleLineCrossingsFound);
+    connect(m_crossingDetector, &CrossingDetector::finished, this, [this] {
+        if (m_cancelCrossingCheckButton)
+            m_cancelCrossingCheckButton->setVisible(false);
+    });
+
+    m_imageLoadProgressBar = new QProgressBar(this);
+    m_imageLoadProgressBar->setRange(0, 100);
+    m_imageLoadProgressBar->setMaximumWidth(160);
+    m_imageLoadProgressBar->setVisible(false);
+
+    m_cancelImageLoadButton = new QToolButton(this);
+    m_cancelImageLoadButton->setText(tr("Cancel"));
+    m_cancelImageLoadButton->setVisible(false);
+    connect(m_cancelImageLoadButton, &QToolButton::clicked, this, &MainWindow::cancelBackgroundImageLoad);
+
+    m_cancelCrossingCheckButton = new QToolButton(this);
+    m_cancelCrossingCheckButton->setText(tr("Cancel"));
+    m_cancelCrossingCheckButton->setToolTip(tr("Stop looking for crossing lines"));
+    m_cancelCrossingCheckButton->setVisible(false);
+    connect(m_cancelCrossingCheckButton, &QToolButton::clicked, this, &MainWindow::cancelLineCrossingCheck);
+
+    statusBar()->addPermanentWidget(m_imageLoadProgressBar);
+    statusBar()->addPermanentWidget(m_cancelImageLoadButton);
+    statusBar()->addPermanentWidget(m_cancelCrossingCheckButton);
+
     connect(m_scene, &QGraphicsScene::selectionChanged, this, &MainWindow::onSceneSelectionChanged);
     connect(m_scene, &QGraphicsScene::changed, this, &MainWindow::onSceneChanged);
 
@@ -290,8 +390,11 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
-    m_polygons.clear();
-    m_lines.clear();
+    if (m_imageLoader)
+        m_imageLoader->cancel();
+
+    clearPolygons();
+    clearLines();
     m_vertices.clear();
     m_nextLineId = 0;
     m_nextPolygonId = 0;
@@ -315,6 +418,11 @@ Vertex *MainWindow::createVertexWithId(int id, const QPointF &position)
 {
     auto vertex = std::make_unique<Vertex>(id, position, m_scene);
     Vertex *vertexPtr = vertex.get();
+    vertexPtr->setSpatialIndex(m_vertexIndex.get());
+    vertexPtr->setCrossingGuard(m_crossingGuard.get());
+    if (kValidateMeshContinuously)
+        vertexPtr->setMeshValidator(m_meshValidator.get());
+    vertexPtr->setHalfEdgeMesh(m_halfEdgeMesh.get());
     m_vertices.push_back(std::move(vertex));
     sortVerticesById();
     return vertexPtr;
@@ -367,30 +475,6 @@ int MainWindow::nextAvailableId() const
     return id;
 }
 
-int MainWindow::nextAvailableLineId() const
-{
-    int id = 0;
-    while (std::find_if(m_lines.begin(), m_lines.end(),
-                        [id](const std::unique_ptr<Line> &candidate) {
-                            return candidate && candidate->id() == id;
-                        }) != m_lines.end()) {
-        ++id;
-    }
-    return id;
-}
-
-int MainWindow::nextAvailablePolygonId() const
-{
-    int id = 0;
-    while (std::find_if(m_polygons.begin(), m_polygons.end(),
-                        [id](const std::unique_ptr<Polygon> &candidate) {
-                            return candidate && candidate->id() == id;
-                        }) != m_polygons.end()) {
-        ++id;
-    }
-    return id;
-}
-
 void MainWindow::sortVerticesById()
 {
     std::sort(m_vertices.begin(), m_vertices.end(),
@@ -414,9 +498,7 @@ Vertex *MainWindow::findVertexById(int id) const
 
 Line *MainWindow::createLine(Vertex *startVertex, Vertex *endVertex)
 {
-    const int id = nextAvailableLineId();
-    Line *line = createLineWithId(id, startVertex, endVertex);
-    return line;
+    return createLineWithId(m_nextLineId, startVertex, endVertex);
 }
 
 Line *MainWindow::createLineWithId(int id, Vertex *startVertex, Vertex *endVertex)
@@ -426,14 +508,18 @@ Line *MainWindow::createLineWithId(int id, Vertex *startVertex, Vertex *endVerte
 
     auto line = std::make_unique<Line>(id, startVertex, endVertex, m_scene);
     Line *linePtr = line.get();
-    m_lines.push_back(std::move(line));
+    linePtr->setSpatialIndex(m_lineIndex.get());
+    if (kValidateMeshContinuously)
+        linePtr->setMeshValidator(m_meshValidator.get());
+    linePtr->setHalfEdgeMesh(m_halfEdgeMesh.get());
+    storeLine(std::move(line));
+    m_nextLineId = std::max(m_nextLineId, id + 1);
     return linePtr;
 }
 
 Polygon *MainWindow::createPolygon(const std::vector<Vertex *> &vertices, const std::vector<Line *> &lines)
 {
-    const int id = nextAvailablePolygonId();
-    return createPolygonWithId(id, vertices, lines);
+    return createPolygonWithId(m_nextPolygonId, vertices, lines);
 }
 
 Polygon *MainWindow::createPolygonWithId(int id,
@@ -446,7 +532,7 @@ Polygon *MainWindow::createPolygonWithId(int id,
     if (vertices.size() != lines.size())
         return nullptr;
 
-    if (findPolygonById(id))
+    if (m_polygonsById.count(id))
         return nullptr;
 
     std::vector<Line *> lineCopy = lines;
@@ -462,7 +548,12 @@ Polygon *MainWindow::createPolygonWithId(int id,
 
     auto polygon = std::make_unique<Polygon>(id, std::move(vertexCopy), std::move(lineCopy), m_scene);
     Polygon *polygonPtr = polygon.get();
-    m_polygons.push_back(std::move(polygon));
+    polygonPtr->setSpatialIndex(m_polygonIndex.get());
+    if (kValidateMeshContinuously)
+        polygonPtr->setMeshValidator(m_meshValidator.get());
+    polygonPtr->setHalfEdgeMesh(m_halfEdgeMesh.get());
+    storePolygon(std::move(polygon));
+    m_nextPolygonId = std::max(m_nextPolygonId, id + 1);
     return polygonPtr;
 }
 
@@ -471,23 +562,127 @@ void MainWindow::deleteLine(Line *line)
     if (!line)
         return;
 
-    std::vector<Polygon *> polygonsToDelete;
-    polygonsToDelete.reserve(m_polygons.size());
-    for (const auto &polygon : m_polygons) {
-        if (polygon && polygon->involvesLine(line))
-            polygonsToDelete.push_back(polygon.get());
+    const std::vector<Polygon *> polygonsToDelete = line->connectedPolygons();
+    for (Polygon *polygon : polygonsToDelete)
+        deletePolygon(polygon);
+
+    const auto slot = m_lineSlots.find(line);
+    if (slot == m_lineSlots.end())
+        return;
+
+    // A running crossing check would report on lines that are gone.
+    cancelLineCrossingCheck();
+
+    // The last line takes the slot of the deleted one.
+    const std::size_t index = slot->second;
+    m_lineSlots.erase(slot);
+    if (index + 1 != m_lines.size()) {
+        std::swap(m_lines[index], m_lines.back());
+        m_lineSlots[m_lines[index].get()] = index;
     }
+    m_lines.pop_back();
+}
 
-    for (Polygon *polygon : polygonsToDelete)
+std::vector<Polygon *> MainWindow::closeCellsAroundLine(Line *line)
+{
+    std::vector<Polygon *> cells;
+    const int halfEdge = line ? m_halfEdgeMesh->halfEdge(line) : HalfEdgeMesh::kNoHalfEdge;
+    if (halfEdge == HalfEdgeMesh::kNoHalfEdge)
+        return cells;
+
+    // Both sides were one face before the line; the half-edges after it on
+    // either side tell whether that face was a cell.
+    const int twin = HalfEdgeMesh::twin(halfEdge);
+    Polygon *polygon = m_halfEdgeMesh->face(m_halfEdgeMesh->next(halfEdge));
+    if (polygon != m_halfEdgeMesh->face(m_halfEdgeMesh->next(twin)))
+        return cells;
+
+    if (polygon) {
+        // A chord across a cell splits it; the first half keeps the id. Both
+        // rings are checked before the cell goes, so a failure leaves it.
+        FaceCycle left;
+        FaceCycle right;
+        if (!walkFaceCycle(*m_halfEdgeMesh, halfEdge, polygon, left)
+            || !walkFaceCycle(*m_halfEdgeMesh, twin, polygon, right)) {
+            return cells;
+        }
+
+        std::vector<Line *> leftLines;
+        std::vector<Vertex *> leftVertices;
+        std::vector<Line *> rightLines;
+        std::vector<Vertex *> rightVertices;
+        if (!orderLinesIntoPolygon(left.lines, leftLines, leftVertices)
+            || !orderLinesIntoPolygon(right.lines, rightLines, rightVertices)) {
+            return cells;
+        }
+
+        const int id = polygon->id();
         deletePolygon(polygon);
+        if (Polygon *cell = createPolygonWithId(id, leftVertices, leftLines))
+            cells.push_back(cell);
+        if (Polygon *cell = createPolygon(rightVertices, rightLines))
+            cells.push_back(cell);
+        return cells;
+    }
 
-    const auto it = std::find_if(m_lines.begin(), m_lines.end(),
-                                 [line](const std::unique_ptr<Line> &candidate) {
-                                     return candidate.get() == line;
-                                 });
+    // Otherwise the line closed a cycle around empty space. Only bounded faces
+    // (positive area on the walk's side) become cells, never the outside,
+    // which is not even walked if a ray shows it to be the outside.
+    for (const int start : {halfEdge, twin}) {
+        if (isOutsideFace(*m_halfEdgeMesh, *m_lineIndex, start))
+            continue;
 
-    if (it != m_lines.end())
-        m_lines.erase(it);
+        FaceCycle cycle;
+        if (!walkFaceCycle(*m_halfEdgeMesh, start, nullptr, cycle) || signedArea(cycle.vertices) <= 0.0)
+            continue;
+        if (Polygon *cell = createPolygon(cycle.vertices, cycle.lines))
+            cells.push_back(cell);
+    }
+    return cells;
+}
+
+Polygon *MainWindow::deleteLineMergingCells(Line *line)
+{
+    if (!line)
+        return nullptr;
+
+    const std::vector<Polygon *> cells = line->connectedPolygons();
+    if (cells.size() != 2) {
+        deleteLine(line);
+        return nullptr;
+    }
+
+    // The merged cell is bounded by the lines that belong to only one of the
+    // two cells; any other shared lines stay behind inside it.
+    std::vector<Line *> allLines = cells[0]->lines();
+    allLines.insert(allLines.end(), cells[1]->lines().begin(), cells[1]->lines().end());
+    std::sort(allLines.begin(), allLines.end());
+    std::vector<Line *> boundary;
+    boundary.reserve(allLines.size());
+    for (std::size_t i = 0; i < allLines.size(); ++i) {
+        if (i + 1 < allLines.size() && allLines[i] == allLines[i + 1])
+            ++i;
+        else
+            boundary.push_back(allLines[i]);
+    }
+
+    // The ring is checked while both cells still exist. Cells that share
+    // more than one run of lines enclose a hole when merged, which is no
+    // polygon; the line then goes with both cells, as deleteLine does.
+    std::vector<Line *> orderedLines;
+    std::vector<Vertex *> orderedVertices;
+    if (!orderLinesIntoPolygon(boundary, orderedLines, orderedVertices)) {
+        deleteLine(line);
+        if (statusBar())
+            statusBar()->showMessage(tr("The cells on both sides of the line do not merge into one polygon; "
+                                        "both were deleted with the line."),
+                                     5000);
+        return nullptr;
+    }
+
+    const int id = std::min(cells[0]->id(), cells[1]->id());
+    deleteLine(line);
+    return createPolygonWithId(id, orderedVertices, orderedLines);
 }
 
 void MainWindow::deletePolygon(Polygon *polygon)
@@ -495,14 +690,45 @@ void MainWindow::deletePolygon(Polygon *polygon)
     if (!polygon)
         return;
 
-    const auto it = std::find_if(m_polygons.begin(),
-                                 m_polygons.end(),
-                                 [polygon](const std::unique_ptr<Polygon> &candidate) {
-                                     return candidate.get() == polygon;
-                                 });
+    const auto slot = m_polygonSlots.find(polygon);
+    if (slot == m_polygonSlots.end())
+        return;
 
-    if (it != m_polygons.end())
-        m_polygons.erase(it);
+    const std::size_t index = slot->second;
+    m_polygonSlots.erase(slot);
+    m_polygonsById.erase(polygon->id());
+    if (index + 1 != m_polygons.size()) {
+        std::swap(m_polygons[index], m_polygons.back());
+        m_polygonSlots[m_polygons[index].get()] = index;
+    }
+    m_polygons.pop_back();
+}
+
+void MainWindow::storeLine(std::unique_ptr<Line> line)
+{
+    m_lineSlots[line.get()] = m_lines.size();
+    m_lines.push_back(std::move(line));
+}
+
+void MainWindow::storePolygon(std::unique_ptr<Polygon> polygon)
+{
+    m_polygonSlots[polygon.get()] = m_polygons.size();
+    m_polygonsById[polygon->id()] = polygon.get();
+    m_polygons.push_back(std::move(polygon));
+}
+
+void MainWindow::clearLines()
+{
+    cancelLineCrossingCheck();
+    m_lines.clear();
+    m_lineSlots.clear();
+}
+
+void MainWindow::clearPolygons()
+{
+    m_polygons.clear();
+    m_polygonSlots.clear();
+    m_polygonsById.clear();
 }
 
 Line *MainWindow::findLineByGraphicsItem(const QGraphicsItem *item) const
@@ -553,15 +779,8 @@ Line *MainWindow::findLineById(int id) const
 
 Polygon *MainWindow::findPolygonById(int id) const
 {
-    const auto it = std::find_if(m_polygons.begin(), m_polygons.end(),
-                                 [id](const std::unique_ptr<Polygon> &polygon) {
-                                     return polygon && polygon->id() == id;
-                                 });
-
-    if (it != m_polygons.end())
-        return it->get();
-
-    return nullptr;
+    const auto it = m_polygonsById.find(id);
+    return it != m_polygonsById.end() ? it->second : nullptr;
 }
 
 Line *MainWindow::findLineByVertices(Vertex *startVertex, Vertex *endVertex) const
@@ -569,19 +788,11 @@ Line *MainWindow::findLineByVertices(Vertex *startVertex, Vertex *endVertex) con
     if (!startVertex || !endVertex)
         return nullptr;
 
-    const auto it = std::find_if(m_lines.begin(), m_lines.end(),
-                                 [startVertex, endVertex](const std::unique_ptr<Line> &line) {
-                                     if (!line)
-                                         return false;
-
-                                     const bool sameDirection = line->startVertex() == startVertex && line->endVertex() == endVertex;
-                                     const bool oppositeDirection = line->startVertex() == endVertex && line->endVertex() == startVertex;
-                                     return sameDirection || oppositeDirection;
-                                 });
-
-    if (it != m_lines.end())
-        return it->get();
-
+    // Only the lines at one of the vertices can join the two.
+    for (Line *line : startVertex->connectedLines()) {
+        if (line && line->involvesVertex(endVertex))
+            return line;
+    }
     return nullptr;
 }
 
@@ -592,6 +803,13 @@ bool MainWindow::orderLinesIntoPolygon(const std::vector<Line *> &inputLines,
     if (inputLines.size() < 3)
         return false;
 
+    // Lines around a face of the line graph are read off the half-edge mesh;
+    // anything else goes through the adjacency walk below.
+    if (m_halfEdgeMesh && m_halfEdgeMesh->faceRing(inputLines, orderedLines, orderedVertices)) {
+        ensureCounterClockwise(orderedVertices, orderedLines);
+        return true;
+    }
+
     std::unordered_set<Line *> uniqueLines;
     uniqueLines.reserve(inputLines.size());
 
@@ -693,132 +911,17 @@ bool MainWindow::containsVertex(const Vertex *vertex) const
 
 bool MainWindow::containsLine(const Line *line) const
 {
-    return std::any_of(m_lines.begin(),
-                       m_lines.end(),
-                       [line](const std::unique_ptr<Line> &candidate) {
-                           return candidate.get() == line;
-                       });
+    return m_lineSlots.count(line) > 0;
 }
 
 bool MainWindow::containsPolygon(const Polygon *polygon) const
 {
-    return std::any_of(m_polygons.begin(),
-                       m_polygons.end(),
-                       [polygon](const std::unique_ptr<Polygon> &candidate) {
-                           return candidate.get() == polygon;
-                       });
+    return m_polygonSlots.count(polygon) > 0;
 }
 
 bool MainWindow::validateRelationships() const
 {
-    bool valid = true;
-
-    for (const auto &vertexPtr : m_vertices) {
-        Vertex *vertex = vertexPtr.get();
-        if (!vertex)
-            continue;
-
-        for (Line *line : vertex->connectedLines()) {
-            if (!line)
-                continue;
-
-            if (!containsLine(line)) {
-                qWarning() << "Vertex" << vertex->id() << "references an unknown line";
-                valid = false;
-                continue;
-            }
-
-            if (line->startVertex() != vertex && line->endVertex() != vertex) {
-                qWarning() << "Vertex" << vertex->id() << "is linked to line" << line->id()
-                           << "that does not include it.";
-                valid = false;
-            }
-        }
-
-        for (Polygon *polygon : vertex->connectedPolygons()) {
-            if (!polygon)
-                continue;
-
-            if (!containsPolygon(polygon)) {
-                qWarning() << "Vertex" << vertex->id() << "references an unknown polygon";
-                valid = false;
-                continue;
-            }
-
-            if (!polygon->involvesVertex(vertex)) {
-                qWarning() << "Vertex" << vertex->id() << "is linked to polygon" << polygon->id()
-                           << "that does not contain it.";
-                valid = false;
-            }
-        }
-    }
-
-    for (const auto &linePtr : m_lines) {
-        Line *line = linePtr.get();
-        if (!line)
-            continue;
-
-        for (Polygon *polygon : line->connectedPolygons()) {
-            if (!polygon)
-                continue;
-
-            if (!containsPolygon(polygon)) {
-                qWarning() << "Line" << line->id() << "references an unknown polygon";
-                valid = false;
-                continue;
-            }
-
-            if (!polygon->involvesLine(line)) {
-                qWarning() << "Line" << line->id() << "is linked to polygon" << polygon->id()
-                           << "that does not include it.";
-                valid = false;
-            }
-        }
-    }
-
-    for (const auto &polygonPtr : m_polygons) {
-        Polygon *polygon = polygonPtr.get();
-        if (!polygon)
-            continue;
-
-        for (Vertex *vertex : polygon->vertices()) {
-            if (!vertex)
-                continue;
-
-            if (!containsVertex(vertex)) {
-                qWarning() << "Polygon" << polygon->id() << "references an unknown vertex";
-                valid = false;
-                continue;
-            }
-
-            const auto &vertexPolygons = vertex->connectedPolygons();
-            if (std::find(vertexPolygons.begin(), vertexPolygons.end(), polygon) == vertexPolygons.end()) {
-                qWarning() << "Polygon" << polygon->id() << "includes vertex" << vertex->id()
-                           << "that does not reference it back.";
-                valid = false;
-            }
-        }
-
-        for (Line *line : polygon->lines()) {
-            if (!line)
-                continue;
-
-            if (!containsLine(line)) {
-                qWarning() << "Polygon" << polygon->id() << "references an unknown line";
-                valid = false;
-                continue;
-            }
-
-            const auto &linePolygons = line->connectedPolygons();
-            if (std::find(linePolygons.begin(), linePolygons.end(), polygon) == linePolygons.end()) {
-                qWarning() << "Polygon" << polygon->id() << "includes line" << line->id()
-                           << "that does not reference it back.";
-                valid = false;
-            }
-        }
-    }
-
-    return valid;
+    return m_meshValidator->validateAll(m_vertices, m_lines, m_polygons);
 }
 
 void MainWindow::runVerticesLinesPolygonsStressTest()
@@ -967,42 +1070,435 @@ void MainWindow::runVerticesLinesPolygonsStressTest()
         statusBar()->showMessage(tr("Completed vertices/lines/polygons stress test."), 5000);
 }
 
-void MainWindow::on_actionDelete_Image_triggered(){
-    if (!m_scene)
+void MainWindow::buildBenchmarkGridMesh(int cellCount, const QRectF &area)
+{
+    if (cellCount <= 0)
         return;
 
-    if (m_backgroundItem) {
-        m_scene->removeItem(m_backgroundItem);
-        delete m_backgroundItem;
-        m_backgroundItem = nullptr;
+    const int cellsPerSide = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(cellCount))));
+    const int verticesPerSide = cellsPerSide + 1;
+    const qreal spacing = std::min(area.width(), area.height()) / cellsPerSide;
+
+    // Built in index form and bulk-loaded like the Voronoi tissue, so that
+    // production-sized grids skip the per-entity interactive paths.
+    PlanarMesh mesh;
+    mesh.vertices.reserve(static_cast<std::size_t>(verticesPerSide) * verticesPerSide);
+    for (int row = 0; row < verticesPerSide; ++row) {
+        for (int column = 0; column < verticesPerSide; ++column)
+            mesh.vertices.emplace_back(area.left() + column * spacing, area.top() + row * spacing);
     }
 
-    m_scene->clearSelection();
-    m_polygons.clear();
-    m_lines.clear();
-    m_vertices.clear();
-    m_nextLineId = 0;
-    m_nextPolygonId = 0;
+    const auto vertexAt = [verticesPerSide](int column, int row) { return row * verticesPerSide + column; };
 
-    m_scene->setSceneRect(0.0, 0.0, 512.0, 512.0);
-    ui->graphicsView->setSceneRect(m_scene->sceneRect());
+    // Horizontal edges first, then vertical ones, so each cell can look its
+    // four sides up by index.
+    const int horizontalCount = verticesPerSide * cellsPerSide;
+    mesh.lines.reserve(2 * static_cast<std::size_t>(horizontalCount));
+    for (int row = 0; row < verticesPerSide; ++row) {
+        for (int column = 0; column < cellsPerSide; ++column)
+            mesh.lines.emplace_back(vertexAt(column, row), vertexAt(column + 1, row));
+    }
+    for (int column = 0; column < verticesPerSide; ++column) {
+        for (int row = 0; row < cellsPerSide; ++row)
+            mesh.lines.emplace_back(vertexAt(column, row), vertexAt(column, row + 1));
+    }
 
-    if (ui->label_2)
-        ui->label_2->setText(tr("-"));
-    if (ui->label_4)
-        ui->label_4->setText(tr("-"));
-    if (ui->label_canvas_size)
-        ui->label_canvas_size->setText(tr("-"));
+    const std::size_t faceCount = static_cast<std::size_t>(cellsPerSide) * cellsPerSide;
+    mesh.faceOffsets.reserve(faceCount + 1);
+    mesh.faceVertices.reserve(4 * faceCount);
+    mesh.faceLines.reserve(4 * faceCount);
+    for (int row = 0; row < cellsPerSide; ++row) {
+        for (int column = 0; column < cellsPerSide; ++column) {
+            mesh.faceVertices.insert(mesh.faceVertices.end(),
+                                     {vertexAt(column, row),
+                                      vertexAt(column + 1, row),
+                                      vertexAt(column + 1, row + 1),
+                                      vertexAt(column, row + 1)});
+            mesh.faceLines.insert(mesh.faceLines.end(),
+                                  {row * cellsPerSide + column,
+                                   horizontalCount + (column + 1) * cellsPerSide + row,
+                                   (row + 1) * cellsPerSide + column,
+                                   horizontalCount + column * cellsPerSide + row});
+            mesh.faceOffsets.push_back(static_cast<int>(mesh.faceVertices.size()));
+        }
+    }
 
-    resetSelectionLabels();
+    loadPlanarMesh(mesh);
 }
 
-void MainWindow::on_actionAdd_Vertex_triggered()
+std::vector<Vertex *> MainWindow::createVerticesInBatch(const std::vector<QPointF> &positions)
 {
+    std::vector<Vertex *> vertices;
     if (!m_scene)
-        return;
+        return vertices;
+
+    // Ids continue after the current maximum, so m_vertices stays sorted and
+    // neither a per-vertex sort nor a per-vertex id search is needed.
+    int vertexId = m_vertices.empty() ? 0 : m_vertices.back()->id() + 1;
+    vertices.reserve(positions.size());
+    m_vertices.reserve(m_vertices.size() + positions.size());
+    for (const QPointF &position : positions) {
+        auto vertex = std::make_unique<Vertex>(vertexId++, position, m_scene);
+        vertex->setSpatialIndex(m_vertexIndex.get());
+        vertex->setCrossingGuard(m_crossingGuard.get());
+        if (kValidateMeshContinuously)
+            vertex->setMeshValidator(m_meshValidator.get());
+        vertex->setHalfEdgeMesh(m_halfEdgeMesh.get());
+        vertices.push_back(vertex.get());
+        m_vertices.push_back(std::move(vertex));
+    }
+    return vertices;
+}
 
-    QDialog dialog(this);
+std::vector<Line *> MainWindow::createLinesInBatch(const std::vector<std::pair<Vertex *, Vertex *>> &endpoints)
+{
+    std::vector<Line *> lines;
+    if (!m_scene)
+        return lines;
+
+    int lineId = 0;
+    for (const auto &line : m_lines) {
+        if (line)
+            lineId = std::max(lineId, line->id() + 1);
+    }
+
+    lines.reserve(endpoints.size());
+    m_lines.reserve(m_lines.size() + endpoints.size());
+    for (const auto &[start, end] : endpoints) {
+        auto line = std::make_unique<Line>(lineId++, start, end, m_scene);
+        line->setSpatialIndex(m_lineIndex.get());
+        if (kValidateMeshContinuously)
+            line->setMeshValidator(m_meshValidator.get());
+        line->setHalfEdgeMesh(m_halfEdgeMesh.get());
+        lines.push_back(line.get());
+        storeLine(std::move(line));
+    }
+    m_nextLineId = lineId;
+    return lines;
+}
+
+std::vector<Polygon *> MainWindow::createPolygonsInBatch(const PlanarMesh &mesh,
+                                                       const std::vector<Vertex *> &vertices,
+                                                       const std::vector<Line *> &lines)
+{
+    std::vector<Polygon *> polygons;
+    if (!m_scene)
+        return polygons;
+
+    int polygonId = 0;
+    for (const auto &polygon : m_polygons) {
+        if (polygon)
+            polygonId = std::max(polygonId, polygon->id() + 1);
+    }
+
+    // Faces come with their rings already in order, so orderLinesIntoPolygon
+    // is skipped.
+    polygons.reserve(mesh.faceCount());
+    m_polygons.reserve(m_polygons.size() + mesh.faceCount());
+    for (std::size_t face = 0; face < mesh.faceCount(); ++face) {
+        const auto begin = static_cast<std::size_t>(mesh.faceOffsets[face]);
+        const auto end = static_cast<std::size_t>(mesh.faceOffsets[face + 1]);
+
+        std::vector<Vertex *> faceVertices;
+        std::vector<Line *> faceLines;
+        faceVertices.reserve(end - begin);
+        faceLines.reserve(end - begin);
+        for (std::size_t i = begin; i < end; ++i) {
+            faceVertices.push_back(vertices[static_cast<std::size_t>(mesh.faceVertices[i])]);
+            faceLines.push_back(lines[static_cast<std::size_t>(mesh.faceLines[i])]);
+        }
+        ensureCounterClockwise(faceVertices, faceLines);
+
+        auto polygon = std::make_unique<Polygon>(polygonId++, std::move(faceVertices), std::move(faceLines), m_scene);
+        polygon->setSpatialIndex(m_polygonIndex.get());
+        if (kValidateMeshContinuously)
+            polygon->setMeshValidator(m_meshValidator.get());
+        polygon->setHalfEdgeMesh(m_halfEdgeMesh.get());
+        polygons.push_back(polygon.get());
+        storePolygon(std::move(polygon));
+    }
+
+    m_nextPolygonId = polygonId;
+    return polygons;
+}
+
+void MainWindow::loadPlanarMesh(const PlanarMesh &mesh)
+{
+    if (!m_scene)
+        return;
+
+    const std::vector<Vertex *> vertices = createVerticesInBatch(mesh.vertices);
+
+    std::vector<std::pair<Vertex *, Vertex *>> endpoints;
+    endpoints.reserve(mesh.lines.size());
+    for (const auto &[start, end] : mesh.lines)
+        endpoints.emplace_back(vertices[static_cast<std::size_t>(start)], vertices[static_cast<std::size_t>(end)]);
+    const std::vector<Line *> lines = createLinesInBatch(endpoints);
+
+    createPolygonsInBatch(mesh, vertices, lines);
+}
+
+QJsonObject MainWindow::runStressBenchmark(const StressBenchmarkOptions &options)
+{
+    QJsonObject report;
+    report.insert(QStringLiteral("benchmark"), QStringLiteral("vertices_lines_polygons_stress"));
+    report.insert(QStringLiteral("options"), options.toJson());
+    report.insert(QStringLiteral("qt_version"), QString::fromLatin1(qVersion()));
+    report.insert(QStringLiteral("platform"), QGuiApplication::platformName());
+    // Debug builds also run the incremental relationship check on every edit.
+    report.insert(QStringLiteral("debug_build"), kValidateMeshContinuously);
+
+    if (!m_scene) {
+        report.insert(QStringLiteral("error"), QStringLiteral("No active scene."));
+        return report;
+    }
+
+    m_scene->clearSelection();
+    clearPolygons();
+    clearLines();
+    m_vertices.clear();
+    m_nextLineId = 0;
+    m_nextPolygonId = 0;
+
+    const QRectF sceneRect = m_scene->sceneRect().isValid() ? m_scene->sceneRect() : QRectF(0.0, 0.0, 512.0, 512.0);
+    QRandomGenerator rng(options.seed);
+    StressBenchmarkRecorder recorder;
+
+    const auto timed = [&recorder](const QString &operation, auto &&function) {
+        QElapsedTimer timer;
+        timer.start();
+        if constexpr (std::is_void_v<decltype(function())>) {
+            function();
+            recorder.record(operation, timer.nsecsElapsed());
+        } else {
+            auto result = function();
+            recorder.record(operation, timer.nsecsElapsed());
+            return result;
+        }
+    };
+
+    QElapsedTimer setupTimer;
+    setupTimer.start();
+    if (options.meshKind == QLatin1String("voronoi")) {
+        VoronoiTissueOptions tissueOptions;
+        tissueOptions.cellCount = options.meshSize;
+        tissueOptions.area = sceneRect;
+        tissueOptions.seed = options.seed;
+        loadPlanarMesh(generateVoronoiTissue(tissueOptions));
+    } else {
+        buildBenchmarkGridMesh(options.meshSize, sceneRect);
+    }
+    report.insert(QStringLiteral("setup_ms"), static_cast<double>(setupTimer.nsecsElapsed()) / 1.0e6);
+
+    QJsonObject meshCounts;
+    meshCounts.insert(QStringLiteral("vertices"), static_cast<qint64>(m_vertices.size()));
+    meshCounts.insert(QStringLiteral("lines"), static_cast<qint64>(m_lines.size()));
+    meshCounts.insert(QStringLiteral("polygons"), static_cast<qint64>(m_polygons.size()));
+    report.insert(QStringLiteral("initial_mesh"), meshCounts);
+
+    int validationFailures = 0;
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    for (int round = 0; round < options.rounds; ++round) {
+        std::vector<Vertex *> roundVertices;
+        roundVertices.reserve(static_cast<std::size_t>(options.verticesPerRound));
+        for (int i = 0; i < options.verticesPerRound; ++i) {
+            const QPointF position(sceneRect.left() + sceneRect.width() * rng.generateDouble(),
+                                   sceneRect.top() + sceneRect.height() * rng.generateDouble());
+            if (Vertex *vertex = timed(QStringLiteral("create_vertex"), [&] { return createVertex(position); }))
+                roundVertices.push_back(vertex);
+        }
+
+        std::vector<Line *> ringLines;
+        ringLines.reserve(roundVertices.size());
+        for (std::size_t i = 0; i < roundVertices.size(); ++i) {
+            Vertex *start = roundVertices[i];
+            Vertex *end = roundVertices[(i + 1) % roundVertices.size()];
+            Line *line = timed(QStringLiteral("find_line"), [&] { return findLineByVertices(start, end); });
+            if (!line)
+                line = timed(QStringLiteral("create_line"), [&] { return createLine(start, end); });
+            if (line)
+                ringLines.push_back(line);
+        }
+
+        Polygon *polygon = nullptr;
+        if (roundVertices.size() >= 3 && ringLines.size() == roundVertices.size()) {
+            polygon = timed(QStringLiteral("create_polygon"), [&] { return createPolygon(roundVertices, ringLines); });
+        }
+
+        for (int i = 0; i < options.findsPerRound; ++i) {
+            if (!m_vertices.empty()) {
+                const int id = m_vertices[rng.bounded(static_cast<quint32>(m_vertices.size()))]->id();
+                timed(QStringLiteral("find_vertex"), [&] { return findVertexById(id); });
+            }
+            if (!m_lines.empty()) {
+                const Line *target = m_lines[rng.bounded(static_cast<quint32>(m_lines.size()))].get();
+                Vertex *start = target->startVertex();
+                Vertex *end = target->endVertex();
+                timed(QStringLiteral("find_line"), [&] { return findLineByVertices(start, end); });
+            }
+            if (!m_polygons.empty()) {
+                const int id = m_polygons[rng.bounded(static_cast<quint32>(m_polygons.size()))]->id();
+                timed(QStringLiteral("find_polygon"), [&] { return findPolygonById(id); });
+            }
+        }
+
+        if (options.validateEvery > 0 && (round + 1) % options.validateEvery == 0) {
+            if (!timed(QStringLiteral("validate"), [this] { return validateRelationships(); }))
+                ++validationFailures;
+        }
+
+        if (polygon && rng.generateDouble() < options.deleteFraction)
+            timed(QStringLiteral("delete_polygon"), [&] { deletePolygon(polygon); });
+
+        for (Line *line : ringLines) {
+            if (rng.generateDouble() < options.deleteFraction && containsLine(line))
+                timed(QStringLiteral("delete_line"), [&] { deleteLine(line); });
+        }
+
+        // Whatever survives is removed too, so every round starts from the
+        // background mesh; these deletions cascade to the remaining lines.
+        for (Vertex *vertex : roundVertices) {
+            if (containsVertex(vertex))
+                timed(QStringLiteral("delete_vertex"), [&] { deleteVertex(vertex); });
+        }
+    }
+
+    report.insert(QStringLiteral("total_ms"), static_cast<double>(totalTimer.nsecsElapsed()) / 1.0e6);
+    report.insert(QStringLiteral("validation_failures"), validationFailures);
+    report.insert(QStringLiteral("operations"), recorder.toJson());
+    return report;
+}
+
+void MainWindow::runGraphicsItemBenchmark()
+{
+    constexpr int itemCount = 20000;
+    constexpr int probeCount = 20000;
+    constexpr qreal vertexRadius = 6.0;
+    const QRectF sceneRect(0.0, 0.0, 4096.0, 4096.0);
+
+    QRandomGenerator rng(1234);
+    std::vector<QPointF> positions;
+    positions.reserve(itemCount);
+    for (int i = 0; i < itemCount; ++i)
+        positions.emplace_back(sceneRect.width() * rng.generateDouble(), sceneRect.height() * rng.generateDouble());
+
+    std::vector<QPointF> probes;
+    probes.reserve(probeCount);
+    for (int i = 0; i < probeCount; ++i)
+        probes.emplace_back(sceneRect.width() * rng.generateDouble(), sceneRect.height() * rng.generateDouble());
+
+    const auto segmentFor = [&positions](int index) {
+        const QPointF &start = positions[static_cast<std::size_t>(index)];
+        return QLineF(start, start + QPointF(20.0 + index % 40, 10.0 - index % 25));
+    };
+
+    // The previous item configuration, kept here as the baseline.
+    const ItemBenchmarkResult ellipseResult = benchmarkGraphicsItems(
+        [&positions](int index) {
+            auto *item = new QGraphicsEllipseItem(-vertexRadius, -vertexRadius, vertexRadius * 2, vertexRadius * 2);
+            item->setBrush(QBrush(Qt::red));
+            item->setPen(QPen(Qt::NoPen));
+            item->setZValue(1.0);
+            item->setFlag(QGraphicsItem::ItemIsSelectable);
+            item->setFlag(QGraphicsItem::ItemIsMovable);
+            item->setFlag(QGraphicsItem::ItemSendsScenePositionChanges);
+            item->setFlag(QGraphicsItem::ItemIgnoresTransformations);
+            item->setCursor(Qt::OpenHandCursor);
+            item->setPos(positions[static_cast<std::size_t>(index)]);
+            return static_cast<QGraphicsItem *>(item);
+        },
+        itemCount, probes, sceneRect);
+
+    const ItemBenchmarkResult vertexResult = benchmarkGraphicsItems(
+        [&positions](int index) {
+            auto *item = new VertexGraphicsItem(nullptr, vertexRadius);
+            item->setPos(positions[static_cast<std::size_t>(index)]);
+            return static_cast<QGraphicsItem *>(item);
+        },
+        itemCount, probes, sceneRect);
+
+    const ItemBenchmarkResult lineItemResult = benchmarkGraphicsItems(
+        [&segmentFor](int index) {
+            auto *item = new QGraphicsLineItem(segmentFor(index));
+            QPen pen(QColor(0, 170, 0));
+            pen.setWidthF(2.0);
+            item->setPen(pen);
+            item->setZValue(0.5);
+            item->setFlag(QGraphicsItem::ItemIsSelectable);
+            return static_cast<QGraphicsItem *>(item);
+        },
+        itemCount, probes, sceneRect);
+
+    const ItemBenchmarkResult lineResult = benchmarkGraphicsItems(
+        [&segmentFor](int index) {
+            auto *item = new LineGraphicsItem;
+            item->setLine(segmentFor(index));
+            return static_cast<QGraphicsItem *>(item);
+        },
+        itemCount, probes, sceneRect);
+
+    const auto report = [](const char *name, const ItemBenchmarkResult &result) {
+        qInfo().noquote() << QStringLiteral("%1: %2 bytes/item on the heap, created in %3 ms, "
+                                            "%4 point hit tests in %5 ms (%6 hits)")
+                                 .arg(QLatin1String(name))
+                                 .arg(result.heapBytesPerItem)
+                                 .arg(result.creationMs)
+                                 .arg(probeCount)
+                                 .arg(result.hitTestMs)
+                                 .arg(result.hits);
+    };
+
+    qInfo() << "Graphics item benchmark with" << itemCount << "items per kind";
+    report("QGraphicsEllipseItem (previous vertex)", ellipseResult);
+    report("VertexGraphicsItem", vertexResult);
+    report("QGraphicsLineItem (previous line)", lineItemResult);
+    report("LineGraphicsItem", lineResult);
+
+    if (statusBar()) {
+        statusBar()->showMessage(tr("Graphics item benchmark: vertices %1 -> %2 bytes/item, lines %3 -> %4 bytes/item.")
+                                     .arg(ellipseResult.heapBytesPerItem)
+                                     .arg(vertexResult.heapBytesPerItem)
+                                     .arg(lineItemResult.heapBytesPerItem)
+                                     .arg(lineResult.heapBytesPerItem),
+                                 10000);
+    }
+}
+
+void MainWindow::on_actionDelete_Image_triggered(){
+    if (!m_scene)
+        return;
+
+    cancelBackgroundImageLoad();
+    removeBackgroundItem();
+
+    m_scene->clearSelection();
+    clearPolygons();
+    clearLines();
+    m_vertices.clear();
+    m_nextLineId = 0;
+    m_nextPolygonId = 0;
+
+    m_scene->setSceneRect(0.0, 0.0, 512.0, 512.0);
+    ui->graphicsView->setSceneRect(m_scene->sceneRect());
+
+    if (ui->label_2)
+        ui->label_2->setText(tr("-"));
+    if (ui->label_4)
+        ui->label_4->setText(tr("-"));
+    if (ui->label_canvas_size)
+        ui->label_canvas_size->setText(tr("-"));
+
+    resetSelectionLabels();
+}
+
+void MainWindow::on_actionAdd_Vertex_triggered()
+{
+    if (!m_scene)
+        return;
+
+    QDialog dialog(this);
     dialog.setWindowTitle(tr("Add Vertex"));
 
     QFormLayout form(&dialog);
@@ -1107,6 +1603,10 @@ void MainWindow::on_actionAdd_Line_triggered()
         return;
     }
 
+    const std::vector<Polygon *> cells = closeCellsAroundLine(line);
+    if (!cells.empty() && statusBar())
+        statusBar()->showMessage(tr("The line closed %n cell(s).", nullptr, static_cast<int>(cells.size())), 5000);
+
     if (QGraphicsItem *item = line->graphicsItem()) {
         m_scene->clearSelection();
         item->setSelected(true);
@@ -1352,13 +1852,6 @@ void MainWindow::on_actionAdd_Polygon_triggered()
 
 void MainWindow::on_actionFind_Line_triggered()
 {
-    if (m_lines.empty()) {
-        QMessageBox::information(this,
-                                 tr("Find Line"),
-                                 tr("There are no lines to select."));
-        return;
-    }
-
     int maxId = 0;
     bool hasLine = false;
     for (const auto &line : m_lines) {
@@ -1375,25 +1868,100 @@ void MainWindow::on_actionFind_Line_triggered()
         return;
     }
 
-    bool ok = false;
-    const int idToFind = QInputDialog::getInt(this,
-                                              tr("Find Line"),
-                                              tr("Enter the line ID:"),
-                                              0,
-                                              0,
-                                              std::max(0, maxId),
-                                              1,
-                                              &ok);
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Find Line"));
 
-    if (!ok)
-        return;
+    auto *mainLayout = new QVBoxLayout(&dialog);
 
-    Line *line = findLineById(idToFind);
-    if (!line) {
-        QMessageBox::warning(this,
-                              tr("Find Line"),
-                              tr("No line with ID %1 was found.").arg(idToFind));
+    auto *modeGroup = new QGroupBox(tr("Search Mode"), &dialog);
+    auto *modeLayout = new QVBoxLayout(modeGroup);
+    auto *idRadio = new QRadioButton(tr("By ID"), modeGroup);
+    auto *positionRadio = new QRadioButton(tr("Near Position"), modeGroup);
+    idRadio->setChecked(true);
+    modeLayout->addWidget(idRadio);
+    modeLayout->addWidget(positionRadio);
+    modeGroup->setLayout(modeLayout);
+
+    auto *stack = new QStackedWidget(&dialog);
+
+    auto *idWidget = new QWidget(&dialog);
+    auto *idLayout = new QFormLayout(idWidget);
+    auto *idSpinBox = new QSpinBox(idWidget);
+    idSpinBox->setRange(0, std::max(0, maxId));
+    idLayout->addRow(tr("Line ID:"), idSpinBox);
+    idWidget->setLayout(idLayout);
+    stack->addWidget(idWidget);
+
+    auto *positionWidget = new QWidget(&dialog);
+    auto *positionLayout = new QFormLayout(positionWidget);
+    auto *xSpinBox = new QDoubleSpinBox(positionWidget);
+    auto *ySpinBox = new QDoubleSpinBox(positionWidget);
+    auto *toleranceSpinBox = new QDoubleSpinBox(positionWidget);
+
+    const QRectF sceneRect = m_scene ? m_scene->sceneRect() : QRectF();
+    xSpinBox->setRange(sceneRect.left(), sceneRect.right());
+    ySpinBox->setRange(sceneRect.top(), sceneRect.bottom());
+    xSpinBox->setDecimals(2);
+    ySpinBox->setDecimals(2);
+
+    toleranceSpinBox->setRange(0.0, 1000.0);
+    toleranceSpinBox->setDecimals(2);
+    toleranceSpinBox->setSingleStep(0.5);
+    toleranceSpinBox->setValue(5.0);
+
+    positionLayout->addRow(tr("X position:"), xSpinBox);
+    positionLayout->addRow(tr("Y position:"), ySpinBox);
+    positionLayout->addRow(tr("Max distance:"), toleranceSpinBox);
+    positionWidget->setLayout(positionLayout);
+    stack->addWidget(positionWidget);
+
+    QObject::connect(idRadio, &QRadioButton::toggled, stack, [stack](bool checked) {
+        if (checked)
+            stack->setCurrentIndex(0);
+    });
+    QObject::connect(positionRadio, &QRadioButton::toggled, stack, [stack](bool checked) {
+        if (checked)
+            stack->setCurrentIndex(1);
+    });
+
+    stack->setCurrentIndex(0);
+
+    mainLayout->addWidget(modeGroup);
+    mainLayout->addWidget(stack);
+
+    auto *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
+                                           Qt::Horizontal,
+                                           &dialog);
+    mainLayout->addWidget(buttonBox);
+
+    QObject::connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted)
         return;
+
+    Line *line = nullptr;
+    if (idRadio->isChecked()) {
+        const int idToFind = idSpinBox->value();
+        line = findLineById(idToFind);
+        if (!line) {
+            QMessageBox::warning(this,
+                                  tr("Find Line"),
+                                  tr("No line with ID %1 was found.").arg(idToFind));
+            return;
+        }
+    } else {
+        const QPointF positionToFind(xSpinBox->value(), ySpinBox->value());
+        line = m_lineIndex ? m_lineIndex->nearest(positionToFind, toleranceSpinBox->value()) : nullptr;
+        if (!line) {
+            QMessageBox::information(this,
+                                     tr("Find Line"),
+                                     tr("No line lies within %1 of (%2, %3).")
+                                         .arg(toleranceSpinBox->value())
+                                         .arg(positionToFind.x())
+                                         .arg(positionToFind.y()));
+            return;
+        }
     }
 
     if (m_scene)
@@ -1433,25 +2001,92 @@ void MainWindow::on_actionFind_Polygon_triggered()
         return;
     }
 
-    bool ok = false;
-    const int idToFind = QInputDialog::getInt(this,
-                                              tr("Find Polygon"),
-                                              tr("Enter the polygon ID:"),
-                                              0,
-                                              0,
-                                              std::max(0, maxId),
-                                              1,
-                                              &ok);
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Find Polygon"));
 
-    if (!ok)
-        return;
+    auto *mainLayout = new QVBoxLayout(&dialog);
 
-    Polygon *polygon = findPolygonById(idToFind);
-    if (!polygon) {
-        QMessageBox::warning(this,
-                              tr("Find Polygon"),
-                              tr("No polygon with ID %1 was found.").arg(idToFind));
+    auto *modeGroup = new QGroupBox(tr("Search Mode"), &dialog);
+    auto *modeLayout = new QVBoxLayout(modeGroup);
+    auto *idRadio = new QRadioButton(tr("By ID"), modeGroup);
+    auto *positionRadio = new QRadioButton(tr("By Position"), modeGroup);
+    idRadio->setChecked(true);
+    modeLayout->addWidget(idRadio);
+    modeLayout->addWidget(positionRadio);
+    modeGroup->setLayout(modeLayout);
+
+    auto *stack = new QStackedWidget(&dialog);
+
+    auto *idWidget = new QWidget(&dialog);
+    auto *idLayout = new QFormLayout(idWidget);
+    auto *idSpinBox = new QSpinBox(idWidget);
+    idSpinBox->setRange(0, std::max(0, maxId));
+    idLayout->addRow(tr("Polygon ID:"), idSpinBox);
+    idWidget->setLayout(idLayout);
+    stack->addWidget(idWidget);
+
+    auto *positionWidget = new QWidget(&dialog);
+    auto *positionLayout = new QFormLayout(positionWidget);
+    auto *xSpinBox = new QDoubleSpinBox(positionWidget);
+    auto *ySpinBox = new QDoubleSpinBox(positionWidget);
+
+    const QRectF sceneRect = m_scene ? m_scene->sceneRect() : QRectF();
+    xSpinBox->setRange(sceneRect.left(), sceneRect.right());
+    ySpinBox->setRange(sceneRect.top(), sceneRect.bottom());
+    xSpinBox->setDecimals(2);
+    ySpinBox->setDecimals(2);
+
+    positionLayout->addRow(tr("X position:"), xSpinBox);
+    positionLayout->addRow(tr("Y position:"), ySpinBox);
+    positionWidget->setLayout(positionLayout);
+    stack->addWidget(positionWidget);
+
+    QObject::connect(idRadio, &QRadioButton::toggled, stack, [stack](bool checked) {
+        if (checked)
+            stack->setCurrentIndex(0);
+    });
+    QObject::connect(positionRadio, &QRadioButton::toggled, stack, [stack](bool checked) {
+        if (checked)
+            stack->setCurrentIndex(1);
+    });
+
+    stack->setCurrentIndex(0);
+
+    mainLayout->addWidget(modeGroup);
+    mainLayout->addWidget(stack);
+
+    auto *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
+                                           Qt::Horizontal,
+                                           &dialog);
+    mainLayout->addWidget(buttonBox);
+
+    QObject::connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted)
         return;
+
+    Polygon *polygon = nullptr;
+    if (idRadio->isChecked()) {
+        const int idToFind = idSpinBox->value();
+        polygon = findPolygonById(idToFind);
+        if (!polygon) {
+            QMessageBox::warning(this,
+                                  tr("Find Polygon"),
+                                  tr("No polygon with ID %1 was found.").arg(idToFind));
+            return;
+        }
+    } else {
+        const QPointF positionToFind(xSpinBox->value(), ySpinBox->value());
+        polygon = m_polygonIndex ? m_polygonIndex->polygonAt(positionToFind) : nullptr;
+        if (!polygon) {
+            QMessageBox::information(this,
+                                     tr("Find Polygon"),
+                                     tr("No polygon contains (%1, %2).")
+                                         .arg(positionToFind.x())
+                                         .arg(positionToFind.y()));
+            return;
+        }
     }
 
     if (m_scene)
@@ -1513,8 +2148,8 @@ void MainWindow::on_actionDelete_All_Vertices_triggered()
                                              QMessageBox::No);
 
     if (reply == QMessageBox::Yes) {
-        m_polygons.clear();
-        m_lines.clear();
+        clearPolygons();
+        clearLines();
         m_vertices.clear();
         m_nextLineId = 0;
         m_nextPolygonId = 0;
@@ -1571,7 +2206,7 @@ void MainWindow::on_actionDelete_Line_triggered()
     if (m_scene)
         m_scene->clearSelection();
 
-    deleteLine(line);
+    deleteLineMergingCells(line);
     resetSelectionLabels();
 }
 
@@ -1649,8 +2284,8 @@ void MainWindow::on_actionDelete_All_Lines_triggered()
     if (m_scene)
         m_scene->clearSelection();
 
-    m_polygons.clear();
-    m_lines.clear();
+    clearPolygons();
+    clearLines();
     m_nextLineId = 0;
     m_nextPolygonId = 0;
     resetSelectionLabels();
@@ -1677,7 +2312,7 @@ void MainWindow::on_actionDelete_All_Polygons_triggered()
     if (m_scene)
         m_scene->clearSelection();
 
-    m_polygons.clear();
+    clearPolygons();
     m_nextPolygonId = 0;
     resetSelectionLabels();
 }
@@ -1773,30 +2408,10 @@ void MainWindow::on_actionFind_Vertex_triggered()
     const QPointF positionToFind(xSpinBox->value(), ySpinBox->value());
     const double tolerance = toleranceSpinBox->value();
 
-    const auto findById = [idToFind](const std::unique_ptr<Vertex> &vertex) {
-        return vertex && vertex->id() == idToFind;
-    };
-
-    auto it = std::find_if(m_vertices.begin(), m_vertices.end(), findById);
-    if (it != m_vertices.end()) {
-        selectedVertex = it->get();
-    }
-
-    if (!selectedVertex) {
-        const auto findByPosition = [positionToFind, tolerance](const std::unique_ptr<Vertex> &vertex) {
-            if (!vertex)
-                return false;
-
-            const QPointF vertexPos = vertex->graphicsItem() ? vertex->graphicsItem()->scenePos() : vertex->position();
-            const qreal dx = vertexPos.x() - positionToFind.x();
-            const qreal dy = vertexPos.y() - positionToFind.y();
-            const qreal distanceSquared = dx * dx + dy * dy;
-            return distanceSquared <= tolerance * tolerance;
-        };
-
-        it = std::find_if(m_vertices.begin(), m_vertices.end(), findByPosition);
-        if (it != m_vertices.end())
-            selectedVertex = it->get();
+    if (idRadio->isChecked()) {
+        selectedVertex = findVertexById(idToFind);
+    } else if (m_vertexIndex) {
+        selectedVertex = m_vertexIndex->nearest(positionToFind, tolerance);
     }
 
     if (!selectedVertex) {
@@ -1845,6 +2460,9 @@ void MainWindow::onSceneChanged(const QList<QRectF> & /*region*/)
     if (!m_scene)
         return;
 
+    if (kValidateMeshContinuously && m_meshValidator->hasPendingChecks())
+        m_meshValidator->validatePending();
+
     const auto selectedItems = m_scene->selectedItems();
     if (selectedItems.size() != 1)
         return;
@@ -1867,7 +2485,13 @@ void MainWindow::handleAddVertexFromContextMenu(const QPointF &scenePosition)
     if (!m_scene->sceneRect().contains(scenePosition))
         return;
 
-    Vertex *vertex = createVertex(scenePosition);
+    // Clicking on or right next to an existing vertex selects it instead of
+    // stacking a duplicate on top.
+    const qreal viewScale = ui->graphicsView->transform().m11();
+    const qreal snapRadius = viewScale > 0.0 ? kVertexSnapRadiusPixels / viewScale : kVertexSnapRadiusPixels;
+    Vertex *vertex = m_vertexIndex ? m_vertexIndex->nearest(scenePosition, snapRadius) : nullptr;
+    if (!vertex)
+        vertex = createVertex(scenePosition);
     if (!vertex)
         return;
 
@@ -1927,7 +2551,7 @@ void MainWindow::handleDeleteLineFromContextMenu(QGraphicsItem *lineItem)
 
     if (Line *line = findLineByGraphicsItem(lineItem)) {
         m_scene->clearSelection();
-        deleteLine(line);
+        deleteLineMergingCells(line);
         resetSelectionLabels();
     }
 }
@@ -1956,7 +2580,7 @@ void MainWindow::handleDeleteSelectedLinesFromContextMenu(const QList<QGraphicsI
     m_scene->clearSelection();
 
     for (Line *line : linesToDelete)
-        deleteLine(line);
+        deleteLineMergingCells(line);
 
     resetSelectionLabels();
 }
@@ -2037,6 +2661,10 @@ void MainWindow::handleCreateLineFromContextMenu(QGraphicsItem *firstVertexItem,
     if (!line)
         return;
 
+    const std::vector<Polygon *> cells = closeCellsAroundLine(line);
+    if (!cells.empty() && statusBar())
+        statusBar()->showMessage(tr("The line closed %n cell(s).", nullptr, static_cast<int>(cells.size())), 5000);
+
     if (QGraphicsItem *lineGraphicsItem = line->graphicsItem()) {
         m_scene->clearSelection();
         lineGraphicsItem->setSelected(true);
@@ -2275,7 +2903,7 @@ void MainWindow::handleDeleteSelectedItemsFromContextMenu(const QList<QGraphicsI
         deletePolygon(polygon);
 
     for (Line *line : linesToDelete)
-        deleteLine(line);
+        deleteLineMergingCells(line);
 
     for (Vertex *vertex : verticesToDelete)
         deleteVertex(vertex);
@@ -2382,49 +3010,206 @@ void MainWindow::on_actionCell_Contour_Image_triggered()
     if (filePath.isEmpty())
         return;
 
-    const QPixmap pixmap(filePath);
-    if (pixmap.isNull()) {
+    QString errorString;
+    const QSize imageSize = ImageLoader::readImageSize(filePath, &errorString);
+    if (!errorString.isEmpty()) {
         QMessageBox::warning(this,
                              tr("Open Image"),
                              tr("Failed to load image: %1").arg(QDir::toNativeSeparators(filePath)));
         return;
     }
 
-    if (m_backgroundItem) {
-        m_scene->removeItem(m_backgroundItem);
-        delete m_backgroundItem;
-        m_backgroundItem = nullptr;
-    }
+    m_imageLoader->cancel();
+    removeBackgroundItem();
 
     m_scene->clearSelection();
-    m_polygons.clear();
-    m_lines.clear();
+    clearPolygons();
+    clearLines();
     m_vertices.clear();
     m_nextLineId = 0;
     m_nextPolygonId = 0;
 
-    m_backgroundItem = m_scene->addPixmap(pixmap);
-    if (m_backgroundItem) {
-        m_backgroundItem->setZValue(-1.0);
-        m_backgroundItem->setPos(0.0, 0.0);
+    // The header is enough to lay out the scene; pixels arrive from the loader.
+    if (imageSize.isValid()) {
+        m_scene->setSceneRect(QRectF(QPointF(0.0, 0.0), QSizeF(imageSize)));
+        ui->graphicsView->setSceneRect(m_scene->sceneRect());
     }
 
-    m_scene->setSceneRect(pixmap.rect());
-    ui->graphicsView->setSceneRect(m_scene->sceneRect());
-
     const QFileInfo fileInfo(filePath);
     if (ui->label_2)
         ui->label_2->setText(QDir::toNativeSeparators(fileInfo.absolutePath()));
     if (ui->label_4)
         ui->label_4->setText(fileInfo.fileName());
-    if (ui->label_canvas_size)
-        ui->label_canvas_size->setText(tr("%1 x %2").arg(pixmap.width()).arg(pixmap.height()));
+    if (ui->label_canvas_size) {
+        ui->label_canvas_size->setText(imageSize.isValid()
+                                           ? tr("%1 x %2").arg(imageSize.width()).arg(imageSize.height())
+                                           : tr("-"));
+    }
 
     resetSelectionLabels();
+
+    m_loadingImagePath = filePath;
+    setImageLoadInProgress(true);
+    m_imageLoader->load(filePath);
+}
+
+void MainWindow::handleBackgroundPreviewReady(const QImage &preview)
+{
+    if (!m_scene || preview.isNull())
+        return;
+
+    setBackgroundPixmap(QPixmap::fromImage(preview), m_scene->sceneRect().size());
+}
+
+void MainWindow::handleBackgroundImageReady(const QImage &image)
+{
+    setImageLoadInProgress(false);
+
+    if (!m_scene || image.isNull())
+        return;
+
+    const QPixmap pixmap = QPixmap::fromImage(image);
+    if (m_scene->sceneRect() != QRectF(pixmap.rect())) {
+        m_scene->setSceneRect(pixmap.rect());
+        ui->graphicsView->setSceneRect(m_scene->sceneRect());
+        if (ui->label_canvas_size)
+            ui->label_canvas_size->setText(tr("%1 x %2").arg(pixmap.width()).arg(pixmap.height()));
+    }
+
+    m_backgroundImage = image;
+    setContourMask(BinaryImage());
+    setBackgroundPixmap(pixmap, pixmap.size());
 }
 
+void MainWindow::handleBackgroundImageLoadFailed(const QString &errorString)
+{
+    setImageLoadInProgress(false);
+
+    QString message = tr("Failed to load image: %1").arg(QDir::toNativeSeparators(m_loadingImagePath));
+    if (!errorString.isEmpty())
+        message += QStringLiteral("\n") + errorString;
 
+    QMessageBox::warning(this, tr("Open Image"), message);
+}
 
+void MainWindow::handleBackgroundImageLoadProgress(int percent)
+{
+    if (m_imageLoadProgressBar)
+        m_imageLoadProgressBar->setValue(percent);
+}
+
+void MainWindow::cancelBackgroundImageLoad()
+{
+    if (!m_imageLoader || !m_imageLoader->isLoading())
+        return;
+
+    m_imageLoader->cancel();
+    setImageLoadInProgress(false);
+
+    if (statusBar())
+        statusBar()->showMessage(tr("Image loading canceled."), 5000);
+}
+
+void MainWindow::removeBackgroundItem()
+{
+    if (auto *zoomableView = qobject_cast<ZoomableGraphicsView *>(ui->graphicsView))
+        zoomableView->clearCanvasBackground();
+
+    removeSkeletonOverlay();
+    m_backgroundImage = QImage();
+    setContourMask(BinaryImage());
+
+    if (!m_scene || !m_backgroundItem)
+        return;
+
+    m_scene->removeItem(m_backgroundItem);
+    delete m_backgroundItem;
+    m_backgroundItem = nullptr;
+}
+
+void MainWindow::setContourMask(BinaryImage mask)
+{
+    m_contourMask = std::move(mask);
+    m_contourDistance.reset();
+}
+
+// The contour mask of the last skeletonization, or without one yet the plain
+// threshold of the background image. Null until the full image is loaded;
+// the preview of a canceled load does not match the scene's pixel grid.
+const BinaryImage &MainWindow::contourMask()
+{
+    if (m_contourMask.isNull() && !m_backgroundImage.isNull())
+        m_contourMask = BinaryImage::fromContourImage(m_backgroundImage);
+    return m_contourMask;
+}
+
+// Distance from every pixel to the nearest contour pixel, computed once per
+// contour mask.
+const DistanceTransform *MainWindow::contourDistanceTransform()
+{
+    if (m_contourDistance)
+        return m_contourDistance.get();
+    if (contourMask().isNull())
+        return nullptr;
+
+    QElapsedTimer timer;
+    timer.start();
+    m_contourDistance = std::make_unique<DistanceTransform>(m_contourMask);
+    qInfo() << "Computed the distance transform of" << m_contourMask.width() << "x" << m_contourMask.height()
+            << "contour mask in" << timer.elapsed() << "ms";
+    return m_contourDistance.get();
+}
+
+void MainWindow::removeSkeletonOverlay()
+{
+    if (!m_scene || !m_skeletonItem)
+        return;
+
+    m_scene->removeItem(m_skeletonItem);
+    delete m_skeletonItem;
+    m_skeletonItem = nullptr;
+}
+
+void MainWindow::setBackgroundPixmap(const QPixmap &pixmap, const QSizeF &sceneSize)
+{
+    if (!m_scene)
+        return;
+
+    if (!m_backgroundItem) {
+        m_backgroundItem = m_scene->addPixmap(pixmap);
+        if (!m_backgroundItem)
+            return;
+
+        m_backgroundItem->setZValue(-1.0);
+        m_backgroundItem->setPos(0.0, 0.0);
+    } else {
+        m_backgroundItem->setPixmap(pixmap);
+    }
+
+    // A downscaled preview is stretched over the full image extent until the
+    // full-resolution pixmap replaces it.
+    QTransform transform;
+    if (!pixmap.isNull() && !sceneSize.isEmpty()
+        && (pixmap.width() != qRound(sceneSize.width()) || pixmap.height() != qRound(sceneSize.height()))) {
+        transform.scale(sceneSize.width() / pixmap.width(), sceneSize.height() / pixmap.height());
+    }
+    m_backgroundItem->setTransform(transform);
+}
+
+void MainWindow::setImageLoadInProgress(bool inProgress)
+{
+    if (m_imageLoadProgressBar) {
+        m_imageLoadProgressBar->setValue(0);
+        m_imageLoadProgressBar->setVisible(inProgress);
+    }
+    if (m_cancelImageLoadButton)
+        m_cancelImageLoadButton->setVisible(inProgress);
+
+    if (inProgress && statusBar())
+        statusBar()->showMessage(tr("Loading %1...").arg(QDir::toNativeSeparators(m_loadingImagePath)));
+    else if (statusBar())
+        statusBar()->clearMessage();
+}
 
 void MainWindow::on_actionCustom_Canvas_triggered()
 {
@@ -2461,6 +3246,28 @@ void MainWindow::on_actionCustom_Canvas_triggered()
     blueSpinBox->setValue(0);
     layout->addRow(tr("Blue (0-255):"), blueSpinBox);
 
+    auto *gridCheckBox = new QCheckBox(tr("Show grid"), &dialog);
+    layout->addRow(gridCheckBox);
+
+    auto *gridSpacingSpinBox = new QDoubleSpinBox(&dialog);
+    gridSpacingSpinBox->setRange(1.0, 10000.0);
+    gridSpacingSpinBox->setDecimals(1);
+    gridSpacingSpinBox->setValue(50.0);
+    gridSpacingSpinBox->setEnabled(false);
+    layout->addRow(tr("Grid spacing (px):"), gridSpacingSpinBox);
+    QObject::connect(gridCheckBox, &QCheckBox::toggled, gridSpacingSpinBox, &QWidget::setEnabled);
+
+    auto *scaleBarCheckBox = new QCheckBox(tr("Show scale bar"), &dialog);
+    layout->addRow(scaleBarCheckBox);
+
+    auto *scaleBarLengthSpinBox = new QDoubleSpinBox(&dialog);
+    scaleBarLengthSpinBox->setRange(1.0, 10000.0);
+    scaleBarLengthSpinBox->setDecimals(1);
+    scaleBarLengthSpinBox->setValue(100.0);
+    scaleBarLengthSpinBox->setEnabled(false);
+    layout->addRow(tr("Scale bar length (px):"), scaleBarLengthSpinBox);
+    QObject::connect(scaleBarCheckBox, &QCheckBox::toggled, scaleBarLengthSpinBox, &QWidget::setEnabled);
+
     auto *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
                                            Qt::Horizontal,
                                            &dialog);
@@ -2477,30 +3284,31 @@ void MainWindow::on_actionCustom_Canvas_triggered()
     const int green = greenSpinBox->value();
     const int blue = blueSpinBox->value();
 
-    if (m_backgroundItem) {
-        m_scene->removeItem(m_backgroundItem);
-        delete m_backgroundItem;
-        m_backgroundItem = nullptr;
-    }
+    cancelBackgroundImageLoad();
+    removeBackgroundItem();
 
-    QImage backgroundImage(width, height, QImage::Format_RGB32);
-    backgroundImage.fill(QColor(red, green, blue));
+    m_scene->setSceneRect(0.0, 0.0, static_cast<qreal>(width), static_cast<qreal>(height));
 
-    const QPixmap pixmap = QPixmap::fromImage(backgroundImage);
-    m_backgroundItem = m_scene->addPixmap(pixmap);
-    if (m_backgroundItem) {
-        m_backgroundItem->setZValue(-1.0);
-        m_backgroundItem->setPos(0.0, 0.0);
+    // The canvas is painted procedurally by the view, so no image is allocated
+    // regardless of its size.
+    if (auto *zoomableView = qobject_cast<ZoomableGraphicsView *>(ui->graphicsView)) {
+        ZoomableGraphicsView::CanvasBackground background;
+        background.rect = m_scene->sceneRect();
+        background.color = QColor(red, green, blue);
+        background.showGrid = gridCheckBox->isChecked();
+        background.gridSpacing = gridSpacingSpinBox->value();
+        background.showScaleBar = scaleBarCheckBox->isChecked();
+        background.scaleBarLength = scaleBarLengthSpinBox->value();
+        zoomableView->setCanvasBackground(background);
     }
 
-    m_scene->setSceneRect(0.0, 0.0, static_cast<qreal>(width), static_cast<qreal>(height));
     ui->graphicsView->setSceneRect(m_scene->sceneRect());
     if (ui->label_canvas_size) {
         ui->label_canvas_size->setText(tr("%1 x %2").arg(width).arg(height));
     }
 
-    m_polygons.clear();
-    m_lines.clear();
+    clearPolygons();
+    clearLines();
     m_vertices.clear();
     m_nextLineId = 0;
     m_nextPolygonId = 0;
@@ -2627,8 +3435,8 @@ void MainWindow::on_actionImport_Vertex_Only_triggered()
     }
 
     m_scene->clearSelection();
-    m_polygons.clear();
-    m_lines.clear();
+    clearPolygons();
+    clearLines();
     m_vertices.clear();
     m_nextLineId = 0;
     m_nextPolygonId = 0;
@@ -2639,18 +3447,8 @@ void MainWindow::on_actionImport_Vertex_Only_triggered()
     resetSelectionLabels();
 }
 
-void MainWindow::on_actionExport_Vertex_Line_triggered()
+QJsonObject MainWindow::meshToJson() const
 {
-    if (!m_scene)
-        return;
-
-    const QString fileName = QFileDialog::getSaveFileName(this,
-                                                          tr("Export Vertices, Lines, and Polygons"),
-                                                          QString(),
-                                                          tr("JSON Files (*.json);;All Files (*)"));
-    if (fileName.isEmpty())
-        return;
-
     QJsonArray vertexArray;
     for (const auto &vertex : m_vertices) {
         if (!vertex)
@@ -2714,6 +3512,20 @@ void MainWindow::on_actionExport_Vertex_Line_triggered()
     rootObject.insert(QStringLiteral("vertices"), vertexArray);
     rootObject.insert(QStringLiteral("lines"), lineArray);
     rootObject.insert(QStringLiteral("polygons"), polygonArray);
+    return rootObject;
+}
+
+void MainWindow::on_actionExport_Vertex_Line_triggered()
+{
+    if (!m_scene)
+        return;
+
+    const QString fileName = QFileDialog::getSaveFileName(this,
+                                                          tr("Export Vertices, Lines, and Polygons"),
+                                                          QString(),
+                                                          tr("JSON Files (*.json);;All Files (*)"));
+    if (fileName.isEmpty())
+        return;
 
     QFile file(fileName);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
@@ -2723,7 +3535,7 @@ void MainWindow::on_actionExport_Vertex_Line_triggered()
         return;
     }
 
-    const QJsonDocument document(rootObject);
+    const QJsonDocument document(meshToJson());
     file.write(document.toJson(QJsonDocument::Indented));
     file.close();
 }
@@ -2796,6 +3608,576 @@ void MainWindow::on_actiontest_vertices_lines_polygons_triggered()
     runVerticesLinesPolygonsStressTest();
 }
 
+void MainWindow::on_actionBenchmark_Graphics_Items_triggered()
+{
+    runGraphicsItemBenchmark();
+}
+
+void MainWindow::on_actionGenerate_Voronoi_Tissue_triggered()
+{
+    if (!m_scene)
+        return;
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Generate Voronoi Tissue"));
+
+    auto *layout = new QFormLayout(&dialog);
+    layout->addRow(new QLabel(tr("Fills the canvas with cells and replaces the current vertices, lines, and polygons."),
+                              &dialog));
+
+    auto *cellCountSpinBox = new QSpinBox(&dialog);
+    cellCountSpinBox->setRange(1, 2000000);
+    cellCountSpinBox->setValue(1000);
+    layout->addRow(tr("Cells:"), cellCountSpinBox);
+
+    auto *seedSpinBox = new QSpinBox(&dialog);
+    seedSpinBox->setRange(0, std::numeric_limits<int>::max());
+    seedSpinBox->setValue(1);
+    layout->addRow(tr("Seed:"), seedSpinBox);
+
+    auto *jitterSpinBox = new QDoubleSpinBox(&dialog);
+    jitterSpinBox->setRange(0.0, 1.0);
+    jitterSpinBox->setDecimals(2);
+    jitterSpinBox->setSingleStep(0.05);
+    jitterSpinBox->setValue(0.8);
+    layout->addRow(tr("Jitter (0-1):"), jitterSpinBox);
+
+    auto *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
+                                           Qt::Horizontal,
+                                           &dialog);
+    layout->addRow(buttonBox);
+    QObject::connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    VoronoiTissueOptions options;
+    options.cellCount = cellCountSpinBox->value();
+    options.area = m_scene->sceneRect().isValid() ? m_scene->sceneRect() : QRectF(0.0, 0.0, 512.0, 512.0);
+    options.seed = static_cast<quint32>(seedSpinBox->value());
+    options.jitter = jitterSpinBox->value();
+
+    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer timer;
+    timer.start();
+    const PlanarMesh mesh = generateVoronoiTissue(options);
+    const qint64 generationMs = timer.restart();
+
+    m_scene->clearSelection();
+    clearPolygons();
+    clearLines();
+    m_vertices.clear();
+    m_nextLineId = 0;
+    m_nextPolygonId = 0;
+    loadPlanarMesh(mesh);
+    resetSelectionLabels();
+    QGuiApplication::restoreOverrideCursor();
+
+    qInfo() << "Generated" << mesh.faceCount() << "Voronoi cells in" << generationMs << "ms, loaded in"
+            << timer.elapsed() << "ms";
+    if (statusBar()) {
+        statusBar()->showMessage(tr("Generated %1 cells, %2 lines, and %3 vertices.")
+                                     .arg(mesh.faceCount())
+                                     .arg(mesh.lines.size())
+                                     .arg(mesh.vertices.size()),
+                                 5000);
+    }
+}
+
+void MainWindow::on_actionSkeletonization_triggered()
+{
+    if (!m_scene)
+        return;
+
+    if (m_imageLoader && m_imageLoader->isLoading()) {
+        QMessageBox::warning(this, tr("Skeletonization"), tr("Wait for the image to finish loading."));
+        return;
+    }
+    if (!m_backgroundItem || m_backgroundItem->pixmap().isNull()) {
+        QMessageBox::warning(this, tr("Skeletonization"), tr("Open a cell contour image first."));
+        return;
+    }
+    if (m_backgroundImage.isNull()) {
+        // Only the downscaled preview of a canceled load is shown.
+        QMessageBox::warning(this, tr("Skeletonization"), tr("Load the full image first."));
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Skeletonization"));
+
+    auto *layout = new QFormLayout(&dialog);
+    layout->addRow(new QLabel(tr("Cleans up the contour image and thins the contours to one pixel wide lines."),
+                              &dialog));
+
+    auto *denoisingComboBox = new QComboBox(&dialog);
+    denoisingComboBox->addItem(tr("None"), static_cast<int>(ContourDenoising::None));
+    denoisingComboBox->addItem(tr("Gaussian"), static_cast<int>(ContourDenoising::Gaussian));
+    denoisingComboBox->addItem(tr("Median 3 x 3"), static_cast<int>(ContourDenoising::Median));
+    denoisingComboBox->setCurrentIndex(1);
+    layout->addRow(tr("Denoising:"), denoisingComboBox);
+
+    auto *sigmaSpinBox = new QDoubleSpinBox(&dialog);
+    sigmaSpinBox->setRange(0.3, 20.0);
+    sigmaSpinBox->setDecimals(1);
+    sigmaSpinBox->setSingleStep(0.5);
+    sigmaSpinBox->setValue(1.0);
+    sigmaSpinBox->setSuffix(tr(" px"));
+    layout->addRow(tr("Gaussian sigma:"), sigmaSpinBox);
+
+    auto *thresholdingComboBox = new QComboBox(&dialog);
+    thresholdingComboBox->addItem(tr("Otsu (global)"), static_cast<int>(ContourThresholding::Otsu));
+    thresholdingComboBox->addItem(tr("Adaptive (local mean)"), static_cast<int>(ContourThresholding::Adaptive));
+    layout->addRow(tr("Thresholding:"), thresholdingComboBox);
+
+    auto *windowSpinBox = new QSpinBox(&dialog);
+    windowSpinBox->setRange(1, 500);
+    windowSpinBox->setValue(15);
+    windowSpinBox->setSuffix(tr(" px"));
+    windowSpinBox->setEnabled(false);
+    layout->addRow(tr("Window radius:"), windowSpinBox);
+
+    auto *offsetSpinBox = new QDoubleSpinBox(&dialog);
+    offsetSpinBox->setRange(0.0, 50.0);
+    offsetSpinBox->setDecimals(1);
+    offsetSpinBox->setValue(2.0);
+    offsetSpinBox->setSuffix(tr(" %"));
+    offsetSpinBox->setEnabled(false);
+    layout->addRow(tr("Offset from local mean:"), offsetSpinBox);
+
+    auto *elementComboBox = new QComboBox(&dialog);
+    elementComboBox->addItem(tr("Disk"), static_cast<int>(StructuringElement::Disk));
+    elementComboBox->addItem(tr("Square"), static_cast<int>(StructuringElement::Square));
+    elementComboBox->addItem(tr("Cross"), static_cast<int>(StructuringElement::Cross));
+    layout->addRow(tr("Structuring element:"), elementComboBox);
+
+    auto *openingSpinBox = new QSpinBox(&dialog);
+    openingSpinBox->setRange(0, 50);
+    openingSpinBox->setSuffix(tr(" px"));
+    openingSpinBox->setSpecialValueText(tr("Off"));
+    layout->addRow(tr("Opening radius:"), openingSpinBox);
+
+    auto *closingSpinBox = new QSpinBox(&dialog);
+    closingSpinBox->setRange(0, 50);
+    closingSpinBox->setSuffix(tr(" px"));
+    closingSpinBox->setSpecialValueText(tr("Off"));
+    layout->addRow(tr("Closing radius:"), closingSpinBox);
+
+    QObject::connect(denoisingComboBox, &QComboBox::currentIndexChanged, sigmaSpinBox, [=](int) {
+        sigmaSpinBox->setEnabled(denoisingComboBox->currentData().toInt()
+                                 == static_cast<int>(ContourDenoising::Gaussian));
+    });
+    QObject::connect(thresholdingComboBox, &QComboBox::currentIndexChanged, windowSpinBox, [=](int) {
+        const bool adaptive = thresholdingComboBox->currentData().toInt()
+                              == static_cast<int>(ContourThresholding::Adaptive);
+        windowSpinBox->setEnabled(adaptive);
+        offsetSpinBox->setEnabled(adaptive);
+    });
+
+    auto *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
+                                           Qt::Horizontal,
+                                           &dialog);
+    layout->addRow(buttonBox);
+    QObject::connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    ContourPreprocessOptions options;
+    options.denoising = static_cast<ContourDenoising>(denoisingComboBox->currentData().toInt());
+    options.gaussianSigma = sigmaSpinBox->value();
+    options.thresholding = static_cast<ContourThresholding>(thresholdingComboBox->currentData().toInt());
+    options.adaptiveRadius = windowSpinBox->value();
+    options.adaptiveOffset = offsetSpinBox->value() / 100.0;
+    options.element = static_cast<StructuringElement>(elementComboBox->currentData().toInt());
+    options.openingRadius = openingSpinBox->value();
+    options.closingRadius = closingSpinBox->value();
+
+    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer timer;
+    timer.start();
+    // The loaded image keeps 16-bit depth.
+    const BinaryImage contours = preprocessContourImage(m_backgroundImage, options);
+    const qint64 thresholdMs = timer.restart();
+    setContourMask(contours);
+    BinaryImage skeleton = thinToSkeleton(contours);
+    const qint64 thinningMs = timer.elapsed();
+
+    const qint64 skeletonPixels = skeleton.count();
+    removeSkeletonOverlay();
+    m_skeletonItem = new SkeletonOverlayItem(std::move(skeleton));
+    m_scene->addItem(m_skeletonItem);
+    QGuiApplication::restoreOverrideCursor();
+
+    qInfo() << "Preprocessed" << contours.width() << "x" << contours.height() << "image in" << thresholdMs
+            << "ms, thinned to" << skeletonPixels << "skeleton pixels in" << thinningMs << "ms";
+    if (statusBar()) {
+        statusBar()->showMessage(tr("Skeletonized %1 contour pixels to %2 skeleton pixels in %3 ms.")
+                                     .arg(contours.count())
+                                     .arg(skeletonPixels)
+                                     .arg(thresholdMs + thinningMs),
+                                 5000);
+    }
+}
+
+void MainWindow::on_actionWatershed_Segmentation_triggered()
+{
+    if (!m_scene)
+        return;
+
+    if (m_imageLoader && m_imageLoader->isLoading()) {
+        QMessageBox::warning(this, tr("Watershed Segmentation"), tr("Wait for the image to finish loading."));
+        return;
+    }
+    if (!m_backgroundItem || m_backgroundItem->pixmap().isNull()) {
+        QMessageBox::warning(this, tr("Watershed Segmentation"), tr("Open a cell contour image first."));
+        return;
+    }
+    if (m_backgroundImage.isNull()) {
+        // Only the downscaled preview of a canceled load is shown.
+        QMessageBox::warning(this, tr("Watershed Segmentation"), tr("Load the full image first."));
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Watershed Segmentation"));
+
+    auto *layout = new QFormLayout(&dialog);
+    layout->addRow(new QLabel(tr("Floods the contour image from one marker per cell, for membranes too faint to "
+                                 "skeletonize. The cell boundaries replace the skeleton."),
+                              &dialog));
+
+    enum Seeds { DistanceMaxima, FreeVertices };
+    auto *seedsComboBox = new QComboBox(&dialog);
+    seedsComboBox->addItem(tr("Distance transform maxima"), static_cast<int>(DistanceMaxima));
+    seedsComboBox->addItem(tr("Vertices not on any line"), static_cast<int>(FreeVertices));
+    layout->addRow(tr("Markers:"), seedsComboBox);
+
+    auto *radiusSpinBox = new QDoubleSpinBox(&dialog);
+    radiusSpinBox->setRange(1.0, 1000.0);
+    radiusSpinBox->setDecimals(1);
+    radiusSpinBox->setValue(3.0);
+    radiusSpinBox->setSuffix(tr(" px"));
+    layout->addRow(tr("Minimum cell radius:"), radiusSpinBox);
+    QObject::connect(seedsComboBox, &QComboBox::currentIndexChanged, radiusSpinBox, [=](int) {
+        radiusSpinBox->setEnabled(seedsComboBox->currentData().toInt() == DistanceMaxima);
+    });
+
+    auto *meshCheckBox = new QCheckBox(tr("Replace the vertices, lines, and polygons with the cells"), &dialog);
+    meshCheckBox->setChecked(true);
+    layout->addRow(meshCheckBox);
+
+    auto *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
+                                           Qt::Horizontal,
+                                           &dialog);
+    layout->addRow(buttonBox);
+    QObject::connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<QPoint> markers;
+    if (seedsComboBox->currentData().toInt() == DistanceMaxima) {
+        if (const DistanceTransform *distance = contourDistanceTransform())
+            markers = distanceMaxima(*distance, radiusSpinBox->value());
+    } else {
+        for (const auto &vertex : m_vertices) {
+            if (vertex->connectedLines().empty())
+                markers.emplace_back(static_cast<int>(std::floor(vertex->position().x())),
+                                     static_cast<int>(std::floor(vertex->position().y())));
+        }
+    }
+    const qint64 markerMs = timer.restart();
+
+    if (markers.empty()) {
+        QGuiApplication::restoreOverrideCursor();
+        QMessageBox::warning(this,
+                             tr("Watershed Segmentation"),
+                             seedsComboBox->currentData().toInt() == DistanceMaxima
+                                 ? tr("No cell is wider than the minimum radius.")
+                                 : tr("Place a vertex inside each cell first."));
+        return;
+    }
+
+    const LabelImage labels = watershed(m_backgroundImage, contourMask(), markers);
+    const qint64 floodingMs = timer.restart();
+
+    // The boundaries, thinned, take the place of the skeleton, so Detect
+    // Vertex and Detect Line work on the segmentation as well.
+    BinaryImage skeleton = thinToSkeleton(labels.boundaries());
+    removeSkeletonOverlay();
+    m_skeletonItem = new SkeletonOverlayItem(std::move(skeleton));
+    m_scene->addItem(m_skeletonItem);
+    const qint64 skeletonMs = timer.restart();
+
+    // The cells go into the model the same way an imported label mask does.
+    // Without a mesh the regions are the cells; with one, its polygons.
+    std::size_t cellCount = static_cast<std::size_t>(labels.labelCount());
+    std::vector<int> lostLabels;
+    if (meshCheckBox->isChecked()) {
+        const PlanarMesh mesh = meshFromLabels(labels, 1.0, &lostLabels);
+        m_scene->clearSelection();
+        clearPolygons();
+        clearLines();
+        m_vertices.clear();
+        m_nextLineId = 0;
+        m_nextPolygonId = 0;
+        loadPlanarMesh(mesh);
+        resetSelectionLabels();
+        cellCount = mesh.faceCount();
+    }
+    QGuiApplication::restoreOverrideCursor();
+
+    qInfo() << "Placed" << markers.size() << "watershed markers in" << markerMs << "ms, flooded"
+            << labels.width() << "x" << labels.height() << "image in" << floodingMs << "ms, traced boundaries in"
+            << skeletonMs << "ms, built" << cellCount << "cells in" << timer.elapsed() << "ms";
+    if (statusBar()) {
+        statusBar()->showMessage(tr("Segmented %1 cells in %2 ms.")
+                                     .arg(cellCount)
+                                     .arg(markerMs + floodingMs + skeletonMs + timer.elapsed()),
+                                 5000);
+    }
+
+    if (!lostLabels.empty()) {
+        QMessageBox::warning(this,
+                             tr("Watershed Segmentation"),
+                             tr("%n cell(s) touch themselves at a corner and got no polygon.",
+                                nullptr,
+                                static_cast<int>(lostLabels.size())));
+    }
+}
+
+void MainWindow::on_actionDetect_Vertex_triggered()
+{
+    if (!m_scene)
+        return;
+
+    if (!m_skeletonItem) {
+        QMessageBox::warning(this, tr("Detect Vertex"), tr("Run Process > Skeletonization first."));
+        return;
+    }
+
+    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer timer;
+    timer.start();
+    const std::vector<QPointF> junctions = detectJunctions(m_skeletonItem->image());
+    const qint64 detectionMs = timer.restart();
+
+    // Junctions that already have a vertex are skipped, so detecting again
+    // after manual edits only adds what is missing.
+    std::vector<QPointF> positions;
+    positions.reserve(junctions.size());
+    for (const QPointF &position : junctions) {
+        if (!m_vertexIndex->nearest(position, kVertexSnapRadiusPixels))
+            positions.push_back(position);
+    }
+    createVerticesInBatch(positions);
+    QGuiApplication::restoreOverrideCursor();
+
+    qInfo() << "Detected" << junctions.size() << "junctions in" << detectionMs << "ms, added" << positions.size()
+            << "vertices in" << timer.elapsed() << "ms";
+    if (statusBar()) {
+        statusBar()->showMessage(tr("Detected %1 junctions; added %2 vertices.")
+                                     .arg(junctions.size())
+                                     .arg(positions.size()),
+                                 5000);
+    }
+}
+
+void MainWindow::on_actionDetect_Line_triggered()
+{
+    if (!m_scene)
+        return;
+
+    if (!m_skeletonItem) {
+        QMessageBox::warning(this, tr("Detect Line"), tr("Run Process > Skeletonization first."));
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Detect Line"));
+
+    auto *layout = new QFormLayout(&dialog);
+    layout->addRow(new QLabel(tr("Traces the skeleton between junctions and adds a line for each membrane segment."),
+                              &dialog));
+
+    auto *spurLengthSpinBox = new QDoubleSpinBox(&dialog);
+    spurLengthSpinBox->setRange(0.0, 10000.0);
+    spurLengthSpinBox->setDecimals(1);
+    spurLengthSpinBox->setValue(10.0);
+    spurLengthSpinBox->setSuffix(tr(" px"));
+    layout->addRow(tr("Prune dead ends shorter than:"), spurLengthSpinBox);
+
+    auto *followCurvesCheckBox = new QCheckBox(tr("Follow curved segments with extra vertices"), &dialog);
+    layout->addRow(followCurvesCheckBox);
+
+    auto *toleranceSpinBox = new QDoubleSpinBox(&dialog);
+    toleranceSpinBox->setRange(0.1, 100.0);
+    toleranceSpinBox->setDecimals(1);
+    toleranceSpinBox->setValue(2.0);
+    toleranceSpinBox->setSuffix(tr(" px"));
+    toleranceSpinBox->setEnabled(false);
+    layout->addRow(tr("Curve tolerance:"), toleranceSpinBox);
+    QObject::connect(followCurvesCheckBox, &QCheckBox::toggled, toleranceSpinBox, &QWidget::setEnabled);
+
+    auto *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
+                                           Qt::Horizontal,
+                                           &dialog);
+    layout->addRow(buttonBox);
+    QObject::connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    QObject::connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted)
+        return;
+
+    SkeletonTraceOptions options;
+    options.minimumSpurLength = spurLengthSpinBox->value();
+    options.polylines = followCurvesCheckBox->isChecked();
+    const qreal tolerance = toleranceSpinBox->value();
+
+    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer timer;
+    timer.start();
+    const SkeletonGraph graph = traceSkeleton(m_skeletonItem->image(), options);
+    const qint64 tracingMs = timer.restart();
+
+    // Points are the graph nodes followed by the inner points of the
+    // simplified polylines; each segment joins two of them.
+    std::vector<QPointF> points = graph.nodes;
+    std::vector<std::pair<std::size_t, std::size_t>> segments;
+    for (const SkeletonBranch &branch : graph.branches) {
+        auto previous = static_cast<std::size_t>(branch.start);
+        if (options.polylines) {
+            const std::vector<QPointF> simplified = simplifyPolyline(branch.polyline, tolerance);
+            for (std::size_t i = 1; i + 1 < simplified.size(); ++i) {
+                segments.emplace_back(previous, points.size());
+                previous = points.size();
+                points.push_back(simplified[i]);
+            }
+        }
+        segments.emplace_back(previous, static_cast<std::size_t>(branch.end));
+    }
+
+    // Nodes reuse the vertex already there (e.g. from Detect Vertex); all
+    // other points become new vertices in one batch.
+    std::vector<Vertex *> pointVertices(points.size(), nullptr);
+    std::vector<QPointF> newPositions;
+    std::vector<std::size_t> newPoints;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        if (i < graph.nodes.size())
+            pointVertices[i] = m_vertexIndex->nearest(points[i], kVertexSnapRadiusPixels);
+        if (!pointVertices[i]) {
+            newPoints.push_back(i);
+            newPositions.push_back(points[i]);
+        }
+    }
+    const std::vector<Vertex *> newVertices = createVerticesInBatch(newPositions);
+    for (std::size_t i = 0; i < newPoints.size(); ++i)
+        pointVertices[newPoints[i]] = newVertices[i];
+
+    // Segments that collapse onto one vertex or repeat a line are dropped.
+    std::vector<std::pair<Vertex *, Vertex *>> endpoints;
+    std::set<std::pair<Vertex *, Vertex *>> addedLines;
+    for (const auto &[first, second] : segments) {
+        Vertex *start = pointVertices[first];
+        Vertex *end = pointVertices[second];
+        if (start == end || !addedLines.insert(std::minmax(start, end)).second)
+            continue;
+        const std::vector<Line *> &existingLines = start->connectedLines();
+        if (std::any_of(existingLines.begin(), existingLines.end(), [end](const Line *line) {
+                return line->involvesVertex(end);
+            })) {
+            continue;
+        }
+        endpoints.emplace_back(start, end);
+    }
+    createLinesInBatch(endpoints);
+    QGuiApplication::restoreOverrideCursor();
+
+    qInfo() << "Traced" << graph.branches.size() << "skeleton branches in" << tracingMs << "ms, added"
+            << endpoints.size() << "lines and" << newVertices.size() << "vertices in" << timer.elapsed() << "ms";
+    if (statusBar()) {
+        statusBar()->showMessage(tr("Traced %1 segments; added %2 lines and %3 vertices.")
+                                     .arg(graph.branches.size())
+                                     .arg(endpoints.size())
+                                     .arg(newVertices.size()),
+                                 5000);
+    }
+}
+
+void MainWindow::on_actionDetect_Polygon_triggered()
+{
+    if (!m_scene)
+        return;
+
+    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer timer;
+    timer.start();
+
+    PlanarMesh mesh;
+    std::vector<Vertex *> vertices;
+    std::vector<Line *> lines;
+    std::unordered_map<const Vertex *, int> vertexIndices;
+    vertices.reserve(m_vertices.size());
+    mesh.vertices.reserve(m_vertices.size());
+    vertexIndices.reserve(m_vertices.size());
+    for (const auto &vertex : m_vertices) {
+        vertexIndices.emplace(vertex.get(), static_cast<int>(vertices.size()));
+        vertices.push_back(vertex.get());
+        mesh.vertices.push_back(vertex->position());
+    }
+    lines.reserve(m_lines.size());
+    mesh.lines.reserve(m_lines.size());
+    for (const auto &line : m_lines) {
+        lines.push_back(line.get());
+        mesh.lines.emplace_back(vertexIndices.at(line->startVertex()), vertexIndices.at(line->endVertex()));
+    }
+
+    extractFaces(mesh);
+    const qint64 extractionMs = timer.restart();
+
+    // Faces that already have a polygon are kept as they are.
+    PlanarMesh newFaces;
+    for (std::size_t face = 0; face < mesh.faceCount(); ++face) {
+        const auto begin = mesh.faceLines.begin() + mesh.faceOffsets[face];
+        const auto end = mesh.faceLines.begin() + mesh.faceOffsets[face + 1];
+        const auto faceSize = static_cast<std::size_t>(end - begin);
+        const std::vector<Polygon *> &candidates = lines[static_cast<std::size_t>(*begin)]->connectedPolygons();
+        const bool exists = std::any_of(candidates.begin(), candidates.end(), [&](const Polygon *polygon) {
+            const std::vector<Line *> &polygonLines = polygon->lines();
+            return polygonLines.size() == faceSize && std::all_of(begin, end, [&](int line) {
+                return std::find(polygonLines.begin(), polygonLines.end(), lines[static_cast<std::size_t>(line)])
+                       != polygonLines.end();
+            });
+        });
+        if (exists)
+            continue;
+
+        newFaces.faceVertices.insert(newFaces.faceVertices.end(),
+                                     mesh.faceVertices.begin() + mesh.faceOffsets[face],
+                                     mesh.faceVertices.begin() + mesh.faceOffsets[face + 1]);
+        newFaces.faceLines.insert(newFaces.faceLines.end(), begin, end);
+        newFaces.faceOffsets.push_back(static_cast<int>(newFaces.faceVertices.size()));
+    }
+    createPolygonsInBatch(newFaces, vertices, lines);
+    QGuiApplication::restoreOverrideCursor();
+
+    qInfo() << "Extracted" << mesh.faceCount() << "faces in" << extractionMs << "ms, added" << newFaces.faceCount()
+            << "polygons in" << timer.elapsed() << "ms";
+    if (statusBar()) {
+        statusBar()->showMessage(tr("Found %1 cells; added %2 polygons.")
+                                     .arg(mesh.faceCount())
+                                     .arg(newFaces.faceCount()),
+                                 5000);
+    }
+}
+
 void MainWindow::on_actionImport_Vertex_Line_triggered()
 {
     const QString fileName = QFileDialog::getOpenFileName(this,
@@ -2828,16 +4210,106 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
         return;
     }
 
-    const QJsonObject rootObject = document.object();
+    QString errorString;
+    if (!loadMeshFromJson(document.object(), &errorString)) {
+        QMessageBox::warning(this, tr("Import Vertices, Lines, and Polygons"), errorString);
+        return;
+    }
+}
+
+void MainWindow::on_actionImport_Label_Mask_triggered()
+{
+    if (!m_scene)
+        return;
+
+    const QString fileName = QFileDialog::getOpenFileName(this,
+                                                          tr("Import Label Mask"),
+                                                          QString(),
+                                                          tr("Label Images (*.tif *.tiff *.png);;All Files (*)"));
+    if (fileName.isEmpty())
+        return;
+
+    QImage image;
+    if (!image.load(fileName)) {
+        QMessageBox::warning(this,
+                             tr("Import Label Mask"),
+                             tr("Failed to load image: %1").arg(QDir::toNativeSeparators(fileName)));
+        return;
+    }
+
+    bool ok = false;
+    const double tolerance = QInputDialog::getDouble(this,
+                                                     tr("Import Label Mask"),
+                                                     tr("Simplify cell boundaries to within (pixels):"),
+                                                     1.0,
+                                                     0.0,
+                                                     100.0,
+                                                     1,
+                                                     &ok);
+    if (!ok)
+        return;
+
+    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+    QElapsedTimer timer;
+    timer.start();
+    const LabelImage labels = LabelImage::fromImage(image);
+    std::vector<int> lostLabels;
+    const PlanarMesh mesh = meshFromLabels(labels, tolerance, &lostLabels);
+    const qint64 tracingMs = timer.restart();
+
+    // Without a background image the canvas takes the size of the mask, so
+    // the cells land where they are in the image.
+    if (!m_backgroundItem && m_scene->sceneRect() != QRectF(image.rect())) {
+        m_scene->setSceneRect(image.rect());
+        ui->graphicsView->setSceneRect(m_scene->sceneRect());
+        if (ui->label_canvas_size)
+            ui->label_canvas_size->setText(tr("%1 x %2").arg(image.width()).arg(image.height()));
+    }
+
+    m_scene->clearSelection();
+    clearPolygons();
+    clearLines();
+    m_vertices.clear();
+    m_nextLineId = 0;
+    m_nextPolygonId = 0;
+    loadPlanarMesh(mesh);
+    resetSelectionLabels();
+    QGuiApplication::restoreOverrideCursor();
+
+    qInfo() << "Traced" << labels.labelCount() << "labels of" << labels.width() << "x" << labels.height()
+            << "mask into" << mesh.faceCount() << "cells in" << tracingMs << "ms, loaded in" << timer.elapsed()
+            << "ms";
+    if (statusBar()) {
+        statusBar()->showMessage(tr("Imported %1 cells, %2 lines, and %3 vertices.")
+                                     .arg(mesh.faceCount())
+                                     .arg(mesh.lines.size())
+                                     .arg(mesh.vertices.size()),
+                                 5000);
+    }
+
+    if (!lostLabels.empty()) {
+        QStringList labelList;
+        for (const int label : lostLabels)
+            labelList << QString::number(label);
+        QMessageBox::warning(this,
+                             tr("Import Label Mask"),
+                             tr("%n label(s) produced no cell, for example because the region touches "
+                                "itself at a corner: %1",
+                                nullptr,
+                                static_cast<int>(lostLabels.size()))
+                                 .arg(labelList.join(QStringLiteral(", "))));
+    }
+}
+
+bool MainWindow::loadMeshFromJson(const QJsonObject &rootObject, QString *errorString)
+{
     const QJsonValue verticesValue = rootObject.value(QStringLiteral("vertices"));
     const QJsonValue linesValue = rootObject.value(QStringLiteral("lines"));
     const QJsonValue polygonsValue = rootObject.value(QStringLiteral("polygons"));
 
     if (!verticesValue.isArray() || !linesValue.isArray() || !polygonsValue.isArray()) {
-        QMessageBox::warning(this,
-                              tr("Import Vertices, Lines, and Polygons"),
-                              tr("The JSON file must contain 'vertices', 'lines', and 'polygons' arrays."));
-        return;
+        *errorString = tr("The JSON file must contain 'vertices', 'lines', and 'polygons' arrays.");
+        return false;
     }
 
     const QJsonArray verticesArray = verticesValue.toArray();
@@ -2865,10 +4337,8 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
 
     for (const QJsonValue &value : verticesArray) {
         if (!value.isObject()) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Each vertex entry must be a JSON object."));
-            return;
+            *errorString = tr("Each vertex entry must be a JSON object.");
+            return false;
         }
 
         const QJsonObject vertexObject = value.toObject();
@@ -2877,18 +4347,14 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
         const QJsonValue yValue = vertexObject.value(QStringLiteral("y"));
 
         if (!idValue.isDouble() || !xValue.isDouble() || !yValue.isDouble()) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Vertex entries must contain numeric 'id', 'x', and 'y' fields."));
-            return;
+            *errorString = tr("Vertex entries must contain numeric 'id', 'x', and 'y' fields.");
+            return false;
         }
 
         const int id = idValue.toInt();
         if (!vertexIds.insert(id).second) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Duplicate vertex id %1 detected.").arg(id));
-            return;
+            *errorString = tr("Duplicate vertex id %1 detected.").arg(id);
+            return false;
         }
 
         const qreal x = xValue.toDouble();
@@ -2903,10 +4369,8 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
 
     for (const QJsonValue &value : linesArray) {
         if (!value.isObject()) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Each line entry must be a JSON object."));
-            return;
+            *errorString = tr("Each line entry must be a JSON object.");
+            return false;
         }
 
         const QJsonObject lineObject = value.toObject();
@@ -2915,10 +4379,8 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
         const QJsonValue endValue = lineObject.value(QStringLiteral("endVertexId"));
 
         if (!idValue.isDouble() || !startValue.isDouble() || !endValue.isDouble()) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Line entries must contain numeric 'id', 'startVertexId', and 'endVertexId' fields."));
-            return;
+            *errorString = tr("Line entries must contain numeric 'id', 'startVertexId', and 'endVertexId' fields.");
+            return false;
         }
 
         const int id = idValue.toInt();
@@ -2926,24 +4388,18 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
         const int endId = endValue.toInt();
 
         if (!lineIds.insert(id).second) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Duplicate line id %1 detected.").arg(id));
-            return;
+            *errorString = tr("Duplicate line id %1 detected.").arg(id);
+            return false;
         }
 
         if (startId == endId) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Line %1 references the same vertex for both ends.").arg(id));
-            return;
+            *errorString = tr("Line %1 references the same vertex for both ends.").arg(id);
+            return false;
         }
 
         if (!vertexIds.count(startId) || !vertexIds.count(endId)) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Line %1 references undefined vertices.").arg(id));
-            return;
+            *errorString = tr("Line %1 references undefined vertices.").arg(id);
+            return false;
         }
 
         importedLines.push_back({id, startId, endId});
@@ -2957,10 +4413,8 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
 
     for (const QJsonValue &value : polygonsArray) {
         if (!value.isObject()) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Each polygon entry must be a JSON object."));
-            return;
+            *errorString = tr("Each polygon entry must be a JSON object.");
+            return false;
         }
 
         const QJsonObject polygonObject = value.toObject();
@@ -2969,53 +4423,41 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
         const QJsonValue lineIdsValue = polygonObject.value(QStringLiteral("lineIds"));
 
         if (!idValue.isDouble() || !vertexIdsValue.isArray() || !lineIdsValue.isArray()) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Polygon entries must contain numeric 'id' and arrays of 'vertexIds' and 'lineIds'."));
-            return;
+            *errorString = tr("Polygon entries must contain numeric 'id' and arrays of 'vertexIds' and 'lineIds'.");
+            return false;
         }
 
         const int id = idValue.toInt();
         if (!polygonIds.insert(id).second) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Duplicate polygon id %1 detected.").arg(id));
-            return;
+            *errorString = tr("Duplicate polygon id %1 detected.").arg(id);
+            return false;
         }
 
         const QJsonArray polygonVertexIdsArray = vertexIdsValue.toArray();
         const QJsonArray polygonLineIdsArray = lineIdsValue.toArray();
 
         if (polygonVertexIdsArray.size() < 3 || polygonLineIdsArray.size() < 3) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Polygon %1 must reference at least three vertices and three lines.").arg(id));
-            return;
+            *errorString = tr("Polygon %1 must reference at least three vertices and three lines.").arg(id);
+            return false;
         }
 
         if (polygonVertexIdsArray.size() != polygonLineIdsArray.size()) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Polygon %1 must have matching counts of vertices and lines.").arg(id));
-            return;
+            *errorString = tr("Polygon %1 must have matching counts of vertices and lines.").arg(id);
+            return false;
         }
 
         std::vector<int> polygonVertexIds;
         polygonVertexIds.reserve(polygonVertexIdsArray.size());
         for (const QJsonValue &vertexIdValue : polygonVertexIdsArray) {
             if (!vertexIdValue.isDouble()) {
-                QMessageBox::warning(this,
-                                      tr("Import Vertices, Lines, and Polygons"),
-                                      tr("Polygon %1 contains a non-numeric vertex id.").arg(id));
-                return;
+                *errorString = tr("Polygon %1 contains a non-numeric vertex id.").arg(id);
+                return false;
             }
 
             const int vertexId = vertexIdValue.toInt();
             if (!vertexIds.count(vertexId)) {
-                QMessageBox::warning(this,
-                                      tr("Import Vertices, Lines, and Polygons"),
-                                      tr("Polygon %1 references undefined vertex %2.").arg(id).arg(vertexId));
-                return;
+                *errorString = tr("Polygon %1 references undefined vertex %2.").arg(id).arg(vertexId);
+                return false;
             }
 
             polygonVertexIds.push_back(vertexId);
@@ -3025,18 +4467,14 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
         polygonLineIds.reserve(polygonLineIdsArray.size());
         for (const QJsonValue &lineIdValue : polygonLineIdsArray) {
             if (!lineIdValue.isDouble()) {
-                QMessageBox::warning(this,
-                                      tr("Import Vertices, Lines, and Polygons"),
-                                      tr("Polygon %1 contains a non-numeric line id.").arg(id));
-                return;
+                *errorString = tr("Polygon %1 contains a non-numeric line id.").arg(id);
+                return false;
             }
 
             const int lineId = lineIdValue.toInt();
             if (!lineIds.count(lineId)) {
-                QMessageBox::warning(this,
-                                      tr("Import Vertices, Lines, and Polygons"),
-                                      tr("Polygon %1 references undefined line %2.").arg(id).arg(lineId));
-                return;
+                *errorString = tr("Polygon %1 references undefined line %2.").arg(id).arg(lineId);
+                return false;
             }
 
             polygonLineIds.push_back(lineId);
@@ -3046,9 +4484,11 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
         maxPolygonId = std::max(maxPolygonId, id);
     }
 
+    QStringList problems;
+
     m_scene->clearSelection();
-    m_polygons.clear();
-    m_lines.clear();
+    clearPolygons();
+    clearLines();
     m_vertices.clear();
     m_nextLineId = 0;
     m_nextPolygonId = 0;
@@ -3060,9 +4500,7 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
         Vertex *startVertex = findVertexById(lineData.startId);
         Vertex *endVertex = findVertexById(lineData.endId);
         if (!createLineWithId(lineData.id, startVertex, endVertex)) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Failed to create line %1.").arg(lineData.id));
+            problems << tr("Failed to create line %1.").arg(lineData.id);
             break;
         }
     }
@@ -3073,9 +4511,7 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
         for (int vertexId : polygonData.vertexIds) {
             Vertex *vertex = findVertexById(vertexId);
             if (!vertex) {
-                QMessageBox::warning(this,
-                                      tr("Import Vertices, Lines, and Polygons"),
-                                      tr("Failed to find vertex %1 for polygon %2.").arg(vertexId).arg(polygonData.id));
+                problems << tr("Failed to find vertex %1 for polygon %2.").arg(vertexId).arg(polygonData.id);
                 polygonVertices.clear();
                 break;
             }
@@ -3090,9 +4526,7 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
         for (int lineId : polygonData.lineIds) {
             Line *line = findLineById(lineId);
             if (!line) {
-                QMessageBox::warning(this,
-                                      tr("Import Vertices, Lines, and Polygons"),
-                                      tr("Failed to find line %1 for polygon %2.").arg(lineId).arg(polygonData.id));
+                problems << tr("Failed to find line %1 for polygon %2.").arg(lineId).arg(polygonData.id);
                 polygonLines.clear();
                 break;
             }
@@ -3103,13 +4537,152 @@ void MainWindow::on_actionImport_Vertex_Line_triggered()
             continue;
 
         if (!createPolygonWithId(polygonData.id, polygonVertices, polygonLines)) {
-            QMessageBox::warning(this,
-                                  tr("Import Vertices, Lines, and Polygons"),
-                                  tr("Failed to create polygon %1.").arg(polygonData.id));
+            problems << tr("Failed to create polygon %1.").arg(polygonData.id);
         }
     }
 
     m_nextLineId = maxLineId >= 0 ? maxLineId + 1 : 0;
     m_nextPolygonId = maxPolygonId >= 0 ? maxPolygonId + 1 : 0;
     resetSelectionLabels();
+
+    if (!problems.isEmpty()) {
+        *errorString = problems.join(QLatin1Char('\n'));
+        return false;
+    }
+    return true;
+}
+
+void MainWindow::on_actionTiled_Overlay_Rendering_toggled(bool checked)
+{
+    auto *zoomableView = qobject_cast<ZoomableGraphicsView *>(ui->graphicsView);
+    if (!zoomableView)
+        return;
+
+    zoomableView->setTiledOverlayRenderingEnabled(checked);
+
+    if (statusBar()) {
+        statusBar()->showMessage(checked ? tr("Overlay is rendered in background tiles.")
+                                         : tr("Overlay is rendered directly."),
+                                 3000);
+    }
+}
+
+void MainWindow::on_actionPrevent_Line_Crossings_toggled(bool checked)
+{
+    if (m_crossingGuard)
+        m_crossingGuard->setEnabled(checked);
+
+    if (statusBar()) {
+        statusBar()->showMessage(checked ? tr("Dragged vertices stop before their lines cross other lines.")
+                                         : tr("Dragged vertices move freely."),
+                                 3000);
+    }
+}
+
+void MainWindow::on_actionFind_Line_Crossings_triggered()
+{
+    if (m_lines.size() < 2) {
+        QMessageBox::information(this,
+                                 tr("Find Line Crossings"),
+                                 tr("At least two lines are needed to look for crossings."));
+        return;
+    }
+
+    // The worker only sees this snapshot, so the mesh can keep being edited
+    // while the check runs; results are matched back by line ID.
+    std::vector<CrossingSegment> segments;
+    segments.reserve(m_lines.size());
+    for (const auto &line : m_lines) {
+        if (!line || !line->startVertex() || !line->endVertex())
+            continue;
+
+        segments.push_back(CrossingSegment{line->id(),
+                                           line->startVertex()->id(),
+                                           line->endVertex()->id(),
+                                           QLineF(line->startVertex()->position(), line->endVertex()->position())});
+    }
+
+    m_crossingDetector->detect(std::move(segments));
+    m_cancelCrossingCheckButton->setVisible(true);
+
+    if (statusBar())
+        statusBar()->showMessage(tr("Checking %1 lines for crossings...").arg(m_lines.size()));
+}
+
+void MainWindow::cancelLineCrossingCheck()
+{
+    if (!m_crossingDetector || !m_crossingDetector->isRunning())
+        return;
+
+    m_crossingDetector->cancel();
+    if (statusBar())
+        statusBar()->showMessage(tr("Line crossing check canceled."), 5000);
+}
+
+void MainWindow::handleLineCrossingsProgress(int percent)
+{
+    if (statusBar())
+        statusBar()->showMessage(tr("Checking lines for crossings... %1%").arg(percent));
+}
+
+void MainWindow::handleLineCrossingsFound(const std::vector<LineCrossing> &crossings)
+{
+    qInfo().noquote() << QStringLiteral("Line crossing check found %1 crossing pair(s).").arg(crossings.size());
+
+    if (crossings.empty()) {
+        if (statusBar())
+            statusBar()->showMessage(tr("No crossing lines found."), 5000);
+        return;
+    }
+
+    std::unordered_map<int, Line *> linesById;
+    linesById.reserve(m_lines.size());
+    for (const auto &line : m_lines) {
+        if (line)
+            linesById.emplace(line->id(), line.get());
+    }
+
+    QStringList pairs;
+    std::vector<Line *> crossingLines;
+    crossingLines.reserve(crossings.size() * 2);
+    for (const LineCrossing &crossing : crossings) {
+        const auto first = linesById.find(crossing.firstLineId);
+        const auto second = linesById.find(crossing.secondLineId);
+        if (first == linesById.end() || second == linesById.end())
+            continue; // Deleted while the check was running.
+
+        crossingLines.push_back(first->second);
+        crossingLines.push_back(second->second);
+        pairs << QStringLiteral("%1 x %2").arg(crossing.firstLineId).arg(crossing.secondLineId);
+    }
+
+    qInfo().noquote() << QStringLiteral("Crossing line pairs: %1").arg(pairs.join(QStringLiteral(", ")));
+
+    if (m_scene && !crossingLines.empty()) {
+        // One selectionChanged for the whole batch instead of one per line.
+        {
+            const QSignalBlocker blocker(m_scene);
+            m_scene->clearSelection();
+            for (Line *line : crossingLines) {
+                if (QGraphicsItem *item = line->graphicsItem())
+                    item->setSelected(true);
+            }
+        }
+        onSceneSelectionChanged();
+
+        if (ui->graphicsView && crossingLines.front()->graphicsItem())
+            ui->graphicsView->centerOn(crossingLines.front()->graphicsItem());
+    }
+
+    if (statusBar())
+        statusBar()->showMessage(tr("Found %1 crossing line pair(s); the lines are selected.").arg(pairs.size()), 5000);
+
+    constexpr int kListedPairs = 20;
+    QString details = pairs.mid(0, kListedPairs).join(QStringLiteral("\n"));
+    if (pairs.size() > kListedPairs)
+        details += tr("\n... and %1 more (see the log).").arg(pairs.size() - kListedPairs);
+
+    QMessageBox::warning(this,
+                         tr("Find Line Crossings"),
+                         tr("Found %1 crossing line pair(s) (line IDs):\n%2").arg(pairs.size()).arg(details));
 }
@@ -1,12 +1,18 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "binaryimage.h"
+
 #include <QGraphicsItem>
+#include <QImage>
+#include <QJsonObject>
 #include <QList>
 #include <QMainWindow>
 #include <QPointF>
 #include <QRectF>
 #include <memory>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 class QGraphicsScene;
@@ -16,6 +22,23 @@ class Line;
 class Polygon;
 class QGraphicsPixmapItem;
 class QGraphicsItem;
+class QPixmap;
+class QSizeF;
+class QProgressBar;
+class QToolButton;
+class ImageLoader;
+class VertexSpatialIndex;
+class LineSpatialIndex;
+class PolygonSpatialIndex;
+class CrossingGuard;
+class CrossingDetector;
+class MeshValidator;
+class HalfEdgeMesh;
+class DistanceTransform;
+class SkeletonOverlayItem;
+struct LineCrossing;
+struct PlanarMesh;
+struct StressBenchmarkOptions;
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -31,6 +54,8 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    QJsonObject runStressBenchmark(const StressBenchmarkOptions &options);
+
 private slots:
     void on_actionDelete_Image_triggered();
     void on_actionAdd_Vertex_triggered();
@@ -51,9 +76,20 @@ private slots:
     void on_actionImport_Vertex_Only_triggered();
     void on_actionExport_Vertex_Line_triggered();
     void on_actionImport_Vertex_Line_triggered();
+    void on_actionImport_Label_Mask_triggered();
     void on_actionSnapShot_All_triggered();
     void on_actionSnapShot_View_triggered();
     void on_actiontest_vertices_lines_polygons_triggered();
+    void on_actionBenchmark_Graphics_Items_triggered();
+    void on_actionGenerate_Voronoi_Tissue_triggered();
+    void on_actionSkeletonization_triggered();
+    void on_actionWatershed_Segmentation_triggered();
+    void on_actionDetect_Vertex_triggered();
+    void on_actionDetect_Line_triggered();
+    void on_actionDetect_Polygon_triggered();
+    void on_actionTiled_Overlay_Rendering_toggled(bool checked);
+    void on_actionPrevent_Line_Crossings_toggled(bool checked);
+    void on_actionFind_Line_Crossings_triggered();
     void onSceneSelectionChanged();
     void onSceneChanged(const QList<QRectF> &region);
     void handleAddVertexFromContextMenu(const QPointF &scenePosition);
@@ -67,8 +103,19 @@ private slots:
     void handleDeleteSelectedPolygonsFromContextMenu(const QList<QGraphicsItem *> &polygonItems);
     void handleCreatePolygonFromContextMenu(const QList<QGraphicsItem *> &vertexItems);
     void handleDeleteSelectedItemsFromContextMenu(const QList<QGraphicsItem *> &items);
+    void handleBackgroundPreviewReady(const QImage &preview);
+    void handleBackgroundImageReady(const QImage &image);
+    void handleBackgroundImageLoadFailed(const QString &errorString);
+    void handleBackgroundImageLoadProgress(int percent);
+    void cancelBackgroundImageLoad();
+    void cancelLineCrossingCheck();
+    void handleLineCrossingsProgress(int percent);
+    void handleLineCrossingsFound(const std::vector<LineCrossing> &crossings);
 
 private:
+    // The microbenchmarks in benchmarks/ drive the model directly.
+    friend class MainWindowBenchmark;
+
     Vertex *createVertex(const QPointF &position);
     Vertex *createVertexWithId(int id, const QPointF &position);
     void deleteVertex(Vertex *vertex);
@@ -76,11 +123,15 @@ private:
     void sortVerticesById();
     Vertex *findVertexByGraphicsItem(const QGraphicsItem *item) const;
     Vertex *findVertexById(int id) const;
-    int nextAvailableLineId() const;
-    int nextAvailablePolygonId() const;
     Line *createLine(Vertex *startVertex, Vertex *endVertex);
     Line *createLineWithId(int id, Vertex *startVertex, Vertex *endVertex);
     void deleteLine(Line *line);
+    // Creates the cells a newly added line closes off, splitting the cell it
+    // crosses if there is one. Only the faces on either side are walked.
+    std::vector<Polygon *> closeCellsAroundLine(Line *line);
+    // Deletes the line and, if it separated two cells, replaces them with one.
+    // Cells that would not merge into a single ring go with the line.
+    Polygon *deleteLineMergingCells(Line *line);
     Line *findLineByGraphicsItem(const QGraphicsItem *item) const;
     Line *findLineById(int id) const;
     Line *findLineByVertices(Vertex *startVertex, Vertex *endVertex) const;
@@ -90,23 +141,68 @@ private:
     void updateSelectionLabels(Vertex *vertex);
     void updateSelectionLabels(Line *line);
     void updateSelectionLabels(Polygon *polygon);
+    void removeBackgroundItem();
+    void setContourMask(BinaryImage mask);
+    const BinaryImage &contourMask();
+    const DistanceTransform *contourDistanceTransform();
+    void removeSkeletonOverlay();
+    void setBackgroundPixmap(const QPixmap &pixmap, const QSizeF &sceneSize);
+    void setImageLoadInProgress(bool inProgress);
 
     Ui::MainWindow *ui;
     QGraphicsScene *m_scene = nullptr;
+    std::unique_ptr<VertexSpatialIndex> m_vertexIndex;
+    std::unique_ptr<LineSpatialIndex> m_lineIndex;
+    std::unique_ptr<PolygonSpatialIndex> m_polygonIndex;
+    std::unique_ptr<CrossingGuard> m_crossingGuard;
+    std::unique_ptr<MeshValidator> m_meshValidator;
+    std::unique_ptr<HalfEdgeMesh> m_halfEdgeMesh;
     std::vector<std::unique_ptr<Vertex>> m_vertices;
     std::vector<std::unique_ptr<Line>> m_lines;
     std::vector<std::unique_ptr<Polygon>> m_polygons;
+    // Where each line and polygon sits in m_lines and m_polygons, and the
+    // polygons by id, so that deleting one swaps the last into its slot.
+    std::unordered_map<const Line *, std::size_t> m_lineSlots;
+    std::unordered_map<const Polygon *, std::size_t> m_polygonSlots;
+    std::unordered_map<int, Polygon *> m_polygonsById;
     QGraphicsPixmapItem *m_backgroundItem = nullptr;
+    // The loaded image at its own depth, which the pixmap may not keep.
+    QImage m_backgroundImage;
+    // Contour mask of the loaded image, from the last skeletonization, and
+    // its distance transform once something has asked for it.
+    BinaryImage m_contourMask;
+    std::unique_ptr<DistanceTransform> m_contourDistance;
+    SkeletonOverlayItem *m_skeletonItem = nullptr;
+    ImageLoader *m_imageLoader = nullptr;
+    QProgressBar *m_imageLoadProgressBar = nullptr;
+    QToolButton *m_cancelImageLoadButton = nullptr;
+    QToolButton *m_cancelCrossingCheckButton = nullptr;
+    QString m_loadingImagePath;
+    CrossingDetector *m_crossingDetector = nullptr;
     int m_nextLineId = 0;
     int m_nextPolygonId = 0;
 
     Polygon *createPolygon(const std::vector<Vertex *> &vertices, const std::vector<Line *> &lines);
     void deletePolygon(Polygon *polygon);
+    void storeLine(std::unique_ptr<Line> line);
+    void storePolygon(std::unique_ptr<Polygon> polygon);
+    void clearLines();
+    void clearPolygons();
     Polygon *findPolygonByGraphicsItem(const QGraphicsItem *item) const;
     bool orderLinesIntoPolygon(const std::vector<Line *> &inputLines,
                                std::vector<Line *> &orderedLines,
                                std::vector<Vertex *> &orderedVertices) const;
     void runVerticesLinesPolygonsStressTest();
+    void runGraphicsItemBenchmark();
+    void buildBenchmarkGridMesh(int cellCount, const QRectF &area);
+    std::vector<Vertex *> createVerticesInBatch(const std::vector<QPointF> &positions);
+    std::vector<Line *> createLinesInBatch(const std::vector<std::pair<Vertex *, Vertex *>> &endpoints);
+    std::vector<Polygon *> createPolygonsInBatch(const PlanarMesh &mesh,
+                                                 const std::vector<Vertex *> &vertices,
+                                                 const std::vector<Line *> &lines);
+    void loadPlanarMesh(const PlanarMesh &mesh);
+    QJsonObject meshToJson() const;
+    bool loadMeshFromJson(const QJsonObject &rootObject, QString *errorString);
     bool validateRelationships() const;
     bool containsVertex(const Vertex *vertex) const;
     bool containsLine(const Line *line) const;
@@ -0,0 +1,163 @@
+#include "meshgeometry.h"
+
+#include "vertex.h"
+
+#include <QLineF>
+#include <QPointF>
+
+#include <algorithm>
+#include <cmath>
+
+qreal signedArea(const std::vector<Vertex *> &vertices)
+{
+    if (vertices.size() < 3)
+        return 0.0;
+
+    qreal area = 0.0;
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        const Vertex *current = vertices[i];
+        const Vertex *next = vertices[(i + 1) % vertices.size()];
+        if (!current || !next)
+            continue;
+
+        const QPointF currentPos = current->position();
+        const QPointF nextPos = next->position();
+        area += (currentPos.x() * nextPos.y()) - (nextPos.x() * currentPos.y());
+    }
+
+    return area * 0.5;
+}
+
+void ensureCounterClockwise(std::vector<Vertex *> &vertices, std::vector<Line *> &lines)
+{
+    if (vertices.size() < 3 || lines.size() != vertices.size())
+        return;
+
+    if (signedArea(vertices) < 0) {
+        std::vector<Vertex *> reversedVertices;
+        reversedVertices.reserve(vertices.size());
+        reversedVertices.push_back(vertices.front());
+        for (std::size_t i = vertices.size(); i-- > 1;)
+            reversedVertices.push_back(vertices[i]);
+
+        std::vector<Line *> reversedLines;
+        reversedLines.reserve(lines.size());
+        for (auto it = lines.rbegin(); it != lines.rend(); ++it)
+            reversedLines.push_back(*it);
+
+        vertices = std::move(reversedVertices);
+        lines = std::move(reversedLines);
+    }
+}
+
+std::vector<Vertex *> sortVerticesCounterClockwise(const std::vector<Vertex *> &vertices)
+{
+    std::vector<Vertex *> sorted;
+    sorted.reserve(vertices.size());
+    for (Vertex *vertex : vertices) {
+        if (vertex)
+            sorted.push_back(vertex);
+    }
+
+    if (sorted.size() < 3)
+        return sorted;
+
+    qreal sumX = 0.0;
+    qreal sumY = 0.0;
+    for (Vertex *vertex : sorted) {
+        const QPointF pos = vertex->position();
+        sumX += pos.x();
+        sumY += pos.y();
+    }
+    const qreal invCount = 1.0 / static_cast<qreal>(sorted.size());
+    const QPointF centroid(sumX * invCount, sumY * invCount);
+
+    std::sort(sorted.begin(), sorted.end(), [&centroid](Vertex *lhs, Vertex *rhs) {
+        const QPointF lhsPos = lhs->position();
+        const QPointF rhsPos = rhs->position();
+        const qreal lhsAngle = std::atan2(lhsPos.y() - centroid.y(), lhsPos.x() - centroid.x());
+        const qreal rhsAngle = std::atan2(rhsPos.y() - centroid.y(), rhsPos.x() - centroid.x());
+        if (lhsAngle < rhsAngle)
+            return true;
+        if (lhsAngle > rhsAngle)
+            return false;
+
+        const qreal lhsDx = lhsPos.x() - centroid.x();
+        const qreal lhsDy = lhsPos.y() - centroid.y();
+        const qreal rhsDx = rhsPos.x() - centroid.x();
+        const qreal rhsDy = rhsPos.y() - centroid.y();
+        const qreal lhsDistSq = lhsDx * lhsDx + lhsDy * lhsDy;
+        const qreal rhsDistSq = rhsDx * rhsDx + rhsDy * rhsDy;
+        return lhsDistSq < rhsDistSq;
+    });
+
+    if (signedArea(sorted) < 0) {
+        std::vector<Vertex *> reversed;
+        reversed.reserve(sorted.size());
+        reversed.push_back(sorted.front());
+        for (std::size_t i = sorted.size(); i-- > 1;)
+            reversed.push_back(sorted[i]);
+        sorted = std::move(reversed);
+    }
+
+    return sorted;
+}
+
+std::vector<QPointF> simplifyPolyline(const std::vector<QPointF> &points, qreal tolerance)
+{
+    if (points.size() < 3)
+        return points;
+
+    // Distance from position to the chord first-last, or to first when the
+    // chord has no length.
+    const auto distanceToChord = [](const QPointF &position, const QPointF &first, const QPointF &last) {
+        const QPointF chord = last - first;
+        const qreal length = std::hypot(chord.x(), chord.y());
+        const QPointF offset = position - first;
+        if (qFuzzyIsNull(length))
+            return std::hypot(offset.x(), offset.y());
+        return std::abs(chord.x() * offset.y() - chord.y() * offset.x()) / length;
+    };
+
+    // A closed path is split twice regardless of tolerance, so it keeps at
+    // least a triangle.
+    const bool closed = QLineF(points.front(), points.back()).length() <= tolerance;
+    struct Range
+    {
+        std::size_t first;
+        std::size_t last;
+        int forcedSplits;
+    };
+
+    std::vector<bool> kept(points.size(), false);
+    kept.front() = true;
+    kept.back() = true;
+    std::vector<Range> ranges{{0, points.size() - 1, closed ? 2 : 0}};
+    while (!ranges.empty()) {
+        const Range range = ranges.back();
+        ranges.pop_back();
+
+        std::size_t farthest = range.first;
+        qreal farthestDistance = -1.0;
+        for (std::size_t i = range.first + 1; i < range.last; ++i) {
+            const qreal distance = distanceToChord(points[i], points[range.first], points[range.last]);
+            if (distance > farthestDistance) {
+                farthestDistance = distance;
+                farthest = i;
+            }
+        }
+        if (farthest == range.first || (farthestDistance <= tolerance && range.forcedSplits == 0))
+            continue;
+
+        kept[farthest] = true;
+        ranges.push_back(Range{range.first, farthest, std::max(0, range.forcedSplits - 1)});
+        ranges.push_back(Range{farthest, range.last, 0});
+    }
+
+    std::vector<QPointF> result;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        if (kept[i])
+            result.push_back(points[i]);
+    }
+    return result;
+}
@@ -0,0 +1,28 @@
+#ifndef MESHGEOMETRY_H
+#define MESHGEOMETRY_H
+
+#include <QPointF>
+#include <QtGlobal>
+
+#include <vector>
+
+class Vertex;
+class Line;
+
+// Shoelace area of the closed vertex ring; positive when counter-clockwise
+// in scene coordinates.
+qreal signedArea(const std::vector<Vertex *> &vertices);
+
+// Reverses a polygon ring (keeping the first vertex) if it is clockwise.
+// lines[i] must join vertices[i] and vertices[i + 1].
+void ensureCounterClockwise(std::vector<Vertex *> &vertices, std::vector<Line *> &lines);
+
+// Orders vertices by angle around their centroid, counter-clockwise.
+std::vector<Vertex *> sortVerticesCounterClockwise(const std::vector<Vertex *> &vertices);
+
+// Douglas-Peucker simplification: keeps the end points and the fewest points
+// between them so that no dropped point is further than tolerance from the
+// result. A closed path (equal end points) keeps at least two points between.
+std::vector<QPointF> simplifyPolyline(const std::vector<QPointF> &points, qreal tolerance);
+
+#endif // MESHGEOMETRY_H
@@ -0,0 +1,408 @@
+#include "meshvalidator.h"
+
+#include "line.h"
+#include "polygon.h"
+#include "vertex.h"
+
+#include <QDebug>
+#include <QFuture>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace {
+template<typename First, typename Second>
+struct IncidenceHash
+{
+    std::size_t operator()(const std::pair<const First *, const Second *> &incidence) const
+    {
+        const std::size_t first = std::hash<const First *>()(incidence.first);
+        const std::size_t second = std::hash<const Second *>()(incidence.second);
+        return first ^ (second + 0x9e3779b9 + (first << 6) + (first >> 2));
+    }
+};
+
+template<typename First, typename Second>
+using IncidenceSet = std::unordered_set<std::pair<const First *, const Second *>, IncidenceHash<First, Second>>;
+
+template<typename Entity, typename Candidate>
+bool listContains(const std::vector<Entity *> &list, const Candidate *entity)
+{
+    return std::find(list.begin(), list.end(), entity) != list.end();
+}
+
+// Every incidence recorded by each side, indexed once for a full pass. After
+// construction it is only read, so the per-kind checks can share it.
+struct MeshSnapshot
+{
+    std::unordered_set<const Vertex *> vertices;
+    std::unordered_set<const Line *> lines;
+    std::unordered_set<const Polygon *> polygons;
+
+    IncidenceSet<Vertex, Line> linesOfVertices;       // vertex->connectedLines()
+    IncidenceSet<Vertex, Polygon> polygonsOfVertices; // vertex->connectedPolygons()
+    IncidenceSet<Vertex, Line> endpointsOfLines;      // line->startVertex()/endVertex()
+    IncidenceSet<Line, Polygon> polygonsOfLines;      // line->connectedPolygons()
+    IncidenceSet<Vertex, Polygon> verticesOfPolygons; // polygon->vertices()
+    IncidenceSet<Line, Polygon> linesOfPolygons;      // polygon->lines()
+
+    bool hasVertex(const Vertex *vertex) const { return vertices.count(vertex) > 0; }
+    bool hasLine(const Line *line) const { return lines.count(line) > 0; }
+    bool hasPolygon(const Polygon *polygon) const { return polygons.count(polygon) > 0; }
+
+    bool vertexListsLine(const Vertex *vertex, const Line *line) const
+    {
+        return linesOfVertices.count({vertex, line}) > 0;
+    }
+    bool vertexListsPolygon(const Vertex *vertex, const Polygon *polygon) const
+    {
+        return polygonsOfVertices.count({vertex, polygon}) > 0;
+    }
+    bool lineUsesVertex(const Line *line, const Vertex *vertex) const
+    {
+        return endpointsOfLines.count({vertex, line}) > 0;
+    }
+    bool lineListsPolygon(const Line *line, const Polygon *polygon) const
+    {
+        return polygonsOfLines.count({line, polygon}) > 0;
+    }
+    bool polygonUsesVertex(const Polygon *polygon, const Vertex *vertex) const
+    {
+        return verticesOfPolygons.count({vertex, polygon}) > 0;
+    }
+    bool polygonUsesLine(const Polygon *polygon, const Line *line) const
+    {
+        return linesOfPolygons.count({line, polygon}) > 0;
+    }
+};
+
+// The incremental pass looks incidences up on the entities themselves; their
+// lists are short, and only a handful of entities are pending at a time.
+struct LiveMesh
+{
+    const std::unordered_set<const Vertex *> &vertices;
+    const std::unordered_set<const Line *> &lines;
+    const std::unordered_set<const Polygon *> &polygons;
+
+    bool hasVertex(const Vertex *vertex) const { return vertices.count(vertex) > 0; }
+    bool hasLine(const Line *line) const { return lines.count(line) > 0; }
+    bool hasPolygon(const Polygon *polygon) const { return polygons.count(polygon) > 0; }
+
+    bool vertexListsLine(const Vertex *vertex, const Line *line) const
+    {
+        return listContains(vertex->connectedLines(), line);
+    }
+    bool vertexListsPolygon(const Vertex *vertex, const Polygon *polygon) const
+    {
+        return listContains(vertex->connectedPolygons(), polygon);
+    }
+    bool lineUsesVertex(const Line *line, const Vertex *vertex) const { return line->involvesVertex(vertex); }
+    bool lineListsPolygon(const Line *line, const Polygon *polygon) const
+    {
+        return listContains(line->connectedPolygons(), polygon);
+    }
+    bool polygonUsesVertex(const Polygon *polygon, const Vertex *vertex) const
+    {
+        return polygon->involvesVertex(vertex);
+    }
+    bool polygonUsesLine(const Polygon *polygon, const Line *line) const { return polygon->involvesLine(line); }
+};
+
+template<typename Mesh>
+void checkVertex(const Vertex *vertex, const Mesh &mesh, QStringList &problems)
+{
+    for (const Line *line : vertex->connectedLines()) {
+        if (!line)
+            continue;
+
+        if (!mesh.hasLine(line)) {
+            problems << QStringLiteral("Vertex %1 references an unknown line").arg(vertex->id());
+        } else if (!mesh.lineUsesVertex(line, vertex)) {
+            problems << QStringLiteral("Vertex %1 is linked to line %2 that does not include it.")
+                            .arg(vertex->id())
+                            .arg(line->id());
+        }
+    }
+
+    for (const Polygon *polygon : vertex->connectedPolygons()) {
+        if (!polygon)
+            continue;
+
+        if (!mesh.hasPolygon(polygon)) {
+            problems << QStringLiteral("Vertex %1 references an unknown polygon").arg(vertex->id());
+        } else if (!mesh.polygonUsesVertex(polygon, vertex)) {
+            problems << QStringLiteral("Vertex %1 is linked to polygon %2 that does not contain it.")
+                            .arg(vertex->id())
+                            .arg(polygon->id());
+        }
+    }
+}
+
+template<typename Mesh>
+void checkLine(const Line *line, const Mesh &mesh, QStringList &problems)
+{
+    for (const Vertex *vertex : {line->startVertex(), line->endVertex()}) {
+        if (!vertex)
+            continue;
+
+        if (!mesh.hasVertex(vertex)) {
+            problems << QStringLiteral("Line %1 references an unknown vertex").arg(line->id());
+        } else if (!mesh.vertexListsLine(vertex, line)) {
+            problems << QStringLiteral("Line %1 uses vertex %2 that does not reference it back.")
+                            .arg(line->id())
+                            .arg(vertex->id());
+        }
+    }
+
+    for (const Polygon *polygon : line->connectedPolygons()) {
+        if (!polygon)
+            continue;
+
+        if (!mesh.hasPolygon(polygon)) {
+            problems << QStringLiteral("Line %1 references an unknown polygon").arg(line->id());
+        } else if (!mesh.polygonUsesLine(polygon, line)) {
+            problems << QStringLiteral("Line %1 is linked to polygon %2 that does not include it.")
+                            .arg(line->id())
+                            .arg(polygon->id());
+        }
+    }
+}
+
+template<typename Mesh>
+void checkPolygon(const Polygon *polygon, const Mesh &mesh, QStringList &problems)
+{
+    for (const Vertex *vertex : polygon->vertices()) {
+        if (!vertex)
+            continue;
+
+        if (!mesh.hasVertex(vertex)) {
+            problems << QStringLiteral("Polygon %1 references an unknown vertex").arg(polygon->id());
+        } else if (!mesh.vertexListsPolygon(vertex, polygon)) {
+            problems << QStringLiteral("Polygon %1 includes vertex %2 that does not reference it back.")
+                            .arg(polygon->id())
+                            .arg(vertex->id());
+        }
+    }
+
+    for (const Line *line : polygon->lines()) {
+        if (!line)
+            continue;
+
+        if (!mesh.hasLine(line)) {
+            problems << QStringLiteral("Polygon %1 references an unknown line").arg(polygon->id());
+        } else if (!mesh.lineListsPolygon(line, polygon)) {
+            problems << QStringLiteral("Polygon %1 includes line %2 that does not reference it back.")
+                            .arg(polygon->id())
+                            .arg(line->id());
+        }
+    }
+}
+} // namespace
+
+bool MeshValidator::validateAll(const std::vector<std::unique_ptr<Vertex>> &vertices,
+                                const std::vector<std::unique_ptr<Line>> &lines,
+                                const std::vector<std::unique_ptr<Polygon>> &polygons)
+{
+    MeshSnapshot snapshot;
+
+    // Each kind fills only its own sets, so the three passes run side by side.
+    QFuture<void> indexVertices = QtConcurrent::run([&vertices, &snapshot] {
+        snapshot.vertices.reserve(vertices.size());
+        snapshot.linesOfVertices.reserve(vertices.size() * 3);
+        for (const auto &vertex : vertices) {
+            if (!vertex)
+                continue;
+            snapshot.vertices.insert(vertex.get());
+            for (const Line *line : vertex->connectedLines())
+                snapshot.linesOfVertices.insert({vertex.get(), line});
+            for (const Polygon *polygon : vertex->connectedPolygons())
+                snapshot.polygonsOfVertices.insert({vertex.get(), polygon});
+        }
+    });
+    QFuture<void> indexLines = QtConcurrent::run([&lines, &snapshot] {
+        snapshot.lines.reserve(lines.size());
+        snapshot.endpointsOfLines.reserve(lines.size() * 2);
+        for (const auto &line : lines) {
+            if (!line)
+                continue;
+            snapshot.lines.insert(line.get());
+            snapshot.endpointsOfLines.insert({line->startVertex(), line.get()});
+            snapshot.endpointsOfLines.insert({line->endVertex(), line.get()});
+            for (const Polygon *polygon : line->connectedPolygons())
+                snapshot.polygonsOfLines.insert({line.get(), polygon});
+        }
+    });
+    QFuture<void> indexPolygons = QtConcurrent::run([&polygons, &snapshot] {
+        snapshot.polygons.reserve(polygons.size());
+        for (const auto &polygon : polygons) {
+            if (!polygon)
+                continue;
+            snapshot.polygons.insert(polygon.get());
+            for (const Vertex *vertex : polygon->vertices())
+                snapshot.verticesOfPolygons.insert({vertex, polygon.get()});
+            for (const Line *line : polygon->lines())
+                snapshot.linesOfPolygons.insert({line, polygon.get()});
+        }
+    });
+    indexVertices.waitForFinished();
+    indexLines.waitForFinished();
+    indexPolygons.waitForFinished();
+
+    QStringList vertexProblems;
+    QStringList lineProblems;
+    QStringList polygonProblems;
+
+    QFuture<void> checkVertices = QtConcurrent::run([&vertices, &snapshot, &vertexProblems] {
+        for (const auto &vertex : vertices) {
+            if (vertex)
+                checkVertex(vertex.get(), snapshot, vertexProblems);
+        }
+    });
+    QFuture<void> checkLines = QtConcurrent::run([&lines, &snapshot, &lineProblems] {
+        for (const auto &line : lines) {
+            if (line)
+                checkLine(line.get(), snapshot, lineProblems);
+        }
+    });
+    for (const auto &polygon : polygons) {
+        if (polygon)
+            checkPolygon(polygon.get(), snapshot, polygonProblems);
+    }
+    checkVertices.waitForFinished();
+    checkLines.waitForFinished();
+
+    // Everything tracked has just been checked.
+    clearPending();
+
+    return report(vertexProblems + lineProblems + polygonProblems);
+}
+
+bool MeshValidator::hasPendingChecks() const
+{
+    return !m_pendingVertices.empty() || !m_pendingLines.empty() || !m_pendingPolygons.empty();
+}
+
+bool MeshValidator::validatePending()
+{
+    const LiveMesh mesh{m_vertices, m_lines, m_polygons};
+    QStringList problems;
+
+    for (const Vertex *vertex : m_pendingVertices)
+        checkVertex(vertex, mesh, problems);
+    for (const Line *line : m_pendingLines)
+        checkLine(line, mesh, problems);
+    for (const Polygon *polygon : m_pendingPolygons)
+        checkPolygon(polygon, mesh, problems);
+
+    clearPending();
+    return report(problems);
+}
+
+void MeshValidator::trackVertex(Vertex *vertex)
+{
+    if (!vertex || !m_vertices.insert(vertex).second)
+        return;
+
+    m_pendingVertices.insert(vertex);
+    touchNeighbours(vertex);
+}
+
+void MeshValidator::untrackVertex(Vertex *vertex)
+{
+    if (!m_vertices.erase(vertex))
+        return;
+
+    m_pendingVertices.erase(vertex);
+    touchNeighbours(vertex);
+}
+
+void MeshValidator::trackLine(Line *line)
+{
+    if (!line || !m_lines.insert(line).second)
+        return;
+
+    m_pendingLines.insert(line);
+    touchNeighbours(line);
+}
+
+void MeshValidator::untrackLine(Line *line)
+{
+    if (!m_lines.erase(line))
+        return;
+
+    m_pendingLines.erase(line);
+    touchNeighbours(line);
+}
+
+void MeshValidator::trackPolygon(Polygon *polygon)
+{
+    if (!polygon || !m_polygons.insert(polygon).second)
+        return;
+
+    m_pendingPolygons.insert(polygon);
+    touchNeighbours(polygon);
+}
+
+void MeshValidator::untrackPolygon(Polygon *polygon)
+{
+    if (!m_polygons.erase(polygon))
+        return;
+
+    m_pendingPolygons.erase(polygon);
+    touchNeighbours(polygon);
+}
+
+// Only tracked neighbours are marked: anything else is either already gone or
+// not yet registered, and will be reported as unknown when its referrer is
+// checked.
+void MeshValidator::touchNeighbours(const Vertex *vertex)
+{
+    for (const Line *line : vertex->connectedLines()) {
+        if (m_lines.count(line))
+            m_pendingLines.insert(line);
+    }
+    for (const Polygon *polygon : vertex->connectedPolygons()) {
+        if (m_polygons.count(polygon))
+            m_pendingPolygons.insert(polygon);
+    }
+}
+
+void MeshValidator::touchNeighbours(const Line *line)
+{
+    for (const Vertex *vertex : {line->startVertex(), line->endVertex()}) {
+        if (m_vertices.count(vertex))
+            m_pendingVertices.insert(vertex);
+    }
+    for (const Polygon *polygon : line->connectedPolygons()) {
+        if (m_polygons.count(polygon))
+            m_pendingPolygons.insert(polygon);
+    }
+}
+
+void MeshValidator::touchNeighbours(const Polygon *polygon)
+{
+    for (const Vertex *vertex : polygon->vertices()) {
+        if (m_vertices.count(vertex))
+            m_pendingVertices.insert(vertex);
+    }
+    for (const Line *line : polygon->lines()) {
+        if (m_lines.count(line))
+            m_pendingLines.insert(line);
+    }
+}
+
+void MeshValidator::clearPending()
+{
+    m_pendingVertices.clear();
+    m_pendingLines.clear();
+    m_pendingPolygons.clear();
+}
+
+bool MeshValidator::report(const QStringList &problems)
+{
+    for (const QString &problem : problems)
+        qWarning().noquote() << problem;
+    return problems.isEmpty();
+}
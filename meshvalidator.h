@@ -0,0 +1,53 @@
+#ifndef MESHVALIDATOR_H
+#define MESHVALIDATOR_H
+
+#include <QStringList>
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+class Vertex;
+class Line;
+class Polygon;
+
+// Checks that the vertex, line and polygon back-references agree.
+//
+// validateAll() indexes every entity and incidence once in hash sets and then
+// checks each entity kind in parallel, so a full pass is linear in the size of
+// the mesh. Entities that register themselves (setMeshValidator) are also
+// tracked: creating or destroying one marks it and its neighbours as pending,
+// and validatePending() rechecks only those.
+class MeshValidator
+{
+public:
+    bool validateAll(const std::vector<std::unique_ptr<Vertex>> &vertices,
+                     const std::vector<std::unique_ptr<Line>> &lines,
+                     const std::vector<std::unique_ptr<Polygon>> &polygons);
+
+    bool hasPendingChecks() const;
+    bool validatePending();
+
+    void trackVertex(Vertex *vertex);
+    void untrackVertex(Vertex *vertex);
+    void trackLine(Line *line);
+    void untrackLine(Line *line);
+    void trackPolygon(Polygon *polygon);
+    void untrackPolygon(Polygon *polygon);
+
+private:
+    void touchNeighbours(const Vertex *vertex);
+    void touchNeighbours(const Line *line);
+    void touchNeighbours(const Polygon *polygon);
+    void clearPending();
+    static bool report(const QStringList &problems);
+
+    std::unordered_set<const Vertex *> m_vertices;
+    std::unordered_set<const Line *> m_lines;
+    std::unordered_set<const Polygon *> m_polygons;
+    std::unordered_set<const Vertex *> m_pendingVertices;
+    std::unordered_set<const Line *> m_pendingLines;
+    std::unordered_set<const Polygon *> m_pendingPolygons;
+};
+
+#endif // MESHVALIDATOR_H
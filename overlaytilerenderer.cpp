@@ -0,0 +1,362 @@
+#include "overlaytilerenderer.h"
+
+#include "linegraphicsitem.h"
+#include "vertexgraphicsitem.h"
+
+#include <QGraphicsItem>
+#include <QGraphicsPolygonItem>
+#include <QGraphicsScene>
+#include <QList>
+#include <QMetaObject>
+#include <QPainter>
+#include <QRect>
+#include <QSize>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+constexpr int kTileSize = 256;
+constexpr int kMaximumCachedTiles = 256;
+// Items that ignore the view transform (vertices) extend this many device
+// pixels beyond the scene rect reported for them.
+constexpr qreal kIgnoredTransformMargin = 8.0;
+
+int tileIndex(qreal deviceCoordinate)
+{
+    return static_cast<int>(std::floor(deviceCoordinate / kTileSize));
+}
+
+void drawSelectionOutline(QPainter &painter, const QRectF &rect)
+{
+    QPen outlinePen(Qt::white, 0.0, Qt::SolidLine);
+    painter.setPen(outlinePen);
+    painter.setBrush(Qt::NoBrush);
+    painter.drawRect(rect);
+
+    outlinePen.setColor(Qt::black);
+    outlinePen.setStyle(Qt::DashLine);
+    painter.setPen(outlinePen);
+    painter.drawRect(rect);
+}
+} // namespace
+
+OverlayTileRenderer::OverlayTileRenderer(QObject *parent)
+    : QObject(parent)
+{
+}
+
+OverlayTileRenderer::~OverlayTileRenderer()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void OverlayTileRenderer::setScene(QGraphicsScene *scene)
+{
+    m_scene = scene;
+    invalidateAll();
+}
+
+void OverlayTileRenderer::invalidateSceneRect(const QRectF &rect)
+{
+    if (m_scale <= 0.0 || m_tiles.isEmpty())
+        return;
+
+    const qreal margin = kIgnoredTransformMargin;
+    const QRectF scaledRect(rect.left() * m_scale - margin,
+                            rect.top() * m_scale - margin,
+                            rect.width() * m_scale + 2.0 * margin,
+                            rect.height() * m_scale + 2.0 * margin);
+
+    const int firstColumn = tileIndex(scaledRect.left());
+    const int lastColumn = tileIndex(scaledRect.right());
+    const int firstRow = tileIndex(scaledRect.top());
+    const int lastRow = tileIndex(scaledRect.bottom());
+
+    // Large invalidations (e.g. clearing the mesh) touch far fewer cached tiles
+    // than the rect spans, so walk whichever set is smaller.
+    const qint64 spannedTiles = static_cast<qint64>(lastColumn - firstColumn + 1) * (lastRow - firstRow + 1);
+    if (spannedTiles > m_tiles.size()) {
+        for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+            const QPoint &key = it.key();
+            if (key.x() >= firstColumn && key.x() <= lastColumn && key.y() >= firstRow && key.y() <= lastRow)
+                ++it->revision;
+        }
+        return;
+    }
+
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const auto it = m_tiles.find(QPoint(column, row));
+            if (it != m_tiles.end())
+                ++it->revision;
+        }
+    }
+}
+
+void OverlayTileRenderer::invalidateAll()
+{
+    for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it)
+        ++it->revision;
+}
+
+void OverlayTileRenderer::paint(QPainter *painter, const QRectF &exposedSceneRect)
+{
+    if (!painter || !m_scene)
+        return;
+
+    const QTransform worldTransform = painter->worldTransform();
+    updateScale(worldTransform.m11());
+    if (m_scale <= 0.0)
+        return;
+
+    ++m_frame;
+
+    const QPointF deviceOffset(worldTransform.dx(), worldTransform.dy());
+    const QRectF deviceRect = worldTransform.mapRect(exposedSceneRect);
+    const int firstColumn = tileIndex(deviceRect.left() - deviceOffset.x());
+    const int lastColumn = tileIndex(deviceRect.right() - deviceOffset.x());
+    const int firstRow = tileIndex(deviceRect.top() - deviceOffset.y());
+    const int lastRow = tileIndex(deviceRect.bottom() - deviceOffset.y());
+
+    bool allTilesRendered = true;
+
+    painter->save();
+    painter->resetTransform();
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const QPoint key(column, row);
+            const QPoint origin(qRound(column * kTileSize + deviceOffset.x()),
+                                qRound(row * kTileSize + deviceOffset.y()));
+
+            Tile &tile = m_tiles[key];
+            tile.lastUsedFrame = m_frame;
+
+            if (!tile.image.isNull()) {
+                painter->drawImage(origin, tile.image);
+            } else {
+                allTilesRendered = false;
+                paintStaleTiles(painter, QRect(origin, QSize(kTileSize, kTileSize)), deviceOffset);
+            }
+
+            if (tile.renderedRevision != tile.revision && !tile.pending)
+                scheduleTile(key, tile);
+        }
+    }
+    painter->restore();
+
+    if (allTilesRendered)
+        m_staleTiles.clear();
+
+    evictTiles();
+}
+
+void OverlayTileRenderer::updateScale(qreal scale)
+{
+    if (qFuzzyCompare(scale, m_scale))
+        return;
+
+    // Keep the last rendered tiles around, stretched to the new scale, until
+    // their replacements arrive. During a zoom animation most intermediate
+    // scales never finish rendering, so only replace them with real content.
+    QHash<QPoint, QImage> renderedTiles;
+    for (auto it = m_tiles.cbegin(); it != m_tiles.cend(); ++it) {
+        if (!it->image.isNull())
+            renderedTiles.insert(it.key(), it->image);
+    }
+
+    if (!renderedTiles.isEmpty()) {
+        m_staleTiles = std::move(renderedTiles);
+        m_staleScale = m_scale;
+    }
+
+    m_tiles.clear();
+    m_scale = scale;
+    ++m_generation;
+}
+
+void OverlayTileRenderer::scheduleTile(const QPoint &key, Tile &tile)
+{
+    std::vector<Primitive> primitives = collectPrimitives(tileSceneRect(key));
+    tile.pending = true;
+
+    const qreal scale = m_scale;
+    const quint64 revision = tile.revision;
+    const quint64 generation = m_generation;
+    m_pool.start([this, key, scale, revision, generation, primitives = std::move(primitives)]() {
+        const QImage image = renderTile(key, scale, primitives);
+        QMetaObject::invokeMethod(
+            this,
+            [this, key, revision, generation, image]() {
+                handleTileRendered(key, revision, generation, image);
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void OverlayTileRenderer::handleTileRendered(const QPoint &key,
+                                             quint64 revision,
+                                             quint64 generation,
+                                             const QImage &image)
+{
+    if (generation != m_generation)
+        return;
+
+    const auto it = m_tiles.find(key);
+    if (it == m_tiles.end())
+        return;
+
+    it->pending = false;
+    it->image = image;
+    it->renderedRevision = revision;
+
+    emit tileReady(tileSceneRect(key));
+}
+
+void OverlayTileRenderer::paintStaleTiles(QPainter *painter,
+                                          const QRect &targetRect,
+                                          const QPointF &deviceOffset) const
+{
+    if (m_staleTiles.isEmpty() || m_staleScale <= 0.0)
+        return;
+
+    const qreal staleTileSize = kTileSize * m_scale / m_staleScale;
+
+    painter->save();
+    painter->setClipRect(targetRect, Qt::IntersectClip);
+    for (auto it = m_staleTiles.cbegin(); it != m_staleTiles.cend(); ++it) {
+        const QRectF staleRect(it.key().x() * staleTileSize + deviceOffset.x(),
+                               it.key().y() * staleTileSize + deviceOffset.y(),
+                               staleTileSize,
+                               staleTileSize);
+        if (staleRect.intersects(targetRect))
+            painter->drawImage(staleRect, it.value());
+    }
+    painter->restore();
+}
+
+void OverlayTileRenderer::evictTiles()
+{
+    if (m_tiles.size() <= kMaximumCachedTiles)
+        return;
+
+    std::vector<std::pair<quint64, QPoint>> candidates;
+    candidates.reserve(static_cast<std::size_t>(m_tiles.size()));
+    for (auto it = m_tiles.cbegin(); it != m_tiles.cend(); ++it) {
+        if (it->lastUsedFrame != m_frame)
+            candidates.emplace_back(it->lastUsedFrame, it.key());
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    for (const auto &candidate : candidates) {
+        if (m_tiles.size() <= kMaximumCachedTiles)
+            break;
+        m_tiles.remove(candidate.second);
+    }
+}
+
+std::vector<OverlayTileRenderer::Primitive> OverlayTileRenderer::collectPrimitives(const QRectF &sceneRect) const
+{
+    std::vector<Primitive> primitives;
+    if (!m_scene)
+        return primitives;
+
+    const QList<QGraphicsItem *> items = m_scene->items(sceneRect,
+                                                        Qt::IntersectsItemBoundingRect,
+                                                        Qt::AscendingOrder,
+                                                        QTransform::fromScale(m_scale, m_scale));
+    primitives.reserve(static_cast<std::size_t>(items.size()));
+
+    for (QGraphicsItem *item : items) {
+        if (!item || !item->isVisible())
+            continue;
+
+        Primitive primitive;
+        primitive.selected = item->isSelected();
+
+        if (auto *vertexItem = qgraphicsitem_cast<VertexGraphicsItem *>(item)) {
+            const qreal radius = vertexItem->radius();
+            primitive.shape = Primitive::Shape::Ellipse;
+            primitive.pen = vertexItem->pen();
+            primitive.brush = vertexItem->brush();
+            primitive.ignoresTransformations = true;
+            primitive.anchor = item->scenePos();
+            primitive.rect = QRectF(-radius, -radius, radius * 2.0, radius * 2.0);
+        } else if (auto *lineItem = qgraphicsitem_cast<LineGraphicsItem *>(item)) {
+            primitive.shape = Primitive::Shape::Line;
+            primitive.pen = lineItem->pen();
+            primitive.points << item->mapToScene(lineItem->line().p1()) << item->mapToScene(lineItem->line().p2());
+            primitive.rect = item->sceneBoundingRect();
+        } else if (auto *polygonItem = qgraphicsitem_cast<QGraphicsPolygonItem *>(item)) {
+            primitive.shape = Primitive::Shape::Polygon;
+            primitive.pen = polygonItem->pen();
+            primitive.brush = polygonItem->brush();
+            primitive.points = item->mapToScene(polygonItem->polygon());
+            primitive.rect = item->sceneBoundingRect();
+        } else {
+            continue;
+        }
+
+        primitives.push_back(std::move(primitive));
+    }
+
+    return primitives;
+}
+
+QRectF OverlayTileRenderer::tileSceneRect(const QPoint &key) const
+{
+    const qreal sceneTileSize = kTileSize / m_scale;
+    return QRectF(key.x() * sceneTileSize, key.y() * sceneTileSize, sceneTileSize, sceneTileSize);
+}
+
+QImage OverlayTileRenderer::renderTile(const QPoint &key, qreal scale, const std::vector<Primitive> &primitives)
+{
+    QImage image(kTileSize, kTileSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    const QTransform sceneToTile(scale, 0.0, 0.0, scale, -key.x() * kTileSize, -key.y() * kTileSize);
+
+    for (const Primitive &primitive : primitives) {
+        switch (primitive.shape) {
+        case Primitive::Shape::Polygon:
+            painter.setTransform(sceneToTile);
+            painter.setPen(primitive.pen);
+            painter.setBrush(primitive.brush);
+            painter.drawPolygon(primitive.points);
+            if (primitive.selected)
+                drawSelectionOutline(painter, primitive.rect);
+            break;
+        case Primitive::Shape::Line:
+            painter.setTransform(sceneToTile);
+            painter.setPen(primitive.pen);
+            if (primitive.points.size() == 2)
+                painter.drawLine(primitive.points.at(0), primitive.points.at(1));
+            if (primitive.selected)
+                drawSelectionOutline(painter, primitive.rect);
+            break;
+        case Primitive::Shape::Ellipse:
+            if (primitive.ignoresTransformations) {
+                const QPointF tileAnchor = sceneToTile.map(primitive.anchor);
+                painter.setTransform(QTransform::fromTranslate(tileAnchor.x(), tileAnchor.y()));
+            } else {
+                painter.setTransform(sceneToTile);
+            }
+            painter.setPen(primitive.pen);
+            painter.setBrush(primitive.brush);
+            painter.drawEllipse(primitive.rect);
+            if (primitive.selected)
+                drawSelectionOutline(painter, primitive.rect);
+            break;
+        }
+    }
+
+    return image;
+}
@@ -0,0 +1,80 @@
+#ifndef OVERLAYTILERENDERER_H
+#define OVERLAYTILERENDERER_H
+
+#include <QBrush>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QPen>
+#include <QPoint>
+#include <QPointF>
+#include <QPolygonF>
+#include <QRectF>
+#include <QThreadPool>
+#include <QTransform>
+
+#include <vector>
+
+class QGraphicsScene;
+class QPainter;
+
+class OverlayTileRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OverlayTileRenderer(QObject *parent = nullptr);
+    ~OverlayTileRenderer() override;
+
+    void setScene(QGraphicsScene *scene);
+    void invalidateSceneRect(const QRectF &rect);
+    void invalidateAll();
+    void paint(QPainter *painter, const QRectF &exposedSceneRect);
+
+signals:
+    void tileReady(const QRectF &sceneRect);
+
+private:
+    struct Primitive
+    {
+        enum class Shape { Ellipse, Line, Polygon };
+
+        Shape shape = Shape::Polygon;
+        QPolygonF points;
+        QRectF rect;
+        QPointF anchor;
+        bool ignoresTransformations = false;
+        QPen pen;
+        QBrush brush;
+        bool selected = false;
+    };
+
+    struct Tile
+    {
+        QImage image;
+        quint64 revision = 1;
+        quint64 renderedRevision = 0;
+        quint64 lastUsedFrame = 0;
+        bool pending = false;
+    };
+
+    void updateScale(qreal scale);
+    void scheduleTile(const QPoint &key, Tile &tile);
+    void handleTileRendered(const QPoint &key, quint64 revision, quint64 generation, const QImage &image);
+    void paintStaleTiles(QPainter *painter, const QRect &targetRect, const QPointF &deviceOffset) const;
+    void evictTiles();
+    std::vector<Primitive> collectPrimitives(const QRectF &sceneRect) const;
+    QRectF tileSceneRect(const QPoint &key) const;
+    static QImage renderTile(const QPoint &key, qreal scale, const std::vector<Primitive> &primitives);
+
+    QGraphicsScene *m_scene = nullptr;
+    QThreadPool m_pool;
+    QHash<QPoint, Tile> m_tiles;
+    QHash<QPoint, QImage> m_staleTiles;
+    qreal m_scale = 0.0;
+    qreal m_staleScale = 0.0;
+    quint64 m_generation = 0;
+    quint64 m_frame = 0;
+};
+
+#endif // OVERLAYTILERENDERER_H
@@ -0,0 +1,174 @@
+#include "pixelcomponents.h"
+
+#include "stripes.h"
+
+#include <QtAlgorithms>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+// The foreground pixels a stripe finds, before they are joined in order.
+struct ComponentStripe : Stripe
+{
+    std::vector<int> columns;
+    std::vector<int> rowCounts;
+};
+
+int findRoot(std::vector<int> &parents, int index)
+{
+    while (parents[static_cast<std::size_t>(index)] != index) {
+        int &parent = parents[static_cast<std::size_t>(index)];
+        parent = parents[static_cast<std::size_t>(parent)];
+        index = parent;
+    }
+    return index;
+}
+
+// The smaller index becomes the root, so each root is the first pixel of its
+// component in raster order.
+void unite(std::vector<int> &parents, int first, int second)
+{
+    first = findRoot(parents, first);
+    second = findRoot(parents, second);
+    if (first != second)
+        parents[static_cast<std::size_t>(std::max(first, second))] = std::min(first, second);
+}
+} // namespace
+
+PixelComponents::PixelComponents(const BinaryImage &mask)
+    : m_width(mask.width())
+{
+    const int height = mask.height();
+    m_rowStarts.assign(static_cast<std::size_t>(height) + 1, 0);
+    if (mask.isNull())
+        return;
+
+    std::vector<ComponentStripe> stripes = makeStripes<ComponentStripe>(height);
+    QtConcurrent::blockingMap(stripes, [&](ComponentStripe &stripe) {
+        stripe.rowCounts.assign(static_cast<std::size_t>(stripe.end - stripe.first), 0);
+        for (int y = stripe.first; y < stripe.end; ++y) {
+            const quint64 *row = mask.row(y);
+            for (int w = 0; w < mask.wordsPerRow(); ++w) {
+                for (quint64 bits = row[w]; bits != 0; bits &= bits - 1) {
+                    stripe.columns.push_back(w * 64 + static_cast<int>(qCountTrailingZeroBits(bits)));
+                    ++stripe.rowCounts[static_cast<std::size_t>(y - stripe.first)];
+                }
+            }
+        }
+    });
+
+    for (ComponentStripe &stripe : stripes) {
+        m_columns.insert(m_columns.end(), stripe.columns.begin(), stripe.columns.end());
+        std::copy(stripe.rowCounts.begin(), stripe.rowCounts.end(), m_rowStarts.begin() + stripe.first + 1);
+        stripe.columns = std::vector<int>();
+    }
+    std::partial_sum(m_rowStarts.begin(), m_rowStarts.end(), m_rowStarts.begin());
+    m_rows.resize(m_columns.size());
+    for (int y = 0; y < height; ++y) {
+        std::fill(m_rows.begin() + m_rowStarts[static_cast<std::size_t>(y)],
+                  m_rows.begin() + m_rowStarts[static_cast<std::size_t>(y) + 1],
+                  y);
+    }
+
+    // Joins pixel i to the pixels of the row above that touch it.
+    std::vector<int> parents(m_columns.size());
+    std::iota(parents.begin(), parents.end(), 0);
+    const auto uniteWithRowAbove = [&](int i) {
+        const int x = m_columns[static_cast<std::size_t>(i)];
+        const auto y = static_cast<std::size_t>(m_rows[static_cast<std::size_t>(i)]);
+        const auto rowBegin = m_columns.begin() + m_rowStarts[y - 1];
+        const auto rowEnd = m_columns.begin() + m_rowStarts[y];
+        for (auto it = std::lower_bound(rowBegin, rowEnd, x - 1); it != rowEnd && *it <= x + 1; ++it)
+            unite(parents, i, static_cast<int>(it - m_columns.begin()));
+    };
+
+    // Each stripe merges its own pixels in parallel, touching only its own
+    // part of parents; the rows where stripes meet are merged afterwards.
+    std::vector<int> stripeIndices(stripes.size());
+    std::iota(stripeIndices.begin(), stripeIndices.end(), 0);
+    QtConcurrent::blockingMap(stripeIndices, [&](const int &stripeIndex) {
+        const ComponentStripe &stripe = stripes[static_cast<std::size_t>(stripeIndex)];
+        for (int y = stripe.first; y < stripe.end; ++y) {
+            const int rowBegin = m_rowStarts[static_cast<std::size_t>(y)];
+            for (int i = rowBegin; i < m_rowStarts[static_cast<std::size_t>(y) + 1]; ++i) {
+                const auto index = static_cast<std::size_t>(i);
+                if (i > rowBegin && m_columns[index - 1] == m_columns[index] - 1)
+                    unite(parents, i, i - 1);
+                if (y > stripe.first)
+                    uniteWithRowAbove(i);
+            }
+        }
+    });
+    for (std::size_t s = 1; s < stripes.size(); ++s) {
+        const auto y = static_cast<std::size_t>(stripes[s].first);
+        for (int i = m_rowStarts[y]; i < m_rowStarts[y + 1]; ++i)
+            uniteWithRowAbove(i);
+    }
+
+    // Roots come first in raster order, so components are numbered as they
+    // are met.
+    m_components.resize(m_columns.size());
+    std::vector<int> componentSizes;
+    for (int i = 0; i < pixelCount(); ++i) {
+        const int root = findRoot(parents, i);
+        if (root == i) {
+            m_components[static_cast<std::size_t>(i)] = static_cast<int>(componentSizes.size());
+            componentSizes.push_back(0);
+        } else {
+            m_components[static_cast<std::size_t>(i)] = m_components[static_cast<std::size_t>(root)];
+        }
+        ++componentSizes[static_cast<std::size_t>(m_components[static_cast<std::size_t>(i)])];
+    }
+
+    m_componentStarts.resize(componentSizes.size() + 1);
+    std::partial_sum(componentSizes.begin(), componentSizes.end(), m_componentStarts.begin() + 1);
+    m_componentPixels.resize(m_columns.size());
+    std::vector<int> next(m_componentStarts.begin(), m_componentStarts.end() - 1);
+    for (int i = 0; i < pixelCount(); ++i) {
+        const auto component = static_cast<std::size_t>(m_components[static_cast<std::size_t>(i)]);
+        m_componentPixels[static_cast<std::size_t>(next[component]++)] = i;
+    }
+}
+
+int PixelComponents::pixelCount() const
+{
+    return static_cast<int>(m_columns.size());
+}
+
+int PixelComponents::componentCount() const
+{
+    return static_cast<int>(m_componentStarts.size()) - 1;
+}
+
+QPoint PixelComponents::pixel(int index) const
+{
+    return QPoint(m_columns[static_cast<std::size_t>(index)], m_rows[static_cast<std::size_t>(index)]);
+}
+
+int PixelComponents::componentOf(int index) const
+{
+    return m_components[static_cast<std::size_t>(index)];
+}
+
+int PixelComponents::indexOf(int x, int y) const
+{
+    if (x < 0 || x >= m_width || y < 0 || y + 1 >= static_cast<int>(m_rowStarts.size()))
+        return -1;
+
+    const auto rowBegin = m_columns.begin() + m_rowStarts[static_cast<std::size_t>(y)];
+    const auto rowEnd = m_columns.begin() + m_rowStarts[static_cast<std::size_t>(y) + 1];
+    const auto it = std::lower_bound(rowBegin, rowEnd, x);
+    return it != rowEnd && *it == x ? static_cast<int>(it - m_columns.begin()) : -1;
+}
+
+const int *PixelComponents::componentBegin(int component) const
+{
+    return m_componentPixels.data() + m_componentStarts[static_cast<std::size_t>(component)];
+}
+
+const int *PixelComponents::componentEnd(int component) const
+{
+    return m_componentPixels.data() + m_componentStarts[static_cast<std::size_t>(component) + 1];
+}
@@ -0,0 +1,43 @@
+#ifndef PIXELCOMPONENTS_H
+#define PIXELCOMPONENTS_H
+
+#include "binaryimage.h"
+
+#include <QPoint>
+
+#include <vector>
+
+// The 8-connected components of the set pixels of a BinaryImage. Pixels are
+// numbered in raster order and components in raster order of their first
+// pixel.
+class PixelComponents
+{
+public:
+    PixelComponents() = default;
+    // Labels the components with a union-find over row stripes, run on all
+    // cores.
+    explicit PixelComponents(const BinaryImage &mask);
+
+    int pixelCount() const;
+    int componentCount() const;
+
+    QPoint pixel(int index) const;
+    int componentOf(int index) const;
+    // Index of the set pixel at (x, y), or -1 if that pixel is clear.
+    int indexOf(int x, int y) const;
+
+    // Pixel indices of each component, in raster order.
+    const int *componentBegin(int component) const;
+    const int *componentEnd(int component) const;
+
+private:
+    int m_width = 0;
+    std::vector<int> m_columns;
+    std::vector<int> m_rows;
+    std::vector<int> m_rowStarts;
+    std::vector<int> m_components;
+    std::vector<int> m_componentStarts{0};
+    std::vector<int> m_componentPixels;
+};
+
+#endif // PIXELCOMPONENTS_H
@@ -0,0 +1,25 @@
+#ifndef PLANARMESH_H
+#define PLANARMESH_H
+
+#include <QPointF>
+
+#include <utility>
+#include <vector>
+
+// A mesh in plain index form, as produced by the generators and importers
+// and bulk-loaded into the model by MainWindow::loadPlanarMesh.
+struct PlanarMesh
+{
+    std::vector<QPointF> vertices;
+    // Endpoints of each line as indices into vertices.
+    std::vector<std::pair<int, int>> lines;
+    // Face f owns faceVertices and faceLines in [faceOffsets[f], faceOffsets[f + 1]);
+    // faceLines[i] joins faceVertices[i] to the next vertex of the same face.
+    std::vector<int> faceOffsets{0};
+    std::vector<int> faceVertices;
+    std::vector<int> faceLines;
+
+    std::size_t faceCount() const { return faceOffsets.size() - 1; }
+};
+
+#endif // PLANARMESH_H
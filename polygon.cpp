@@ -1,7 +1,12 @@
 #include "polygon.h"
 
+#include "halfedgemesh.h"
 #include "line.h"
+#include "meshvalidator.h"
+#include "polygonfilllayer.h"
+#include "polygonspatialindex.h"
 #include "vertex.h"
+#include "zoomablegraphicsview.h"
 
 #include <QGraphicsPolygonItem>
 #include <QGraphicsScene>
@@ -9,6 +14,10 @@
 #include <QBrush>
 #include <QPolygonF>
 #include <QRandomGenerator>
+#include <QStyle>
+#include <QStyleOptionGraphicsItem>
+#include <QVariant>
+#include <QWidget>
 
 #include <algorithm>
 #include <utility>
@@ -30,6 +39,44 @@ public:
         setZValue(0.25);
         setFlag(QGraphicsItem::ItemIsSelectable);
     }
+
+    void setOutline(const QPolygonF &polygon)
+    {
+        const QRectF previousRect = sceneBoundingRect();
+        setPolygon(polygon);
+        PolygonFillLayer::invalidate(scene(), previousRect.united(sceneBoundingRect()));
+    }
+
+    // The fill is drawn by the scene's PolygonFillLayer; only the outline is
+    // painted per item.
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override
+    {
+        if (ZoomableGraphicsView::rendersOverlayInTiles(widget))
+            return;
+
+        painter->setPen(pen());
+        painter->setBrush(Qt::NoBrush);
+        painter->drawPolygon(polygon(), fillRule());
+
+        if (option->state & QStyle::State_Selected) {
+            painter->setPen(QPen(option->palette.windowText(), 0.0, Qt::DashLine));
+            painter->drawRect(boundingRect());
+        }
+    }
+
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override
+    {
+        if (change == QGraphicsItem::ItemSceneChange && scene()) {
+            PolygonFillLayer::invalidate(scene(), sceneBoundingRect());
+        } else if (change == QGraphicsItem::ItemSceneHasChanged && scene()) {
+            PolygonFillLayer::attach(scene());
+            PolygonFillLayer::invalidate(scene(), sceneBoundingRect());
+        } else if (change == QGraphicsItem::ItemVisibleHasChanged && scene()) {
+            PolygonFillLayer::invalidate(scene(), sceneBoundingRect());
+        }
+        return QGraphicsPolygonItem::itemChange(change, value);
+    }
 };
 } // namespace
 
@@ -56,6 +103,15 @@ Polygon::Polygon(int id,
 
 Polygon::~Polygon()
 {
+    if (m_meshValidator)
+        m_meshValidator->untrackPolygon(this);
+
+    if (m_halfEdgeMesh)
+        m_halfEdgeMesh->untrackPolygon(this);
+
+    if (m_spatialIndex)
+        m_spatialIndex->remove(this);
+
     detachFromLines();
     detachFromVertices();
 
@@ -86,8 +142,50 @@ QGraphicsItem *Polygon::graphicsItem() const
     return m_item;
 }
 
+void Polygon::setSpatialIndex(PolygonSpatialIndex *index)
+{
+    if (m_spatialIndex == index)
+        return;
+
+    if (m_spatialIndex)
+        m_spatialIndex->remove(this);
+
+    m_spatialIndex = index;
+    if (m_spatialIndex)
+        m_spatialIndex->insert(this);
+}
+
+void Polygon::setMeshValidator(MeshValidator *validator)
+{
+    if (m_meshValidator == validator)
+        return;
+
+    if (m_meshValidator)
+        m_meshValidator->untrackPolygon(this);
+
+    m_meshValidator = validator;
+    if (m_meshValidator)
+        m_meshValidator->trackPolygon(this);
+}
+
+void Polygon::setHalfEdgeMesh(HalfEdgeMesh *mesh)
+{
+    if (m_halfEdgeMesh == mesh)
+        return;
+
+    if (m_halfEdgeMesh)
+        m_halfEdgeMesh->untrackPolygon(this);
+
+    m_halfEdgeMesh = mesh;
+    if (m_halfEdgeMesh)
+        m_halfEdgeMesh->trackPolygon(this);
+}
+
 void Polygon::updateShape()
 {
+    if (m_spatialIndex)
+        m_spatialIndex->markChanged(this);
+
     if (!m_item)
         return;
 
@@ -103,7 +201,7 @@ void Polygon::updateShape()
         polygon << position;
     }
 
-    static_cast<QGraphicsPolygonItem *>(m_item)->setPolygon(polygon);
+    static_cast<PolygonGraphicsItem *>(m_item)->setOutline(polygon);
 }
 
 bool Polygon::involvesVertex(const Vertex *vertex) const
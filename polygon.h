@@ -8,6 +8,9 @@ class QGraphicsItem;
 class QGraphicsScene;
 class Vertex;
 class Line;
+class PolygonSpatialIndex;
+class MeshValidator;
+class HalfEdgeMesh;
 
 class Polygon
 {
@@ -23,6 +26,9 @@ public:
     const std::vector<Line *> &lines() const;
     QGraphicsItem *graphicsItem() const;
 
+    void setSpatialIndex(PolygonSpatialIndex *index);
+    void setMeshValidator(MeshValidator *validator);
+    void setHalfEdgeMesh(HalfEdgeMesh *mesh);
     void updateShape();
     bool involvesVertex(const Vertex *vertex) const;
     bool involvesLine(const Line *line) const;
@@ -40,6 +46,9 @@ private:
     std::vector<Line *> m_lines;
     QGraphicsScene *m_scene = nullptr;
     QGraphicsItem *m_item = nullptr;
+    PolygonSpatialIndex *m_spatialIndex = nullptr;
+    MeshValidator *m_meshValidator = nullptr;
+    HalfEdgeMesh *m_halfEdgeMesh = nullptr;
     QColor m_color;
 };
 
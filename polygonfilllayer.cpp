@@ -0,0 +1,243 @@
+#include "polygonfilllayer.h"
+
+#include "zoomablegraphicsview.h"
+
+#include <QGraphicsPolygonItem>
+#include <QGraphicsScene>
+#include <QList>
+#include <QPainter>
+#include <QPainterPath>
+#include <QStyleOptionGraphicsItem>
+#include <QTransform>
+#include <QWidget>
+#include <QtMath>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr int kTileSize = 256;
+constexpr int kMaximumCachedTiles = 128;
+// Just below the polygon items (0.25), so fills sit under every outline but
+// above the background image.
+constexpr qreal kFillLayerZValue = 0.2;
+
+QHash<const QGraphicsScene *, PolygonFillLayer *> &layersByScene()
+{
+    static QHash<const QGraphicsScene *, PolygonFillLayer *> layers;
+    return layers;
+}
+
+int tileIndex(qreal deviceCoordinate)
+{
+    return static_cast<int>(std::floor(deviceCoordinate / kTileSize));
+}
+} // namespace
+
+PolygonFillLayer::PolygonFillLayer()
+{
+    setZValue(kFillLayerZValue);
+    setAcceptedMouseButtons(Qt::NoButton);
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+PolygonFillLayer::~PolygonFillLayer()
+{
+    auto &layers = layersByScene();
+    for (auto it = layers.begin(); it != layers.end(); ++it) {
+        if (it.value() == this) {
+            layers.erase(it);
+            break;
+        }
+    }
+}
+
+PolygonFillLayer *PolygonFillLayer::attach(QGraphicsScene *scene)
+{
+    if (!scene)
+        return nullptr;
+
+    PolygonFillLayer *&layer = layersByScene()[scene];
+    if (!layer) {
+        layer = new PolygonFillLayer;
+        scene->addItem(layer);
+    }
+    return layer;
+}
+
+void PolygonFillLayer::invalidate(QGraphicsScene *scene, const QRectF &sceneRect)
+{
+    if (PolygonFillLayer *layer = layersByScene().value(scene, nullptr))
+        layer->invalidateRect(sceneRect);
+}
+
+int PolygonFillLayer::type() const
+{
+    return Type;
+}
+
+QRectF PolygonFillLayer::boundingRect() const
+{
+    return m_bounds;
+}
+
+QPainterPath PolygonFillLayer::shape() const
+{
+    return QPainterPath();
+}
+
+bool PolygonFillLayer::contains(const QPointF &point) const
+{
+    Q_UNUSED(point);
+    return false;
+}
+
+void PolygonFillLayer::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    if (!widget) {
+        // Exports and other offscreen renders draw straight from the items.
+        paintFills(painter, option->exposedRect);
+        return;
+    }
+
+    if (ZoomableGraphicsView::rendersOverlayInTiles(widget))
+        return;
+
+    const QTransform transform = painter->worldTransform();
+    if (transform.type() > QTransform::TxScale || !qFuzzyCompare(transform.m11(), transform.m22())) {
+        paintFills(painter, option->exposedRect);
+        return;
+    }
+
+    const qreal devicePixelRatio = widget->devicePixelRatioF();
+    if (!qFuzzyCompare(transform.m11(), m_scale) || !qFuzzyCompare(devicePixelRatio, m_devicePixelRatio)) {
+        m_tiles.clear();
+        m_scale = transform.m11();
+        m_devicePixelRatio = devicePixelRatio;
+    }
+
+    ++m_frame;
+
+    const QPointF deviceOffset(transform.dx(), transform.dy());
+    const QRectF exposedRect = option->exposedRect.intersected(m_bounds);
+    if (exposedRect.isEmpty())
+        return;
+
+    const QRectF deviceRect = transform.mapRect(exposedRect);
+    const int firstColumn = tileIndex(deviceRect.left() - deviceOffset.x());
+    const int lastColumn = tileIndex(deviceRect.right() - deviceOffset.x());
+    const int firstRow = tileIndex(deviceRect.top() - deviceOffset.y());
+    const int lastRow = tileIndex(deviceRect.bottom() - deviceOffset.y());
+
+    painter->save();
+    painter->resetTransform();
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const QPoint key(column, row);
+            Tile &tile = m_tiles[key];
+            tile.lastUsedFrame = m_frame;
+            if (tile.dirty)
+                renderTile(key, tile, devicePixelRatio);
+
+            painter->drawImage(QPoint(qRound(column * kTileSize + deviceOffset.x()),
+                                      qRound(row * kTileSize + deviceOffset.y())),
+                               tile.image);
+        }
+    }
+    painter->restore();
+
+    evictTiles();
+}
+
+void PolygonFillLayer::invalidateRect(const QRectF &sceneRect)
+{
+    if (sceneRect.isEmpty())
+        return;
+
+    if (!m_bounds.contains(sceneRect)) {
+        prepareGeometryChange();
+        m_bounds = m_bounds.united(sceneRect);
+    }
+
+    if (m_tiles.isEmpty() || m_scale <= 0.0)
+        return;
+
+    // One device pixel of slack covers antialiased polygon edges.
+    const QRectF deviceRect = QRectF(sceneRect.topLeft() * m_scale, sceneRect.bottomRight() * m_scale)
+                                  .adjusted(-1.0, -1.0, 1.0, 1.0);
+    const int firstColumn = tileIndex(deviceRect.left());
+    const int lastColumn = tileIndex(deviceRect.right());
+    const int firstRow = tileIndex(deviceRect.top());
+    const int lastRow = tileIndex(deviceRect.bottom());
+
+    for (auto it = m_tiles.begin(); it != m_tiles.end(); ++it) {
+        const QPoint &key = it.key();
+        if (key.x() >= firstColumn && key.x() <= lastColumn && key.y() >= firstRow && key.y() <= lastRow)
+            it->dirty = true;
+    }
+}
+
+void PolygonFillLayer::paintFills(QPainter *painter, const QRectF &sceneRect) const
+{
+    if (!scene())
+        return;
+
+    const QList<QGraphicsItem *> items = scene()->items(sceneRect, Qt::IntersectsItemBoundingRect, Qt::AscendingOrder);
+
+    painter->save();
+    painter->setPen(Qt::NoPen);
+    for (QGraphicsItem *item : items) {
+        auto *polygonItem = qgraphicsitem_cast<QGraphicsPolygonItem *>(item);
+        if (!polygonItem || !polygonItem->isVisible())
+            continue;
+
+        painter->setBrush(polygonItem->brush());
+        painter->drawPolygon(polygonItem->mapToScene(polygonItem->polygon()), polygonItem->fillRule());
+    }
+    painter->restore();
+}
+
+void PolygonFillLayer::renderTile(const QPoint &key, Tile &tile, qreal devicePixelRatio) const
+{
+    const int pixelSize = qCeil(kTileSize * devicePixelRatio);
+    if (tile.image.isNull() || tile.image.width() != pixelSize) {
+        tile.image = QImage(pixelSize, pixelSize, QImage::Format_ARGB32_Premultiplied);
+        tile.image.setDevicePixelRatio(devicePixelRatio);
+    }
+    tile.image.fill(Qt::transparent);
+
+    const qreal sceneTileSize = kTileSize / m_scale;
+    const QRectF tileSceneRect(key.x() * sceneTileSize, key.y() * sceneTileSize, sceneTileSize, sceneTileSize);
+
+    QPainter tilePainter(&tile.image);
+    tilePainter.setRenderHint(QPainter::Antialiasing);
+    tilePainter.setTransform(QTransform(m_scale, 0.0, 0.0, m_scale, -key.x() * kTileSize, -key.y() * kTileSize));
+    paintFills(&tilePainter, tileSceneRect);
+
+    tile.dirty = false;
+}
+
+void PolygonFillLayer::evictTiles()
+{
+    if (m_tiles.size() <= kMaximumCachedTiles)
+        return;
+
+    std::vector<std::pair<quint64, QPoint>> candidates;
+    candidates.reserve(static_cast<std::size_t>(m_tiles.size()));
+    for (auto it = m_tiles.cbegin(); it != m_tiles.cend(); ++it) {
+        if (it->lastUsedFrame != m_frame)
+            candidates.emplace_back(it->lastUsedFrame, it.key());
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    for (const auto &candidate : candidates) {
+        if (m_tiles.size() <= kMaximumCachedTiles)
+            break;
+        m_tiles.remove(candidate.second);
+    }
+}
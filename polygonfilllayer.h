@@ -0,0 +1,53 @@
+#ifndef POLYGONFILLLAYER_H
+#define POLYGONFILLLAYER_H
+
+#include <QGraphicsItem>
+#include <QHash>
+#include <QImage>
+#include <QPoint>
+#include <QRectF>
+
+class QGraphicsScene;
+
+// Draws the translucent fills of all polygon items in a scene from a cache of
+// device-resolution tiles. Polygon items only paint their outlines and report
+// shape changes, so a repaint re-renders just the tiles those changes touched.
+class PolygonFillLayer : public QGraphicsItem
+{
+public:
+    enum { Type = UserType + 3 };
+
+    ~PolygonFillLayer() override;
+
+    static PolygonFillLayer *attach(QGraphicsScene *scene);
+    static void invalidate(QGraphicsScene *scene, const QRectF &sceneRect);
+
+    int type() const override;
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;
+    bool contains(const QPointF &point) const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    struct Tile
+    {
+        QImage image;
+        bool dirty = true;
+        quint64 lastUsedFrame = 0;
+    };
+
+    PolygonFillLayer();
+
+    void invalidateRect(const QRectF &sceneRect);
+    void paintFills(QPainter *painter, const QRectF &sceneRect) const;
+    void renderTile(const QPoint &key, Tile &tile, qreal devicePixelRatio) const;
+    void evictTiles();
+
+    QRectF m_bounds;
+    QHash<QPoint, Tile> m_tiles;
+    qreal m_scale = 0.0;
+    qreal m_devicePixelRatio = 1.0;
+    quint64 m_frame = 0;
+};
+
+#endif // POLYGONFILLLAYER_H
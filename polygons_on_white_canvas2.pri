@@ -0,0 +1,74 @@
+# Everything but main(), shared by the application, benchmarks/ and tests/.
+
+SOURCES += \
+    $$PWD/mainwindow.cpp \
+    $$PWD/binaryimage.cpp \
+    $$PWD/contourpreprocessor.cpp \
+    $$PWD/distancetransform.cpp \
+    $$PWD/junctiondetector.cpp \
+    $$PWD/labelimage.cpp \
+    $$PWD/labelmesh.cpp \
+    $$PWD/line.cpp \
+    $$PWD/meshgeometry.cpp \
+    $$PWD/meshvalidator.cpp \
+    $$PWD/vertex.cpp \
+    $$PWD/polygon.cpp \
+    $$PWD/crossingdetector.cpp \
+    $$PWD/crossingguard.cpp \
+    $$PWD/pixelcomponents.cpp \
+    $$PWD/polygonfilllayer.cpp \
+    $$PWD/polygonspatialindex.cpp \
+    $$PWD/skeletonizer.cpp \
+    $$PWD/skeletonoverlayitem.cpp \
+    $$PWD/skeletontracer.cpp \
+    $$PWD/stressbenchmark.cpp \
+    $$PWD/vertexgraphicsitem.cpp \
+    $$PWD/vertexspatialindex.cpp \
+    $$PWD/voronoitissue.cpp \
+    $$PWD/watershed.cpp \
+    $$PWD/faceextractor.cpp \
+    $$PWD/halfedgemesh.cpp \
+    $$PWD/imageloader.cpp \
+    $$PWD/linegraphicsitem.cpp \
+    $$PWD/linespatialindex.cpp \
+    $$PWD/overlaytilerenderer.cpp \
+    $$PWD/zoomablegraphicsview.cpp
+
+HEADERS += \
+    $$PWD/mainwindow.h \
+    $$PWD/binaryimage.h \
+    $$PWD/contourpreprocessor.h \
+    $$PWD/distancetransform.h \
+    $$PWD/junctiondetector.h \
+    $$PWD/labelimage.h \
+    $$PWD/labelmesh.h \
+    $$PWD/line.h \
+    $$PWD/meshgeometry.h \
+    $$PWD/meshvalidator.h \
+    $$PWD/planarmesh.h \
+    $$PWD/vertex.h \
+    $$PWD/polygon.h \
+    $$PWD/crossingdetector.h \
+    $$PWD/crossingguard.h \
+    $$PWD/pixelcomponents.h \
+    $$PWD/polygonfilllayer.h \
+    $$PWD/polygonspatialindex.h \
+    $$PWD/skeletonizer.h \
+    $$PWD/skeletonoverlayitem.h \
+    $$PWD/skeletontracer.h \
+    $$PWD/stressbenchmark.h \
+    $$PWD/stripes.h \
+    $$PWD/vertexgraphicsitem.h \
+    $$PWD/vertexspatialindex.h \
+    $$PWD/voronoitissue.h \
+    $$PWD/watershed.h \
+    $$PWD/faceextractor.h \
+    $$PWD/halfedgemesh.h \
+    $$PWD/imageloader.h \
+    $$PWD/linegraphicsitem.h \
+    $$PWD/linespatialindex.h \
+    $$PWD/overlaytilerenderer.h \
+    $$PWD/zoomablegraphicsview.h
+
+FORMS += \
+    $$PWD/mainwindow.ui
@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -8,23 +8,22 @@ CONFIG += c++17
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+include(polygons_on_white_canvas2.pri)
+
 SOURCES += \
-    main.cpp \
-    mainwindow.cpp \
-    line.cpp \
-    vertex.cpp \
-    polygon.cpp \
-    zoomablegraphicsview.cpp
-
-HEADERS += \
-    mainwindow.h \
-    line.h \
-    vertex.h \
-    polygon.h \
-    zoomablegraphicsview.h
-
-FORMS += \
-    mainwindow.ui
+    main.cpp
+
+# "make microbenchmarks" builds benchmarks/microbenchmarks.pro next to the app.
+microbenchmarks.commands = $(MKDIR) $$shell_path($$OUT_PWD/benchmarks) && \
+    cd $$shell_path($$OUT_PWD/benchmarks) && \
+    $$QMAKE_QMAKE $$shell_path($$PWD/benchmarks/microbenchmarks.pro) && $(MAKE)
+QMAKE_EXTRA_TARGETS += microbenchmarks
+
+# "make check" builds and runs every test in tests/tests.pro.
+check.commands = $(MKDIR) $$shell_path($$OUT_PWD/tests) && \
+    cd $$shell_path($$OUT_PWD/tests) && \
+    $$QMAKE_QMAKE $$shell_path($$PWD/tests/tests.pro) && $(MAKE) check
+QMAKE_EXTRA_TARGETS += check
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
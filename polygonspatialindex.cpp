@@ -0,0 +1,242 @@
+#include "polygonspatialindex.h"
+
+#include "polygon.h"
+#include "vertex.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr int kNodeCapacity = 16;
+constexpr std::size_t kPointsPerTask = 4096;
+
+QPointF centerOf(const QRectF &rect)
+{
+    return rect.center();
+}
+
+bool boundsContain(const QRectF &bounds, const QPointF &position)
+{
+    return position.x() >= bounds.left() && position.x() <= bounds.right() && position.y() >= bounds.top()
+           && position.y() <= bounds.bottom();
+}
+
+// Orders [begin, end) so that consecutive runs of kNodeCapacity items are
+// spatially compact: vertical slices by x, then y within each slice.
+template<typename Iterator, typename BoundsOf>
+void sortTileRecursive(Iterator begin, Iterator end, BoundsOf boundsOf)
+{
+    const auto count = static_cast<std::size_t>(std::distance(begin, end));
+    if (count <= static_cast<std::size_t>(kNodeCapacity))
+        return;
+
+    std::sort(begin, end, [&](const auto &lhs, const auto &rhs) {
+        return centerOf(boundsOf(lhs)).x() < centerOf(boundsOf(rhs)).x();
+    });
+
+    const std::size_t nodeCount = (count + kNodeCapacity - 1) / kNodeCapacity;
+    const auto sliceCount = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(nodeCount))));
+    const std::size_t sliceSize = sliceCount * kNodeCapacity;
+
+    for (std::size_t offset = 0; offset < count; offset += sliceSize) {
+        const Iterator sliceBegin = begin + static_cast<std::ptrdiff_t>(offset);
+        const Iterator sliceEnd = begin + static_cast<std::ptrdiff_t>(std::min(count, offset + sliceSize));
+        std::sort(sliceBegin, sliceEnd, [&](const auto &lhs, const auto &rhs) {
+            return centerOf(boundsOf(lhs)).y() < centerOf(boundsOf(rhs)).y();
+        });
+    }
+}
+
+// Signed test of position against the directed edge start -> end:
+// > 0 left of the edge, < 0 right of it, 0 on the supporting line.
+qreal isLeft(const QPointF &start, const QPointF &end, const QPointF &position)
+{
+    return (end.x() - start.x()) * (position.y() - start.y()) - (position.x() - start.x()) * (end.y() - start.y());
+}
+} // namespace
+
+void PolygonSpatialIndex::insert(Polygon *polygon)
+{
+    if (polygon && m_polygons.insert(polygon).second)
+        m_dirty = true;
+}
+
+void PolygonSpatialIndex::remove(Polygon *polygon)
+{
+    if (m_polygons.erase(polygon) > 0)
+        m_dirty = true;
+}
+
+void PolygonSpatialIndex::markChanged(Polygon *polygon)
+{
+    if (m_polygons.count(polygon))
+        m_dirty = true;
+}
+
+void PolygonSpatialIndex::clear()
+{
+    m_polygons.clear();
+    m_entries.clear();
+    m_nodes.clear();
+    m_root = -1;
+    m_dirty = false;
+}
+
+std::size_t PolygonSpatialIndex::size() const
+{
+    return m_polygons.size();
+}
+
+Polygon *PolygonSpatialIndex::polygonAt(const QPointF &position) const
+{
+    rebuildIfNeeded();
+    const Entry *entry = entryAt(position);
+    return entry ? entry->polygon : nullptr;
+}
+
+std::vector<int> PolygonSpatialIndex::polygonIdsAt(const std::vector<QPointF> &positions) const
+{
+    rebuildIfNeeded();
+
+    std::vector<int> ids(positions.size(), -1);
+    if (positions.empty() || m_root < 0)
+        return ids;
+
+    std::vector<std::size_t> taskOffsets;
+    taskOffsets.reserve(positions.size() / kPointsPerTask + 1);
+    for (std::size_t offset = 0; offset < positions.size(); offset += kPointsPerTask)
+        taskOffsets.push_back(offset);
+
+    // The snapshot is read-only from here on, so tasks share it without locking.
+    QtConcurrent::blockingMap(taskOffsets, [this, &positions, &ids](const std::size_t &offset) {
+        const std::size_t end = std::min(positions.size(), offset + kPointsPerTask);
+        for (std::size_t i = offset; i < end; ++i) {
+            if (const Entry *entry = entryAt(positions[i]))
+                ids[i] = entry->id;
+        }
+    });
+
+    return ids;
+}
+
+bool PolygonSpatialIndex::windingContains(const QPolygonF &ring, const QPointF &position)
+{
+    const int count = static_cast<int>(ring.size());
+    if (count < 3)
+        return false;
+
+    int winding = 0;
+    for (int i = 0; i < count; ++i) {
+        const QPointF &start = ring.at(i);
+        const QPointF &end = ring.at((i + 1) % count);
+        if (start.y() <= position.y()) {
+            if (end.y() > position.y() && isLeft(start, end, position) > 0.0)
+                ++winding;
+        } else if (end.y() <= position.y() && isLeft(start, end, position) < 0.0) {
+            --winding;
+        }
+    }
+    return winding != 0;
+}
+
+void PolygonSpatialIndex::rebuildIfNeeded() const
+{
+    if (!m_dirty)
+        return;
+
+    m_entries.clear();
+    m_nodes.clear();
+    m_root = -1;
+    m_dirty = false;
+
+    m_entries.reserve(m_polygons.size());
+    for (Polygon *polygon : m_polygons) {
+        Entry entry;
+        entry.polygon = polygon;
+        entry.id = polygon->id();
+        entry.ring.reserve(static_cast<int>(polygon->vertices().size()));
+        for (const Vertex *vertex : polygon->vertices()) {
+            if (vertex)
+                entry.ring << vertex->position();
+        }
+        if (entry.ring.size() < 3)
+            continue;
+        entry.bounds = entry.ring.boundingRect();
+        m_entries.push_back(std::move(entry));
+    }
+
+    if (m_entries.empty())
+        return;
+
+    sortTileRecursive(m_entries.begin(), m_entries.end(), [](const Entry &entry) -> const QRectF & {
+        return entry.bounds;
+    });
+
+    for (std::size_t first = 0; first < m_entries.size(); first += kNodeCapacity) {
+        Node leaf;
+        leaf.first = static_cast<int>(first);
+        leaf.count = static_cast<int>(std::min<std::size_t>(kNodeCapacity, m_entries.size() - first));
+        leaf.bounds = m_entries[first].bounds;
+        for (int i = 1; i < leaf.count; ++i)
+            leaf.bounds = leaf.bounds.united(m_entries[first + i].bounds);
+        m_nodes.push_back(leaf);
+    }
+
+    // Each level is packed the same way until a single root remains. A level's
+    // nodes are reordered before their parents are created, so children of a
+    // parent always occupy a contiguous range.
+    std::size_t levelBegin = 0;
+    std::size_t levelEnd = m_nodes.size();
+    while (levelEnd - levelBegin > 1) {
+        sortTileRecursive(m_nodes.begin() + static_cast<std::ptrdiff_t>(levelBegin),
+                          m_nodes.begin() + static_cast<std::ptrdiff_t>(levelEnd),
+                          [](const Node &node) -> const QRectF & { return node.bounds; });
+
+        for (std::size_t first = levelBegin; first < levelEnd; first += kNodeCapacity) {
+            Node parent;
+            parent.leaf = false;
+            parent.first = static_cast<int>(first);
+            parent.count = static_cast<int>(std::min<std::size_t>(kNodeCapacity, levelEnd - first));
+            parent.bounds = m_nodes[first].bounds;
+            for (int i = 1; i < parent.count; ++i)
+                parent.bounds = parent.bounds.united(m_nodes[first + i].bounds);
+            m_nodes.push_back(parent);
+        }
+
+        levelBegin = levelEnd;
+        levelEnd = m_nodes.size();
+    }
+
+    m_root = static_cast<int>(levelBegin);
+}
+
+const PolygonSpatialIndex::Entry *PolygonSpatialIndex::entryAt(const QPointF &position) const
+{
+    if (m_root < 0)
+        return nullptr;
+
+    int stack[256];
+    int depth = 0;
+    stack[depth++] = m_root;
+
+    while (depth > 0) {
+        const Node &node = m_nodes[static_cast<std::size_t>(stack[--depth])];
+        if (!boundsContain(node.bounds, position))
+            continue;
+
+        if (node.leaf) {
+            for (int i = node.first; i < node.first + node.count; ++i) {
+                const Entry &entry = m_entries[static_cast<std::size_t>(i)];
+                if (boundsContain(entry.bounds, position) && windingContains(entry.ring, position))
+                    return &entry;
+            }
+        } else {
+            for (int i = node.first; i < node.first + node.count; ++i)
+                stack[depth++] = i;
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,58 @@
+#ifndef POLYGONSPATIALINDEX_H
+#define POLYGONSPATIALINDEX_H
+
+#include <QPointF>
+#include <QPolygonF>
+#include <QRectF>
+
+#include <unordered_set>
+#include <vector>
+
+class Polygon;
+
+// Bounding-box R-tree over polygons with an exact winding-number test for
+// point location. The tree is bulk-loaded (sort-tile-recursive) from a
+// snapshot of the polygon outlines and rebuilt lazily after polygons change,
+// so the query methods may run concurrently once the snapshot is current.
+class PolygonSpatialIndex
+{
+public:
+    void insert(Polygon *polygon);
+    void remove(Polygon *polygon);
+    void markChanged(Polygon *polygon);
+    void clear();
+    std::size_t size() const;
+
+    Polygon *polygonAt(const QPointF &position) const;
+    std::vector<int> polygonIdsAt(const std::vector<QPointF> &positions) const;
+
+    static bool windingContains(const QPolygonF &ring, const QPointF &position);
+
+private:
+    struct Entry
+    {
+        Polygon *polygon = nullptr;
+        int id = -1;
+        QRectF bounds;
+        QPolygonF ring;
+    };
+
+    struct Node
+    {
+        QRectF bounds;
+        int first = 0;
+        int count = 0;
+        bool leaf = true;
+    };
+
+    void rebuildIfNeeded() const;
+    const Entry *entryAt(const QPointF &position) const;
+
+    std::unordered_set<Polygon *> m_polygons;
+    mutable bool m_dirty = true;
+    mutable std::vector<Entry> m_entries;
+    mutable std::vector<Node> m_nodes;
+    mutable int m_root = -1;
+};
+
+#endif // POLYGONSPATIALINDEX_H
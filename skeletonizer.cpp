@@ -0,0 +1,123 @@
+#include "skeletonizer.h"
+
+#include "stripes.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <atomic>
+
+namespace {
+// Neighbour words of a row: bit b of west(...) is the pixel left of bit b.
+quint64 west(const quint64 *row, int w)
+{
+    return (row[w] << 1) | (w > 0 ? row[w - 1] >> 63 : 0);
+}
+
+quint64 east(const quint64 *row, int w, int wordsPerRow)
+{
+    return (row[w] >> 1) | (w + 1 < wordsPerRow ? row[w + 1] << 63 : 0);
+}
+
+quint64 atLeastTwo(quint64 a, quint64 b, quint64 c, quint64 d)
+{
+    return (a & b) | (c & d) | ((a | b) & (c | d));
+}
+
+// Pixels of center that the given subiteration deletes. p0..p7 are the
+// neighbours E, NE, N, NW, W, SW, S, SE.
+quint64 deletablePixels(quint64 center, const quint64 (&p)[8], bool firstSubiteration)
+{
+    // G1: exactly one 4-connected run of neighbours (Hilditch crossing number 1).
+    const quint64 t0 = ~p[0] & (p[1] | p[2]);
+    const quint64 t1 = ~p[2] & (p[3] | p[4]);
+    const quint64 t2 = ~p[4] & (p[5] | p[6]);
+    const quint64 t3 = ~p[6] & (p[7] | p[0]);
+    const quint64 g1 = (t0 | t1 | t2 | t3) & ~atLeastTwo(t0, t1, t2, t3);
+
+    // G2: 2 <= min(N1, N2) <= 3, counting occupied neighbour pairs.
+    const quint64 a1 = p[1] | p[0];
+    const quint64 a3 = p[3] | p[2];
+    const quint64 a5 = p[5] | p[4];
+    const quint64 a7 = p[7] | p[6];
+    const quint64 b1 = p[1] | p[2];
+    const quint64 b3 = p[3] | p[4];
+    const quint64 b5 = p[5] | p[6];
+    const quint64 b7 = p[7] | p[0];
+    const quint64 g2 = atLeastTwo(a1, a3, a5, a7) & atLeastTwo(b1, b3, b5, b7)
+                       & (~(a1 & a3 & a5 & a7) | ~(b1 & b3 & b5 & b7));
+
+    // G3 / G3': keep the south-east (resp. north-west) boundary for the
+    // other subiteration.
+    const quint64 g3 = firstSubiteration ? ~((p[1] | p[2] | ~p[7]) & p[0]) : ~((p[5] | p[6] | ~p[3]) & p[4]);
+
+    return center & g1 & g2 & g3;
+}
+
+// One subiteration over rows [stripe.first, stripe.end) from source into
+// target; returns whether anything was deleted.
+bool thinStripe(const BinaryImage &source, BinaryImage &target, const Stripe &stripe, bool firstSubiteration)
+{
+    const int wordsPerRow = source.wordsPerRow();
+    const std::vector<quint64> zeroRow(static_cast<std::size_t>(wordsPerRow), 0);
+    bool changed = false;
+
+    for (int y = stripe.first; y < stripe.end; ++y) {
+        const quint64 *above = y > 0 ? source.row(y - 1) : zeroRow.data();
+        const quint64 *current = source.row(y);
+        const quint64 *below = y + 1 < source.height() ? source.row(y + 1) : zeroRow.data();
+        quint64 *output = target.row(y);
+
+        for (int w = 0; w < wordsPerRow; ++w) {
+            const quint64 center = current[w];
+            if (center == 0) {
+                output[w] = 0;
+                continue;
+            }
+
+            const quint64 neighbours[8] = {east(current, w, wordsPerRow),
+                                           east(above, w, wordsPerRow),
+                                           above[w],
+                                           west(above, w),
+                                           west(current, w),
+                                           west(below, w),
+                                           below[w],
+                                           east(below, w, wordsPerRow)};
+            const quint64 deleted = deletablePixels(center, neighbours, firstSubiteration);
+            output[w] = center & ~deleted;
+            changed = changed || deleted != 0;
+        }
+    }
+    return changed;
+}
+} // namespace
+
+BinaryImage thinToSkeleton(const BinaryImage &image)
+{
+    if (image.isNull())
+        return image;
+
+    // More stripes than cores, so that stripes with more foreground do not
+    // leave cores idle.
+    const std::vector<Stripe> stripes = makeStripes(image.height());
+
+    // Each subiteration reads one buffer and writes the other, so stripes
+    // never see each other's deletions before the subiteration ends.
+    BinaryImage current = image;
+    BinaryImage next(image.width(), image.height());
+    for (;;) {
+        bool changed = false;
+        for (const bool firstSubiteration : {true, false}) {
+            std::atomic<bool> subiterationChanged{false};
+            QtConcurrent::blockingMap(stripes, [&](const Stripe &stripe) {
+                if (thinStripe(current, next, stripe, firstSubiteration))
+                    subiterationChanged.store(true, std::memory_order_relaxed);
+            });
+            std::swap(current, next);
+            changed = changed || subiterationChanged.load();
+        }
+        if (!changed)
+            break;
+    }
+    return current;
+}
@@ -0,0 +1,12 @@
+#ifndef SKELETONIZER_H
+#define SKELETONIZER_H
+
+#include "binaryimage.h"
+
+// Thins the foreground of image to an 8-connected, one pixel wide skeleton
+// with the two-subiteration algorithm of Guo and Hall (1989). Each
+// subiteration evaluates 64 pixels at a time on the packed words, and row
+// stripes are processed on all cores.
+BinaryImage thinToSkeleton(const BinaryImage &image);
+
+#endif // SKELETONIZER_H
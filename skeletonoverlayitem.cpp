@@ -0,0 +1,107 @@
+#include "skeletonoverlayitem.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QPainterPath>
+#include <QStyleOptionGraphicsItem>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace {
+// Above the background image (-1), below the polygon fills (0.2).
+constexpr qreal kOverlayZValue = -0.5;
+
+// Whether any bit in [first, first + count) of the packed row is set.
+bool anyBitSet(const quint64 *row, int first, int count)
+{
+    int x = first;
+    const int end = first + count;
+    while (x < end) {
+        const int bit = x % 64;
+        const int span = std::min(64 - bit, end - x);
+        const quint64 mask = span == 64 ? ~quint64(0) : ((quint64(1) << span) - 1) << bit;
+        if (row[x / 64] & mask)
+            return true;
+        x += span;
+    }
+    return false;
+}
+} // namespace
+
+SkeletonOverlayItem::SkeletonOverlayItem(BinaryImage image, const QColor &color)
+    : m_image(std::move(image))
+    , m_color(color)
+{
+    setZValue(kOverlayZValue);
+    setAcceptedMouseButtons(Qt::NoButton);
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+}
+
+const BinaryImage &SkeletonOverlayItem::image() const
+{
+    return m_image;
+}
+
+int SkeletonOverlayItem::type() const
+{
+    return Type;
+}
+
+QRectF SkeletonOverlayItem::boundingRect() const
+{
+    return QRectF(0.0, 0.0, m_image.width(), m_image.height());
+}
+
+QPainterPath SkeletonOverlayItem::shape() const
+{
+    return QPainterPath();
+}
+
+bool SkeletonOverlayItem::contains(const QPointF &point) const
+{
+    Q_UNUSED(point);
+    return false;
+}
+
+void SkeletonOverlayItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    const QRect source = option->exposedRect.toAlignedRect() & boundingRect().toRect();
+    if (source.isEmpty())
+        return;
+
+    // When zoomed out, each screen pixel covers a block of step x step image
+    // pixels and is lit if any of them is set, so thin lines never vanish.
+    const qreal levelOfDetail = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    const int step = std::max(1, static_cast<int>(std::floor(1.0 / std::max(levelOfDetail, 1e-6))));
+
+    QImage raster((source.width() + step - 1) / step, (source.height() + step - 1) / step, QImage::Format_ARGB32_Premultiplied);
+    raster.fill(Qt::transparent);
+    const QRgb color = m_color.rgba();
+
+    std::vector<quint64> blockRow(static_cast<std::size_t>(m_image.wordsPerRow()));
+    for (int rasterY = 0; rasterY < raster.height(); ++rasterY) {
+        const int firstRow = source.top() + rasterY * step;
+        const int endRow = std::min(firstRow + step, source.bottom() + 1);
+        std::fill(blockRow.begin(), blockRow.end(), 0);
+        for (int y = firstRow; y < endRow; ++y) {
+            const quint64 *row = m_image.row(y);
+            for (int w = source.left() / 64; w <= source.right() / 64; ++w)
+                blockRow[static_cast<std::size_t>(w)] |= row[w];
+        }
+
+        auto *pixels = reinterpret_cast<QRgb *>(raster.scanLine(rasterY));
+        for (int rasterX = 0; rasterX < raster.width(); ++rasterX) {
+            const int firstColumn = source.left() + rasterX * step;
+            const int count = std::min(step, source.right() + 1 - firstColumn);
+            if (anyBitSet(blockRow.data(), firstColumn, count))
+                pixels[rasterX] = color;
+        }
+    }
+
+    painter->drawImage(QRectF(source.topLeft(), QSizeF(raster.width() * step, raster.height() * step)), raster);
+}
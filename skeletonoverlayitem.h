@@ -0,0 +1,32 @@
+#ifndef SKELETONOVERLAYITEM_H
+#define SKELETONOVERLAYITEM_H
+
+#include "binaryimage.h"
+
+#include <QColor>
+#include <QGraphicsItem>
+
+// Shows a binary image (such as a skeleton) over the background image, one
+// scene unit per pixel. Only the exposed part is rasterised, at screen
+// resolution, so huge images cost no more to draw than the view shows.
+class SkeletonOverlayItem : public QGraphicsItem
+{
+public:
+    enum { Type = UserType + 4 };
+
+    explicit SkeletonOverlayItem(BinaryImage image, const QColor &color = QColor(255, 64, 160));
+
+    const BinaryImage &image() const;
+
+    int type() const override;
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;
+    bool contains(const QPointF &point) const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    BinaryImage m_image;
+    QColor m_color;
+};
+
+#endif // SKELETONOVERLAYITEM_H
@@ -0,0 +1,303 @@
+#include "skeletontracer.h"
+
+#include "junctiondetector.h"
+#include "pixelcomponents.h"
+
+#include <QLineF>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <numeric>
+
+namespace {
+constexpr int kNeighbourOffsets[8][2] = {{1, 0}, {1, -1}, {0, -1}, {-1, -1}, {-1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+// A branch as traced, before pruning; end is -1 for a free end.
+struct TracedBranch
+{
+    int start = -1;
+    int end = -1;
+    qreal length = 0.0;
+    QPointF freeEnd;
+    std::vector<QPointF> polyline;
+};
+
+QPointF pixelCentre(const QPoint &pixel)
+{
+    return QPointF(pixel.x() + 0.5, pixel.y() + 0.5);
+}
+
+qreal polylineLength(const std::vector<QPointF> &points)
+{
+    qreal length = 0.0;
+    for (std::size_t i = 1; i < points.size(); ++i)
+        length += QLineF(points[i - 1], points[i]).length();
+    return length;
+}
+
+class BranchTracer
+{
+public:
+    BranchTracer(const PixelComponents &branches,
+                 const PixelComponents &junctions,
+                 const std::vector<QPointF> &junctionCentres,
+                 bool keepPolylines)
+        : m_branches(branches)
+        , m_junctions(junctions)
+        , m_junctionCentres(junctionCentres)
+        , m_keepPolylines(keepPolylines)
+    {
+    }
+
+    std::vector<TracedBranch> trace(int component) const
+    {
+        const int *begin = m_branches.componentBegin(component);
+        const int size = static_cast<int>(m_branches.componentEnd(component) - begin);
+
+        // Neighbours within the component, junctions touched, and free ends.
+        std::vector<int> neighbourStarts(static_cast<std::size_t>(size) + 1, 0);
+        std::vector<int> neighbours;
+        std::vector<std::pair<int, int>> contacts;
+        std::vector<int> freeEnds;
+        for (int local = 0; local < size; ++local) {
+            const QPoint pixel = m_branches.pixel(begin[local]);
+            int branchNeighbours = 0;
+            bool touchesJunction = false;
+            for (const auto &offset : kNeighbourOffsets) {
+                const int x = pixel.x() + offset[0];
+                const int y = pixel.y() + offset[1];
+                const int index = m_branches.indexOf(x, y);
+                if (index >= 0) {
+                    neighbours.push_back(static_cast<int>(std::lower_bound(begin, begin + size, index) - begin));
+                    ++branchNeighbours;
+                    continue;
+                }
+                const int junctionPixel = m_junctions.indexOf(x, y);
+                if (junctionPixel >= 0) {
+                    contacts.emplace_back(m_junctions.componentOf(junctionPixel), local);
+                    touchesJunction = true;
+                }
+            }
+            neighbourStarts[static_cast<std::size_t>(local) + 1] = static_cast<int>(neighbours.size());
+            if (branchNeighbours <= 1 && !touchesJunction)
+                freeEnds.push_back(local);
+        }
+
+        std::vector<TracedBranch> result;
+        if (contacts.empty())
+            return result;
+
+        std::sort(contacts.begin(), contacts.end());
+        contacts.erase(std::unique(contacts.begin(), contacts.end()), contacts.end());
+        const int first = contacts.front().first;
+        const auto firstEnd = std::find_if(contacts.begin(), contacts.end(), [first](const auto &contact) {
+            return contact.first != first;
+        });
+
+        std::vector<int> sources;
+        for (auto it = contacts.begin(); it != firstEnd; ++it)
+            sources.push_back(it->second);
+
+        if (firstEnd != contacts.end()) {
+            // Joins the first junction to each other junction it touches.
+            search(neighbourStarts, neighbours, sources);
+            for (auto it = firstEnd; it != contacts.end();) {
+                const int junction = it->first;
+                int target = it->second;
+                for (; it != contacts.end() && it->first == junction; ++it) {
+                    if (distance(it->second) < distance(target))
+                        target = it->second;
+                }
+                result.push_back(makeBranch(begin, first, junction, target));
+            }
+        } else if (!freeEnds.empty()) {
+            // A branch from the junction to a free end.
+            search(neighbourStarts, neighbours, sources);
+            const int target = *std::max_element(freeEnds.begin(), freeEnds.end(), [this](int a, int b) {
+                return distance(a) < distance(b);
+            });
+            result.push_back(makeBranch(begin, first, -1, target));
+        } else {
+            // A loop that leaves the junction and comes back to it; the far
+            // side of the loop is the contact furthest from the first one.
+            search(neighbourStarts, neighbours, {sources.front()});
+            const int target = *std::max_element(sources.begin(), sources.end(), [this](int a, int b) {
+                return distance(a) < distance(b);
+            });
+            if (distance(target) > 1)
+                result.push_back(makeBranch(begin, first, first, target));
+        }
+        return result;
+    }
+
+private:
+    int distance(int local) const { return m_distances[static_cast<std::size_t>(local)]; }
+
+    // Breadth-first search from sources; leaves hop counts and parents.
+    void search(const std::vector<int> &neighbourStarts,
+                const std::vector<int> &neighbours,
+                const std::vector<int> &sources) const
+    {
+        const std::size_t size = neighbourStarts.size() - 1;
+        m_distances.assign(size, std::numeric_limits<int>::max());
+        m_parents.assign(size, -1);
+        std::deque<int> queue;
+        for (const int source : sources) {
+            m_distances[static_cast<std::size_t>(source)] = 0;
+            queue.push_back(source);
+        }
+        while (!queue.empty()) {
+            const int current = queue.front();
+            queue.pop_front();
+            const auto currentIndex = static_cast<std::size_t>(current);
+            for (int i = neighbourStarts[currentIndex]; i < neighbourStarts[currentIndex + 1]; ++i) {
+                const auto next = static_cast<std::size_t>(neighbours[static_cast<std::size_t>(i)]);
+                if (m_distances[next] != std::numeric_limits<int>::max())
+                    continue;
+                m_distances[next] = m_distances[currentIndex] + 1;
+                m_parents[next] = current;
+                queue.push_back(static_cast<int>(next));
+            }
+        }
+    }
+
+    // The shortest pixel path from the search sources to target, between the
+    // centres of the junctions start and end (or ending at target if free).
+    TracedBranch makeBranch(const int *begin, int start, int end, int target) const
+    {
+        std::vector<QPointF> points;
+        points.push_back(m_junctionCentres[static_cast<std::size_t>(start)]);
+        std::vector<QPointF> path;
+        for (int local = target; local >= 0; local = m_parents[static_cast<std::size_t>(local)])
+            path.push_back(pixelCentre(m_branches.pixel(begin[local])));
+        points.insert(points.end(), path.rbegin(), path.rend());
+        if (end >= 0)
+            points.push_back(m_junctionCentres[static_cast<std::size_t>(end)]);
+
+        TracedBranch branch;
+        branch.start = start;
+        branch.end = end;
+        branch.length = polylineLength(points);
+        branch.freeEnd = points.back();
+        if (m_keepPolylines)
+            branch.polyline = std::move(points);
+        return branch;
+    }
+
+    const PixelComponents &m_branches;
+    const PixelComponents &m_junctions;
+    const std::vector<QPointF> &m_junctionCentres;
+    bool m_keepPolylines = true;
+    // Scratch space of the last search.
+    mutable std::vector<int> m_distances;
+    mutable std::vector<int> m_parents;
+};
+
+void reverseBranch(SkeletonBranch &branch)
+{
+    std::swap(branch.start, branch.end);
+    std::reverse(branch.polyline.begin(), branch.polyline.end());
+}
+} // namespace
+
+SkeletonGraph traceSkeleton(const BinaryImage &skeleton, const SkeletonTraceOptions &options)
+{
+    SkeletonGraph graph;
+    if (skeleton.isNull())
+        return graph;
+
+    // Removing the junction regions leaves each branch as its own component.
+    const BinaryImage junctionMask = junctionPixels(skeleton);
+    const BinaryImage regionMask = junctionRegions(skeleton, junctionMask);
+    BinaryImage branchMask = skeleton;
+    for (int y = 0; y < skeleton.height(); ++y) {
+        quint64 *row = branchMask.row(y);
+        const quint64 *regionRow = regionMask.row(y);
+        for (int w = 0; w < skeleton.wordsPerRow(); ++w)
+            row[w] &= ~regionRow[w];
+    }
+
+    const PixelComponents junctions(regionMask);
+    const PixelComponents branches(branchMask);
+    graph.nodes = junctionCentres(junctions, junctionMask);
+
+    std::vector<int> components(static_cast<std::size_t>(branches.componentCount()));
+    std::iota(components.begin(), components.end(), 0);
+    std::vector<std::vector<TracedBranch>> traced(components.size());
+    QtConcurrent::blockingMap(components, [&](const int &component) {
+        BranchTracer tracer(branches, junctions, graph.nodes, options.polylines);
+        traced[static_cast<std::size_t>(component)] = tracer.trace(component);
+    });
+
+    // Keep the free branches that are long enough, giving each a node at its
+    // free end.
+    const int junctionCount = static_cast<int>(graph.nodes.size());
+    for (auto &componentBranches : traced) {
+        for (TracedBranch &tracedBranch : componentBranches) {
+            if (tracedBranch.end < 0) {
+                if (tracedBranch.length < options.minimumSpurLength)
+                    continue;
+                tracedBranch.end = static_cast<int>(graph.nodes.size());
+                graph.nodes.push_back(tracedBranch.freeEnd);
+            }
+            graph.branches.push_back(SkeletonBranch{tracedBranch.start,
+                                                    tracedBranch.end,
+                                                    tracedBranch.length,
+                                                    std::move(tracedBranch.polyline)});
+        }
+    }
+
+    // Pruning can leave a junction between just two branches; join them.
+    std::vector<std::vector<int>> incident(graph.nodes.size());
+    for (std::size_t i = 0; i < graph.branches.size(); ++i) {
+        incident[static_cast<std::size_t>(graph.branches[i].start)].push_back(static_cast<int>(i));
+        incident[static_cast<std::size_t>(graph.branches[i].end)].push_back(static_cast<int>(i));
+    }
+    std::vector<bool> removedBranches(graph.branches.size(), false);
+    for (int node = 0; node < junctionCount; ++node) {
+        std::vector<int> &nodeBranches = incident[static_cast<std::size_t>(node)];
+        if (nodeBranches.size() != 2 || nodeBranches[0] == nodeBranches[1])
+            continue;
+
+        SkeletonBranch &first = graph.branches[static_cast<std::size_t>(nodeBranches[0])];
+        SkeletonBranch &second = graph.branches[static_cast<std::size_t>(nodeBranches[1])];
+        if (first.end != node)
+            reverseBranch(first);
+        if (second.start != node)
+            reverseBranch(second);
+
+        std::vector<int> &farBranches = incident[static_cast<std::size_t>(second.end)];
+        *std::find(farBranches.begin(), farBranches.end(), nodeBranches[1]) = nodeBranches[0];
+        first.end = second.end;
+        first.length += second.length;
+        if (!second.polyline.empty())
+            first.polyline.insert(first.polyline.end(), second.polyline.begin() + 1, second.polyline.end());
+        removedBranches[static_cast<std::size_t>(nodeBranches[1])] = true;
+        nodeBranches.clear();
+    }
+
+    // Drop the nodes no branch uses any more and renumber the rest.
+    std::vector<int> nodeIds(graph.nodes.size(), -1);
+    std::vector<QPointF> nodes;
+    for (std::size_t node = 0; node < graph.nodes.size(); ++node) {
+        if (incident[node].empty())
+            continue;
+        nodeIds[node] = static_cast<int>(nodes.size());
+        nodes.push_back(graph.nodes[node]);
+    }
+    std::vector<SkeletonBranch> keptBranches;
+    keptBranches.reserve(graph.branches.size());
+    for (std::size_t i = 0; i < graph.branches.size(); ++i) {
+        if (removedBranches[i])
+            continue;
+        SkeletonBranch &branch = graph.branches[i];
+        branch.start = nodeIds[static_cast<std::size_t>(branch.start)];
+        branch.end = nodeIds[static_cast<std::size_t>(branch.end)];
+        keptBranches.push_back(std::move(branch));
+    }
+    graph.nodes = std::move(nodes);
+    graph.branches = std::move(keptBranches);
+    return graph;
+}
@@ -0,0 +1,45 @@
+#ifndef SKELETONTRACER_H
+#define SKELETONTRACER_H
+
+#include "binaryimage.h"
+
+#include <QPointF>
+
+#include <vector>
+
+struct SkeletonTraceOptions
+{
+    // Branches that end freely and are shorter than this, in pixels, are
+    // dropped as spurs.
+    qreal minimumSpurLength = 10.0;
+    // Whether to keep the pixel path of each branch.
+    bool polylines = true;
+};
+
+struct SkeletonBranch
+{
+    // Indices into SkeletonGraph::nodes; equal for a branch that loops back
+    // to its junction.
+    int start = -1;
+    int end = -1;
+    qreal length = 0.0;
+    // Through the pixel centres from the start node to the end node, both
+    // included. Empty unless polylines were requested.
+    std::vector<QPointF> polyline;
+};
+
+struct SkeletonGraph
+{
+    // Junction centres followed by the free ends of the branches kept, in
+    // image coordinates.
+    std::vector<QPointF> nodes;
+    std::vector<SkeletonBranch> branches;
+};
+
+// Splits a one pixel wide skeleton at its junctions (see detectJunctions)
+// and traces each branch between them, one task per branch on all cores.
+// Short dead-end spurs are pruned, and junctions left with two branches are
+// dissolved into a single branch. Curves without any junction are ignored.
+SkeletonGraph traceSkeleton(const BinaryImage &skeleton, const SkeletonTraceOptions &options = {});
+
+#endif // SKELETONTRACER_H
@@ -0,0 +1,193 @@
+#include "stressbenchmark.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QJsonDocument>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+double toMicroseconds(qint64 nanoseconds)
+{
+    return static_cast<double>(nanoseconds) / 1000.0;
+}
+
+// Nearest-rank percentile of already sorted samples.
+qint64 percentile(const std::vector<qint64> &sorted, double fraction)
+{
+    const auto rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+} // namespace
+
+QJsonObject StressBenchmarkOptions::toJson() const
+{
+    QJsonObject object;
+    object.insert(QStringLiteral("rounds"), rounds);
+    object.insert(QStringLiteral("vertices_per_round"), verticesPerRound);
+    object.insert(QStringLiteral("mesh_size"), meshSize);
+    object.insert(QStringLiteral("mesh_kind"), meshKind);
+    object.insert(QStringLiteral("seed"), static_cast<qint64>(seed));
+    object.insert(QStringLiteral("finds_per_round"), findsPerRound);
+    object.insert(QStringLiteral("delete_fraction"), deleteFraction);
+    object.insert(QStringLiteral("validate_every"), validateEvery);
+    return object;
+}
+
+bool parseStressBenchmarkOptions(const QStringList &arguments, StressBenchmarkOptions *options, QString *errorString)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Runs the seeded vertices/lines/polygons stress benchmark."));
+    parser.addHelpOption();
+
+    const QCommandLineOption benchmarkOption(QStringLiteral("benchmark"), QStringLiteral("Run the stress benchmark."));
+    const QCommandLineOption roundsOption(QStringLiteral("rounds"),
+                                          QStringLiteral("Number of rounds."),
+                                          QStringLiteral("count"),
+                                          QString::number(options->rounds));
+    const QCommandLineOption verticesOption(QStringLiteral("vertices"),
+                                            QStringLiteral("Vertices created per round."),
+                                            QStringLiteral("count"),
+                                            QString::number(options->verticesPerRound));
+    const QCommandLineOption meshSizeOption(QStringLiteral("mesh-size"),
+                                            QStringLiteral("Cells in the background mesh built before timing."),
+                                            QStringLiteral("count"),
+                                            QString::number(options->meshSize));
+    const QCommandLineOption meshKindOption(QStringLiteral("mesh-kind"),
+                                            QStringLiteral("Background mesh: grid or voronoi."),
+                                            QStringLiteral("kind"),
+                                            options->meshKind);
+    const QCommandLineOption seedOption(QStringLiteral("seed"),
+                                        QStringLiteral("Random seed."),
+                                        QStringLiteral("seed"),
+                                        QString::number(options->seed));
+    const QCommandLineOption findsOption(QStringLiteral("finds"),
+                                         QStringLiteral("Lookups of each kind per round."),
+                                         QStringLiteral("count"),
+                                         QString::number(options->findsPerRound));
+    const QCommandLineOption deleteFractionOption(QStringLiteral("delete-fraction"),
+                                                  QStringLiteral("Share of each round's entities deleted one by one."),
+                                                  QStringLiteral("fraction"),
+                                                  QString::number(options->deleteFraction));
+    const QCommandLineOption validateEveryOption(QStringLiteral("validate-every"),
+                                                 QStringLiteral("Rounds between relationship checks (0 = never)."),
+                                                 QStringLiteral("rounds"),
+                                                 QString::number(options->validateEvery));
+    const QCommandLineOption reportOption(QStringLiteral("report"),
+                                          QStringLiteral("Write the JSON report to this file instead of stdout."),
+                                          QStringLiteral("path"));
+
+    parser.addOptions({benchmarkOption,
+                       roundsOption,
+                       verticesOption,
+                       meshSizeOption,
+                       meshKindOption,
+                       seedOption,
+                       findsOption,
+                       deleteFractionOption,
+                       validateEveryOption,
+                       reportOption});
+
+    if (!parser.parse(arguments)) {
+        *errorString = parser.errorText();
+        return false;
+    }
+
+    // Help is not an error: print it and exit successfully.
+    if (parser.isSet(QStringLiteral("help")))
+        parser.showHelp(0);
+
+    const auto readInt = [&](const QCommandLineOption &option, int minimum, int *value) {
+        bool ok = false;
+        const int parsed = parser.value(option).toInt(&ok);
+        if (!ok || parsed < minimum) {
+            *errorString = QStringLiteral("Invalid value for --%1: %2").arg(option.names().constFirst(), parser.value(option));
+            return false;
+        }
+        *value = parsed;
+        return true;
+    };
+
+    if (!readInt(roundsOption, 1, &options->rounds) || !readInt(verticesOption, 3, &options->verticesPerRound)
+        || !readInt(meshSizeOption, 0, &options->meshSize) || !readInt(findsOption, 0, &options->findsPerRound)
+        || !readInt(validateEveryOption, 0, &options->validateEvery)) {
+        return false;
+    }
+
+    options->meshKind = parser.value(meshKindOption);
+    if (options->meshKind != QLatin1String("grid") && options->meshKind != QLatin1String("voronoi")) {
+        *errorString = QStringLiteral("Invalid value for --mesh-kind: %1").arg(options->meshKind);
+        return false;
+    }
+
+    bool ok = false;
+    options->seed = parser.value(seedOption).toUInt(&ok);
+    if (!ok) {
+        *errorString = QStringLiteral("Invalid value for --seed: %1").arg(parser.value(seedOption));
+        return false;
+    }
+
+    options->deleteFraction = parser.value(deleteFractionOption).toDouble(&ok);
+    if (!ok || options->deleteFraction < 0.0 || options->deleteFraction > 1.0) {
+        *errorString = QStringLiteral("Invalid value for --delete-fraction: %1").arg(parser.value(deleteFractionOption));
+        return false;
+    }
+
+    options->reportPath = parser.value(reportOption);
+    return true;
+}
+
+void StressBenchmarkRecorder::record(const QString &operation, qint64 nanoseconds)
+{
+    m_samples[operation].push_back(nanoseconds);
+}
+
+QJsonObject StressBenchmarkRecorder::toJson() const
+{
+    QJsonObject operations;
+    for (const auto &[operation, samples] : m_samples) {
+        if (samples.empty())
+            continue;
+
+        std::vector<qint64> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        const qint64 total = std::accumulate(sorted.begin(), sorted.end(), qint64(0));
+
+        QJsonObject summary;
+        summary.insert(QStringLiteral("count"), static_cast<qint64>(sorted.size()));
+        summary.insert(QStringLiteral("total_ms"), static_cast<double>(total) / 1.0e6);
+        summary.insert(QStringLiteral("mean_us"), toMicroseconds(total) / static_cast<double>(sorted.size()));
+        summary.insert(QStringLiteral("min_us"), toMicroseconds(sorted.front()));
+        summary.insert(QStringLiteral("p50_us"), toMicroseconds(percentile(sorted, 0.50)));
+        summary.insert(QStringLiteral("p90_us"), toMicroseconds(percentile(sorted, 0.90)));
+        summary.insert(QStringLiteral("p99_us"), toMicroseconds(percentile(sorted, 0.99)));
+        summary.insert(QStringLiteral("max_us"), toMicroseconds(sorted.back()));
+        operations.insert(operation, summary);
+    }
+    return operations;
+}
+
+bool writeStressBenchmarkReport(const QJsonObject &report, const QString &path, QString *errorString)
+{
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if (path.isEmpty()) {
+        QTextStream(stdout) << json;
+        return true;
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        *errorString = file.errorString();
+        return false;
+    }
+    if (file.write(json) != json.size()) {
+        *errorString = file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef STRESSBENCHMARK_H
+#define STRESSBENCHMARK_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+#include <map>
+#include <vector>
+
+// Parameters of the seeded stress benchmark (see MainWindow::runStressBenchmark).
+struct StressBenchmarkOptions
+{
+    int rounds = 100;
+    int verticesPerRound = 10;
+    // Approximate number of cells in the background grid mesh that is built
+    // before timing starts, so operations run against a mesh of this size.
+    int meshSize = 1000;
+    // "grid" (square cells) or "voronoi" (generated tissue).
+    QString meshKind = QStringLiteral("grid");
+    quint32 seed = 1;
+    // Operation mix: random lookups of each kind per round, share of the
+    // round's entities deleted one by one before the round is cleaned up,
+    // and how often (in rounds) the full relationship check runs.
+    int findsPerRound = 20;
+    double deleteFraction = 0.5;
+    int validateEvery = 1;
+    QString reportPath;
+
+    QJsonObject toJson() const;
+};
+
+// Parses the benchmark command line; returns false with a message on errors.
+// --help prints the options and exits the process with code 0.
+bool parseStressBenchmarkOptions(const QStringList &arguments, StressBenchmarkOptions *options, QString *errorString);
+
+// Collects per-operation timings and summarises them with percentiles.
+class StressBenchmarkRecorder
+{
+public:
+    void record(const QString &operation, qint64 nanoseconds);
+    QJsonObject toJson() const;
+
+private:
+    std::map<QString, std::vector<qint64>> m_samples;
+};
+
+bool writeStressBenchmarkReport(const QJsonObject &report, const QString &path, QString *errorString);
+
+#endif // STRESSBENCHMARK_H
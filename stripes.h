@@ -0,0 +1,35 @@
+#ifndef STRIPES_H
+#define STRIPES_H
+
+#include <QThread>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <vector>
+
+// Stripes per core, so that uneven stripes do not leave cores idle.
+constexpr int kStripesPerThread = 4;
+
+// Items [first, end) of a pass split across cores, usually image rows.
+// Passes that gather results per stripe derive their own stripe from it.
+struct Stripe
+{
+    int first = 0;
+    int end = 0;
+};
+
+// Splits [0, count) into stripesPerThread nearly equal stripes per core,
+// and never into more stripes than items.
+template<typename S = Stripe>
+std::vector<S> makeStripes(int count, int stripesPerThread = kStripesPerThread)
+{
+    const int stripeCount = std::clamp(QThread::idealThreadCount() * stripesPerThread, 1, std::max(1, count));
+    std::vector<S> stripes(static_cast<std::size_t>(stripeCount));
+    for (int i = 0; i < stripeCount; ++i) {
+        stripes[static_cast<std::size_t>(i)].first = static_cast<int>(static_cast<qint64>(count) * i / stripeCount);
+        stripes[static_cast<std::size_t>(i)].end = static_cast<int>(static_cast<qint64>(count) * (i + 1) / stripeCount);
+    }
+    return stripes;
+}
+
+#endif // STRIPES_H
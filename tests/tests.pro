@@ -0,0 +1,15 @@
+TEMPLATE = subdirs
+
+# One test target per module; "make check" runs each of them.
+SUBDIRS += \
+    tst_crossingguard \
+    tst_skeletonizer \
+    tst_junctiondetector \
+    tst_skeletontracer \
+    tst_faceextractor \
+    tst_halfedgemesh \
+    tst_contourpreprocessor \
+    tst_distancetransform \
+    tst_watershed \
+    tst_labelimage \
+    tst_labelmesh
@@ -0,0 +1,256 @@
+#include "binaryimage.h"
+#include "contourpreprocessor.h"
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QtTest>
+
+namespace {
+// '#' is foreground, anything else background.
+BinaryImage fromRows(const QStringList &rows)
+{
+    BinaryImage image(static_cast<int>(rows.first().size()), static_cast<int>(rows.size()));
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, rows.at(y).at(x) == QLatin1Char('#'));
+    }
+    return image;
+}
+
+QStringList toRows(const BinaryImage &image)
+{
+    QStringList rows;
+    for (int y = 0; y < image.height(); ++y) {
+        QString row;
+        for (int x = 0; x < image.width(); ++x)
+            row += image.pixel(x, y) ? QLatin1Char('#') : QLatin1Char('.');
+        rows << row;
+    }
+    return rows;
+}
+
+// An 8-bit grey image with the mask pixels at contour and the rest at
+// background.
+QImage greyImage(const BinaryImage &mask, int contour, int background)
+{
+    QImage image(mask.width(), mask.height(), QImage::Format_Grayscale8);
+    for (int y = 0; y < mask.height(); ++y) {
+        uchar *pixels = image.scanLine(y);
+        for (int x = 0; x < mask.width(); ++x)
+            pixels[x] = static_cast<uchar>(mask.pixel(x, y) ? contour : background);
+    }
+    return image;
+}
+
+QImage greyImage16(const BinaryImage &mask, int contour, int background)
+{
+    QImage image(mask.width(), mask.height(), QImage::Format_Grayscale16);
+    for (int y = 0; y < mask.height(); ++y) {
+        auto *pixels = reinterpret_cast<quint16 *>(image.scanLine(y));
+        for (int x = 0; x < mask.width(); ++x)
+            pixels[x] = static_cast<quint16>(mask.pixel(x, y) ? contour : background);
+    }
+    return image;
+}
+
+// A grid of one pixel wide lines every ten pixels, over three words per row.
+BinaryImage gridMask()
+{
+    BinaryImage mask(150, 31);
+    for (int y = 0; y < mask.height(); ++y) {
+        for (int x = 0; x < mask.width(); ++x)
+            mask.setPixel(x, y, x % 10 == 5 || y % 10 == 5);
+    }
+    return mask;
+}
+
+ContourPreprocessOptions plainOptions()
+{
+    ContourPreprocessOptions options;
+    options.denoising = ContourDenoising::None;
+    return options;
+}
+} // namespace
+
+class ContourPreprocessorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nullImageGivesNullMask() { QVERIFY(preprocessContourImage(QImage(), plainOptions()).isNull()); }
+
+    void otsuKeepsMinoritySide()
+    {
+        const BinaryImage mask = gridMask();
+        QCOMPARE(toRows(preprocessContourImage(greyImage(mask, 30, 200), plainOptions())), toRows(mask));
+        QCOMPARE(toRows(preprocessContourImage(greyImage(mask, 220, 40), plainOptions())), toRows(mask));
+        QCOMPARE(toRows(preprocessContourImage(greyImage16(mask, 1000, 1300), plainOptions())), toRows(mask));
+    }
+
+    // Dark contours on a background that brightens from left to right: one
+    // global threshold cannot separate them, the local mean can.
+    void adaptiveFollowsUnevenIllumination()
+    {
+        const BinaryImage mask = gridMask();
+        QImage image(mask.width(), mask.height(), QImage::Format_Grayscale8);
+        for (int y = 0; y < mask.height(); ++y) {
+            uchar *pixels = image.scanLine(y);
+            for (int x = 0; x < mask.width(); ++x) {
+                const int background = 100 + x / 2;
+                pixels[x] = static_cast<uchar>(mask.pixel(x, y) ? background - 40 : background);
+            }
+        }
+
+        ContourPreprocessOptions options = plainOptions();
+        QVERIFY(toRows(preprocessContourImage(image, options)) != toRows(mask));
+        options.thresholding = ContourThresholding::Adaptive;
+        options.adaptiveRadius = 3;
+        QCOMPARE(toRows(preprocessContourImage(image, options)), toRows(mask));
+    }
+
+    void medianRemovesSpecks()
+    {
+        const QStringList band = {
+            "....###......",
+            "....###......",
+            "....###......",
+            "....###......",
+            "....###......",
+            "....###......",
+            "....###......",
+            "....###......",
+        };
+        const QStringList specks = {
+            "....###......",
+            ".#..###......",
+            "....###...#..",
+            "....###......",
+            "....###......",
+            "....###......",
+            "....###.....#",
+            "....###......",
+        };
+        const QImage image = greyImage(fromRows(specks), 0, 255);
+        QCOMPARE(toRows(preprocessContourImage(image, plainOptions())), specks);
+
+        ContourPreprocessOptions options = plainOptions();
+        options.denoising = ContourDenoising::Median;
+        QCOMPARE(toRows(preprocessContourImage(image, options)), band);
+    }
+
+    void elementsHaveTheirShape()
+    {
+        BinaryImage dot(7, 7);
+        dot.setPixel(3, 3, true);
+        // The pixels within the radius of the centre.
+        QCOMPARE(toRows(dilate(dot, StructuringElement::Disk, 2)),
+                 (QStringList{
+                     ".......",
+                     "...#...",
+                     "..###..",
+                     ".#####.",
+                     "..###..",
+                     "...#...",
+                     ".......",
+                 }));
+        QCOMPARE(toRows(dilate(dot, StructuringElement::Cross, 2)),
+                 (QStringList{
+                     ".......",
+                     "...#...",
+                     "...#...",
+                     ".#####.",
+                     "...#...",
+                     "...#...",
+                     ".......",
+                 }));
+        QCOMPARE(toRows(dilate(dot, StructuringElement::Square, 1)),
+                 (QStringList{
+                     ".......",
+                     ".......",
+                     "..###..",
+                     "..###..",
+                     "..###..",
+                     ".......",
+                     ".......",
+                 }));
+        QCOMPARE(toRows(erode(dilate(dot, StructuringElement::Disk, 2), StructuringElement::Disk, 2)), toRows(dot));
+    }
+
+    void morphologyCrossesWordsAndKeepsBorder()
+    {
+        BinaryImage image(130, 3);
+        image.setPixel(63, 1, true);
+        const BinaryImage dilated = dilate(image, StructuringElement::Square, 2);
+        QCOMPARE(dilated.count(), qint64(15));
+        QVERIFY(dilated.pixel(61, 0));
+        QVERIFY(dilated.pixel(65, 2));
+        QVERIFY(!dilated.pixel(66, 1));
+
+        // Outside counts as foreground for erosion, so a full image stays full.
+        BinaryImage full(130, 3);
+        for (int y = 0; y < full.height(); ++y) {
+            for (int x = 0; x < full.width(); ++x)
+                full.setPixel(x, y, true);
+        }
+        QCOMPARE(erode(full, StructuringElement::Disk, 3).count(), full.count());
+    }
+
+    void closingBridgesGapsAndOpeningDropsSpecks()
+    {
+        const QStringList broken = {
+            ".............",
+            ".............",
+            "..####.####..",
+            ".............",
+            ".............",
+            ".............",
+            ".........#...",
+            ".............",
+            ".............",
+        };
+        ContourPreprocessOptions options = plainOptions();
+        options.element = StructuringElement::Square;
+        options.closingRadius = 1;
+        QCOMPARE(toRows(preprocessContourImage(greyImage(fromRows(broken), 0, 255), options)),
+                 (QStringList{
+                     ".............",
+                     ".............",
+                     "..#########..",
+                     ".............",
+                     ".............",
+                     ".............",
+                     ".........#...",
+                     ".............",
+                     ".............",
+                 }));
+
+        // A square opening keeps the block and drops the plus sign and the
+        // line, which are narrower than the element.
+        options.closingRadius = 0;
+        options.openingRadius = 1;
+        const QStringList shapes = {
+            ".............",
+            "..###....#...",
+            "..###...###..",
+            "..###....#...",
+            ".............",
+            "..#######....",
+            ".............",
+        };
+        QCOMPARE(toRows(preprocessContourImage(greyImage(fromRows(shapes), 0, 255), options)),
+                 (QStringList{
+                     ".............",
+                     "..###........",
+                     "..###........",
+                     "..###........",
+                     ".............",
+                     ".............",
+                     ".............",
+                 }));
+    }
+};
+
+QTEST_APPLESS_MAIN(ContourPreprocessorTest)
+
+#include "tst_contourpreprocessor.moc"
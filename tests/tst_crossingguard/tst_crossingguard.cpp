@@ -0,0 +1,104 @@
+#include "crossingguard.h"
+#include "line.h"
+#include "linespatialindex.h"
+#include "vertex.h"
+
+#include <QLineF>
+#include <QtTest>
+
+#include <memory>
+#include <vector>
+
+// A vertex joined to one anchor by a line, dragged past a single obstacle
+// line, all without a scene.
+class DragFixture
+{
+public:
+    DragFixture(const QPointF &anchor, const QPointF &from, const QLineF &obstacle)
+        : m_guard(&m_index)
+    {
+        m_index.setBounds(QRectF(-100.0, -100.0, 200.0, 200.0));
+        m_guard.setEnabled(true);
+
+        m_vertices.push_back(std::make_unique<Vertex>(0, from, nullptr));
+        m_vertices.push_back(std::make_unique<Vertex>(1, anchor, nullptr));
+        m_vertices.push_back(std::make_unique<Vertex>(2, obstacle.p1(), nullptr));
+        m_vertices.push_back(std::make_unique<Vertex>(3, obstacle.p2(), nullptr));
+        addLine(m_vertices[0].get(), m_vertices[1].get());
+        addLine(m_vertices[2].get(), m_vertices[3].get());
+    }
+
+    ~DragFixture()
+    {
+        m_lines.clear();
+        m_vertices.clear();
+    }
+
+    QPointF constrainMove(const QPointF &target) const { return m_guard.constrainMove(m_vertices[0].get(), target); }
+
+    // Whether the moving line would cross the obstacle with its end at position.
+    bool crosses(const QPointF &position) const
+    {
+        return LineSpatialIndex::segmentsIntersect(QLineF(m_vertices[1]->position(), position),
+                                                   QLineF(m_vertices[2]->position(), m_vertices[3]->position()));
+    }
+
+private:
+    void addLine(Vertex *startVertex, Vertex *endVertex)
+    {
+        m_lines.push_back(std::make_unique<Line>(static_cast<int>(m_lines.size()), startVertex, endVertex, nullptr));
+        m_lines.back()->setSpatialIndex(&m_index);
+    }
+
+    LineSpatialIndex m_index;
+    CrossingGuard m_guard;
+    std::vector<std::unique_ptr<Vertex>> m_vertices;
+    std::vector<std::unique_ptr<Line>> m_lines;
+};
+
+class CrossingGuardTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void unobstructedMoveReachesTarget()
+    {
+        const DragFixture fixture(QPointF(0.0, 0.0), QPointF(10.0, -10.0), QLineF(30.0, -1.0, 30.0, 1.0));
+        QCOMPARE(fixture.constrainMove(QPointF(10.0, 10.0)), QPointF(10.0, 10.0));
+    }
+
+    void stopsBeforeEndRunsIntoObstacle()
+    {
+        const DragFixture fixture(QPointF(0.0, 0.0), QPointF(10.0, -10.0), QLineF(5.0, 0.0, 15.0, 0.0));
+        const QPointF stop = fixture.constrainMove(QPointF(10.0, 10.0));
+        QVERIFY(stop.y() < 0.0);
+        QVERIFY(stop.y() > -0.01);
+        QVERIFY(!fixture.crosses(stop));
+    }
+
+    // The line from the anchor sweeps over the whole obstacle although
+    // neither end position crosses it.
+    void stopsBeforeObstacleInsideSweptTriangle()
+    {
+        const DragFixture fixture(QPointF(0.0, 0.0), QPointF(10.0, -10.0), QLineF(5.0, -1.0, 5.0, 1.0));
+        const QPointF target(10.0, 10.0);
+        QVERIFY(!fixture.crosses(target));
+
+        // The line reaches (5, -1) when its end is at (10, -2).
+        const QPointF stop = fixture.constrainMove(target);
+        QCOMPARE(stop.x(), 10.0);
+        QVERIFY(stop.y() < -2.0);
+        QVERIFY(stop.y() > -2.01);
+        QVERIFY(!fixture.crosses(stop));
+    }
+
+    void tangledLineMovesFreely()
+    {
+        const DragFixture fixture(QPointF(0.0, 0.0), QPointF(10.0, 0.0), QLineF(5.0, -1.0, 5.0, 1.0));
+        QCOMPARE(fixture.constrainMove(QPointF(10.0, 5.0)), QPointF(10.0, 5.0));
+    }
+};
+
+QTEST_APPLESS_MAIN(CrossingGuardTest)
+
+#include "tst_crossingguard.moc"
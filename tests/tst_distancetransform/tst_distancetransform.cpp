@@ -0,0 +1,96 @@
+#include "binaryimage.h"
+#include "distancetransform.h"
+
+#include <QPoint>
+#include <QtTest>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+// Checks every pixel against the nearest set pixel found by trying them all.
+// Ties may go to any of the nearest pixels.
+void compareWithBruteForce(const BinaryImage &mask)
+{
+    std::vector<QPoint> setPixels;
+    for (int y = 0; y < mask.height(); ++y) {
+        for (int x = 0; x < mask.width(); ++x) {
+            if (mask.pixel(x, y))
+                setPixels.emplace_back(x, y);
+        }
+    }
+
+    const DistanceTransform transform(mask);
+    QCOMPARE(transform.width(), mask.width());
+    QCOMPARE(transform.height(), mask.height());
+    for (int y = 0; y < mask.height(); ++y) {
+        for (int x = 0; x < mask.width(); ++x) {
+            if (setPixels.empty()) {
+                QCOMPARE(transform.nearestIndex(x, y), int(DistanceTransform::kNoPixel));
+                QVERIFY(std::isinf(transform.distance(x, y)));
+                continue;
+            }
+
+            int best = -1;
+            for (const QPoint &pixel : setPixels) {
+                const int squared = (pixel.x() - x) * (pixel.x() - x) + (pixel.y() - y) * (pixel.y() - y);
+                if (best < 0 || squared < best)
+                    best = squared;
+            }
+            const QPoint nearest = transform.nearestPixel(x, y);
+            QCOMPARE(transform.nearestIndex(x, y), nearest.y() * mask.width() + nearest.x());
+            QVERIFY(mask.pixel(nearest.x(), nearest.y()));
+            QCOMPARE((nearest.x() - x) * (nearest.x() - x) + (nearest.y() - y) * (nearest.y() - y), best);
+            QCOMPARE(transform.distance(x, y), static_cast<float>(std::sqrt(static_cast<double>(best))));
+        }
+    }
+}
+} // namespace
+
+class DistanceTransformTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nullMaskGivesNullTransform() { QVERIFY(DistanceTransform(BinaryImage()).isNull()); }
+
+    void singlePixel()
+    {
+        BinaryImage mask(5, 4);
+        mask.setPixel(1, 1, true);
+        const DistanceTransform transform(mask);
+        QCOMPARE(transform.distance(1, 1), 0.0f);
+        QCOMPARE(transform.distance(4, 1), 3.0f);
+        QCOMPARE(transform.distance(4, 3), std::sqrt(13.0f));
+        QCOMPARE(transform.nearestPixel(4, 3), QPoint(1, 1));
+        QCOMPARE(transform.nearestIndex(0, 0), 6);
+    }
+
+    void emptyMaskIsInfinitelyFar() { compareWithBruteForce(BinaryImage(7, 3)); }
+
+    void matchesBruteForce()
+    {
+        // Sparse and dense masks, single rows and columns, and widths on
+        // either side of a word.
+        std::mt19937 random(3);
+        const int sizes[][2] = {{1, 1}, {1, 40}, {70, 1}, {63, 17}, {64, 20}, {65, 33}, {150, 90}};
+        for (const auto &size : sizes) {
+            for (const double density : {0.002, 0.05, 0.5}) {
+                BinaryImage mask(size[0], size[1]);
+                std::bernoulli_distribution set(density);
+                for (int y = 0; y < mask.height(); ++y) {
+                    for (int x = 0; x < mask.width(); ++x)
+                        mask.setPixel(x, y, set(random));
+                }
+                compareWithBruteForce(mask);
+                if (QTest::currentTestFailed())
+                    return;
+            }
+        }
+    }
+};
+
+QTEST_APPLESS_MAIN(DistanceTransformTest)
+
+#include "tst_distancetransform.moc"
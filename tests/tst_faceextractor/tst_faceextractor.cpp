@@ -0,0 +1,125 @@
+#include "faceextractor.h"
+#include "planarmesh.h"
+
+#include <QPointF>
+#include <QtTest>
+
+#include <utility>
+#include <vector>
+
+namespace {
+PlanarMesh meshOf(std::vector<QPointF> vertices, std::vector<std::pair<int, int>> lines)
+{
+    PlanarMesh mesh;
+    mesh.vertices = std::move(vertices);
+    mesh.lines = std::move(lines);
+    return mesh;
+}
+
+// The square (0, 0)-(10, 10) as vertices 0..3 and lines 0..3.
+PlanarMesh square(std::vector<QPointF> extraVertices, std::vector<std::pair<int, int>> extraLines)
+{
+    std::vector<QPointF> vertices = {QPointF(0.0, 0.0), QPointF(10.0, 0.0), QPointF(10.0, 10.0), QPointF(0.0, 10.0)};
+    vertices.insert(vertices.end(), extraVertices.begin(), extraVertices.end());
+    std::vector<std::pair<int, int>> lines = {{0, 1}, {1, 2}, {2, 3}, {3, 0}};
+    lines.insert(lines.end(), extraLines.begin(), extraLines.end());
+    return meshOf(std::move(vertices), std::move(lines));
+}
+} // namespace
+
+class FaceExtractorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void openGraphHasNoFaces()
+    {
+        PlanarMesh empty;
+        extractFaces(empty);
+        QCOMPARE(empty.faceCount(), std::size_t(0));
+
+        PlanarMesh path = meshOf({QPointF(0.0, 0.0), QPointF(10.0, 0.0), QPointF(10.0, 10.0)}, {{0, 1}, {1, 2}});
+        extractFaces(path);
+        QCOMPARE(path.faceOffsets, std::vector<int>{0});
+        QVERIFY(path.faceVertices.empty());
+        QVERIFY(path.faceLines.empty());
+    }
+
+    void diagonalSplitsSquare()
+    {
+        PlanarMesh mesh = square({}, {{0, 2}});
+        // Stale faces are replaced.
+        mesh.faceOffsets = {0, 2};
+        mesh.faceVertices = {0, 1};
+        mesh.faceLines = {0, 1};
+        extractFaces(mesh);
+        QCOMPARE(mesh.faceOffsets, (std::vector<int>{0, 3, 6}));
+        QCOMPARE(mesh.faceVertices, (std::vector<int>{0, 1, 2, 2, 3, 0}));
+        QCOMPARE(mesh.faceLines, (std::vector<int>{0, 1, 4, 2, 3, 4}));
+    }
+
+    void danglingLineIsLeftOutOfRing()
+    {
+        PlanarMesh mesh = square({QPointF(4.0, 5.0)}, {{0, 4}});
+        extractFaces(mesh);
+        QCOMPARE(mesh.faceOffsets, (std::vector<int>{0, 4}));
+        QCOMPARE(mesh.faceVertices, (std::vector<int>{0, 1, 2, 3}));
+        QCOMPARE(mesh.faceLines, (std::vector<int>{0, 1, 2, 3}));
+    }
+
+    // The square's ring passes vertex 0 on both sides of the triangle hanging
+    // from it, so only the triangle is a face.
+    void faceTouchingVertexTwiceIsSkipped()
+    {
+        PlanarMesh mesh = square({QPointF(5.0, 2.0), QPointF(2.0, 5.0)}, {{0, 4}, {4, 5}, {5, 0}});
+        extractFaces(mesh);
+        QCOMPARE(mesh.faceOffsets, (std::vector<int>{0, 3}));
+        QCOMPARE(mesh.faceVertices, (std::vector<int>{0, 4, 5}));
+        QCOMPARE(mesh.faceLines, (std::vector<int>{4, 5, 6}));
+    }
+
+    void outerFaceOfEachPartIsDropped()
+    {
+        PlanarMesh apart = square({QPointF(20.0, 0.0), QPointF(30.0, 0.0), QPointF(30.0, 10.0), QPointF(20.0, 10.0)},
+                                  {{4, 5}, {5, 6}, {6, 7}, {7, 4}});
+        extractFaces(apart);
+        QCOMPARE(apart.faceOffsets, (std::vector<int>{0, 4, 8}));
+        QCOMPARE(apart.faceVertices, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+
+        // A part nested in a face does not cut a hole into it.
+        PlanarMesh nested = square({QPointF(4.0, 4.0), QPointF(6.0, 4.0), QPointF(6.0, 6.0), QPointF(4.0, 6.0)},
+                                   {{4, 5}, {5, 6}, {6, 7}, {7, 4}});
+        extractFaces(nested);
+        QCOMPARE(nested.faceOffsets, (std::vector<int>{0, 4, 8}));
+        QCOMPARE(nested.faceVertices, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+        QCOMPARE(nested.faceLines, (std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7}));
+    }
+
+    // More vertices than chunks, so the sorting runs on several cores.
+    void gridHasOneFacePerCell()
+    {
+        constexpr int side = 20;
+        PlanarMesh mesh;
+        for (int y = 0; y <= side; ++y) {
+            for (int x = 0; x <= side; ++x) {
+                const int vertex = y * (side + 1) + x;
+                mesh.vertices.emplace_back(x, y);
+                if (x < side)
+                    mesh.lines.emplace_back(vertex, vertex + 1);
+                if (y < side)
+                    mesh.lines.emplace_back(vertex, vertex + side + 1);
+            }
+        }
+        extractFaces(mesh);
+        QCOMPARE(mesh.faceCount(), std::size_t(side * side));
+        for (std::size_t face = 0; face < mesh.faceCount(); ++face) {
+            QCOMPARE(mesh.faceOffsets[face + 1] - mesh.faceOffsets[face], 4);
+            const int corner = mesh.faceVertices[static_cast<std::size_t>(mesh.faceOffsets[face])];
+            QCOMPARE(mesh.faceVertices[static_cast<std::size_t>(mesh.faceOffsets[face]) + 2], corner + side + 2);
+        }
+    }
+};
+
+QTEST_APPLESS_MAIN(FaceExtractorTest)
+
+#include "tst_faceextractor.moc"
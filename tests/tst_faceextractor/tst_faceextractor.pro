@@ -0,0 +1,13 @@
+QT       += core gui concurrent widgets testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_faceextractor
+
+INCLUDEPATH += $$PWD/../..
+
+include(../../polygons_on_white_canvas2.pri)
+
+SOURCES += \
+    tst_faceextractor.cpp
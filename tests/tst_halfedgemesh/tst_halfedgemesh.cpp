@@ -0,0 +1,225 @@
+#include "halfedgemesh.h"
+#include "line.h"
+#include "polygon.h"
+#include "vertex.h"
+
+#include <QPointF>
+#include <QtTest>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// Vertices, lines and polygons registered with one HalfEdgeMesh, all
+// without a scene. Entities are referred to by their index.
+class MeshFixture
+{
+public:
+    ~MeshFixture()
+    {
+        m_polygons.clear();
+        m_lines.clear();
+        m_vertices.clear();
+    }
+
+    HalfEdgeMesh &mesh() { return m_mesh; }
+    Vertex *vertex(int index) const { return m_vertices[static_cast<std::size_t>(index)].get(); }
+    Line *line(int index) const { return m_lines[static_cast<std::size_t>(index)].get(); }
+    Polygon *polygon(int index) const { return m_polygons[static_cast<std::size_t>(index)].get(); }
+
+    void addVertex(qreal x, qreal y)
+    {
+        m_vertices.push_back(std::make_unique<Vertex>(static_cast<int>(m_vertices.size()), QPointF(x, y), nullptr));
+        m_vertices.back()->setHalfEdgeMesh(&m_mesh);
+    }
+
+    void addLine(int start, int end)
+    {
+        m_lines.push_back(std::make_unique<Line>(static_cast<int>(m_lines.size()), vertex(start), vertex(end), nullptr));
+        m_lines.back()->setHalfEdgeMesh(&m_mesh);
+    }
+
+    void removeLastLine() { m_lines.pop_back(); }
+    void removeLastPolygon() { m_polygons.pop_back(); }
+
+    void addPolygon(const std::vector<int> &vertexIndices, const std::vector<int> &lineIndices)
+    {
+        std::vector<Vertex *> vertices;
+        for (const int index : vertexIndices)
+            vertices.push_back(vertex(index));
+        std::vector<Line *> lines;
+        for (const int index : lineIndices)
+            lines.push_back(line(index));
+        m_polygons.push_back(
+            std::make_unique<Polygon>(static_cast<int>(m_polygons.size()), vertices, lines, nullptr));
+        m_polygons.back()->setHalfEdgeMesh(&m_mesh);
+    }
+
+    // Target vertex ids around the vertex by increasing angle, starting at
+    // the lowest id.
+    std::vector<int> star(int index) const
+    {
+        std::vector<int> targets;
+        m_mesh.forEachOutgoing(vertex(index), [&](int halfEdge) { targets.push_back(m_mesh.target(halfEdge)->id()); });
+        std::rotate(targets.begin(), std::min_element(targets.begin(), targets.end()), targets.end());
+        return targets;
+    }
+
+    // Origin vertex ids along next from halfEdge until it comes back.
+    std::vector<int> faceWalk(int halfEdge) const
+    {
+        std::vector<int> origins;
+        int current = halfEdge;
+        do {
+            origins.push_back(m_mesh.origin(current)->id());
+            current = m_mesh.next(current);
+        } while (current != halfEdge && origins.size() <= m_mesh.halfEdgeCount());
+        return origins;
+    }
+
+private:
+    HalfEdgeMesh m_mesh;
+    std::vector<std::unique_ptr<Vertex>> m_vertices;
+    std::vector<std::unique_ptr<Line>> m_lines;
+    std::vector<std::unique_ptr<Polygon>> m_polygons;
+};
+
+namespace {
+// The square (0, 0)-(10, 10) as vertices 0..3, its sides as lines 0..3 and
+// the diagonal from vertex 0 to vertex 2 as line 4.
+void buildSplitSquare(MeshFixture &fixture)
+{
+    fixture.addVertex(0.0, 0.0);
+    fixture.addVertex(10.0, 0.0);
+    fixture.addVertex(10.0, 10.0);
+    fixture.addVertex(0.0, 10.0);
+    fixture.addLine(0, 1);
+    fixture.addLine(1, 2);
+    fixture.addLine(2, 3);
+    fixture.addLine(3, 0);
+    fixture.addLine(0, 2);
+}
+} // namespace
+
+class HalfEdgeMeshTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void starIsOrderedByAngle()
+    {
+        MeshFixture fixture;
+        fixture.addVertex(0.0, 0.0);
+        fixture.addVertex(10.0, 0.0);
+        fixture.addVertex(-10.0, 0.0);
+        fixture.addVertex(0.0, -10.0);
+        fixture.addVertex(0.0, 10.0);
+        for (const int arm : {2, 1, 3, 4})
+            fixture.addLine(0, arm);
+        QCOMPARE(fixture.mesh().halfEdgeCount(), std::size_t(8));
+        // North (-90 degrees), east, south, west.
+        QCOMPARE(fixture.star(0), (std::vector<int>{1, 4, 2, 3}));
+
+        // Moving the north arm to the south-east reorders the star.
+        fixture.vertex(3)->setPosition(QPointF(10.0, 10.0));
+        QCOMPARE(fixture.star(0), (std::vector<int>{1, 3, 4, 2}));
+        QCOMPARE(fixture.star(3), std::vector<int>{0});
+    }
+
+    void nextWalksAroundFaces()
+    {
+        MeshFixture fixture;
+        buildSplitSquare(fixture);
+        HalfEdgeMesh &mesh = fixture.mesh();
+        QCOMPARE(fixture.star(0), (std::vector<int>{1, 2, 3}));
+
+        const int side = mesh.halfEdge(fixture.line(0));
+        QCOMPARE(mesh.origin(side), fixture.vertex(0));
+        QCOMPARE(mesh.target(side), fixture.vertex(1));
+        QCOMPARE(fixture.faceWalk(side), (std::vector<int>{0, 1, 2}));
+        QCOMPARE(fixture.faceWalk(mesh.halfEdge(fixture.line(4))), (std::vector<int>{0, 2, 3}));
+        // The outer face runs the other way round.
+        QCOMPARE(fixture.faceWalk(HalfEdgeMesh::twin(side)), (std::vector<int>{1, 0, 3, 2}));
+        QCOMPARE(mesh.prev(mesh.next(side)), side);
+    }
+
+    void removedLineMergesFacesAndFreesItsPair()
+    {
+        MeshFixture fixture;
+        buildSplitSquare(fixture);
+        HalfEdgeMesh &mesh = fixture.mesh();
+        const int diagonal = mesh.halfEdge(fixture.line(4));
+
+        fixture.removeLastLine();
+        QCOMPARE(mesh.halfEdgeCount(), std::size_t(8));
+        QCOMPARE(fixture.faceWalk(mesh.halfEdge(fixture.line(0))), (std::vector<int>{0, 1, 2, 3}));
+        QCOMPARE(fixture.star(0), (std::vector<int>{1, 3}));
+
+        fixture.addLine(0, 2);
+        QCOMPARE(mesh.halfEdge(fixture.line(4)), diagonal);
+        QCOMPARE(fixture.faceWalk(mesh.halfEdge(fixture.line(0))), (std::vector<int>{0, 1, 2}));
+    }
+
+    void faceRingOrdersTheLinesOfAFace()
+    {
+        MeshFixture fixture;
+        buildSplitSquare(fixture);
+        const HalfEdgeMesh &mesh = fixture.mesh();
+
+        std::vector<Line *> lines;
+        std::vector<Vertex *> vertices;
+        QVERIFY(mesh.faceRing({fixture.line(1), fixture.line(4), fixture.line(0)}, lines, vertices));
+        QCOMPARE(lines, (std::vector<Line *>{fixture.line(1), fixture.line(4), fixture.line(0)}));
+        QCOMPARE(vertices, (std::vector<Vertex *>{fixture.vertex(1), fixture.vertex(2), fixture.vertex(0)}));
+
+        // The diagonal runs from vertex 0 to 2, so this face is on its far side.
+        QVERIFY(mesh.faceRing({fixture.line(4), fixture.line(0), fixture.line(1)}, lines, vertices));
+        QCOMPARE(lines, (std::vector<Line *>{fixture.line(4), fixture.line(0), fixture.line(1)}));
+        QCOMPARE(vertices, (std::vector<Vertex *>{fixture.vertex(2), fixture.vertex(0), fixture.vertex(1)}));
+
+        // The sides of the square are the ring of the outer face.
+        QVERIFY(mesh.faceRing({fixture.line(0), fixture.line(1), fixture.line(2), fixture.line(3)}, lines, vertices));
+        QCOMPARE(vertices,
+                 (std::vector<Vertex *>{fixture.vertex(1), fixture.vertex(0), fixture.vertex(3), fixture.vertex(2)}));
+
+        QVERIFY(!mesh.faceRing({fixture.line(0), fixture.line(1), fixture.line(2), fixture.line(4)}, lines, vertices));
+        QVERIFY(!mesh.faceRing({fixture.line(0), fixture.line(1)}, lines, vertices));
+        QVERIFY(!mesh.faceRing({fixture.line(0), fixture.line(0), fixture.line(1)}, lines, vertices));
+        QVERIFY(!mesh.faceRing({fixture.line(0), nullptr, fixture.line(1)}, lines, vertices));
+    }
+
+    void polygonsFindTheirNeighbours()
+    {
+        MeshFixture fixture;
+        buildSplitSquare(fixture);
+        fixture.addPolygon({0, 1, 2}, {0, 1, 4});
+        fixture.addPolygon({0, 2, 3}, {4, 2, 3});
+        const HalfEdgeMesh &mesh = fixture.mesh();
+
+        const int side = mesh.halfEdge(fixture.line(0));
+        QCOMPARE(mesh.face(side), fixture.polygon(0));
+        QCOMPARE(mesh.face(HalfEdgeMesh::twin(side)), static_cast<Polygon *>(nullptr));
+        QCOMPARE(mesh.face(HalfEdgeMesh::twin(mesh.halfEdge(fixture.line(4)))), fixture.polygon(0));
+        QCOMPARE(mesh.face(mesh.halfEdge(fixture.line(4))), fixture.polygon(1));
+
+        std::vector<Line *> ring;
+        mesh.forEachBoundaryHalfEdge(fixture.polygon(1), [&](int halfEdge) { ring.push_back(mesh.line(halfEdge)); });
+        QCOMPARE(ring.size(), std::size_t(3));
+        QVERIFY(std::is_permutation(ring.begin(), ring.end(),
+                                    std::vector<Line *>{fixture.line(2), fixture.line(3), fixture.line(4)}.begin()));
+
+        std::vector<Polygon *> neighbours;
+        mesh.forEachNeighbour(fixture.polygon(0), [&](Polygon *neighbour) { neighbours.push_back(neighbour); });
+        QCOMPARE(neighbours, std::vector<Polygon *>{fixture.polygon(1)});
+
+        fixture.removeLastPolygon();
+        QCOMPARE(mesh.face(mesh.halfEdge(fixture.line(4))), static_cast<Polygon *>(nullptr));
+        neighbours.clear();
+        mesh.forEachNeighbour(fixture.polygon(0), [&](Polygon *neighbour) { neighbours.push_back(neighbour); });
+        QVERIFY(neighbours.empty());
+    }
+};
+
+QTEST_APPLESS_MAIN(HalfEdgeMeshTest)
+
+#include "tst_halfedgemesh.moc"
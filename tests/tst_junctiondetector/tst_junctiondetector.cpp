@@ -0,0 +1,140 @@
+#include "binaryimage.h"
+#include "junctiondetector.h"
+
+#include <QPointF>
+#include <QString>
+#include <QStringList>
+#include <QtTest>
+
+#include <vector>
+
+namespace {
+// '#' is foreground, anything else background.
+BinaryImage fromRows(const QStringList &rows)
+{
+    BinaryImage image(static_cast<int>(rows.first().size()), static_cast<int>(rows.size()));
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, rows.at(y).at(x) == QLatin1Char('#'));
+    }
+    return image;
+}
+
+QStringList toRows(const BinaryImage &image)
+{
+    QStringList rows;
+    for (int y = 0; y < image.height(); ++y) {
+        QString row;
+        for (int x = 0; x < image.width(); ++x)
+            row += image.pixel(x, y) ? QLatin1Char('#') : QLatin1Char('.');
+        rows << row;
+    }
+    return rows;
+}
+} // namespace
+
+class JunctionDetectorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void branchlessSkeletonsHaveNoJunctions()
+    {
+        const QStringList rows = {
+            "..........",
+            ".####.....",
+            ".#..#..#..",
+            ".####...#.",
+            ".........#",
+        };
+        QCOMPARE(junctionPixels(fromRows(rows)).count(), qint64(0));
+        QVERIFY(detectJunctions(fromRows(rows)).empty());
+    }
+
+    void teeHasOneJunctionPixel()
+    {
+        const QStringList tee = {
+            ".......",
+            ".#####.",
+            "...#...",
+            "...#...",
+            ".......",
+        };
+        const QStringList expected = {
+            ".......",
+            "...#...",
+            ".......",
+            ".......",
+            ".......",
+        };
+        QCOMPARE(toRows(junctionPixels(fromRows(tee))), expected);
+        QCOMPARE(detectJunctions(fromRows(tee)), std::vector<QPointF>{QPointF(3.5, 1.5)});
+    }
+
+    // The four pixels around the centre of a cross each see three branches;
+    // they are one junction at their centre.
+    void crossIsOneJunction()
+    {
+        const QStringList cross = {
+            "...#...",
+            "...#...",
+            "...#...",
+            "###.###",
+            "...#...",
+            "...#...",
+            "...#...",
+        };
+        const QStringList expected = {
+            ".......",
+            ".......",
+            "...#...",
+            "..#.#..",
+            "...#...",
+            ".......",
+            ".......",
+        };
+        QCOMPARE(toRows(junctionPixels(fromRows(cross))), expected);
+        QCOMPARE(detectJunctions(fromRows(cross)), std::vector<QPointF>{QPointF(3.5, 3.5)});
+    }
+
+    // Ordered by the first pixel of each junction region, so the junction
+    // whose branch comes from above is first.
+    void junctionsComeInRasterOrder()
+    {
+        const QStringList rows = {
+            "............",
+            ".........#..",
+            ".........#..",
+            ".###########",
+            "..#.........",
+            "..#.........",
+        };
+        QCOMPARE(detectJunctions(fromRows(rows)),
+                 (std::vector<QPointF>{QPointF(9.5, 3.5), QPointF(2.5, 3.5)}));
+    }
+
+    void junctionOnWordBoundary()
+    {
+        // The stem sits on the last bit of the first word, the bar runs on
+        // into the second.
+        BinaryImage skeleton(80, 6);
+        for (int x = 60; x < 70; ++x)
+            skeleton.setPixel(x, 1, true);
+        for (int y = 2; y < 6; ++y)
+            skeleton.setPixel(63, y, true);
+        const BinaryImage junctions = junctionPixels(skeleton);
+        QCOMPARE(junctions.count(), qint64(1));
+        QVERIFY(junctions.pixel(63, 1));
+        QCOMPARE(detectJunctions(skeleton), std::vector<QPointF>{QPointF(63.5, 1.5)});
+
+        for (int y = 2; y < 6; ++y) {
+            skeleton.setPixel(63, y, false);
+            skeleton.setPixel(64, y, true);
+        }
+        QCOMPARE(detectJunctions(skeleton), std::vector<QPointF>{QPointF(64.5, 1.5)});
+    }
+};
+
+QTEST_APPLESS_MAIN(JunctionDetectorTest)
+
+#include "tst_junctiondetector.moc"
@@ -0,0 +1,134 @@
+#include "binaryimage.h"
+#include "labelimage.h"
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QtTest>
+
+#include <algorithm>
+
+namespace {
+// One digit per label.
+QStringList toRows(const LabelImage &labels)
+{
+    QStringList rows;
+    for (int y = 0; y < labels.height(); ++y) {
+        QString row;
+        for (int x = 0; x < labels.width(); ++x)
+            row += QLatin1Char(static_cast<char>('0' + labels.label(x, y)));
+        rows << row;
+    }
+    return rows;
+}
+
+QStringList toRows(const BinaryImage &image)
+{
+    QStringList rows;
+    for (int y = 0; y < image.height(); ++y) {
+        QString row;
+        for (int x = 0; x < image.width(); ++x)
+            row += image.pixel(x, y) ? QLatin1Char('#') : QLatin1Char('.');
+        rows << row;
+    }
+    return rows;
+}
+
+// One digit per pixel, the digit being its label.
+LabelImage fromRows(const QStringList &rows)
+{
+    int labelCount = 0;
+    for (const QString &row : rows) {
+        for (const QChar digit : row)
+            labelCount = std::max(labelCount, digit.digitValue());
+    }
+    LabelImage labels(static_cast<int>(rows.first().size()), static_cast<int>(rows.size()), labelCount);
+    for (int y = 0; y < labels.height(); ++y) {
+        for (int x = 0; x < labels.width(); ++x)
+            labels.setLabel(x, y, rows.at(y).at(x).digitValue());
+    }
+    return labels;
+}
+} // namespace
+
+class LabelImageTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nullImageGivesNullLabels() { QVERIFY(LabelImage::fromImage(QImage()).isNull()); }
+
+    // Grey levels are taken as they are; labels that do not occur still
+    // count.
+    void greyPixelsAreLabels()
+    {
+        QImage image(4, 2, QImage::Format_Grayscale8);
+        const uchar values[2][4] = {{0, 3, 3, 7}, {0, 0, 5, 7}};
+        for (int y = 0; y < 2; ++y)
+            std::copy(values[y], values[y] + 4, image.scanLine(y));
+
+        const LabelImage labels = LabelImage::fromImage(image);
+        QCOMPARE(labels.labelCount(), 7);
+        QCOMPARE(toRows(labels), (QStringList{"0337", "0057"}));
+    }
+
+    void wideGreyPixelsAreLabels()
+    {
+        QImage image(3, 2, QImage::Format_Grayscale16);
+        const quint16 values[2][3] = {{1000, 1000, 0}, {2, 1000, 300}};
+        for (int y = 0; y < 2; ++y)
+            std::copy(values[y], values[y] + 3, reinterpret_cast<quint16 *>(image.scanLine(y)));
+
+        const LabelImage labels = LabelImage::fromImage(image);
+        QCOMPARE(labels.labelCount(), 1000);
+        QCOMPARE(labels.label(0, 0), 1000);
+        QCOMPARE(labels.label(2, 0), 0);
+        QCOMPARE(labels.label(0, 1), 2);
+        QCOMPARE(labels.label(2, 1), 300);
+    }
+
+    // Black is no label; other colours are numbered as they first appear in
+    // raster order, also when they come back after another colour.
+    void coloursAreNumberedInRasterOrder()
+    {
+        QImage image(5, 3, QImage::Format_RGB32);
+        image.fill(qRgb(0, 0, 0));
+        const QRgb red = qRgb(255, 0, 0);
+        const QRgb green = qRgb(0, 255, 0);
+        const QRgb blue = qRgb(0, 0, 255);
+        image.setPixel(1, 0, green);
+        image.setPixel(2, 0, green);
+        image.setPixel(3, 0, red);
+        image.setPixel(4, 0, green);
+        image.setPixel(0, 1, blue);
+        image.setPixel(1, 1, red);
+        image.setPixel(4, 2, blue);
+
+        const LabelImage labels = LabelImage::fromImage(image);
+        QCOMPARE(labels.labelCount(), 3);
+        QCOMPARE(toRows(labels), (QStringList{"01121", "32000", "00003"}));
+    }
+
+    // A pixel is on a boundary if its right or lower neighbour differs, so
+    // the trace runs along the upper and left side of each change.
+    void boundariesMarkRightAndLowerChanges()
+    {
+        const LabelImage labels = fromRows({
+            "11122",
+            "11122",
+            "33322",
+            "33322",
+        });
+        QCOMPARE(toRows(labels.boundaries()),
+                 (QStringList{
+                     "..#..",
+                     "###..",
+                     "..#..",
+                     "..#..",
+                 }));
+    }
+};
+
+QTEST_APPLESS_MAIN(LabelImageTest)
+
+#include "tst_labelimage.moc"
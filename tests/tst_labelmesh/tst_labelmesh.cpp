@@ -0,0 +1,203 @@
+#include "labelimage.h"
+#include "labelmesh.h"
+#include "planarmesh.h"
+
+#include <QPointF>
+#include <QString>
+#include <QStringList>
+#include <QtTest>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+// One digit per pixel, the digit being its label.
+LabelImage fromRows(const QStringList &rows)
+{
+    int labelCount = 0;
+    for (const QString &row : rows) {
+        for (const QChar digit : row)
+            labelCount = std::max(labelCount, digit.digitValue());
+    }
+    LabelImage labels(static_cast<int>(rows.first().size()), static_cast<int>(rows.size()), labelCount);
+    for (int y = 0; y < labels.height(); ++y) {
+        for (int x = 0; x < labels.width(); ++x)
+            labels.setLabel(x, y, rows.at(y).at(x).digitValue());
+    }
+    return labels;
+}
+
+// Each face as "x,y x,y ..." from its topmost, then leftmost, vertex, and
+// the faces sorted, so that the expectations do not depend on the order the
+// faces are walked in.
+QStringList faceRings(const PlanarMesh &mesh)
+{
+    QStringList rings;
+    for (std::size_t face = 0; face < mesh.faceCount(); ++face) {
+        std::vector<QPointF> ring;
+        for (int i = mesh.faceOffsets[face]; i < mesh.faceOffsets[face + 1]; ++i)
+            ring.push_back(mesh.vertices[static_cast<std::size_t>(mesh.faceVertices[static_cast<std::size_t>(i)])]);
+        std::rotate(ring.begin(),
+                    std::min_element(ring.begin(),
+                                     ring.end(),
+                                     [](const QPointF &first, const QPointF &second) {
+                                         return first.y() != second.y() ? first.y() < second.y()
+                                                                        : first.x() < second.x();
+                                     }),
+                    ring.end());
+        QStringList points;
+        for (const QPointF &point : ring)
+            points << QStringLiteral("%1,%2").arg(point.x()).arg(point.y());
+        rings << points.join(QLatin1Char(' '));
+    }
+    rings.sort();
+    return rings;
+}
+
+// Labels split into blocks at the given columns and rows, numbered in raster
+// order from 1.
+LabelImage blocks(int width, int height, const std::vector<int> &columns, const std::vector<int> &rows)
+{
+    const int blocksPerRow = static_cast<int>(columns.size()) + 1;
+    LabelImage labels(width, height, blocksPerRow * (static_cast<int>(rows.size()) + 1));
+    for (int y = 0; y < height; ++y) {
+        const auto row = std::upper_bound(rows.begin(), rows.end(), y) - rows.begin();
+        for (int x = 0; x < width; ++x) {
+            const auto column = std::upper_bound(columns.begin(), columns.end(), x) - columns.begin();
+            labels.setLabel(x, y, static_cast<int>(row) * blocksPerRow + static_cast<int>(column) + 1);
+        }
+    }
+    return labels;
+}
+} // namespace
+
+class LabelMeshTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nullLabelsGiveEmptyMesh()
+    {
+        std::vector<int> lost = {1};
+        const PlanarMesh mesh = meshFromLabels(LabelImage(), 1.0, &lost);
+        QCOMPARE(mesh.faceCount(), std::size_t(0));
+        QVERIFY(mesh.vertices.empty());
+        QVERIFY(lost.empty());
+    }
+
+    // The boundary between the two regions is one line that both faces use.
+    void neighboursShareTheirBoundary()
+    {
+        const PlanarMesh mesh = meshFromLabels(fromRows({
+                                                   "1122",
+                                                   "1122",
+                                                   "1122",
+                                               }),
+                                               0.0);
+        QCOMPARE(faceRings(mesh), (QStringList{"0,0 2,0 2,3 0,3", "2,0 4,0 4,3 2,3"}));
+        QCOMPARE(mesh.vertices.size(), std::size_t(6));
+        QCOMPARE(mesh.lines.size(), std::size_t(7));
+    }
+
+    // Background between regions gets no face.
+    void backgroundIsNotAFace()
+    {
+        const PlanarMesh mesh = meshFromLabels(fromRows({
+                                                   "11022",
+                                                   "11022",
+                                               }),
+                                               0.0);
+        QCOMPARE(faceRings(mesh), (QStringList{"0,0 2,0 2,2 0,2", "3,0 5,0 5,2 3,2"}));
+    }
+
+    // Block corners on the seams between 256 lattice point tiles, including
+    // the point where four tiles meet, still join into one vertex each.
+    void chainsCrossTileSeams()
+    {
+        std::vector<int> lost;
+        const PlanarMesh mesh = meshFromLabels(blocks(600, 300, {256, 512}, {256}), 1.0, &lost);
+        QCOMPARE(faceRings(mesh),
+                 (QStringList{"0,0 256,0 256,256 0,256",
+                              "0,256 256,256 256,300 0,300",
+                              "256,0 512,0 512,256 256,256",
+                              "256,256 512,256 512,300 256,300",
+                              "512,0 600,0 600,256 512,256",
+                              "512,256 600,256 600,300 512,300"}));
+        QCOMPARE(mesh.vertices.size(), std::size_t(12));
+        QCOMPARE(mesh.lines.size(), std::size_t(17));
+        QVERIFY(lost.empty());
+    }
+
+    // A region inside another has a boundary without junctions; it is traced
+    // once even when it runs through several tiles.
+    void closedIslandsGetFaces()
+    {
+        QCOMPARE(faceRings(meshFromLabels(fromRows({
+                                              "11111",
+                                              "12221",
+                                              "12221",
+                                              "11111",
+                                          }),
+                                          0.0)),
+                 (QStringList{"0,0 5,0 5,4 0,4", "1,1 4,1 4,3 1,3"}));
+
+        LabelImage labels(300, 20, 2);
+        for (int y = 0; y < labels.height(); ++y) {
+            for (int x = 0; x < labels.width(); ++x)
+                labels.setLabel(x, y, x >= 250 && x < 260 && y >= 5 && y < 15 ? 2 : 1);
+        }
+        const PlanarMesh mesh = meshFromLabels(labels, 1.0);
+        QCOMPARE(faceRings(mesh), (QStringList{"0,0 300,0 300,20 0,20", "250,5 260,5 260,15 250,15"}));
+        QCOMPARE(mesh.lines.size(), std::size_t(8));
+    }
+
+    // The hole in the ring of 1 reaches the background through a corner, so
+    // the boundary of 1 passes that corner twice and 1 cannot be a face;
+    // 2 beside it still is.
+    void pinchedLabelsAreLost()
+    {
+        std::vector<int> lost;
+        const PlanarMesh mesh = meshFromLabels(fromRows({
+                                                   "1112",
+                                                   "1012",
+                                                   "1102",
+                                               }),
+                                               0.0,
+                                               &lost);
+        QCOMPARE(faceRings(mesh), QStringList{"3,0 4,0 4,3 3,3 3,2"});
+        QCOMPARE(lost, std::vector<int>{1});
+    }
+
+    // Straightening the boundary between 1 and 2 would put the island of 3
+    // on the side of 2, so that boundary keeps its dent; without the island
+    // it is simplified to a straight line.
+    void simplificationKeepsPointsOnTheirSide()
+    {
+        QStringList rows = {
+            "111111111111",
+            "111111111111",
+            "111111111111",
+            "111111111111",
+            "222211111222",
+            "222211311222",
+            "222211111222",
+            "222222222222",
+            "222222222222",
+            "222222222222",
+            "222222222222",
+            "222222222222",
+        };
+        QCOMPARE(faceRings(meshFromLabels(fromRows(rows), 3.5)),
+                 (QStringList{"0,0 12,0 12,4 9,4 9,7 4,7 4,4 0,4",
+                              "0,4 4,4 4,7 9,7 9,4 12,4 12,12 0,12",
+                              "6,5 7,5 7,6"}));
+
+        rows[5] = QStringLiteral("222211111222");
+        QCOMPARE(faceRings(meshFromLabels(fromRows(rows), 3.5)),
+                 (QStringList{"0,0 12,0 12,4 0,4", "0,4 12,4 12,12 0,12"}));
+    }
+};
+
+QTEST_APPLESS_MAIN(LabelMeshTest)
+
+#include "tst_labelmesh.moc"
@@ -0,0 +1,166 @@
+#include "binaryimage.h"
+#include "skeletonizer.h"
+
+#include <QString>
+#include <QStringList>
+#include <QtTest>
+
+#include <algorithm>
+#include <random>
+
+namespace {
+// '#' is foreground, anything else background.
+BinaryImage fromRows(const QStringList &rows)
+{
+    BinaryImage image(static_cast<int>(rows.first().size()), static_cast<int>(rows.size()));
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, rows.at(y).at(x) == QLatin1Char('#'));
+    }
+    return image;
+}
+
+QStringList toRows(const BinaryImage &image)
+{
+    QStringList rows;
+    for (int y = 0; y < image.height(); ++y) {
+        QString row;
+        for (int x = 0; x < image.width(); ++x)
+            row += image.pixel(x, y) ? QLatin1Char('#') : QLatin1Char('.');
+        rows << row;
+    }
+    return rows;
+}
+
+// Guo and Hall (1989) pixel by pixel, with the neighbours numbered as in the
+// paper: p2 = N, then clockwise to p9 = NW.
+BinaryImage referenceSkeleton(BinaryImage image)
+{
+    const auto at = [](const BinaryImage &source, int x, int y) {
+        return x >= 0 && x < source.width() && y >= 0 && y < source.height() && source.pixel(x, y);
+    };
+    for (;;) {
+        bool changed = false;
+        for (const bool firstSubiteration : {true, false}) {
+            BinaryImage next = image;
+            for (int y = 0; y < image.height(); ++y) {
+                for (int x = 0; x < image.width(); ++x) {
+                    if (!image.pixel(x, y))
+                        continue;
+                    const bool p2 = at(image, x, y - 1);
+                    const bool p3 = at(image, x + 1, y - 1);
+                    const bool p4 = at(image, x + 1, y);
+                    const bool p5 = at(image, x + 1, y + 1);
+                    const bool p6 = at(image, x, y + 1);
+                    const bool p7 = at(image, x - 1, y + 1);
+                    const bool p8 = at(image, x - 1, y);
+                    const bool p9 = at(image, x - 1, y - 1);
+                    const int c = (!p2 && (p3 || p4)) + (!p4 && (p5 || p6)) + (!p6 && (p7 || p8))
+                                  + (!p8 && (p9 || p2));
+                    const int n1 = (p9 || p2) + (p3 || p4) + (p5 || p6) + (p7 || p8);
+                    const int n2 = (p2 || p3) + (p4 || p5) + (p6 || p7) + (p8 || p9);
+                    const int n = std::min(n1, n2);
+                    const bool m = firstSubiteration ? ((p2 || p3 || !p5) && p4) : ((p6 || p7 || !p9) && p8);
+                    if (c == 1 && n >= 2 && n <= 3 && !m) {
+                        next.setPixel(x, y, false);
+                        changed = true;
+                    }
+                }
+            }
+            image = next;
+        }
+        if (!changed)
+            return image;
+    }
+}
+} // namespace
+
+class SkeletonizerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nullImageStaysNull() { QVERIFY(thinToSkeleton(BinaryImage()).isNull()); }
+
+    void thinLinesAreKept()
+    {
+        const QStringList rows = {
+            "..........",
+            ".#........",
+            "..#.......",
+            "...#......",
+            "....######",
+            "..........",
+        };
+        QCOMPARE(toRows(thinToSkeleton(fromRows(rows))), rows);
+    }
+
+    void barThinsToOneRowAcrossWords()
+    {
+        // 150 pixels wide, so the bar runs over three words per row.
+        BinaryImage bar(150, 5);
+        for (int y = 1; y <= 3; ++y) {
+            for (int x = 1; x < 149; ++x)
+                bar.setPixel(x, y, true);
+        }
+        const BinaryImage skeleton = thinToSkeleton(bar);
+        QCOMPARE(skeleton.count(), qint64(146));
+        for (int x = 2; x < 148; ++x)
+            QVERIFY(skeleton.pixel(x, 2));
+    }
+
+    // The corners are cut diagonally, and the loop stays closed.
+    void frameThinsToClosedLoop()
+    {
+        const QStringList frame = {
+            "............",
+            ".##########.",
+            ".##########.",
+            ".##########.",
+            ".###....###.",
+            ".###....###.",
+            ".##########.",
+            ".##########.",
+            ".##########.",
+            "............",
+        };
+        const QStringList expected = {
+            "............",
+            "............",
+            "...#####....",
+            "..#.....#...",
+            "..#......#..",
+            "..#......#..",
+            "..#.....#...",
+            "...#####....",
+            "............",
+            "............",
+        };
+        QCOMPARE(toRows(thinToSkeleton(fromRows(frame))), expected);
+    }
+
+    void matchesPixelByPixelReference()
+    {
+        // Random blobs over several words and more rows than stripes.
+        std::mt19937 random(7);
+        for (int trial = 0; trial < 4; ++trial) {
+            BinaryImage image(130 + 20 * trial, 90);
+            for (int disc = 0; disc < 40; ++disc) {
+                const int cx = static_cast<int>(random() % static_cast<unsigned>(image.width()));
+                const int cy = static_cast<int>(random() % static_cast<unsigned>(image.height()));
+                const int radius = 2 + static_cast<int>(random() % 9);
+                for (int y = std::max(0, cy - radius); y <= std::min(image.height() - 1, cy + radius); ++y) {
+                    for (int x = std::max(0, cx - radius); x <= std::min(image.width() - 1, cx + radius); ++x) {
+                        if ((x - cx) * (x - cx) + (y - cy) * (y - cy) <= radius * radius)
+                            image.setPixel(x, y, true);
+                    }
+                }
+            }
+            QCOMPARE(toRows(thinToSkeleton(image)), toRows(referenceSkeleton(image)));
+        }
+    }
+};
+
+QTEST_APPLESS_MAIN(SkeletonizerTest)
+
+#include "tst_skeletonizer.moc"
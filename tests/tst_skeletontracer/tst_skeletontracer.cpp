@@ -0,0 +1,153 @@
+#include "binaryimage.h"
+#include "skeletontracer.h"
+
+#include <QPointF>
+#include <QStringList>
+#include <QtTest>
+
+#include <cmath>
+#include <vector>
+
+namespace {
+// '#' is foreground, anything else background.
+BinaryImage fromRows(const QStringList &rows)
+{
+    BinaryImage image(static_cast<int>(rows.first().size()), static_cast<int>(rows.size()));
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, rows.at(y).at(x) == QLatin1Char('#'));
+    }
+    return image;
+}
+
+// A bar along row 1 with a stem of stemLength pixels down from column 11.
+BinaryImage tee(int stemLength)
+{
+    BinaryImage image(24, stemLength + 3);
+    for (int x = 1; x < 23; ++x)
+        image.setPixel(x, 1, true);
+    for (int y = 2; y < stemLength + 2; ++y)
+        image.setPixel(11, y, true);
+    return image;
+}
+} // namespace
+
+class SkeletonTracerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void curvesWithoutJunctionsAreIgnored()
+    {
+        QVERIFY(traceSkeleton(BinaryImage()).nodes.empty());
+
+        const SkeletonGraph graph = traceSkeleton(fromRows({
+            "..........",
+            ".####..#..",
+            ".#..#...#.",
+            ".####....#",
+        }));
+        QVERIFY(graph.nodes.empty());
+        QVERIFY(graph.branches.empty());
+    }
+
+    void thetaHasThreeBranchesBetweenTwoJunctions()
+    {
+        const SkeletonGraph graph = traceSkeleton(fromRows({
+            "...............",
+            ".#############.",
+            ".#.....#.....#.",
+            ".#.....#.....#.",
+            ".#.....#.....#.",
+            ".#############.",
+            "...............",
+        }));
+        QCOMPARE(graph.nodes, (std::vector<QPointF>{QPointF(7.5, 1.5), QPointF(7.5, 5.5)}));
+        QCOMPARE(graph.branches.size(), std::size_t(3));
+        for (const SkeletonBranch &branch : graph.branches) {
+            QCOMPARE(branch.start, 0);
+            QCOMPARE(branch.end, 1);
+        }
+        // The sides cut the corners of the frame diagonally.
+        QCOMPARE(graph.branches[0].length, 12.0 + 2.0 * std::sqrt(2.0));
+        QCOMPARE(graph.branches[1].length, 12.0 + 2.0 * std::sqrt(2.0));
+        QCOMPARE(graph.branches[2].length, 4.0);
+        QCOMPARE(graph.branches[2].polyline,
+                 (std::vector<QPointF>{QPointF(7.5, 1.5), QPointF(7.5, 3.5), QPointF(7.5, 5.5)}));
+    }
+
+    void longArmsEndInNodes()
+    {
+        const SkeletonGraph graph = traceSkeleton(tee(11));
+        QCOMPARE(graph.nodes,
+                 (std::vector<QPointF>{QPointF(11.5, 1.5), QPointF(1.5, 1.5), QPointF(22.5, 1.5), QPointF(11.5, 12.5)}));
+        QCOMPARE(graph.branches.size(), std::size_t(3));
+        const int ends[3] = {1, 2, 3};
+        const qreal lengths[3] = {10.0, 11.0, 11.0};
+        for (int i = 0; i < 3; ++i) {
+            const SkeletonBranch &branch = graph.branches[static_cast<std::size_t>(i)];
+            QCOMPARE(branch.start, 0);
+            QCOMPARE(branch.end, ends[i]);
+            QCOMPARE(branch.length, lengths[i]);
+            QCOMPARE(branch.polyline.front(), graph.nodes[0]);
+            QCOMPARE(branch.polyline.back(), graph.nodes[static_cast<std::size_t>(ends[i])]);
+        }
+    }
+
+    void polylinesCanBeLeftOut()
+    {
+        SkeletonTraceOptions options;
+        options.polylines = false;
+        const SkeletonGraph graph = traceSkeleton(tee(11), options);
+        QCOMPARE(graph.branches.size(), std::size_t(3));
+        QCOMPARE(graph.branches[2].length, 11.0);
+        for (const SkeletonBranch &branch : graph.branches)
+            QVERIFY(branch.polyline.empty());
+    }
+
+    // Without the spur the junction joins just two branches and dissolves.
+    void shortSpurIsPruned()
+    {
+        const SkeletonGraph graph = traceSkeleton(tee(3));
+        QCOMPARE(graph.nodes, (std::vector<QPointF>{QPointF(1.5, 1.5), QPointF(22.5, 1.5)}));
+        QCOMPARE(graph.branches.size(), std::size_t(1));
+        const SkeletonBranch &branch = graph.branches.front();
+        QCOMPARE(branch.start, 0);
+        QCOMPARE(branch.end, 1);
+        QCOMPARE(branch.length, 21.0);
+        QCOMPARE(branch.polyline.size(), std::size_t(20));
+        QCOMPARE(branch.polyline.front(), QPointF(1.5, 1.5));
+        QCOMPARE(branch.polyline[9], QPointF(11.5, 1.5));
+        QCOMPARE(branch.polyline.back(), QPointF(22.5, 1.5));
+
+        SkeletonTraceOptions options;
+        options.minimumSpurLength = 0.0;
+        const SkeletonGraph unpruned = traceSkeleton(tee(3), options);
+        QCOMPARE(unpruned.nodes.size(), std::size_t(4));
+        QCOMPARE(unpruned.branches.size(), std::size_t(3));
+        QCOMPARE(unpruned.branches[2].length, 3.0);
+    }
+
+    void loopReturnsToItsJunction()
+    {
+        // The tail is shorter than a spur, so only the loop is left.
+        const SkeletonGraph graph = traceSkeleton(fromRows({
+            "..............",
+            ".#####........",
+            ".#...#........",
+            ".#...#########",
+            ".#...#........",
+            ".#####........",
+            "..............",
+        }));
+        QCOMPARE(graph.nodes, std::vector<QPointF>{QPointF(5.5, 3.5)});
+        QCOMPARE(graph.branches.size(), std::size_t(1));
+        QCOMPARE(graph.branches[0].start, 0);
+        QCOMPARE(graph.branches[0].end, 0);
+        QCOMPARE(graph.branches[0].length, 9.0 + std::sqrt(5.0) + 2.0 * std::sqrt(2.0));
+    }
+};
+
+QTEST_APPLESS_MAIN(SkeletonTracerTest)
+
+#include "tst_skeletontracer.moc"
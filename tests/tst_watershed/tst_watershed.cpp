@@ -0,0 +1,264 @@
+#include "binaryimage.h"
+#include "distancetransform.h"
+#include "labelimage.h"
+#include "watershed.h"
+
+#include <QImage>
+#include <QPoint>
+#include <QString>
+#include <QStringList>
+#include <QtTest>
+
+#include <functional>
+#include <queue>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace {
+// '#' is foreground, anything else background.
+BinaryImage fromRows(const QStringList &rows)
+{
+    BinaryImage image(static_cast<int>(rows.first().size()), static_cast<int>(rows.size()));
+    for (int y = 0; y < image.height(); ++y) {
+        for (int x = 0; x < image.width(); ++x)
+            image.setPixel(x, y, rows.at(y).at(x) == QLatin1Char('#'));
+    }
+    return image;
+}
+
+// One digit per label.
+QStringList toRows(const LabelImage &labels)
+{
+    QStringList rows;
+    for (int y = 0; y < labels.height(); ++y) {
+        QString row;
+        for (int x = 0; x < labels.width(); ++x)
+            row += QLatin1Char(static_cast<char>('0' + labels.label(x, y)));
+        rows << row;
+    }
+    return rows;
+}
+
+QImage greyImage(const BinaryImage &mask, int contour, int background)
+{
+    QImage image(mask.width(), mask.height(), QImage::Format_Grayscale8);
+    for (int y = 0; y < mask.height(); ++y) {
+        uchar *pixels = image.scanLine(y);
+        for (int x = 0; x < mask.width(); ++x)
+            pixels[x] = static_cast<uchar>(mask.pixel(x, y) ? contour : background);
+    }
+    return image;
+}
+
+// Two cells of 9 x 7 pixels side by side, walled in by contour pixels.
+BinaryImage twoCells()
+{
+    return fromRows({
+        "#####################",
+        "#.........#.........#",
+        "#.........#.........#",
+        "#.........#.........#",
+        "#.........#.........#",
+        "#.........#.........#",
+        "#.........#.........#",
+        "#.........#.........#",
+        "#####################",
+    });
+}
+
+// Marker-controlled flooding with a priority queue ordered by level and then
+// by arrival, for 8-bit images with dark contours.
+std::vector<int> referenceWatershed(const QImage &image, const std::vector<QPoint> &markers)
+{
+    const int width = image.width();
+    const int height = image.height();
+    std::vector<int> heights(static_cast<std::size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x)
+            heights[static_cast<std::size_t>(y * width + x)] = 255 - image.constScanLine(y)[x];
+    }
+
+    std::vector<int> labels(heights.size(), 0);
+    using Entry = std::tuple<int, long, int, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    long arrival = 0;
+    int level = 0;
+    const auto pushNeighbours = [&](int index, int label) {
+        const int x = index % width;
+        for (const int neighbour : {x > 0 ? index - 1 : -1,
+                                    x + 1 < width ? index + 1 : -1,
+                                    index - width,
+                                    index + width < width * height ? index + width : -1}) {
+            if (neighbour < 0 || labels[static_cast<std::size_t>(neighbour)] != 0)
+                continue;
+            labels[static_cast<std::size_t>(neighbour)] = -label;
+            queue.emplace(std::max(heights[static_cast<std::size_t>(neighbour)], level), arrival++, neighbour, label);
+        }
+    };
+    for (std::size_t i = 0; i < markers.size(); ++i)
+        labels[static_cast<std::size_t>(markers[i].y() * width + markers[i].x())] = static_cast<int>(i) + 1;
+    for (std::size_t i = 0; i < markers.size(); ++i)
+        pushNeighbours(markers[i].y() * width + markers[i].x(), static_cast<int>(i) + 1);
+    while (!queue.empty()) {
+        const auto [entryLevel, entryArrival, index, label] = queue.top();
+        Q_UNUSED(entryArrival);
+        queue.pop();
+        level = entryLevel;
+        labels[static_cast<std::size_t>(index)] = label;
+        pushNeighbours(index, label);
+    }
+    return labels;
+}
+} // namespace
+
+class WatershedTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void nullImageGivesNullLabels() { QVERIFY(watershed(QImage(), BinaryImage(), {QPoint(0, 0)}).isNull()); }
+
+    // The same split whichever side of the grey range the contour is on.
+    void regionsMeetOnTheContour()
+    {
+        const BinaryImage contour = fromRows({
+            "...........",
+            ".....#.....",
+            ".....#.....",
+            ".....#.....",
+            "...........",
+        });
+        const QStringList expected = {
+            "11111122222",
+            "11111122222",
+            "11111122222",
+            "11111122222",
+            "11111122222",
+        };
+        const std::vector<QPoint> markers = {QPoint(2, 2), QPoint(8, 2)};
+        QCOMPARE(toRows(watershed(greyImage(contour, 200, 50), contour, markers)), expected);
+        const LabelImage labels = watershed(greyImage(contour, 20, 230), contour, markers);
+        QCOMPARE(labels.labelCount(), 2);
+        QCOMPARE(toRows(labels), expected);
+
+        QImage image16(contour.width(), contour.height(), QImage::Format_Grayscale16);
+        for (int y = 0; y < contour.height(); ++y) {
+            auto *pixels = reinterpret_cast<quint16 *>(image16.scanLine(y));
+            for (int x = 0; x < contour.width(); ++x)
+                pixels[x] = contour.pixel(x, y) ? 4000 : 60000;
+        }
+        QCOMPARE(toRows(watershed(image16, contour, markers)), expected);
+    }
+
+    void markersOutsideTheImageAreSkipped()
+    {
+        const BinaryImage contour = twoCells();
+        const LabelImage labels = watershed(greyImage(contour, 20, 230), contour, {QPoint(14, 4), QPoint(30, 4)});
+        QCOMPARE(labels.labelCount(), 2);
+        for (int y = 0; y < labels.height(); ++y) {
+            for (int x = 0; x < labels.width(); ++x)
+                QCOMPARE(labels.label(x, y), 1);
+        }
+
+        const LabelImage unlabelled = watershed(greyImage(contour, 20, 230), contour, {});
+        QCOMPARE(unlabelled.labelCount(), 0);
+        QCOMPARE(unlabelled.label(14, 4), 0);
+    }
+
+    void matchesPriorityQueueFlooding()
+    {
+        std::mt19937 random(5);
+        for (int trial = 0; trial < 4; ++trial) {
+            const int width = 70 + 30 * trial;
+            const int height = 40 + 10 * trial;
+            const int cell = 9 + 3 * trial;
+            BinaryImage contour(width, height);
+            QImage image(width, height, QImage::Format_Grayscale8);
+            std::vector<QPoint> markers;
+            for (int y = 0; y < height; ++y) {
+                uchar *pixels = image.scanLine(y);
+                for (int x = 0; x < width; ++x) {
+                    const bool membrane = x % cell < 2 || y % cell < 2;
+                    contour.setPixel(x, y, membrane);
+                    pixels[x] = static_cast<uchar>((membrane ? 40 : 190) + static_cast<int>(random() % 40) - 20);
+                    if (x % cell == cell / 2 + 1 && y % cell == cell / 2 + 1)
+                        markers.emplace_back(x, y);
+                }
+            }
+
+            const LabelImage labels = watershed(image, contour, markers);
+            const std::vector<int> expected = referenceWatershed(image, markers);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x)
+                    QCOMPARE(labels.label(x, y), expected[static_cast<std::size_t>(y * width + x)]);
+            }
+        }
+    }
+
+    void maximaMarkOneCellEach()
+    {
+        const BinaryImage contour = twoCells();
+        const DistanceTransform distance(contour);
+        const std::vector<QPoint> expected = {QPoint(4, 4), QPoint(14, 4)};
+        QCOMPARE(distanceMaxima(distance, 1.0), expected);
+        QVERIFY(distanceMaxima(DistanceTransform(), 1.0).empty());
+
+        // No cell fits a disc of radius 5.
+        QVERIFY(distanceMaxima(distance, 5.0).empty());
+
+        const LabelImage labels = watershed(greyImage(contour, 20, 230), contour, expected);
+        QCOMPARE(labels.label(9, 4), 1);
+        QCOMPARE(labels.label(11, 4), 2);
+    }
+
+    // Even a tolerance deeper than the cells does not carry a marker's claim
+    // over the contour into the next cell.
+    void claimsStopAtTheContours()
+    {
+        const DistanceTransform distance(twoCells());
+        QCOMPARE(distanceMaxima(distance, 1.0, 100.0), (std::vector<QPoint>{QPoint(4, 4), QPoint(14, 4)}));
+        QCOMPARE(distanceMaxima(distance, 0.0, 100.0), (std::vector<QPoint>{QPoint(4, 4), QPoint(14, 4)}));
+    }
+
+    void ridgeOfElongatedCellIsOneMarker()
+    {
+        const BinaryImage corridor = fromRows({
+            "##############################",
+            "#............................#",
+            "#............................#",
+            "#............................#",
+            "#............................#",
+            "#............................#",
+            "##############################",
+        });
+        QCOMPARE(distanceMaxima(DistanceTransform(corridor), 1.0, 0.0), std::vector<QPoint>{QPoint(3, 3)});
+    }
+
+    void widerCellsComeFirst()
+    {
+        const BinaryImage contour = fromRows({
+            "#####################",
+            "#.....#.............#",
+            "#.....#.............#",
+            "#.....#.............#",
+            "#.....#.............#",
+            "#.....#.............#",
+            "#.....#.............#",
+            "#.....#.............#",
+            "#.....#.............#",
+            "#.....#.............#",
+            "#.....#.............#",
+            "#.....#.............#",
+            "#####################",
+        });
+        const std::vector<QPoint> markers = distanceMaxima(DistanceTransform(contour), 1.0);
+        QCOMPARE(markers.size(), std::size_t(2));
+        QVERIFY(markers[0].x() > 6);
+        QVERIFY(markers[1].x() < 6);
+    }
+};
+
+QTEST_APPLESS_MAIN(WatershedTest)
+
+#include "tst_watershed.moc"
@@ -1,60 +1,16 @@
 #include "vertex.h"
 
+#include "crossingguard.h"
+#include "halfedgemesh.h"
 #include "line.h"
+#include "meshvalidator.h"
 #include "polygon.h"
+#include "vertexgraphicsitem.h"
+#include "vertexspatialindex.h"
 
 #include <QGraphicsScene>
-#include <QGraphicsEllipseItem>
-#include <QPen>
-#include <QBrush>
-#include <QRectF>
-#include <QGraphicsSceneMouseEvent>
-#include <QCursor>
-#include <QVariant>
 #include <algorithm>
 
-class VertexGraphicsItem : public QGraphicsEllipseItem
-{
-public:
-    VertexGraphicsItem(Vertex *vertex, qreal radius)
-        : QGraphicsEllipseItem(-radius, -radius, radius * 2, radius * 2)
-        , m_vertex(vertex)
-    {
-        setBrush(QBrush(Qt::red));
-        setPen(QPen(Qt::NoPen));
-        setZValue(1.0);
-        setFlag(QGraphicsItem::ItemIsSelectable);
-        setFlag(QGraphicsItem::ItemIsMovable);
-        setFlag(QGraphicsItem::ItemSendsScenePositionChanges);
-        setFlag(QGraphicsItem::ItemIgnoresTransformations);
-        setCursor(Qt::OpenHandCursor);
-    }
-
-protected:
-    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override
-    {
-        if (change == QGraphicsItem::ItemScenePositionHasChanged && m_vertex) {
-            m_vertex->updatePositionFromGraphicsItem(value.toPointF());
-        }
-        return QGraphicsEllipseItem::itemChange(change, value);
-    }
-
-    void mousePressEvent(QGraphicsSceneMouseEvent *event) override
-    {
-        setCursor(Qt::ClosedHandCursor);
-        QGraphicsEllipseItem::mousePressEvent(event);
-    }
-
-    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override
-    {
-        setCursor(Qt::OpenHandCursor);
-        QGraphicsEllipseItem::mouseReleaseEvent(event);
-    }
-
-private:
-    Vertex *m_vertex = nullptr;
-};
-
 Vertex::Vertex(int id, const QPointF &position, QGraphicsScene *scene, qreal radius)
     : m_id(id)
     , m_position(position)
@@ -71,6 +27,15 @@ Vertex::Vertex(int id, const QPointF &position, QGraphicsScene *scene, qreal rad
 
 Vertex::~Vertex()
 {
+    if (m_meshValidator)
+        m_meshValidator->untrackVertex(this);
+
+    if (m_halfEdgeMesh)
+        m_halfEdgeMesh->untrackVertex(this);
+
+    if (m_spatialIndex)
+        m_spatialIndex->remove(this);
+
     if (m_scene && m_item) {
         m_scene->removeItem(m_item);
     }
@@ -91,6 +56,10 @@ QPointF Vertex::position() const
 void Vertex::setPosition(const QPointF &position)
 {
     m_position = position;
+    if (m_spatialIndex)
+        m_spatialIndex->update(this, m_position);
+    if (m_halfEdgeMesh)
+        m_halfEdgeMesh->vertexMoved(this);
     updateGraphicsItem();
     notifyConnectedLines();
 }
@@ -100,6 +69,24 @@ QGraphicsItem *Vertex::graphicsItem() const
     return m_item;
 }
 
+void Vertex::setSpatialIndex(VertexSpatialIndex *index)
+{
+    if (m_spatialIndex == index)
+        return;
+
+    if (m_spatialIndex)
+        m_spatialIndex->remove(this);
+
+    m_spatialIndex = index;
+    if (m_spatialIndex)
+        m_spatialIndex->insert(this, m_position);
+}
+
+void Vertex::setCrossingGuard(const CrossingGuard *guard)
+{
+    m_crossingGuard = guard;
+}
+
 void Vertex::addConnectedLine(Line *line)
 {
     if (!line)
@@ -147,13 +134,47 @@ void Vertex::updateGraphicsItem()
     if (!m_item)
         return;
 
-    m_item->setRect(-m_radius, -m_radius, m_radius * 2, m_radius * 2);
     m_item->setPos(m_position);
 }
 
+void Vertex::setMeshValidator(MeshValidator *validator)
+{
+    if (m_meshValidator == validator)
+        return;
+
+    if (m_meshValidator)
+        m_meshValidator->untrackVertex(this);
+
+    m_meshValidator = validator;
+    if (m_meshValidator)
+        m_meshValidator->trackVertex(this);
+}
+
+void Vertex::setHalfEdgeMesh(HalfEdgeMesh *mesh)
+{
+    if (m_halfEdgeMesh == mesh)
+        return;
+
+    if (m_halfEdgeMesh)
+        m_halfEdgeMesh->untrackVertex(this);
+
+    m_halfEdgeMesh = mesh;
+    if (m_halfEdgeMesh)
+        m_halfEdgeMesh->trackVertex(this);
+}
+
+QPointF Vertex::constrainedPosition(const QPointF &position) const
+{
+    return m_crossingGuard ? m_crossingGuard->constrainMove(this, position) : position;
+}
+
 void Vertex::updatePositionFromGraphicsItem(const QPointF &position)
 {
     m_position = position;
+    if (m_spatialIndex)
+        m_spatialIndex->update(this, m_position);
+    if (m_halfEdgeMesh)
+        m_halfEdgeMesh->vertexMoved(this);
     notifyConnectedLines();
 }
 
@@ -6,7 +6,11 @@
 
 class QGraphicsItem;
 class QGraphicsScene;
+class CrossingGuard;
+class HalfEdgeMesh;
+class MeshValidator;
 class VertexGraphicsItem;
+class VertexSpatialIndex;
 class Line;
 class Polygon;
 
@@ -20,6 +24,10 @@ public:
     QPointF position() const;
     void setPosition(const QPointF &position);
     QGraphicsItem *graphicsItem() const;
+    void setSpatialIndex(VertexSpatialIndex *index);
+    void setCrossingGuard(const CrossingGuard *guard);
+    void setMeshValidator(MeshValidator *validator);
+    void setHalfEdgeMesh(HalfEdgeMesh *mesh);
     void addConnectedLine(Line *line);
     void removeConnectedLine(Line *line);
     void addConnectedPolygon(Polygon *polygon);
@@ -29,6 +37,7 @@ public:
 
 private:
     void updateGraphicsItem();
+    QPointF constrainedPosition(const QPointF &position) const;
     void updatePositionFromGraphicsItem(const QPointF &position);
     void notifyConnectedLines();
 
@@ -37,6 +46,10 @@ private:
     QGraphicsScene *m_scene;
     VertexGraphicsItem *m_item;
     qreal m_radius;
+    VertexSpatialIndex *m_spatialIndex = nullptr;
+    const CrossingGuard *m_crossingGuard = nullptr;
+    MeshValidator *m_meshValidator = nullptr;
+    HalfEdgeMesh *m_halfEdgeMesh = nullptr;
     std::vector<Line *> m_lines;
     std::vector<Polygon *> m_polygons;
 
@@ -0,0 +1,143 @@
+#include "vertexgraphicsitem.h"
+
+#include "vertex.h"
+#include "zoomablegraphicsview.h"
+
+#include <QCursor>
+#include <QGraphicsSceneHoverEvent>
+#include <QGraphicsSceneMouseEvent>
+#include <QPainter>
+#include <QPainterPath>
+#include <QStyle>
+#include <QStyleOptionGraphicsItem>
+#include <QVariant>
+#include <QWidget>
+
+#include <map>
+#include <memory>
+
+VertexGraphicsItem::VertexGraphicsItem(Vertex *vertex, qreal radius)
+    : m_vertex(vertex)
+    , m_style(sharedStyle(radius))
+{
+    setZValue(1.0);
+    setFlag(QGraphicsItem::ItemIsSelectable);
+    setFlag(QGraphicsItem::ItemIsMovable);
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges);
+    setFlag(QGraphicsItem::ItemSendsScenePositionChanges);
+    setFlag(QGraphicsItem::ItemIgnoresTransformations);
+    setAcceptHoverEvents(true);
+}
+
+const VertexItemStyle *VertexGraphicsItem::sharedStyle(qreal radius)
+{
+    static std::map<qreal, std::unique_ptr<VertexItemStyle>> styles;
+
+    std::unique_ptr<VertexItemStyle> &style = styles[radius];
+    if (!style) {
+        style = std::make_unique<VertexItemStyle>();
+        style->brush = QBrush(Qt::red);
+        style->pen = QPen(Qt::NoPen);
+        style->radius = radius;
+    }
+    return style.get();
+}
+
+int VertexGraphicsItem::type() const
+{
+    return Type;
+}
+
+qreal VertexGraphicsItem::radius() const
+{
+    return m_style->radius;
+}
+
+const QPen &VertexGraphicsItem::pen() const
+{
+    return m_style->pen;
+}
+
+const QBrush &VertexGraphicsItem::brush() const
+{
+    return m_style->brush;
+}
+
+QRectF VertexGraphicsItem::boundingRect() const
+{
+    const qreal extent = m_style->radius + (m_style->pen.style() == Qt::NoPen ? 0.0 : m_style->pen.widthF() / 2.0);
+    return QRectF(-extent, -extent, extent * 2.0, extent * 2.0);
+}
+
+QPainterPath VertexGraphicsItem::shape() const
+{
+    QPainterPath path;
+    path.addEllipse(QPointF(), m_style->radius, m_style->radius);
+    return path;
+}
+
+bool VertexGraphicsItem::contains(const QPointF &point) const
+{
+    const qreal radius = m_style->radius;
+    return point.x() * point.x() + point.y() * point.y() <= radius * radius;
+}
+
+void VertexGraphicsItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    if (ZoomableGraphicsView::rendersOverlayInTiles(widget))
+        return;
+
+    const qreal radius = m_style->radius;
+    painter->setPen(m_style->pen);
+    painter->setBrush(m_style->brush);
+    painter->drawEllipse(QPointF(), radius, radius);
+
+    if (option->state & QStyle::State_Selected) {
+        painter->setPen(QPen(option->palette.windowText(), 0.0, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(boundingRect());
+    }
+}
+
+QVariant VertexGraphicsItem::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    // Vertex items are top level, so the item position is the scene position.
+    if (change == QGraphicsItem::ItemPositionChange && m_vertex)
+        return m_vertex->constrainedPosition(value.toPointF());
+    if (change == QGraphicsItem::ItemScenePositionHasChanged && m_vertex)
+        m_vertex->updatePositionFromGraphicsItem(value.toPointF());
+    return QGraphicsItem::itemChange(change, value);
+}
+
+// The cursor is set on the viewport while hovering rather than stored per item.
+void VertexGraphicsItem::hoverEnterEvent(QGraphicsSceneHoverEvent *event)
+{
+    if (QWidget *viewport = event->widget())
+        viewport->setCursor(Qt::OpenHandCursor);
+    QGraphicsItem::hoverEnterEvent(event);
+}
+
+void VertexGraphicsItem::hoverLeaveEvent(QGraphicsSceneHoverEvent *event)
+{
+    if (QWidget *viewport = event->widget())
+        viewport->unsetCursor();
+    QGraphicsItem::hoverLeaveEvent(event);
+}
+
+void VertexGraphicsItem::mousePressEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (QWidget *viewport = event->widget())
+        viewport->setCursor(Qt::ClosedHandCursor);
+    QGraphicsItem::mousePressEvent(event);
+}
+
+void VertexGraphicsItem::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (QWidget *viewport = event->widget()) {
+        if (isUnderMouse())
+            viewport->setCursor(Qt::OpenHandCursor);
+        else
+            viewport->unsetCursor();
+    }
+    QGraphicsItem::mouseReleaseEvent(event);
+}
@@ -0,0 +1,49 @@
+#ifndef VERTEXGRAPHICSITEM_H
+#define VERTEXGRAPHICSITEM_H
+
+#include <QBrush>
+#include <QGraphicsItem>
+#include <QPen>
+
+class Vertex;
+
+// Appearance shared by every vertex item with the same radius.
+struct VertexItemStyle
+{
+    QBrush brush;
+    QPen pen;
+    qreal radius = 0.0;
+};
+
+class VertexGraphicsItem : public QGraphicsItem
+{
+public:
+    enum { Type = UserType + 1 };
+
+    VertexGraphicsItem(Vertex *vertex, qreal radius);
+
+    static const VertexItemStyle *sharedStyle(qreal radius);
+
+    int type() const override;
+    qreal radius() const;
+    const QPen &pen() const;
+    const QBrush &brush() const;
+
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;
+    bool contains(const QPointF &point) const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+    void hoverEnterEvent(QGraphicsSceneHoverEvent *event) override;
+    void hoverLeaveEvent(QGraphicsSceneHoverEvent *event) override;
+    void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
+
+private:
+    Vertex *m_vertex = nullptr;
+    const VertexItemStyle *m_style = nullptr;
+};
+
+#endif // VERTEXGRAPHICSITEM_H
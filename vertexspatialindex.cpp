@@ -0,0 +1,304 @@
+#include "vertexspatialindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+namespace {
+constexpr qreal kDefaultCellSize = 32.0;
+constexpr qreal kMinimumCellSize = 1.0;
+constexpr qreal kCellsAcrossBounds = 64.0;
+// Halve the cell size once the average cell inside the bounds holds more than
+// this many vertices.
+constexpr std::size_t kMaximumAverageOccupancy = 8;
+// Radius queries that would scan more cells than this per axis fall back to
+// the expanding ring search.
+constexpr qreal kMaximumScannedCellsPerAxis = 16.0;
+
+qreal squaredDistance(const QPointF &lhs, const QPointF &rhs)
+{
+    const qreal dx = lhs.x() - rhs.x();
+    const qreal dy = lhs.y() - rhs.y();
+    return dx * dx + dy * dy;
+}
+} // namespace
+
+VertexSpatialIndex::VertexSpatialIndex()
+    : m_cellSize(kDefaultCellSize)
+{
+}
+
+void VertexSpatialIndex::setBounds(const QRectF &bounds)
+{
+    m_bounds = bounds.normalized();
+    const qreal extent = std::max(m_bounds.width(), m_bounds.height());
+    const qreal cellSize = extent > 0.0 ? std::max(kMinimumCellSize, extent / kCellsAcrossBounds) : kDefaultCellSize;
+    rebuild(cellSize);
+    growIfCrowded();
+}
+
+void VertexSpatialIndex::clear()
+{
+    m_cells.clear();
+    m_positions.clear();
+}
+
+std::size_t VertexSpatialIndex::size() const
+{
+    return m_positions.size();
+}
+
+void VertexSpatialIndex::insert(Vertex *vertex, const QPointF &position)
+{
+    if (!vertex)
+        return;
+
+    if (!m_positions.emplace(vertex, position).second) {
+        update(vertex, position);
+        return;
+    }
+
+    insertIntoCell(vertex, position);
+    growIfCrowded();
+}
+
+void VertexSpatialIndex::update(Vertex *vertex, const QPointF &position)
+{
+    const auto it = m_positions.find(vertex);
+    if (it == m_positions.end()) {
+        insert(vertex, position);
+        return;
+    }
+
+    const CellCoordinate previousCell = cellFor(it->second);
+    const CellCoordinate nextCell = cellFor(position);
+    if (previousCell.x == nextCell.x && previousCell.y == nextCell.y) {
+        // Same cell: only the cached coordinate changes.
+        auto &entries = m_cells[cellKey(nextCell)];
+        for (Entry &entry : entries) {
+            if (entry.vertex == vertex) {
+                entry.position = position;
+                break;
+            }
+        }
+    } else {
+        removeFromCell(vertex, it->second);
+        insertIntoCell(vertex, position);
+    }
+
+    it->second = position;
+}
+
+void VertexSpatialIndex::remove(Vertex *vertex)
+{
+    const auto it = m_positions.find(vertex);
+    if (it == m_positions.end())
+        return;
+
+    removeFromCell(vertex, it->second);
+    m_positions.erase(it);
+}
+
+Vertex *VertexSpatialIndex::nearest(const QPointF &position, qreal maximumDistance) const
+{
+    if (m_positions.empty() || maximumDistance < 0.0)
+        return nullptr;
+
+    if (maximumDistance / m_cellSize > kMaximumScannedCellsPerAxis) {
+        const std::vector<Vertex *> candidates = kNearest(position, 1);
+        if (candidates.empty())
+            return nullptr;
+
+        const auto it = m_positions.find(candidates.front());
+        return squaredDistance(it->second, position) <= maximumDistance * maximumDistance ? candidates.front()
+                                                                                            : nullptr;
+    }
+
+    Vertex *closest = nullptr;
+    qreal closestDistance = maximumDistance * maximumDistance;
+    const CellCoordinate first = cellFor(position - QPointF(maximumDistance, maximumDistance));
+    const CellCoordinate last = cellFor(position + QPointF(maximumDistance, maximumDistance));
+    forEachInCells(first, last, [&](const Entry &entry) {
+        const qreal distance = squaredDistance(entry.position, position);
+        if (distance <= closestDistance) {
+            closestDistance = distance;
+            closest = entry.vertex;
+        }
+    });
+    return closest;
+}
+
+std::vector<Vertex *> VertexSpatialIndex::withinRadius(const QPointF &position, qreal radius) const
+{
+    std::vector<Vertex *> result;
+    if (m_positions.empty() || radius < 0.0)
+        return result;
+
+    const qreal radiusSquared = radius * radius;
+    const CellCoordinate first = cellFor(position - QPointF(radius, radius));
+    const CellCoordinate last = cellFor(position + QPointF(radius, radius));
+    forEachInCells(first, last, [&](const Entry &entry) {
+        if (squaredDistance(entry.position, position) <= radiusSquared)
+            result.push_back(entry.vertex);
+    });
+    return result;
+}
+
+std::vector<Vertex *> VertexSpatialIndex::kNearest(const QPointF &position, std::size_t count) const
+{
+    std::vector<Vertex *> result;
+    if (count == 0 || m_positions.empty())
+        return result;
+
+    // Max-heap of the best candidates so far; the top is the farthest kept one.
+    std::priority_queue<std::pair<qreal, Vertex *>> best;
+    const auto consider = [&](const Entry &entry) {
+        const qreal distance = squaredDistance(entry.position, position);
+        if (best.size() < count) {
+            best.emplace(distance, entry.vertex);
+        } else if (distance < best.top().first) {
+            best.pop();
+            best.emplace(distance, entry.vertex);
+        }
+    };
+
+    const CellCoordinate center = cellFor(position);
+    std::size_t visited = 0;
+    for (int ring = 0;; ++ring) {
+        const auto visitCell = [&](int x, int y) {
+            const auto it = m_cells.find(cellKey(CellCoordinate{x, y}));
+            if (it == m_cells.end())
+                return;
+            for (const Entry &entry : it->second)
+                consider(entry);
+            visited += it->second.size();
+        };
+
+        if (ring == 0) {
+            visitCell(center.x, center.y);
+        } else {
+            for (int dx = -ring; dx <= ring; ++dx) {
+                visitCell(center.x + dx, center.y - ring);
+                visitCell(center.x + dx, center.y + ring);
+            }
+            for (int dy = -ring + 1; dy <= ring - 1; ++dy) {
+                visitCell(center.x - ring, center.y + dy);
+                visitCell(center.x + ring, center.y + dy);
+            }
+        }
+
+        if (visited >= m_positions.size())
+            break;
+
+        // Every cell beyond this ring is at least ring * cellSize away.
+        const qreal ringDistance = ring * m_cellSize;
+        if (best.size() == count && best.top().first <= ringDistance * ringDistance)
+            break;
+    }
+
+    result.resize(best.size());
+    for (auto it = result.rbegin(); it != result.rend(); ++it) {
+        *it = best.top().second;
+        best.pop();
+    }
+    return result;
+}
+
+std::vector<Vertex *> VertexSpatialIndex::inRect(const QRectF &rect) const
+{
+    std::vector<Vertex *> result;
+    if (m_positions.empty())
+        return result;
+
+    const QRectF area = rect.normalized();
+    const CellCoordinate first = cellFor(area.topLeft());
+    const CellCoordinate last = cellFor(area.bottomRight());
+
+    const qint64 cellCount = static_cast<qint64>(last.x - first.x + 1) * (last.y - first.y + 1);
+    if (cellCount > static_cast<qint64>(m_cells.size())) {
+        for (const auto &cell : m_cells) {
+            for (const Entry &entry : cell.second) {
+                if (area.contains(entry.position))
+                    result.push_back(entry.vertex);
+            }
+        }
+        return result;
+    }
+
+    forEachInCells(first, last, [&](const Entry &entry) {
+        if (area.contains(entry.position))
+            result.push_back(entry.vertex);
+    });
+    return result;
+}
+
+VertexSpatialIndex::CellCoordinate VertexSpatialIndex::cellFor(const QPointF &position) const
+{
+    return CellCoordinate{static_cast<int>(std::floor(position.x() / m_cellSize)),
+                          static_cast<int>(std::floor(position.y() / m_cellSize))};
+}
+
+std::int64_t VertexSpatialIndex::cellKey(const CellCoordinate &cell)
+{
+    // Shifting a negative cell would be undefined, so the halves are packed
+    // as unsigned bits.
+    return static_cast<std::int64_t>((static_cast<std::uint64_t>(static_cast<std::uint32_t>(cell.x)) << 32)
+                                     | static_cast<std::uint32_t>(cell.y));
+}
+
+void VertexSpatialIndex::insertIntoCell(Vertex *vertex, const QPointF &position)
+{
+    m_cells[cellKey(cellFor(position))].push_back(Entry{vertex, position});
+}
+
+void VertexSpatialIndex::removeFromCell(Vertex *vertex, const QPointF &position)
+{
+    const auto cellIt = m_cells.find(cellKey(cellFor(position)));
+    if (cellIt == m_cells.end())
+        return;
+
+    auto &entries = cellIt->second;
+    const auto it = std::find_if(entries.begin(), entries.end(), [vertex](const Entry &entry) {
+        return entry.vertex == vertex;
+    });
+    if (it != entries.end()) {
+        *it = entries.back();
+        entries.pop_back();
+    }
+
+    if (entries.empty())
+        m_cells.erase(cellIt);
+}
+
+void VertexSpatialIndex::rebuild(qreal cellSize)
+{
+    m_cellSize = cellSize;
+    m_cells.clear();
+    for (const auto &[vertex, position] : m_positions)
+        insertIntoCell(vertex, position);
+}
+
+void VertexSpatialIndex::growIfCrowded()
+{
+    if (m_bounds.isEmpty() || m_cellSize <= kMinimumCellSize)
+        return;
+
+    const qreal boundsCells = std::max<qreal>(1.0, (m_bounds.width() / m_cellSize) * (m_bounds.height() / m_cellSize));
+    if (static_cast<qreal>(m_positions.size()) > kMaximumAverageOccupancy * boundsCells)
+        rebuild(std::max(kMinimumCellSize, m_cellSize / 2.0));
+}
+
+template<typename Visitor>
+void VertexSpatialIndex::forEachInCells(const CellCoordinate &first, const CellCoordinate &last, Visitor &&visitor) const
+{
+    for (int y = first.y; y <= last.y; ++y) {
+        for (int x = first.x; x <= last.x; ++x) {
+            const auto it = m_cells.find(cellKey(CellCoordinate{x, y}));
+            if (it == m_cells.end())
+                continue;
+            for (const Entry &entry : it->second)
+                visitor(entry);
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef VERTEXSPATIALINDEX_H
+#define VERTEXSPATIALINDEX_H
+
+#include <QPointF>
+#include <QRectF>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Vertex;
+
+// Uniform hash grid over vertex positions. Cells are only allocated where
+// vertices exist, so positions outside the bounds used for sizing still work.
+class VertexSpatialIndex
+{
+public:
+    VertexSpatialIndex();
+
+    void setBounds(const QRectF &bounds);
+    void clear();
+    std::size_t size() const;
+
+    void insert(Vertex *vertex, const QPointF &position);
+    void update(Vertex *vertex, const QPointF &position);
+    void remove(Vertex *vertex);
+
+    Vertex *nearest(const QPointF &position, qreal maximumDistance) const;
+    std::vector<Vertex *> withinRadius(const QPointF &position, qreal radius) const;
+    std::vector<Vertex *> kNearest(const QPointF &position, std::size_t count) const;
+    std::vector<Vertex *> inRect(const QRectF &rect) const;
+
+private:
+    struct Entry
+    {
+        Vertex *vertex = nullptr;
+        QPointF position;
+    };
+
+    struct CellCoordinate
+    {
+        int x = 0;
+        int y = 0;
+    };
+
+    CellCoordinate cellFor(const QPointF &position) const;
+    static std::int64_t cellKey(const CellCoordinate &cell);
+    void insertIntoCell(Vertex *vertex, const QPointF &position);
+    void removeFromCell(Vertex *vertex, const QPointF &position);
+    void rebuild(qreal cellSize);
+    void growIfCrowded();
+
+    template<typename Visitor>
+    void forEachInCells(const CellCoordinate &first, const CellCoordinate &last, Visitor &&visitor) const;
+
+    QRectF m_bounds;
+    qreal m_cellSize = 0.0;
+    std::unordered_map<std::int64_t, std::vector<Entry>> m_cells;
+    std::unordered_map<Vertex *, QPointF> m_positions;
+};
+
+#endif // VERTEXSPATIALINDEX_H
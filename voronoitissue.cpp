@@ -0,0 +1,295 @@
+#include "voronoitissue.h"
+
+#include <QRandomGenerator>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+// With seeds anywhere in their grid cells, no seed further than three grid
+// steps away can border a cell.
+constexpr int kNeighbourReach = 3;
+constexpr qreal kOnBisectorTolerance = 1e-9;
+
+// Labels of the edges that lie on the border of the area.
+constexpr int kTopSide = -1;
+constexpr int kRightSide = -2;
+constexpr int kBottomSide = -3;
+constexpr int kLeftSide = -4;
+
+struct Cell
+{
+    std::vector<QPointF> ring;
+    // labels[i] names what lies across the edge ring[i] -> ring[i + 1]: the
+    // neighbouring cell's index, or one of the k*Side codes.
+    std::vector<int> labels;
+    // Global vertex ids of the ring vertices this cell owns, -1 elsewhere.
+    std::vector<int> ownedVertexIds;
+    std::vector<int> vertexIds;
+};
+
+// A ring vertex is identified by the cell and the labels of its two edges;
+// every cell meeting at the vertex derives the same sorted triple.
+using VertexKey = std::array<int, 3>;
+
+VertexKey vertexKey(const Cell &cell, int cellIndex, std::size_t i)
+{
+    const std::size_t previous = (i + cell.ring.size() - 1) % cell.ring.size();
+    VertexKey key{cellIndex, cell.labels[previous], cell.labels[i]};
+    std::sort(key.begin(), key.end());
+    return key;
+}
+
+// The vertex belongs to the lowest-numbered cell around it.
+int ownerOf(const VertexKey &key)
+{
+    return *std::find_if(key.begin(), key.end(), [](int label) { return label >= 0; });
+}
+
+// Keeps the part of the cell closer to site than to other; the new edge is
+// labelled with label. Corners within rounding distance of the bisector count
+// as on it, so cocircular seeds (e.g. an unjittered grid) do not leave
+// slivers that only one of the cells sees.
+void clipToBisector(Cell &cell, const QPointF &site, const QPointF &other, int label)
+{
+    const QPointF direction = other - site;
+    const QPointF midpoint = (site + other) / 2.0;
+    const qreal tolerance = kOnBisectorTolerance * QPointF::dotProduct(direction, direction);
+    const auto side = [&](const QPointF &position) {
+        const qreal value = QPointF::dotProduct(position - midpoint, direction);
+        return std::abs(value) <= tolerance ? 0.0 : value;
+    };
+
+    std::vector<QPointF> ring;
+    std::vector<int> labels;
+    ring.reserve(cell.ring.size() + 1);
+    labels.reserve(cell.ring.size() + 1);
+
+    const std::size_t count = cell.ring.size();
+    for (std::size_t i = 0; i < count; ++i) {
+        const QPointF &current = cell.ring[i];
+        const QPointF &next = cell.ring[(i + 1) % count];
+        const qreal currentSide = side(current);
+        const qreal nextSide = side(next);
+        const auto crossing = [&] { return current + (next - current) * (currentSide / (currentSide - nextSide)); };
+
+        if (currentSide <= 0.0) {
+            if (nextSide <= 0.0) {
+                ring.push_back(current);
+                labels.push_back(cell.labels[i]);
+            } else if (currentSide < 0.0) {
+                ring.push_back(current);
+                labels.push_back(cell.labels[i]);
+                ring.push_back(crossing());
+                labels.push_back(label);
+            } else {
+                ring.push_back(current);
+                labels.push_back(label);
+            }
+        } else if (nextSide < 0.0) {
+            ring.push_back(crossing());
+            labels.push_back(cell.labels[i]);
+        }
+    }
+
+    cell.ring = std::move(ring);
+    cell.labels = std::move(labels);
+}
+
+qreal maximumDistanceSquared(const Cell &cell, const QPointF &site)
+{
+    qreal maximum = 0.0;
+    for (const QPointF &position : cell.ring) {
+        const QPointF offset = position - site;
+        maximum = std::max(maximum, QPointF::dotProduct(offset, offset));
+    }
+    return maximum;
+}
+
+// Follows owners until reaching the cell that owns the vertex. Exact key
+// matches are the normal case; where four or more seeds are cocircular the
+// cells disagree on the keys and the nearest vertex of the owner is used.
+int resolveVertex(const std::vector<Cell> &cells, int cellIndex, std::size_t i)
+{
+    for (;;) {
+        const Cell &cell = cells[static_cast<std::size_t>(cellIndex)];
+        if (cell.ownedVertexIds[i] >= 0)
+            return cell.ownedVertexIds[i];
+
+        const VertexKey key = vertexKey(cell, cellIndex, i);
+        const QPointF position = cell.ring[i];
+        const int owner = ownerOf(key);
+        const Cell &ownerCell = cells[static_cast<std::size_t>(owner)];
+
+        std::size_t match = 0;
+        qreal closest = std::numeric_limits<qreal>::max();
+        for (std::size_t j = 0; j < ownerCell.ring.size(); ++j) {
+            if (vertexKey(ownerCell, owner, j) == key) {
+                match = j;
+                break;
+            }
+            const QPointF offset = ownerCell.ring[j] - position;
+            const qreal distance = QPointF::dotProduct(offset, offset);
+            if (distance < closest) {
+                closest = distance;
+                match = j;
+            }
+        }
+
+        // owner < cellIndex, so this terminates.
+        cellIndex = owner;
+        i = match;
+    }
+}
+
+quint64 lineKey(int first, int second)
+{
+    return (static_cast<quint64>(static_cast<quint32>(std::min(first, second))) << 32)
+           | static_cast<quint32>(std::max(first, second));
+}
+} // namespace
+
+PlanarMesh generateVoronoiTissue(const VoronoiTissueOptions &options)
+{
+    PlanarMesh mesh;
+    const QRectF area = options.area.normalized();
+    if (options.cellCount <= 0 || area.isEmpty())
+        return mesh;
+
+    const int columns = std::max(1, static_cast<int>(std::lround(std::sqrt(options.cellCount * area.width() / area.height()))));
+    const int rows = std::max(1, static_cast<int>(std::lround(static_cast<double>(options.cellCount) / columns)));
+    const qreal spacingX = area.width() / columns;
+    const qreal spacingY = area.height() / rows;
+    const qreal jitter = std::clamp<qreal>(options.jitter, 0.0, 1.0);
+
+    std::vector<QPointF> sites;
+    sites.reserve(static_cast<std::size_t>(columns) * rows);
+    QRandomGenerator rng(options.seed);
+    for (int row = 0; row < rows; ++row) {
+        for (int column = 0; column < columns; ++column) {
+            const qreal x = area.left() + (column + 0.5 + jitter * (rng.generateDouble() - 0.5)) * spacingX;
+            const qreal y = area.top() + (row + 0.5 + jitter * (rng.generateDouble() - 0.5)) * spacingY;
+            sites.emplace_back(x, y);
+        }
+    }
+
+    std::vector<int> rowIndices(static_cast<std::size_t>(rows));
+    std::iota(rowIndices.begin(), rowIndices.end(), 0);
+    std::vector<Cell> cells(sites.size());
+
+    // Each cell starts as the whole area and is clipped by the bisectors of
+    // its nearby seeds, nearest first, until no further seed can reach it.
+    QtConcurrent::blockingMap(rowIndices, [&](const int &row) {
+        std::vector<std::pair<qreal, int>> neighbours;
+        for (int column = 0; column < columns; ++column) {
+            const int index = row * columns + column;
+            const QPointF &site = sites[static_cast<std::size_t>(index)];
+
+            neighbours.clear();
+            for (int otherRow = std::max(0, row - kNeighbourReach); otherRow <= std::min(rows - 1, row + kNeighbourReach);
+                 ++otherRow) {
+                for (int otherColumn = std::max(0, column - kNeighbourReach);
+                     otherColumn <= std::min(columns - 1, column + kNeighbourReach);
+                     ++otherColumn) {
+                    const int otherIndex = otherRow * columns + otherColumn;
+                    if (otherIndex == index)
+                        continue;
+                    const QPointF offset = sites[static_cast<std::size_t>(otherIndex)] - site;
+                    neighbours.emplace_back(QPointF::dotProduct(offset, offset), otherIndex);
+                }
+            }
+            std::sort(neighbours.begin(), neighbours.end());
+
+            Cell &cell = cells[static_cast<std::size_t>(index)];
+            cell.ring = {area.topLeft(), area.topRight(), area.bottomRight(), area.bottomLeft()};
+            cell.labels = {kTopSide, kRightSide, kBottomSide, kLeftSide};
+            for (const auto &[distanceSquared, otherIndex] : neighbours) {
+                // A bisector further away than the farthest corner cannot cut.
+                if (distanceSquared > 4.0 * maximumDistanceSquared(cell, site))
+                    break;
+                clipToBisector(cell, site, sites[static_cast<std::size_t>(otherIndex)], otherIndex);
+            }
+        }
+    });
+
+    // Number the vertices each cell owns, then let every cell look up the
+    // ids of the vertices it shares with lower-numbered cells.
+    std::vector<int> vertexOffsets(cells.size() + 1, 0);
+    QtConcurrent::blockingMap(rowIndices, [&](const int &row) {
+        for (int index = row * columns; index < (row + 1) * columns; ++index) {
+            const Cell &cell = cells[static_cast<std::size_t>(index)];
+            int owned = 0;
+            for (std::size_t i = 0; i < cell.ring.size(); ++i) {
+                if (ownerOf(vertexKey(cell, index, i)) == index)
+                    ++owned;
+            }
+            vertexOffsets[static_cast<std::size_t>(index) + 1] = owned;
+        }
+    });
+    std::partial_sum(vertexOffsets.begin(), vertexOffsets.end(), vertexOffsets.begin());
+
+    mesh.vertices.resize(static_cast<std::size_t>(vertexOffsets.back()));
+    QtConcurrent::blockingMap(rowIndices, [&](const int &row) {
+        for (int index = row * columns; index < (row + 1) * columns; ++index) {
+            Cell &cell = cells[static_cast<std::size_t>(index)];
+            int nextId = vertexOffsets[static_cast<std::size_t>(index)];
+            cell.ownedVertexIds.assign(cell.ring.size(), -1);
+            for (std::size_t i = 0; i < cell.ring.size(); ++i) {
+                if (ownerOf(vertexKey(cell, index, i)) != index)
+                    continue;
+                cell.ownedVertexIds[i] = nextId;
+                mesh.vertices[static_cast<std::size_t>(nextId)] = cell.ring[i];
+                ++nextId;
+            }
+        }
+    });
+
+    QtConcurrent::blockingMap(rowIndices, [&](const int &row) {
+        for (int index = row * columns; index < (row + 1) * columns; ++index) {
+            Cell &cell = cells[static_cast<std::size_t>(index)];
+            cell.vertexIds.resize(cell.ring.size());
+            for (std::size_t i = 0; i < cell.ring.size(); ++i)
+                cell.vertexIds[i] = resolveVertex(cells, index, i);
+        }
+    });
+
+    // Lines and faces, in cell order so the numbering is reproducible. Edges
+    // that collapsed onto a single vertex are dropped.
+    std::unordered_map<quint64, int> lineIds;
+    lineIds.reserve(cells.size() * 3 + 4);
+    mesh.lines.reserve(cells.size() * 3);
+    mesh.faceOffsets.reserve(cells.size() + 1);
+    mesh.faceVertices.reserve(cells.size() * 6);
+    mesh.faceLines.reserve(cells.size() * 6);
+
+    for (const Cell &cell : cells) {
+        const std::size_t faceBegin = mesh.faceVertices.size();
+        const std::size_t count = cell.vertexIds.size();
+        for (std::size_t i = 0; i < count; ++i) {
+            const int start = cell.vertexIds[i];
+            const int end = cell.vertexIds[(i + 1) % count];
+            if (start == end)
+                continue;
+
+            const auto [it, inserted] = lineIds.emplace(lineKey(start, end), static_cast<int>(mesh.lines.size()));
+            if (inserted)
+                mesh.lines.emplace_back(start, end);
+            mesh.faceVertices.push_back(start);
+            mesh.faceLines.push_back(it->second);
+        }
+
+        if (mesh.faceVertices.size() - faceBegin < 3) {
+            mesh.faceVertices.resize(faceBegin);
+            mesh.faceLines.resize(faceBegin);
+            continue;
+        }
+        mesh.faceOffsets.push_back(static_cast<int>(mesh.faceVertices.size()));
+    }
+
+    return mesh;
+}
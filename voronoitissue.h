@@ -0,0 +1,25 @@
+#ifndef VORONOITISSUE_H
+#define VORONOITISSUE_H
+
+#include "planarmesh.h"
+
+#include <QRectF>
+
+struct VoronoiTissueOptions
+{
+    // The seeds sit on a grid matching the aspect ratio of area, so the
+    // generated cell count is close to, but not always exactly, cellCount.
+    int cellCount = 1000;
+    QRectF area = QRectF(0.0, 0.0, 512.0, 512.0);
+    quint32 seed = 1;
+    // How far each seed may move from its grid position, as a fraction of
+    // the grid spacing: 0 gives a regular grid, 1 anywhere in its grid cell.
+    qreal jitter = 0.8;
+};
+
+// Voronoi tessellation of jittered seeds, clipped to options.area. Neighbouring
+// cells share their lines and triple junctions; faces are counter-clockwise
+// in the sense of signedArea(). The result only depends on the options.
+PlanarMesh generateVoronoiTissue(const VoronoiTissueOptions &options);
+
+#endif // VORONOITISSUE_H
@@ -0,0 +1,251 @@
+#include "watershed.h"
+
+#include "distancetransform.h"
+#include "stripes.h"
+
+#include <QImage>
+#include <QtAlgorithms>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+// Smallest disc a marker claims, so that a plateau of equal maxima yields
+// one marker.
+constexpr float kMinimumClaimRadius = 1.5f;
+
+struct Candidate
+{
+    float distance = 0.0f;
+    int index = 0;
+};
+
+struct CandidateStripe : Stripe
+{
+    std::vector<Candidate> candidates;
+};
+
+// The grey levels of image as flooding heights, turned so that the contour
+// pixels are on the high side.
+template<typename T>
+std::vector<T> elevations(const QImage &image, const BinaryImage &contours)
+{
+    const int width = image.width();
+    const int height = image.height();
+    const bool haveContours = contours.width() == width && contours.height() == height;
+
+    std::vector<int> rows(static_cast<std::size_t>(height));
+    std::iota(rows.begin(), rows.end(), 0);
+    std::vector<qint64> contourSums(rows.size(), 0);
+    std::vector<qint64> contourCounts(rows.size(), 0);
+    std::vector<qint64> otherSums(rows.size(), 0);
+    if (haveContours) {
+        QtConcurrent::blockingMap(rows, [&](const int &y) {
+            const auto *pixels = reinterpret_cast<const T *>(image.constScanLine(y));
+            const quint64 *words = contours.row(y);
+            qint64 contourSum = 0;
+            qint64 otherSum = 0;
+            for (int x = 0; x < width; ++x) {
+                if ((words[x / 64] >> (x % 64)) & 1)
+                    contourSum += pixels[x];
+                else
+                    otherSum += pixels[x];
+            }
+            const auto row = static_cast<std::size_t>(y);
+            contourSums[row] = contourSum;
+            otherSums[row] = otherSum;
+            for (int w = 0; w < contours.wordsPerRow(); ++w)
+                contourCounts[row] += qPopulationCount(words[w]);
+        });
+    }
+
+    const qint64 contourSum = std::accumulate(contourSums.begin(), contourSums.end(), qint64(0));
+    const qint64 contourCount = std::accumulate(contourCounts.begin(), contourCounts.end(), qint64(0));
+    const qint64 otherSum = std::accumulate(otherSums.begin(), otherSums.end(), qint64(0));
+    const qint64 otherCount = static_cast<qint64>(width) * height - contourCount;
+    // Compares the two means without dividing.
+    const bool darkContours = contourCount > 0 && otherCount > 0
+                              && static_cast<double>(contourSum) * otherCount
+                                     < static_cast<double>(otherSum) * contourCount;
+
+    std::vector<T> result(static_cast<std::size_t>(width) * height);
+    QtConcurrent::blockingMap(rows, [&](const int &y) {
+        const auto *pixels = reinterpret_cast<const T *>(image.constScanLine(y));
+        T *output = result.data() + static_cast<std::size_t>(y) * width;
+        for (int x = 0; x < width; ++x)
+            output[x] = darkContours ? static_cast<T>(std::numeric_limits<T>::max() - pixels[x]) : pixels[x];
+    });
+    return result;
+}
+
+template<typename T>
+LabelImage flood(const QImage &image, const BinaryImage &contours, const std::vector<QPoint> &markers)
+{
+    constexpr int kLevels = std::numeric_limits<T>::max() + 1;
+
+    const int width = image.width();
+    const int height = image.height();
+    const std::vector<T> heights = elevations<T>(image, contours);
+
+    LabelImage result(width, height, static_cast<int>(markers.size()));
+    // A pixel waiting in the queue holds the negated label of the region
+    // that reached it first.
+    int *labels = result.row(0);
+
+    // One FIFO per grey level. Pushing appends to the end of a bucket, so
+    // the queue is written and read in order.
+    std::vector<std::vector<int>> buckets(kLevels);
+    int level = 0;
+
+    const auto push = [&](int index, int label) {
+        // Nothing is queued below the level being flooded, so a basin
+        // reached over a higher pass fills at the height of that pass.
+        const int pixelLevel = std::max<int>(heights[static_cast<std::size_t>(index)], level);
+        labels[index] = -label;
+        buckets[static_cast<std::size_t>(pixelLevel)].push_back(index);
+    };
+    const auto pushNeighbours = [&](int index, int label) {
+        const int x = index % width;
+        if (x > 0 && labels[index - 1] == 0)
+            push(index - 1, label);
+        if (x + 1 < width && labels[index + 1] == 0)
+            push(index + 1, label);
+        if (index >= width && labels[index - width] == 0)
+            push(index - width, label);
+        if (index + width < width * height && labels[index + width] == 0)
+            push(index + width, label);
+    };
+
+    for (std::size_t i = 0; i < markers.size(); ++i) {
+        const QPoint &marker = markers[i];
+        if (marker.x() >= 0 && marker.x() < width && marker.y() >= 0 && marker.y() < height)
+            labels[marker.y() * width + marker.x()] = static_cast<int>(i) + 1;
+    }
+    for (std::size_t i = 0; i < markers.size(); ++i) {
+        const QPoint &marker = markers[i];
+        if (marker.x() < 0 || marker.x() >= width || marker.y() < 0 || marker.y() >= height)
+            continue;
+        const int index = marker.y() * width + marker.x();
+        if (labels[index] == static_cast<int>(i) + 1)
+            pushNeighbours(index, labels[index]);
+    }
+
+    for (; level < kLevels; ++level) {
+        std::vector<int> &bucket = buckets[static_cast<std::size_t>(level)];
+        // The bucket grows while it is drained, hence no iterators.
+        for (std::size_t i = 0; i < bucket.size(); ++i) {
+            const int index = bucket[i];
+            labels[index] = -labels[index];
+            pushNeighbours(index, labels[index]);
+        }
+        std::vector<int>().swap(bucket);
+    }
+    return result;
+}
+} // namespace
+
+std::vector<QPoint> distanceMaxima(const DistanceTransform &distance, qreal minimumRadius, qreal tolerance)
+{
+    if (distance.isNull())
+        return {};
+
+    const int width = distance.width();
+    const int height = distance.height();
+    const float *distances = distance.distances();
+
+    std::vector<CandidateStripe> stripes = makeStripes<CandidateStripe>(height);
+    QtConcurrent::blockingMap(stripes, [&](CandidateStripe &stripe) {
+        for (int y = stripe.first; y < stripe.end; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const int index = y * width + x;
+                const float value = distances[index];
+                if (!(value >= minimumRadius) || std::isinf(value))
+                    continue;
+
+                bool maximum = true;
+                for (int dy = -1; dy <= 1 && maximum; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        const int nx = x + dx;
+                        const int ny = y + dy;
+                        if (nx >= 0 && nx < width && ny >= 0 && ny < height && distances[ny * width + nx] > value) {
+                            maximum = false;
+                            break;
+                        }
+                    }
+                }
+                if (maximum)
+                    stripe.candidates.push_back(Candidate{value, index});
+            }
+        }
+    });
+
+    std::vector<Candidate> candidates;
+    for (const CandidateStripe &stripe : stripes)
+        candidates.insert(candidates.end(), stripe.candidates.begin(), stripe.candidates.end());
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &first, const Candidate &second) {
+        return first.distance != second.distance ? first.distance > second.distance : first.index < second.index;
+    });
+
+    // Strongest first. Each marker claims the ridge around it, where the
+    // distance stays within tolerance of its own, and then its disc; maxima
+    // already claimed belong to the same cell.
+    std::vector<QPoint> markers;
+    BinaryImage claimed(width, height);
+    std::vector<int> stack;
+    for (const Candidate &candidate : candidates) {
+        const int x = candidate.index % width;
+        const int y = candidate.index / width;
+        if (claimed.pixel(x, y))
+            continue;
+        markers.emplace_back(x, y);
+
+        // The ridge never descends below minimumRadius, nor onto the
+        // contours themselves at distance 0, so a wide tolerance cannot
+        // carry a claim into the neighbouring cells.
+        const float floor = std::max({candidate.distance - static_cast<float>(tolerance),
+                                      static_cast<float>(minimumRadius),
+                                      1.0f});
+        claimed.setPixel(x, y, true);
+        stack.assign(1, candidate.index);
+        while (!stack.empty()) {
+            const int index = stack.back();
+            stack.pop_back();
+            const int px = index % width;
+            const int py = index / width;
+            for (int ny = std::max(0, py - 1); ny <= std::min(height - 1, py + 1); ++ny) {
+                for (int nx = std::max(0, px - 1); nx <= std::min(width - 1, px + 1); ++nx) {
+                    if (!claimed.pixel(nx, ny) && distances[ny * width + nx] >= floor) {
+                        claimed.setPixel(nx, ny, true);
+                        stack.push_back(ny * width + nx);
+                    }
+                }
+            }
+        }
+
+        const float radius = std::max(candidate.distance, kMinimumClaimRadius);
+        const int reach = static_cast<int>(radius);
+        for (int dy = std::max(-reach, -y); dy <= std::min(reach, height - 1 - y); ++dy) {
+            const int halfWidth = static_cast<int>(std::sqrt(radius * radius - static_cast<float>(dy * dy)));
+            for (int px = std::max(0, x - halfWidth); px <= std::min(width - 1, x + halfWidth); ++px)
+                claimed.setPixel(px, y + dy, true);
+        }
+    }
+    return markers;
+}
+
+LabelImage watershed(const QImage &image, const BinaryImage &contours, const std::vector<QPoint> &markers)
+{
+    if (image.isNull())
+        return LabelImage();
+
+    QImage grey = image;
+    if (grey.format() != QImage::Format_Grayscale8 && grey.format() != QImage::Format_Grayscale16)
+        grey = grey.convertToFormat(grey.depth() > 32 ? QImage::Format_Grayscale16 : QImage::Format_Grayscale8);
+
+    if (grey.format() == QImage::Format_Grayscale16)
+        return flood<quint16>(grey, contours, markers);
+    return flood<quint8>(grey, contours, markers);
+}
@@ -0,0 +1,34 @@
+#ifndef WATERSHED_H
+#define WATERSHED_H
+
+#include "binaryimage.h"
+#include "labelimage.h"
+
+#include <QPoint>
+#include <QtGlobal>
+
+#include <vector>
+
+class DistanceTransform;
+class QImage;
+
+// One marker per cell from the distance transform of the contour mask: the
+// local maxima of the distance, i.e. the centres of the largest discs that
+// fit between the contours. Maxima closer than minimumRadius to a contour are
+// dropped, and so is a maximum inside the disc of a stronger one or joined to
+// it by a ridge that never drops more than tolerance below it, nor below
+// minimumRadius, as along the middle of an elongated cell.
+std::vector<QPoint> distanceMaxima(const DistanceTransform &distance, qreal minimumRadius, qreal tolerance = 1.0);
+
+// Marker-controlled watershed: floods the contour image from the markers
+// (marker i gets label i + 1) in order of grey level, so regions meet on the
+// contours. The image is turned so that the contours are the high ground,
+// whichever side of the grey range the contour pixels lie on. 8- and 16-bit
+// grey images are flooded at their own depth, other formats are converted.
+//
+// The flooding order is kept in a bucket queue with one FIFO per grey level,
+// which makes it linear in the number of pixels. Pixels that no marker
+// reaches keep label 0.
+LabelImage watershed(const QImage &image, const BinaryImage &contours, const std::vector<QPoint> &markers);
+
+#endif // WATERSHED_H
@@ -1,27 +1,129 @@
 #include "zoomablegraphicsview.h"
 
+#include "linegraphicsitem.h"
+#include "overlaytilerenderer.h"
+#include "vertexgraphicsitem.h"
+
 #include <QContextMenuEvent>
-#include <QGraphicsEllipseItem>
+#include <QFontMetrics>
 #include <QGraphicsItem>
-#include <QGraphicsLineItem>
 #include <QGraphicsPixmapItem>
 #include <QGraphicsPolygonItem>
+#include <QLineF>
 #include <QList>
 #include <QMenu>
 #include <QMouseEvent>
+#include <QPainter>
+#include <QPen>
+#include <QScreen>
 #include <QScrollBar>
+#include <QTransform>
 #include <QWheelEvent>
 #include <QtGlobal>
 
+#include <algorithm>
+#include <cmath>
+
 namespace {
 constexpr double kZoomFactorBase = 1.15;
+constexpr double kWheelStepDelta = 120.0;
+constexpr double kZoomSmoothing = 0.35;
+constexpr double kZoomSettleTolerance = 1e-3;
+constexpr double kFallbackRefreshRate = 60.0;
+constexpr double kMinimumGridSpacingPixels = 8.0;
+constexpr int kScaleBarMargin = 16;
+constexpr int kScaleBarThickness = 6;
+constexpr int kScaleBarLabelSpacing = 2;
+
+QColor overlayColorFor(const QColor &canvasColor, int alpha)
+{
+    QColor color = canvasColor.lightness() < 128 ? QColor(Qt::white) : QColor(Qt::black);
+    color.setAlpha(alpha);
+    return color;
+}
 }
 
 ZoomableGraphicsView::ZoomableGraphicsView(QWidget *parent)
     : QGraphicsView(parent)
 {
-    setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    // Zoom anchoring is done by processFrame() so the transform only changes
+    // once per display frame.
+    setTransformationAnchor(QGraphicsView::NoAnchor);
     setResizeAnchor(QGraphicsView::AnchorUnderMouse);
+
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_frameTimer, &QTimer::timeout, this, &ZoomableGraphicsView::processFrame);
+}
+
+void ZoomableGraphicsView::setCanvasBackground(const CanvasBackground &background)
+{
+    m_canvasBackground = background;
+    m_hasCanvasBackground = true;
+    resetCachedContent();
+    viewport()->update();
+}
+
+void ZoomableGraphicsView::clearCanvasBackground()
+{
+    if (!m_hasCanvasBackground)
+        return;
+
+    m_canvasBackground = CanvasBackground();
+    m_hasCanvasBackground = false;
+    resetCachedContent();
+    viewport()->update();
+}
+
+bool ZoomableGraphicsView::hasCanvasBackground() const
+{
+    return m_hasCanvasBackground;
+}
+
+void ZoomableGraphicsView::setTiledOverlayRenderingEnabled(bool enabled)
+{
+    if (enabled == isTiledOverlayRenderingEnabled())
+        return;
+
+    if (enabled) {
+        m_tileRenderer = new OverlayTileRenderer(this);
+        m_tileRenderer->setScene(scene());
+        connect(m_tileRenderer, &OverlayTileRenderer::tileReady, this, [this](const QRectF &sceneRect) {
+            viewport()->update(mapFromScene(sceneRect).boundingRect().adjusted(-1, -1, 1, 1));
+        });
+        if (scene())
+            m_sceneChangedConnection = connect(scene(), &QGraphicsScene::changed, this, &ZoomableGraphicsView::handleSceneChanged);
+    } else {
+        disconnect(m_sceneChangedConnection);
+        delete m_tileRenderer;
+        m_tileRenderer = nullptr;
+    }
+
+    viewport()->update();
+}
+
+bool ZoomableGraphicsView::isTiledOverlayRenderingEnabled() const
+{
+    return m_tileRenderer != nullptr;
+}
+
+bool ZoomableGraphicsView::rendersOverlayInTiles(const QWidget *viewportWidget)
+{
+    if (!viewportWidget)
+        return false;
+
+    // Items are also painted into the worker tiles without a widget, so only
+    // the view's own viewport pass is skipped.
+    const auto *view = qobject_cast<const ZoomableGraphicsView *>(viewportWidget->parentWidget());
+    return view && view->viewport() == viewportWidget && view->m_tileRenderer;
+}
+
+void ZoomableGraphicsView::handleSceneChanged(const QList<QRectF> &region)
+{
+    if (!m_tileRenderer)
+        return;
+
+    for (const QRectF &rect : region)
+        m_tileRenderer->invalidateSceneRect(rect);
 }
 
 void ZoomableGraphicsView::wheelEvent(QWheelEvent *event)
@@ -38,29 +140,71 @@ void ZoomableGraphicsView::wheelEvent(QWheelEvent *event)
         return;
     }
 
-    const double factor = angleDelta.y() > 0 ? kZoomFactorBase : 1.0 / kZoomFactorBase;
-    applyZoomFactor(factor);
+    // Fractional deltas from touchpads and high-resolution wheels accumulate
+    // into the same target scale as whole notches.
+    const double factor = std::pow(kZoomFactorBase, angleDelta.y() / kWheelStepDelta);
+    applyZoomFactor(factor, event->position().toPoint());
     event->accept();
 #else
     QGraphicsView::wheelEvent(event);
 #endif
 }
 
-void ZoomableGraphicsView::applyZoomFactor(double factor)
+void ZoomableGraphicsView::applyZoomFactor(double factor, const QPoint &viewportAnchor)
 {
-    const double currentScale = transform().m11();
-    double newScale = currentScale * factor;
-    if (newScale < m_minimumScale) {
-        factor = m_minimumScale / currentScale;
-        newScale = m_minimumScale;
-    } else if (newScale > m_maximumScale) {
-        factor = m_maximumScale / currentScale;
-        newScale = m_maximumScale;
+    if (!m_frameTimer.isActive()) {
+        m_currentScale = transform().m11();
+        m_targetScale = m_currentScale;
+    }
+
+    m_targetScale = std::clamp(m_targetScale * factor, m_minimumScale, m_maximumScale);
+    m_zoomAnchorViewportPosition = viewportAnchor;
+    m_zoomAnchorScenePosition = mapToScene(viewportAnchor);
+    scheduleFrame();
+}
+
+void ZoomableGraphicsView::scheduleFrame()
+{
+    if (m_frameTimer.isActive())
+        return;
+
+    const double refreshRate = screen() && screen()->refreshRate() > 0.0 ? screen()->refreshRate()
+                                                                          : kFallbackRefreshRate;
+    m_frameTimer.start(std::max(1, qRound(1000.0 / refreshRate)));
+}
+
+void ZoomableGraphicsView::processFrame()
+{
+    bool needsAnotherFrame = false;
+
+    if (!m_pendingPanDelta.isNull()) {
+        if (QScrollBar *horizontalBar = horizontalScrollBar())
+            horizontalBar->setValue(horizontalBar->value() - m_pendingPanDelta.x());
+        if (QScrollBar *verticalBar = verticalScrollBar())
+            verticalBar->setValue(verticalBar->value() - m_pendingPanDelta.y());
+        m_pendingPanDelta = QPoint();
     }
 
-    if (!qFuzzyCompare(currentScale, newScale)) {
-        scale(factor, factor);
+    if (!qFuzzyCompare(m_currentScale, m_targetScale)) {
+        double nextScale = m_currentScale + (m_targetScale - m_currentScale) * kZoomSmoothing;
+        if (std::abs(nextScale - m_targetScale) <= m_targetScale * kZoomSettleTolerance)
+            nextScale = m_targetScale;
+        else
+            needsAnotherFrame = true;
+
+        setTransform(QTransform::fromScale(nextScale, nextScale));
+        m_currentScale = nextScale;
+
+        // Keep the scene point that was under the cursor at the same place.
+        const QPointF drift = mapFromScene(m_zoomAnchorScenePosition) - QPointF(m_zoomAnchorViewportPosition);
+        if (QScrollBar *horizontalBar = horizontalScrollBar())
+            horizontalBar->setValue(horizontalBar->value() + qRound(drift.x()));
+        if (QScrollBar *verticalBar = verticalScrollBar())
+            verticalBar->setValue(verticalBar->value() + qRound(drift.y()));
     }
+
+    if (!needsAnotherFrame)
+        m_frameTimer.stop();
 }
 
 void ZoomableGraphicsView::contextMenuEvent(QContextMenuEvent *event)
@@ -87,9 +231,9 @@ void ZoomableGraphicsView::contextMenuEvent(QContextMenuEvent *event)
                 continue;
 
             const int type = item->type();
-            if (type == QGraphicsEllipseItem::Type && item->flags().testFlag(QGraphicsItem::ItemIsSelectable)) {
+            if (type == VertexGraphicsItem::Type) {
                 hasVertex = true;
-            } else if (type == QGraphicsLineItem::Type) {
+            } else if (type == LineGraphicsItem::Type) {
                 hasLine = true;
             } else if (type == QGraphicsPolygonItem::Type) {
                 hasPolygon = true;
@@ -104,10 +248,9 @@ void ZoomableGraphicsView::contextMenuEvent(QContextMenuEvent *event)
 
     if (QGraphicsItem *itemUnderCursor = itemAt(event->pos())) {
         const int itemType = itemUnderCursor->type();
-        const bool isSelectableVertex = itemType == QGraphicsEllipseItem::Type
-                                        && itemUnderCursor->flags().testFlag(QGraphicsItem::ItemIsSelectable);
+        const bool isSelectableVertex = itemType == VertexGraphicsItem::Type;
 
-        if (itemType == QGraphicsLineItem::Type) {
+        if (itemType == LineGraphicsItem::Type) {
             QMenu menu(this);
             QAction *deleteSelectedLinesAction = nullptr;
             QAction *createPolygonFromLinesAction = nullptr;
@@ -118,7 +261,7 @@ void ZoomableGraphicsView::contextMenuEvent(QContextMenuEvent *event)
                 if (!selectedItem)
                     continue;
 
-                if (selectedItem->type() == QGraphicsLineItem::Type)
+                if (selectedItem->type() == LineGraphicsItem::Type)
                     selectedLines.append(selectedItem);
             }
 
@@ -191,8 +334,7 @@ void ZoomableGraphicsView::contextMenuEvent(QContextMenuEvent *event)
                 if (!selectedItem)
                     continue;
 
-                const bool isSelectedVertex = selectedItem->type() == QGraphicsEllipseItem::Type
-                                               && selectedItem->flags().testFlag(QGraphicsItem::ItemIsSelectable);
+                const bool isSelectedVertex = selectedItem->type() == VertexGraphicsItem::Type;
 
                 if (isSelectedVertex)
                     selectedVertices.append(selectedItem);
@@ -273,13 +415,9 @@ void ZoomableGraphicsView::mouseMoveEvent(QMouseEvent *event)
             return;
         }
 
-        const QPoint delta = event->pos() - m_lastMousePosition;
+        m_pendingPanDelta += event->pos() - m_lastMousePosition;
         m_lastMousePosition = event->pos();
-
-        if (QScrollBar *horizontalBar = horizontalScrollBar())
-            horizontalBar->setValue(horizontalBar->value() - delta.x());
-        if (QScrollBar *verticalBar = verticalScrollBar())
-            verticalBar->setValue(verticalBar->value() - delta.y());
+        scheduleFrame();
 
         event->accept();
         return;
@@ -291,6 +429,8 @@ void ZoomableGraphicsView::mouseMoveEvent(QMouseEvent *event)
 void ZoomableGraphicsView::mouseReleaseEvent(QMouseEvent *event)
 {
     if (event->button() == Qt::LeftButton && m_isPanning) {
+        m_pendingPanDelta += event->pos() - m_lastMousePosition;
+        processFrame();
         m_isPanning = false;
         viewport()->unsetCursor();
         event->accept();
@@ -299,3 +439,114 @@ void ZoomableGraphicsView::mouseReleaseEvent(QMouseEvent *event)
 
     QGraphicsView::mouseReleaseEvent(event);
 }
+
+void ZoomableGraphicsView::drawBackground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsView::drawBackground(painter, rect);
+
+    if (!m_hasCanvasBackground)
+        return;
+
+    const QRectF canvasRect = rect.intersected(m_canvasBackground.rect);
+    if (!canvasRect.isEmpty()) {
+        painter->fillRect(canvasRect, m_canvasBackground.color);
+
+        if (m_canvasBackground.showGrid)
+            drawCanvasGrid(painter, canvasRect);
+    }
+
+    if (m_canvasBackground.showScaleBar)
+        drawScaleBar(painter);
+}
+
+void ZoomableGraphicsView::drawForeground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsView::drawForeground(painter, rect);
+
+    if (m_tileRenderer)
+        m_tileRenderer->paint(painter, rect);
+}
+
+void ZoomableGraphicsView::scrollContentsBy(int dx, int dy)
+{
+    QGraphicsView::scrollContentsBy(dx, dy);
+
+    // The scale bar is pinned to the viewport, so the scrolled copy of it has
+    // to be repainted along with its new position.
+    if (m_hasCanvasBackground && m_canvasBackground.showScaleBar) {
+        const QRect area = scaleBarViewportRect();
+        viewport()->update(area);
+        viewport()->update(area.translated(dx, dy));
+    }
+}
+
+void ZoomableGraphicsView::drawCanvasGrid(QPainter *painter, const QRectF &rect) const
+{
+    const qreal scale = transform().m11();
+    qreal spacing = m_canvasBackground.gridSpacing;
+    if (spacing <= 0.0 || scale <= 0.0)
+        return;
+
+    while (spacing * scale < kMinimumGridSpacingPixels)
+        spacing *= 2.0;
+
+    const QRectF &canvas = m_canvasBackground.rect;
+    const qreal firstX = canvas.left() + std::ceil((rect.left() - canvas.left()) / spacing) * spacing;
+    const qreal firstY = canvas.top() + std::ceil((rect.top() - canvas.top()) / spacing) * spacing;
+
+    QList<QLineF> gridLines;
+    for (qreal x = firstX; x <= rect.right(); x += spacing)
+        gridLines.append(QLineF(x, rect.top(), x, rect.bottom()));
+    for (qreal y = firstY; y <= rect.bottom(); y += spacing)
+        gridLines.append(QLineF(rect.left(), y, rect.right(), y));
+
+    QPen pen(overlayColorFor(m_canvasBackground.color, 60));
+    pen.setCosmetic(true);
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, false);
+    painter->setPen(pen);
+    painter->drawLines(gridLines);
+    painter->restore();
+}
+
+void ZoomableGraphicsView::drawScaleBar(QPainter *painter) const
+{
+    const QRect area = scaleBarViewportRect();
+    if (area.isEmpty())
+        return;
+
+    const int barLength = qRound(m_canvasBackground.scaleBarLength * transform().m11());
+    const QColor color = overlayColorFor(m_canvasBackground.color, 255);
+
+    painter->save();
+    painter->resetTransform();
+    painter->setRenderHint(QPainter::Antialiasing, false);
+    painter->fillRect(QRect(area.left(), area.bottom() - kScaleBarThickness + 1, barLength, kScaleBarThickness), color);
+    painter->setPen(color);
+    painter->drawText(QRect(area.left(),
+                            area.top(),
+                            area.width(),
+                            area.height() - kScaleBarThickness - kScaleBarLabelSpacing),
+                      Qt::AlignLeft | Qt::AlignBottom,
+                      scaleBarLabel());
+    painter->restore();
+}
+
+QRect ZoomableGraphicsView::scaleBarViewportRect() const
+{
+    const int barLength = qRound(m_canvasBackground.scaleBarLength * transform().m11());
+    if (barLength <= 0)
+        return QRect();
+
+    const QFontMetrics metrics(font());
+    const int width = std::max(barLength, metrics.horizontalAdvance(scaleBarLabel()));
+    const int height = metrics.height() + kScaleBarLabelSpacing + kScaleBarThickness;
+    const int top = viewport()->height() - kScaleBarMargin - height;
+    return QRect(kScaleBarMargin, top, width, height);
+}
+
+QString ZoomableGraphicsView::scaleBarLabel() const
+{
+    return tr("%1 px").arg(m_canvasBackground.scaleBarLength);
+}
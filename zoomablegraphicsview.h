@@ -1,21 +1,45 @@
 #ifndef ZOOMABLEGRAPHICSVIEW_H
 #define ZOOMABLEGRAPHICSVIEW_H
 
+#include <QColor>
 #include <QGraphicsItem>
 #include <QGraphicsView>
 #include <QList>
 #include <QPoint>
 #include <QPointF>
+#include <QRect>
+#include <QRectF>
+#include <QTimer>
 
+class OverlayTileRenderer;
 class QContextMenuEvent;
 class QMouseEvent;
+class QPainter;
 class ZoomableGraphicsView : public QGraphicsView
 {
     Q_OBJECT
 
 public:
+    struct CanvasBackground
+    {
+        QRectF rect;
+        QColor color;
+        bool showGrid = false;
+        qreal gridSpacing = 50.0;
+        bool showScaleBar = false;
+        qreal scaleBarLength = 100.0;
+    };
+
     explicit ZoomableGraphicsView(QWidget *parent = nullptr);
 
+    void setCanvasBackground(const CanvasBackground &background);
+    void clearCanvasBackground();
+    bool hasCanvasBackground() const;
+
+    void setTiledOverlayRenderingEnabled(bool enabled);
+    bool isTiledOverlayRenderingEnabled() const;
+    static bool rendersOverlayInTiles(const QWidget *viewportWidget);
+
 signals:
     void addVertexRequested(const QPointF &scenePosition);
     void deleteVertexRequested(QGraphicsItem *vertexItem);
@@ -35,13 +59,35 @@ protected:
     void mousePressEvent(QMouseEvent *event) override;
     void mouseMoveEvent(QMouseEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
+    void drawBackground(QPainter *painter, const QRectF &rect) override;
+    void drawForeground(QPainter *painter, const QRectF &rect) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+private slots:
+    void handleSceneChanged(const QList<QRectF> &region);
 
 private:
-    void applyZoomFactor(double factor);
+    void applyZoomFactor(double factor, const QPoint &viewportAnchor);
+    void scheduleFrame();
+    void processFrame();
+    void drawCanvasGrid(QPainter *painter, const QRectF &rect) const;
+    void drawScaleBar(QPainter *painter) const;
+    QRect scaleBarViewportRect() const;
+    QString scaleBarLabel() const;
     double m_minimumScale = 0.1;
     double m_maximumScale = 10.0;
     bool m_isPanning = false;
     QPoint m_lastMousePosition;
+    QTimer m_frameTimer;
+    QPoint m_pendingPanDelta;
+    double m_currentScale = 1.0;
+    double m_targetScale = 1.0;
+    QPoint m_zoomAnchorViewportPosition;
+    QPointF m_zoomAnchorScenePosition;
+    CanvasBackground m_canvasBackground;
+    bool m_hasCanvasBackground = false;
+    OverlayTileRenderer *m_tileRenderer = nullptr;
+    QMetaObject::Connection m_sceneChangedConnection;
 };
 
 #endif // ZOOMABLEGRAPHICSVIEW_H